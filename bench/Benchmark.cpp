@@ -0,0 +1,851 @@
+#include "ModelCache.hpp"
+#include "InstanceRegistry.hpp"
+#include "JointAnimation.hpp"
+#include "RenderSort.hpp"
+#include "Culling.hpp"
+#include "Headless.hpp"
+#include "ShaderCache.hpp"
+#include "Profiler.hpp"
+#include "ThreadPool.hpp"
+#include "FileUtil.hpp"
+#include "Simd.hpp"
+#include "J3DFile.hpp"
+#include "TextureDecode.hpp"
+#include "TextureUpload.hpp"
+#include "Renderer.hpp"
+#include "GlRedirect.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <pybind11/embed.h>
+#include <J3D/Data/J3DModelData.hpp>
+#include <J3D/Data/J3DModelInstance.hpp>
+#include <J3D/Material/J3DUniformBufferObject.hpp>
+#include <J3D/Rendering/J3DRendering.hpp>
+#include <glad/glad.h>
+#include <glm/gtc/matrix_transform.hpp>
+
+#ifndef PYJ3D_LIBRARY_VERSION
+#define PYJ3D_LIBRARY_VERSION "unknown"
+#endif
+
+#ifndef PYJ3D_BUILD_TYPE
+#define PYJ3D_BUILD_TYPE "unknown"
+#endif
+
+namespace py = pybind11;
+using namespace py::literals;
+
+namespace PyJ3D::Bench {
+    // Bump whenever a result is renamed or its meaning changes, so trend tooling can tell runs apart.
+    static const int SchemaVersion = 1;
+
+    struct Options {
+        std::string Output;
+        std::string Filter;
+        std::vector<std::string> Models;
+        std::vector<std::string> Clips;
+        bool Quick = false;
+        bool Hardware = false;
+        bool RequireModels = false;  // fail instead of skipping parse and render, for pgo-train
+    };
+
+    struct Result {
+        std::string Name;
+        std::vector<double> SamplesMs;
+        std::vector<std::pair<std::string, double>> Metrics; // derived values such as throughput
+    };
+
+    struct Skipped {
+        std::string Name;
+        std::string Reason;
+    };
+
+    static Options options = {};
+    static std::vector<Result> results = {};
+    static std::vector<Skipped> skipped = {};
+
+    static double NowMs(){
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    static bool Selected(const std::string& name){
+        return options.Filter.empty() || name.find(options.Filter) != std::string::npos;
+    }
+
+    static double Median(std::vector<double> samples){
+        if(samples.empty()) return 0.0;
+
+        std::sort(samples.begin(), samples.end());
+        size_t mid = samples.size() / 2;
+        return samples.size() % 2 ? samples[mid] : (samples[mid - 1] + samples[mid]) * 0.5;
+    }
+
+    // Runs fn once to warm caches, then until both minIterations and the time budget are met.
+    static std::vector<double> Measure(size_t minIterations, const std::function<void()>& fn){
+        double budgetMs = options.Quick ? 100.0 : 1000.0;
+        size_t maxIterations = options.Quick ? 50 : 1000;
+
+        fn();
+
+        std::vector<double> samples;
+        double startMs = NowMs();
+        while(samples.size() < minIterations || (NowMs() - startMs < budgetMs && samples.size() < maxIterations)){
+            double sampleStart = NowMs();
+            fn();
+            samples.push_back(NowMs() - sampleStart);
+        }
+        return samples;
+    }
+
+    static Result& AddResult(const std::string& name, std::vector<double> samplesMs){
+        results.push_back({ name, std::move(samplesMs), {} });
+        return results.back();
+    }
+
+    static void Skip(const std::string& name, const std::string& reason){
+        skipped.push_back({ name, reason });
+        std::cerr << "skipped " << name << ": " << reason << std::endl;
+    }
+
+    // Synthetic BCK with every component keyed, shared slopes and evenly spaced whole frame times.
+    static void PutU16(std::vector<uint8_t>& out, size_t at, uint16_t value){
+        out[at] = (uint8_t)(value >> 8);
+        out[at + 1] = (uint8_t)value;
+    }
+
+    static void PutU32(std::vector<uint8_t>& out, size_t at, uint32_t value){
+        PutU16(out, at, (uint16_t)(value >> 16));
+        PutU16(out, at + 2, (uint16_t)value);
+    }
+
+    static void PutF32(std::vector<uint8_t>& out, size_t at, float value){
+        uint32_t bits;
+        std::memcpy(&bits, &value, 4);
+        PutU32(out, at, bits);
+    }
+
+    static std::vector<uint8_t> MakeKeyedClip(uint16_t jointCount, uint16_t keyCount, uint16_t duration){
+        const size_t sectionStart = 0x20, jointTable = 0x40;
+        uint32_t valuesPerTable = (uint32_t)jointCount * 3 * keyCount * 3;
+
+        size_t scaleTable = (jointTable + jointCount * 9 * 6 + 31) & ~(size_t)31;
+        size_t rotationTable = (scaleTable + valuesPerTable * 4 + 31) & ~(size_t)31;
+        size_t translationTable = (rotationTable + valuesPerTable * 2 + 31) & ~(size_t)31;
+        size_t sectionSize = (translationTable + valuesPerTable * 4 + 31) & ~(size_t)31;
+
+        std::vector<uint8_t> out(sectionStart + sectionSize, 0);
+        std::memcpy(out.data(), "J3D1bck1", 8);
+        PutU32(out, 0x08, (uint32_t)out.size());
+        PutU32(out, 0x0C, 1);
+
+        size_t section = sectionStart;
+        std::memcpy(out.data() + section, "ANK1", 4);
+        PutU32(out, section + 0x04, (uint32_t)sectionSize);
+        out[section + 0x08] = (uint8_t)JointAnimation::LoopMode::Loop;
+        out[section + 0x09] = 0;
+        PutU16(out, section + 0x0A, duration);
+        PutU16(out, section + 0x0C, jointCount);
+        for(size_t table = 0; table < 3; table++) PutU16(out, section + 0x0E + table * 2, (uint16_t)valuesPerTable);
+        PutU32(out, section + 0x14, (uint32_t)jointTable);
+        PutU32(out, section + 0x18, (uint32_t)scaleTable);
+        PutU32(out, section + 0x1C, (uint32_t)rotationTable);
+        PutU32(out, section + 0x20, (uint32_t)translationTable);
+
+        std::mt19937 random(1234);
+        std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+
+        uint32_t next[3] = { 0, 0, 0 };
+        for(uint32_t joint = 0; joint < jointCount; joint++){
+            for(uint32_t component = 0; component < JointAnimation::ComponentCount; component++){
+                uint32_t kind = component % 3;
+                size_t entry = section + jointTable + joint * 9 * 6 + component * 6;
+                PutU16(out, entry, keyCount);
+                PutU16(out, entry + 2, (uint16_t)next[kind]);
+                PutU16(out, entry + 4, 0);
+
+                for(uint32_t key = 0; key < keyCount; key++){
+                    float time = (float)(key * duration / std::max<uint32_t>(keyCount - 1, 1));
+                    float values[3] = { time, unit(random), unit(random) * 0.1f };
+
+                    for(uint32_t i = 0; i < 3; i++, next[kind]++){
+                        if(kind == 1){
+                            float scaled = i == 0 ? values[i] : values[i] * 16384.0f;
+                            PutU16(out, section + rotationTable + next[kind] * 2, (uint16_t)(int16_t)scaled);
+                        }
+                        else {
+                            float value = kind == 0 && i == 1 ? 1.0f + values[i] * 0.25f : (kind == 2 && i == 1 ? values[i] * 100.0f : values[i]);
+                            PutF32(out, section + (kind == 0 ? scaleTable : translationTable) + next[kind] * 4, value);
+                        }
+                    }
+                }
+            }
+        }
+
+        return out;
+    }
+
+    static void BenchClipFile(const std::string& name, const uint8_t* data, size_t size){
+        for(bool lossless : { false, true }){
+            std::string suffix = lossless ? "/lossless" : "/packed";
+
+            std::shared_ptr<JointAnimation::JointClip> clip = JointAnimation::ReadClip(data, size, lossless);
+            if(clip == nullptr){
+                Skip("animation/parse/" + name, "not a BCK or BCA");
+                return;
+            }
+
+            if(Selected("animation/parse/" + name + suffix)){
+                Result& parse = AddResult("animation/parse/" + name + suffix, Measure(5, [&](){ JointAnimation::ReadClip(data, size, lossless); }));
+                parse.Metrics.push_back({ "mbPerSecond", size / 1e6 / (Median(parse.SamplesMs) / 1000.0) });
+                parse.Metrics.push_back({ "memoryBytes", (double)clip->GetMemorySize() });
+            }
+
+            if(Selected("animation/sample/" + name + suffix)){
+                // walks the whole clip so every segment gets located once per sample
+                const size_t frames = 256;
+                std::vector<float> pose(clip->JointCount * JointAnimation::ComponentCount);
+                Result& sample = AddResult("animation/sample/" + name + suffix, Measure(5, [&](){
+                    for(size_t frame = 0; frame < frames; frame++){
+                        JointAnimation::Sample(*clip, (float)frame * clip->Duration / frames, pose.data());
+                    }
+                }));
+
+                double seconds = Median(sample.SamplesMs) / 1000.0;
+                sample.Metrics.push_back({ "posesPerSecond", frames / seconds });
+                sample.Metrics.push_back({ "jointsPerSecond", frames * clip->JointCount / seconds });
+                sample.Metrics.push_back({ "tracks", (double)clip->Tracks.size() });
+            }
+        }
+
+        std::shared_ptr<JointAnimation::JointClip> clip = JointAnimation::ReadClip(data, size, false);
+        if(Selected("animation/encode/" + name)){
+            std::vector<float> pose(clip->JointCount * JointAnimation::ComponentCount);
+            std::vector<uint8_t> encoded;
+            JointAnimation::Sample(*clip, 0.0f, pose.data());
+
+            Result& encode = AddResult("animation/encode/" + name, Measure(5, [&](){
+                for(size_t i = 0; i < 64; i++) JointAnimation::WritePose(pose.data(), clip->JointCount, encoded);
+            }));
+            encode.Metrics.push_back({ "posesPerSecond", 64 / (Median(encode.SamplesMs) / 1000.0) });
+        }
+    }
+
+    static void BenchAnimation(){
+        for(uint16_t joints : { (uint16_t)16, (uint16_t)64, (uint16_t)128 }){
+            std::vector<uint8_t> clip = MakeKeyedClip(joints, 8, 120);
+            BenchClipFile("synthetic_" + std::to_string(joints) + "j", clip.data(), clip.size());
+        }
+
+        for(const std::string& path : options.Clips){
+            Files::MappedFile file;
+            if(!file.Open(path)){
+                Skip("animation/" + path, "couldn't open file");
+                continue;
+            }
+            BenchClipFile(std::filesystem::path(path).filename().string(), file.GetData(), file.GetSize());
+        }
+    }
+
+    // Every kernel at every level the CPU supports, the rest of the suite runs at the active level.
+    static void BenchKernels(){
+        const size_t count = 100000;
+        std::mt19937 random(91011);
+        std::uniform_real_distribution<float> position(-5000.0f, 5000.0f), unit(0.0f, 1.0f);
+
+        Culling::SphereBatch spheres;
+        std::vector<float> u(count), value0(count), value1(count), slope0(count), slope1(count), out(count);
+        for(size_t i = 0; i < count; i++){
+            spheres.Push(glm::vec4(position(random), position(random) * 0.1f, position(random), 10.0f + unit(random) * 200.0f));
+            u[i] = unit(random);
+            value0[i] = position(random);
+            value1[i] = position(random);
+            slope0[i] = unit(random);
+            slope1[i] = unit(random);
+        }
+        std::vector<uint8_t> visible(count);
+
+        std::vector<uint8_t> texels(count * 2), rgba(count * 4);
+        for(uint8_t& byte : texels) byte = (uint8_t)random();
+
+        glm::vec3 cameraPos(0.0f, 500.0f, 0.0f);
+        glm::mat4 view = glm::lookAt(cameraPos, glm::vec3(1000.0f, 0.0f, 1000.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+        glm::mat4 proj = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 1.0f, 10000.0f);
+
+        Simd::Level active = Simd::GetLevel();
+        for(Simd::Level level : { Simd::Level::Scalar, Simd::Level::Sse42, Simd::Level::Avx2 }){
+            if(level > Simd::GetSupportedLevel()) break;
+            Simd::SetLevel(level);
+            std::string suffix = std::string("/") + Simd::GetLevelName(level) + "/" + std::to_string(count);
+
+            if(Selected("kernels/cull" + suffix)){
+                Result& cull = AddResult("kernels/cull" + suffix, Measure(10, [&](){ Culling::Cull(spheres, view, proj, cameraPos, visible.data()); }));
+                cull.Metrics.push_back({ "spheresPerSecond", count / (Median(cull.SamplesMs) / 1000.0) });
+            }
+
+            if(Selected("kernels/hermite" + suffix)){
+                Result& hermite = AddResult("kernels/hermite" + suffix, Measure(10, [&](){
+                    Simd::GetKernels().Hermite(u.data(), value0.data(), value1.data(), slope0.data(), slope1.data(), out.data(), count);
+                }));
+                hermite.Metrics.push_back({ "valuesPerSecond", count / (Median(hermite.SamplesMs) / 1000.0) });
+            }
+
+            if(Selected("kernels/rgb565" + suffix)){
+                Result& rgb565 = AddResult("kernels/rgb565" + suffix, Measure(10, [&](){ Simd::GetKernels().DecodeRgb565(texels.data(), rgba.data(), count); }));
+                rgb565.Metrics.push_back({ "texelsPerSecond", count / (Median(rgb565.SamplesMs) / 1000.0) });
+            }
+
+            if(Selected("kernels/rgb5a3" + suffix)){
+                Result& rgb5a3 = AddResult("kernels/rgb5a3" + suffix, Measure(10, [&](){ Simd::GetKernels().DecodeRgb5a3(texels.data(), rgba.data(), count); }));
+                rgb5a3.Metrics.push_back({ "texelsPerSecond", count / (Median(rgb5a3.SamplesMs) / 1000.0) });
+            }
+        }
+        Simd::SetLevel(active);
+    }
+
+    static void BenchParse(){
+        for(const std::string& path : options.Models){
+            std::string name = "parse/" + std::filesystem::path(path).filename().string();
+            if(!Selected(name)) continue;
+
+            Files::MappedFile file;
+            if(!file.Open(path)){
+                Skip(name, "couldn't open file");
+                continue;
+            }
+
+            if(ModelCache::LoadFromMemory(file.GetData(), file.GetSize(), false) == nullptr){
+                Skip(name, "loader rejected the file");
+                continue;
+            }
+
+            std::shared_ptr<J3DModelData> model;
+            ShaderCache::ShaderCacheStats shadersBefore = ShaderCache::GetStats();
+            Result& parse = AddResult(name, Measure(5, [&](){ model = ModelCache::LoadFromMemory(file.GetData(), file.GetSize(), false); }));
+            ShaderCache::ShaderCacheStats shadersAfter = ShaderCache::GetStats();
+            parse.Metrics.push_back({ "bytes", (double)file.GetSize() });
+            parse.Metrics.push_back({ "mbPerSecond", file.GetSize() / 1e6 / (Median(parse.SamplesMs) / 1000.0) });
+            parse.Metrics.push_back({ "programsReused", (double)(shadersAfter.Reused - shadersBefore.Reused) });
+            parse.Metrics.push_back({ "shaderCompiles", (double)(shadersAfter.Compiled - shadersBefore.Compiled) });
+
+            if(Instances::ModelRecord* record = Instances::FindModel(model.get())){
+                parse.Metrics.push_back({ "textures", (double)record->Textures.Textures });
+                parse.Metrics.push_back({ "decodedTextures", (double)record->Textures.Decoded });
+                parse.Metrics.push_back({ "passthroughTextures", (double)record->Textures.Passthrough });
+                parse.Metrics.push_back({ "decodedTextureBytes", (double)record->Textures.DecodedBytes });
+                parse.Metrics.push_back({ "savedTextureBytes", (double)record->Textures.SavedBytes });
+                parse.Metrics.push_back({ "textureUploadMs", record->Textures.UploadMs });
+            }
+        }
+    }
+
+    // Decodes every level of every texture in the model files, no GL needed.
+    static void BenchTextures(){
+        for(const std::string& path : options.Models){
+            std::string fileName = std::filesystem::path(path).filename().string();
+            std::string decodeName = "textures/decode/" + fileName, bc1Name = "textures/bc1/" + fileName;
+            if(!Selected(decodeName) && !Selected(bc1Name)) continue;
+
+            Files::MappedFile file;
+            std::vector<J3DFile::TextureHeader> textures;
+            if(!file.Open(path) || !J3DFile::ReadTextures(file.GetData(), file.GetSize(), textures)){
+                Skip(decodeName, "no TEX1 section");
+                continue;
+            }
+
+            double pixels = 0.0, cmprPixels = 0.0;
+            for(const J3DFile::TextureHeader& texture : textures){
+                for(uint32_t level = 0; level < texture.MipCount; level++){
+                    double levelPixels = (double)TextureDecode::GetLevelWidth(texture, level) * TextureDecode::GetLevelHeight(texture, level);
+                    if(TextureDecode::IsSupported(texture.Format)) pixels += levelPixels;
+                    if(texture.Format == (uint8_t)TextureDecode::Format::CMPR) cmprPixels += levelPixels;
+                }
+            }
+
+            std::vector<uint8_t> out;
+            if(Selected(decodeName) && pixels > 0.0){
+                Result& decode = AddResult(decodeName, Measure(5, [&](){
+                    for(const J3DFile::TextureHeader& texture : textures){
+                        for(uint32_t level = 0; level < texture.MipCount; level++) TextureDecode::DecodeLevel(file.GetData(), file.GetSize(), texture, level, out);
+                    }
+                }));
+                decode.Metrics.push_back({ "textures", (double)textures.size() });
+                decode.Metrics.push_back({ "megapixelsPerSecond", pixels / 1e6 / (Median(decode.SamplesMs) / 1000.0) });
+            }
+
+            if(Selected(bc1Name) && cmprPixels > 0.0){
+                Result& bc1 = AddResult(bc1Name, Measure(5, [&](){
+                    for(const J3DFile::TextureHeader& texture : textures){
+                        for(uint32_t level = 0; level < texture.MipCount; level++) TextureDecode::ConvertCmprToBc1(file.GetData(), file.GetSize(), texture, level, out);
+                    }
+                }));
+                bc1.Metrics.push_back({ "megapixelsPerSecond", cmprPixels / 1e6 / (Median(bc1.SamplesMs) / 1000.0) });
+            }
+        }
+    }
+
+    // Square grid spaced by the model's bounding sphere, camera pulled back far enough to see all of it.
+    static void PlaceGrid(const std::vector<std::shared_ptr<J3DModelInstance>>& instances, float spacing, glm::mat4& view, glm::mat4& proj, glm::vec3& cameraPos){
+        size_t side = (size_t)std::ceil(std::sqrt((double)instances.size()));
+        for(size_t i = 0; i < instances.size(); i++){
+            glm::vec3 position((float)(i % side) * spacing, 0.0f, (float)(i / side) * spacing);
+            instances[i]->SetTranslation(position);
+            if(Instances::InstanceRecord* record = Instances::Find(instances[i].get())) record->Translation = position;
+        }
+
+        float extent = side * spacing;
+        glm::vec3 center(extent * 0.5f, 0.0f, extent * 0.5f);
+        cameraPos = center + glm::vec3(0.0f, extent * 0.6f + spacing, extent * 0.9f + spacing);
+        view = glm::lookAt(cameraPos, center, glm::vec3(0.0f, 1.0f, 0.0f));
+        proj = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 1.0f, extent * 4.0f + spacing * 4.0f);
+    }
+
+    static void BenchSort(const J3D::Rendering::RenderPacketVector& gathered){
+        if(gathered.empty()) return;
+
+        std::mt19937 random(5678);
+        for(size_t count : { (size_t)100, (size_t)1000, (size_t)10000, (size_t)100000 }){
+            J3D::Rendering::RenderPacketVector source;
+            source.reserve(count);
+            for(size_t i = 0; i < count; i++){
+                source.push_back(gathered[i % gathered.size()]);
+
+                // copies of translucent packets get their own depth so the sort has real work to do
+                J3DRenderPacket& packet = source.back();
+                if((packet.SortKey & 0x00800000) == 0) packet.SortKey = (packet.SortKey & ~0x007FFFFFu) | (random() & 0x007FFFFF);
+            }
+
+            for(RenderSort::SortMode mode : { RenderSort::SortMode::Name, RenderSort::SortMode::Keyed }){
+                std::string name = std::string("sort/") + (mode == RenderSort::SortMode::Name ? "name/" : "keyed/") + std::to_string(count);
+                if(!Selected(name)) continue;
+
+                RenderSort::SetSortMode(mode);
+                J3D::Rendering::RenderPacketVector packets;
+                std::vector<double> samples;
+
+                // copies are made outside the timed region
+                Measure(5, [&](){ packets = source; });
+                for(size_t i = 0; i < (options.Quick ? 5 : 30); i++){
+                    packets = source;
+                    double start = NowMs();
+                    RenderSort::Sort(packets);
+                    samples.push_back(NowMs() - start);
+                }
+
+                Result& sort = AddResult(name, std::move(samples));
+                sort.Metrics.push_back({ "packetsPerSecond", count / (Median(sort.SamplesMs) / 1000.0) });
+            }
+        }
+
+        RenderSort::SetSortMode(RenderSort::SortMode::Keyed);
+    }
+
+    static void AddStageMetrics(Result& result){
+        std::deque<Profiler::FrameStats> history = Profiler::GetHistory();
+        if(history.empty()) return;
+
+        for(size_t stage = 0; stage < Profiler::StageCount; stage++){
+            double cpu = 0.0, gpu = 0.0;
+            size_t gpuFrames = 0;
+            for(const Profiler::FrameStats& frame : history){
+                cpu += frame.CpuMs[stage];
+                if(frame.GpuMs[stage] >= 0.0){
+                    gpu += frame.GpuMs[stage];
+                    gpuFrames++;
+                }
+            }
+
+            const char* stageName = Profiler::GetStageName((Profiler::Stage)stage);
+            if(cpu > 0.0) result.Metrics.push_back({ std::string("cpuMs.") + stageName, cpu / history.size() });
+            if(gpuFrames > 0) result.Metrics.push_back({ std::string("gpuMs.") + stageName, gpu / gpuFrames });
+        }
+
+        for(size_t counter = 0; counter < Profiler::CounterCount; counter++){
+            double total = 0.0;
+            for(const Profiler::FrameStats& frame : history) total += (double)frame.Counters[counter];
+            result.Metrics.push_back({ std::string("counters.") + Profiler::GetCounterName((Profiler::Counter)counter), total / history.size() });
+        }
+    }
+
+    static void BenchRender(){
+        if(options.Models.empty()){
+            Skip("render", "no model given, pass a .bmd/.bdl file or directory");
+            Skip("sort", "no model given, packets are gathered from a real model");
+            return;
+        }
+
+        std::shared_ptr<J3DModelData> data = ModelCache::LoadFromFile(options.Models.front(), false);
+        if(data == nullptr){
+            Skip("render", "couldn't load " + options.Models.front());
+            return;
+        }
+
+        Instances::ModelRecord* model = Instances::FindModel(data.get());
+        float spacing = model != nullptr && model->BoundingSphere.w > 0.0f ? model->BoundingSphere.w * 2.5f : 500.0f;
+
+        Headless::OffscreenTarget target;
+        if(!target.Resize(1280, 720)){
+            Skip("render", "couldn't create the offscreen framebuffer");
+            return;
+        }
+        target.Bind();
+
+        J3D::Rendering::RenderPacketVector gathered;
+        for(size_t count : { (size_t)1, (size_t)100, (size_t)1000, (size_t)10000 }){
+            std::string name = "render/" + std::to_string(count);
+            // the sort benchmarks reuse the 100 instance packets
+            bool gatherForSort = count == 100 && (options.Filter.empty() || options.Filter.rfind("sort", 0) == 0);
+            if(!Selected(name) && !gatherForSort) continue;
+
+            std::vector<std::shared_ptr<J3DModelInstance>> instances;
+            for(size_t i = 0; i < count; i++) instances.push_back(Instances::CreateInstance(data));
+
+            glm::mat4 view, proj;
+            glm::vec3 cameraPos;
+            PlaceGrid(instances, spacing, view, proj, cameraPos);
+
+            size_t frames = options.Quick ? 10 : (count >= 10000 ? 30 : 120);
+            Profiler::SetEnabled(true, true, frames);
+
+            // through the same Renderer::Render the bindings use, so the frame clock, animation and draw counters
+            // all run, glFinish so each sample includes the GPU's share
+            Renderer renderer;
+            renderer.SetCamera(proj, view);
+            auto renderFrame = [&](){
+                glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+                renderer.Submit(instances);
+                renderer.Render(1.0f / 60.0f, cameraPos, false);
+                glFinish();
+            };
+
+            for(size_t i = 0; i < 3; i++) renderFrame();
+            if(gatherForSort){
+                RenderSort::SetSortMode(renderer.GetSortMode());
+                gathered = J3D::Rendering::SortPackets(instances, cameraPos);
+            }
+
+            std::vector<double> samples;
+            for(size_t i = 0; i < frames; i++){
+                double start = NowMs();
+                renderFrame();
+                samples.push_back(NowMs() - start);
+            }
+            // resolves the last frames' timer queries
+            Profiler::BeginFrame();
+            Profiler::EndFrame();
+
+            if(Selected(name)){
+                Result& render = AddResult(name, std::move(samples));
+                render.Metrics.push_back({ "instances", (double)count });
+                render.Metrics.push_back({ "framesPerSecond", 1000.0 / Median(render.SamplesMs) });
+                AddStageMetrics(render);
+            }
+
+            Profiler::SetEnabled(false, false, 1);
+            renderer.Destroy();
+            for(std::shared_ptr<J3DModelInstance>& instance : instances) Instances::Unregister(instance.get());
+        }
+
+        target.Unbind();
+        target.Destroy();
+
+        BenchSort(gathered);
+    }
+
+    // Four cameras orbiting a 100 instance grid through one Renderer, each frame animates once and draws every view.
+    static void BenchViews(){
+        if(!Selected("render/views")) return;
+        if(options.Models.empty()){
+            Skip("render/views", "no model given, pass a .bmd/.bdl file or directory");
+            return;
+        }
+
+        std::shared_ptr<J3DModelData> data = ModelCache::LoadFromFile(options.Models.front(), false);
+        if(data == nullptr){
+            Skip("render/views", "couldn't load " + options.Models.front());
+            return;
+        }
+
+        Instances::ModelRecord* model = Instances::FindModel(data.get());
+        float spacing = model != nullptr && model->BoundingSphere.w > 0.0f ? model->BoundingSphere.w * 2.5f : 500.0f;
+
+        std::vector<std::shared_ptr<J3DModelInstance>> instances;
+        for(size_t i = 0; i < 100; i++) instances.push_back(Instances::CreateInstance(data));
+
+        glm::mat4 view, proj;
+        glm::vec3 cameraPos;
+        PlaceGrid(instances, spacing, view, proj, cameraPos);
+
+        float extent = std::ceil(std::sqrt((float)instances.size())) * spacing;
+        glm::vec3 center(extent * 0.5f, 0.0f, extent * 0.5f);
+        glm::mat4 views[4];
+        for(size_t i = 0; i < 4; i++){
+            glm::mat4 orbit = glm::rotate(glm::translate(glm::mat4(1.0f), center), glm::radians(90.0f * i), glm::vec3(0.0f, 1.0f, 0.0f));
+            views[i] = view * glm::translate(orbit, -center);
+        }
+
+        Renderer renderer;
+        auto renderFrame = [&](){
+            renderer.Submit(instances);
+            renderer.RenderViews(nullptr, 1.0f / 60.0f, views, 4, proj, 640, 360, glm::vec4(0.0f), [](size_t){});
+            glFinish();
+        };
+
+        for(size_t i = 0; i < 3; i++) renderFrame();
+
+        std::vector<double> samples;
+        size_t frames = options.Quick ? 10 : 60;
+        for(size_t i = 0; i < frames; i++){
+            double start = NowMs();
+            renderFrame();
+            samples.push_back(NowMs() - start);
+        }
+
+        Result& result = AddResult("render/views", std::move(samples));
+        result.Metrics.push_back({ "views", 4.0 });
+        result.Metrics.push_back({ "instances", (double)instances.size() });
+        result.Metrics.push_back({ "animatedPerFrame", (double)renderer.GetStats().Animated });
+        result.Metrics.push_back({ "drawnPerFrame", (double)renderer.GetStats().Drawn });
+
+        renderer.Destroy();
+        for(std::shared_ptr<J3DModelInstance>& instance : instances) Instances::Unregister(instance.get());
+    }
+
+    // Times calls through the built module from an embedded interpreter. overheadNs subtracts the cost
+    // of calling an empty Python lambda, leaving what the binding layer itself adds.
+    static void BenchBindings(){
+        if(!Selected("bindings/")) return;
+
+#ifdef PYJ3D_MODULE_DIR
+        try {
+            py::scoped_interpreter interpreter;
+            py::module_::import("sys").attr("path").attr("insert")(0, PYJ3D_MODULE_DIR);
+            py::module_ timeit = py::module_::import("timeit");
+
+            std::vector<uint8_t> clip = MakeKeyedClip(16, 8, 120);
+            py::dict scope;
+            scope["J3DUltra"] = py::module_::import("J3DUltra");
+            scope["clip"] = py::bytes((const char*)clip.data(), clip.size());
+            py::exec("noop = lambda: None\nvec = J3DUltra.Vec3(1.0, 2.0, 3.0)\n", scope);
+
+            const size_t calls = options.Quick ? 20000 : 200000;
+            auto time = [&](const char* statement, size_t count){
+                std::vector<double> samples;
+                for(size_t i = 0; i < 5; i++){
+                    samples.push_back(timeit.attr("timeit")(statement, "number"_a=count, "globals"_a=scope).cast<double>() * 1e9 / count);
+                }
+                return samples;
+            };
+
+            std::vector<double> baseline = time("noop()", calls);
+            double baselineNs = Median(baseline);
+
+            const std::pair<const char*, const char*> statements[] = {
+                { "noArgs", "J3DUltra.isProfiling()" },
+                { "returnsDict", "J3DUltra.getCullingStats()" },
+                { "construct", "J3DUltra.Vec3(1.0, 2.0, 3.0)" },
+                { "setAttribute", "vec.x = 1.0" },
+                { "bufferArgument", "J3DUltra.loadJointClip(data=clip)" }
+            };
+
+            AddResult("bindings/baseline", baseline).Metrics.push_back({ "nsPerCall", baselineNs });
+            for(const auto& [name, statement] : statements){
+                // loadJointClip hashes its input, keep it to fewer calls
+                size_t count = std::strstr(statement, "loadJointClip") ? calls / 20 : calls;
+                std::vector<double> samples = time(statement, count);
+                double ns = Median(samples);
+
+                Result& binding = AddResult(std::string("bindings/") + name, std::move(samples));
+                binding.Metrics.push_back({ "nsPerCall", ns });
+                binding.Metrics.push_back({ "overheadNs", ns - baselineNs });
+            }
+        }
+        catch(const std::exception& error){
+            Skip("bindings", error.what());
+        }
+#else
+        Skip("bindings", "built without the Python module");
+#endif
+    }
+
+    static void WriteString(FILE* file, const std::string& value){
+        std::fputc('"', file);
+        for(char c : value){
+            if(c == '"' || c == '\\') std::fprintf(file, "\\%c", c);
+            else if((unsigned char)c < 0x20) std::fprintf(file, "\\u%04x", c);
+            else std::fputc(c, file);
+        }
+        std::fputc('"', file);
+    }
+
+    // Sample values are per iteration in milliseconds unless the result's metrics say otherwise (bindings report ns).
+    static bool WriteResults(FILE* file, const std::string& renderer, const std::string& glVersion){
+        std::fprintf(file, "{\n  \"schema\": %d,\n  \"timestamp\": %lld,\n  \"build\": {\"libraryRevision\": ", SchemaVersion, (long long)std::time(nullptr));
+        WriteString(file, PYJ3D_LIBRARY_VERSION);
+        std::fprintf(file, ", \"buildType\": ");
+        WriteString(file, PYJ3D_BUILD_TYPE);
+        std::fprintf(file, ", \"profiling\": %s},\n  \"environment\": {\"glRenderer\": ", PYJ3D_PROFILING ? "true" : "false");
+        WriteString(file, renderer);
+        std::fprintf(file, ", \"glVersion\": ");
+        WriteString(file, glVersion);
+        std::fprintf(file, ", \"simd\": \"%s\", \"workers\": %zu, \"quick\": %s},\n  \"results\": [", Simd::GetLevelName(Simd::GetLevel()), Jobs::GetWorkerCount(), options.Quick ? "true" : "false");
+
+        for(size_t i = 0; i < results.size(); i++){
+            const Result& result = results[i];
+            std::vector<double> sorted = result.SamplesMs;
+            std::sort(sorted.begin(), sorted.end());
+
+            double mean = 0.0, variance = 0.0;
+            for(double sample : sorted) mean += sample;
+            mean /= std::max<size_t>(sorted.size(), 1);
+            for(double sample : sorted) variance += (sample - mean) * (sample - mean);
+
+            std::fprintf(file, "%s\n    {\"name\": ", i == 0 ? "" : ",");
+            WriteString(file, result.Name);
+            std::fprintf(file, ", \"iterations\": %zu, \"min\": %.6g, \"median\": %.6g, \"mean\": %.6g, \"max\": %.6g, \"stddev\": %.6g",
+                         sorted.size(), sorted.empty() ? 0.0 : sorted.front(), Median(sorted), mean, sorted.empty() ? 0.0 : sorted.back(),
+                         std::sqrt(variance / std::max<size_t>(sorted.size(), 1)));
+
+            std::fprintf(file, ", \"metrics\": {");
+            for(size_t m = 0; m < result.Metrics.size(); m++){
+                std::fprintf(file, "%s", m == 0 ? "" : ", ");
+                WriteString(file, result.Metrics[m].first);
+                std::fprintf(file, ": %.6g", std::isfinite(result.Metrics[m].second) ? result.Metrics[m].second : 0.0);
+            }
+            std::fprintf(file, "}}");
+        }
+
+        std::fprintf(file, "\n  ],\n  \"skipped\": [");
+        for(size_t i = 0; i < skipped.size(); i++){
+            std::fprintf(file, "%s\n    {\"name\": ", i == 0 ? "" : ",");
+            WriteString(file, skipped[i].Name);
+            std::fprintf(file, ", \"reason\": ");
+            WriteString(file, skipped[i].Reason);
+            std::fprintf(file, "}");
+        }
+        std::fprintf(file, "\n  ]\n}\n");
+
+        return std::ferror(file) == 0;
+    }
+
+    static void AddInput(const std::filesystem::path& path){
+        std::string extension = path.extension().string();
+        std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c){ return (char)std::tolower(c); });
+
+        if(extension == ".bmd" || extension == ".bdl") options.Models.push_back(path.string());
+        else if(extension == ".bck" || extension == ".bca") options.Clips.push_back(path.string());
+    }
+
+    static bool ParseArguments(int argc, char** argv){
+        for(int i = 1; i < argc; i++){
+            std::string arg = argv[i];
+            if(arg == "--output" && i + 1 < argc) options.Output = argv[++i];
+            else if(arg == "--filter" && i + 1 < argc) options.Filter = argv[++i];
+            else if(arg == "--quick") options.Quick = true;
+            else if(arg == "--hardware") options.Hardware = true;
+            else if(arg == "--require-models") options.RequireModels = true;
+            else if(arg.rfind("--", 0) == 0){
+                std::cerr << "usage: " << argv[0] << " [--output results.json] [--filter name] [--quick] [--hardware] [--require-models] [model/clip files or directories...]" << std::endl;
+                return false;
+            }
+            else if(std::filesystem::is_directory(arg)){
+                std::vector<std::filesystem::path> files;
+                for(const auto& entry : std::filesystem::recursive_directory_iterator(arg)){
+                    if(entry.is_regular_file()) files.push_back(entry.path());
+                }
+                // directory order isn't stable, results should be
+                std::sort(files.begin(), files.end());
+                for(const std::filesystem::path& file : files) AddInput(file);
+            }
+            else AddInput(arg);
+        }
+        return true;
+    }
+
+    static int Run(int argc, char** argv){
+        if(!ParseArguments(argc, argv)) return 2;
+        if(options.RequireModels && options.Models.empty()){
+            std::cerr << "--require-models: no .bmd/.bdl files among the inputs" << std::endl;
+            return 2;
+        }
+
+        // Mesa's software rasterizer by default so numbers compare across machines, --hardware keeps the driver
+        if(!options.Hardware){
+#ifndef _WIN32
+            setenv("LIBGL_ALWAYS_SOFTWARE", "1", 0);
+            setenv("EGL_PLATFORM", "surfaceless", 0);
+#endif
+        }
+
+        std::string renderer = "none", glVersion = "none", error;
+        bool hasContext = Headless::CreateContext(error) && gladLoadGLLoader((GLADloadproc)Headless::GetProcAddress);
+        if(hasContext){
+            renderer = (const char*)glGetString(GL_RENDERER);
+            glVersion = (const char*)glGetString(GL_VERSION);
+
+            J3DUniformBufferObject::CreateUBO();
+            GlRedirect::Install();
+            ShaderCache::Install();
+            RenderSort::SetSortMode(RenderSort::SortMode::Keyed);
+        }
+
+        BenchKernels();
+        BenchAnimation();
+        BenchTextures();
+
+        if(hasContext){
+            BenchParse();
+            BenchRender();
+            BenchViews();
+        }
+        else if(options.RequireModels){
+            std::cerr << "--require-models: no GL context: " << error << std::endl;
+            return 1;
+        }
+        else {
+            Skip("parse", "no GL context: " + error);
+            Skip("render", "no GL context: " + error);
+            Skip("sort", "no GL context: " + error);
+        }
+
+        BenchBindings();
+
+        if(hasContext){
+            Profiler::Shutdown();
+            Instances::Clear();
+            ModelCache::Clear();
+            ShaderCache::Uninstall();
+            GlRedirect::Uninstall();
+            J3DUniformBufferObject::DestroyUBO();
+            Headless::DestroyContext();
+        }
+
+        FILE* file = options.Output.empty() ? stdout : std::fopen(options.Output.c_str(), "w");
+        if(file == nullptr){
+            std::cerr << "couldn't write " << options.Output << std::endl;
+            return 1;
+        }
+
+        bool written = WriteResults(file, renderer, glVersion);
+        if(file != stdout) written = std::fclose(file) == 0 && written;
+        return written ? 0 : 1;
+    }
+}
+
+int main(int argc, char** argv){
+    return PyJ3D::Bench::Run(argc, argv);
+}
@@ -0,0 +1,217 @@
+#include "AnimationLod.hpp"
+#include "InstanceRegistry.hpp"
+#include "Profiler.hpp"
+#include "FrameClock.hpp"
+
+#include <functional>
+#include <unordered_map>
+
+#include <J3D/Data/J3DModelInstance.hpp>
+#include <J3D/Animation/J3DColorAnimationInstance.hpp>
+#include <J3D/Animation/J3DTexIndexAnimationInstance.hpp>
+#include <J3D/Animation/J3DTexMatrixAnimationInstance.hpp>
+#include <J3D/Animation/J3DJointAnimationInstance.hpp>
+#include <J3D/Animation/J3DJointFullAnimationInstance.hpp>
+#include <J3D/Animation/J3DVisibilityAnimationInstance.hpp>
+
+namespace PyJ3D::AnimationLod {
+    // Per animation, not per instance, since instances can share animation objects.
+    struct HoldState {
+        std::weak_ptr<J3DAnimation::J3DAnimationInstance> Animation;
+        uint64_t Frame = 0;      // last frame an instance using it was updated
+        uint64_t Pass = 0;       // Update call that first saw it this frame
+        bool Running = false;    // an instance using it ran at full rate this frame
+        bool Held = false;       // paused by level of detail
+        bool Ticked = false;     // paused for the rest of the frame, an earlier render already ticked it
+        bool UserPaused = false;
+        float Debt = 0.0f;       // time skipped while held
+    };
+
+    static LodPolicy globalPolicy = {};
+    static LodStats stats = {};
+    static std::unordered_map<J3DAnimation::J3DAnimationInstance*, HoldState> holds = {};
+    static uint64_t lastSweepFrame = 0;
+    static uint64_t pass = 0;
+
+    // scratch reused by Update
+    static std::vector<J3DModelInstance*> batchInstances = {};
+    static std::vector<HoldState*> touched = {};
+
+    // Skips a joint clip's sampled pose, JointAnimation holds and swaps those itself.
+    template<typename Fn>
+    static void ForEachAnimation(J3DModelInstance* instance, Instances::InstanceRecord* record, Fn&& fn){
+        std::shared_ptr<J3DAnimation::J3DAnimationInstance> animations[] = {
+            instance->GetRegisterColorAnimation(),
+            instance->GetTexIndexAnimation(),
+            instance->GetTexMatrixAnimation(),
+            instance->GetJointAnimation(),
+            instance->GetJointFullAnimation(),
+            instance->GetVisibilityAnimation()
+        };
+
+        for(const std::shared_ptr<J3DAnimation::J3DAnimationInstance>& animation : animations){
+            if(animation != nullptr && (record == nullptr || animation != record->PoseAnimation)) fn(animation);
+        }
+    }
+
+    // An expired entry whose address came back belongs to a new animation.
+    static HoldState& GetHold(const std::shared_ptr<J3DAnimation::J3DAnimationInstance>& animation){
+        HoldState& hold = holds[animation.get()];
+        if(hold.Animation.expired()){
+            hold = HoldState();
+            hold.Animation = animation;
+        }
+        return hold;
+    }
+
+    static void SweepExpired(uint64_t frame){
+        for(auto it = holds.begin(); it != holds.end();){
+            if(it->second.Animation.expired()){
+                it = holds.erase(it);
+            }
+            else {
+                ++it;
+            }
+        }
+        lastSweepFrame = frame;
+    }
+
+    static uint32_t GetInterval(J3DModelInstance* instance, Instances::InstanceRecord* record, const glm::vec3& cameraPos, const LodPolicy& policy){
+        glm::vec4 sphere;
+        float dist;
+        if(Instances::GetWorldSphere(instance, sphere)){
+            dist = glm::max(glm::distance(glm::vec3(sphere), cameraPos) - sphere.w, 0.0f);
+        }
+        else {
+            dist = glm::distance(record->Translation, cameraPos);
+        }
+
+        if(dist <= policy.NearDistance) return 1;
+        return glm::max(dist <= policy.FarDistance ? policy.MidInterval : policy.FarInterval, 1u);
+    }
+
+    void SetPolicy(const LodPolicy& policy){
+        globalPolicy = policy;
+    }
+
+    const LodPolicy& GetPolicy(){
+        return globalPolicy;
+    }
+
+    const LodStats& GetStats(){
+        return stats;
+    }
+
+    void Update(J3DModelInstance* const* instances, size_t count, float dt, const glm::vec3& cameraPos, const LodPolicy& policy){
+        PYJ3D_PROFILE_STAGE(Animation);
+
+        stats = LodStats();
+        stats.Instances = (uint32_t)count;
+
+        uint64_t frame = FrameClock::GetFrame();
+        if(frame - lastSweepFrame >= 600) SweepExpired(frame);
+        pass++;
+
+        touched.clear();
+        for(size_t i = 0; i < count; i++){
+            J3DModelInstance* instance = instances[i];
+            Instances::InstanceRecord* record = Instances::Find(instance);
+
+            bool held = false;
+            uint32_t interval = 1;
+            if(record != nullptr && policy.Enabled){
+                interval = GetInterval(instance, record, cameraPos, policy);
+
+                // stagger instances sharing an interval so their updates don't land on the same frame
+                uint32_t phase = (uint32_t)(std::hash<const void*>()(instance) >> 4);
+                held = interval > 1 && (frame + phase) % interval != 0;
+            }
+
+            if(record != nullptr){
+                if(held) stats.Throttled++;
+                else if(record->AnimThrottled) stats.Updated++;
+                else stats.FullRate++;
+                record->AnimThrottled = held;
+                record->AnimInterval = policy.Interpolate ? interval : 1;
+            }
+            else {
+                stats.FullRate++;
+            }
+
+            ForEachAnimation(instance, record, [&](const std::shared_ptr<J3DAnimation::J3DAnimationInstance>& animation){
+                HoldState& hold = GetHold(animation);
+                if(hold.Frame != frame){
+                    // first sighting this frame, a held animation owes another frame of time
+                    if(hold.Ticked){
+                        hold.Ticked = false;
+                        if(!hold.Held && !hold.UserPaused) animation->SetPaused(false);
+                    }
+                    if(hold.Held && !hold.UserPaused) hold.Debt += dt;
+                    hold.Frame = frame;
+                    hold.Pass = pass;
+                    hold.Running = false;
+                    touched.push_back(&hold);
+                }
+                else if(hold.Pass != pass && !hold.Ticked){
+                    // another renderer or scene drawing it this frame, J3DUltra would tick it a second time
+                    hold.Ticked = true;
+                    if(!hold.Held && !hold.UserPaused) animation->SetPaused(true);
+                    return;
+                }
+                if(hold.Pass == pass) hold.Running |= !held;
+            });
+        }
+
+        // an animation shared with any full rate instance keeps running, only hold the ones nobody ran
+        for(HoldState* hold : touched){
+            std::shared_ptr<J3DAnimation::J3DAnimationInstance> animation = hold->Animation.lock();
+            if(animation == nullptr) continue;
+
+            if(!hold->Running && !hold->Held){
+                hold->Held = true;
+                hold->Debt = 0.0f;
+                if(!hold->UserPaused) animation->SetPaused(true);
+            }
+            else if(hold->Running && hold->Held){
+                // Render ticks this frame's dt, catch up on the frames that were skipped
+                hold->Held = false;
+                if(!hold->UserPaused){
+                    animation->SetPaused(false);
+                    if(hold->Debt > 0.0f) animation->Tick(hold->Debt);
+                }
+                hold->Debt = 0.0f;
+            }
+        }
+    }
+
+    void Update(const std::vector<std::shared_ptr<J3DModelInstance>>& instances, float dt, const glm::vec3& cameraPos){
+        batchInstances.clear();
+        for(const std::shared_ptr<J3DModelInstance>& instance : instances){
+            batchInstances.push_back(instance.get());
+        }
+
+        Update(batchInstances.data(), batchInstances.size(), dt, cameraPos, globalPolicy);
+    }
+
+    void SetPaused(const std::shared_ptr<J3DAnimation::J3DAnimationInstance>& animation, bool paused){
+        if(animation == nullptr) return;
+
+        // nothing to remember for an animation level of detail never touched
+        if(!paused && holds.find(animation.get()) == holds.end()){
+            animation->SetPaused(false);
+            return;
+        }
+
+        HoldState& hold = GetHold(animation);
+        hold.UserPaused = paused;
+        if(!hold.Held && !hold.Ticked) animation->SetPaused(paused);
+    }
+
+    void Clear(){
+        for(auto& [ptr, hold] : holds){
+            std::shared_ptr<J3DAnimation::J3DAnimationInstance> animation = hold.Animation.lock();
+            if(animation != nullptr && (hold.Held || hold.Ticked) && !hold.UserPaused) animation->SetPaused(false);
+        }
+        holds.clear();
+    }
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+class J3DModelInstance;
+namespace J3DAnimation { class J3DAnimationInstance; }
+
+namespace PyJ3D::AnimationLod {
+    // Distances are measured from the camera to the instance's bounding sphere, or its origin when bounds are unknown.
+    struct LodPolicy {
+        bool Enabled = false;
+        float NearDistance = 1000.0f; // full rate inside this distance
+        float FarDistance = 4000.0f;  // MidInterval up to here, FarInterval beyond
+        uint32_t MidInterval = 2;
+        uint32_t FarInterval = 4;
+        bool Interpolate = true;      // native joint clips blend toward their last sample on held frames instead of holding
+    };
+
+    struct LodStats {
+        uint32_t Instances = 0;
+        uint32_t FullRate = 0;  // near instances ticked every frame
+        uint32_t Updated = 0;   // throttled instances that caught up this frame
+        uint32_t Throttled = 0; // instances whose animations were held this frame
+    };
+
+    void SetPolicy(const LodPolicy& policy);
+    const LodPolicy& GetPolicy();
+
+    // Counters from the most recent Update call.
+    const LodStats& GetStats();
+
+    // Call for the instances about to be rendered, before J3D::Rendering::Render ticks them. Intervals are counted
+    // in FrameClock frames, so several scenes or views updating in one frame don't throw off the stagger.
+    // An animation is only held when every instance using it this frame is held, held time is ticked in one step
+    // once it runs again. Native joint clips skip sampling while held, and with Interpolate set show their pose
+    // moving from what was on screen at their last sample to that sample over the interval, one interval behind.
+    // Library animations have no pose to blend from and just hold. J3DUltra still evaluates a held library
+    // animation's paused pose when it draws, holding only saves its tick. Animations a later Update in the same
+    // frame finds already updated are paused until the next frame, so only the first render of a frame ticks them.
+    void Update(J3DModelInstance* const* instances, size_t count, float dt, const glm::vec3& cameraPos, const LodPolicy& policy);
+    void Update(const std::vector<std::shared_ptr<J3DModelInstance>>& instances, float dt, const glm::vec3& cameraPos);
+
+    // Pause or resume an animation for the user. Holding never resumes a user pause, and a user resume
+    // waits until level of detail releases the animation.
+    void SetPaused(const std::shared_ptr<J3DAnimation::J3DAnimationInstance>& animation, bool paused);
+
+    // Forget hold state, held animations are resumed.
+    void Clear();
+}
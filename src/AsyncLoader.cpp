@@ -0,0 +1,169 @@
+#include "AsyncLoader.hpp"
+#include "ModelCache.hpp"
+#include "ThreadPool.hpp"
+#include "InstanceRegistry.hpp"
+#include "FileUtil.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <mutex>
+
+#include <J3D/Data/J3DModelData.hpp>
+#include <J3D/Data/J3DModelInstance.hpp>
+#include <J3D/Animation/J3DAnimationLoader.hpp>
+
+namespace PyJ3D::AsyncLoader {
+    struct StagedModel {
+        std::shared_ptr<LoadHandle> Handle;
+        Files::SharedBytes Data;
+        std::string Key;
+        bool UseCache;
+        bool Prepared;
+        Instances::ModelRecord Record;
+    };
+
+    static std::deque<StagedModel> staged = {};
+    static std::mutex stagedMutex;
+
+    // running estimate of J3DUltra's load time per source byte, so the pump can stop before a model that won't fit
+    static double msPerByte = 0.0;
+
+    static void StageModel(std::shared_ptr<LoadHandle> handle, Files::SharedBytes data, std::string key, bool useCache){
+        StagedModel job = { handle, std::move(data), key, useCache, false, {} };
+
+        // bounds and the raycast BVH are built here, models already in the cache skip it
+        if(!useCache || !ModelCache::Contains(key)){
+            job.Record = Instances::PrepareModel(job.Data.Data, job.Data.Size);
+            job.Prepared = true;
+        }
+
+        handle->Stage();
+
+        std::lock_guard<std::mutex> lock(stagedMutex);
+        staged.push_back(std::move(job));
+    }
+
+    std::shared_ptr<LoadHandle> LoadModel(const std::string& path, bool useCache){
+        std::shared_ptr<LoadHandle> handle = std::make_shared<LoadHandle>(path);
+
+        Jobs::Submit([handle, path, useCache](){
+            Files::SharedBytes data;
+            if(!Files::MapFile(path, data, true)){
+                handle->Fail("Couldn't load model " + path);
+                return;
+            }
+
+            std::string key = useCache ? ModelCache::MakeFileKey(path) : "";
+            StageModel(handle, std::move(data), key, useCache && !key.empty());
+        });
+
+        return handle;
+    }
+
+    std::shared_ptr<LoadHandle> LoadModel(Files::SharedBytes data, bool useCache){
+        std::shared_ptr<LoadHandle> handle = std::make_shared<LoadHandle>("<bytes>");
+
+        Jobs::Submit([handle, data = std::move(data), useCache]() mutable {
+            std::string key = useCache ? ModelCache::MakeMemoryKey(data.Data, data.Size) : "";
+            StageModel(handle, std::move(data), key, useCache);
+        });
+
+        return handle;
+    }
+
+    static void ParseAnimation(std::shared_ptr<LoadHandle> handle, const Files::SharedBytes& data){
+        J3DAnimation::J3DAnimationLoader Loader;
+        std::shared_ptr<J3DAnimation::J3DAnimationInstance> anim = Loader.LoadAnimation((void*)data.Data, data.Size);
+
+        if(anim == nullptr){
+            handle->Fail("Couldn't parse animation " + handle->GetName());
+            return;
+        }
+
+        handle->Finish(anim);
+    }
+
+    std::shared_ptr<LoadHandle> LoadAnimation(const std::string& path){
+        std::shared_ptr<LoadHandle> handle = std::make_shared<LoadHandle>(path);
+
+        Jobs::Submit([handle, path](){
+            Files::SharedBytes data;
+            if(!Files::MapFile(path, data)){
+                handle->Fail("Couldn't load animation " + path);
+                return;
+            }
+
+            ParseAnimation(handle, data);
+        });
+
+        return handle;
+    }
+
+    std::shared_ptr<LoadHandle> LoadAnimation(Files::SharedBytes data){
+        std::shared_ptr<LoadHandle> handle = std::make_shared<LoadHandle>("<bytes>");
+
+        Jobs::Submit([handle, data = std::move(data)]() mutable {
+            ParseAnimation(handle, data);
+        });
+
+        return handle;
+    }
+
+    uint32_t PumpUploads(float budgetMs){
+        auto start = std::chrono::steady_clock::now();
+        uint32_t finished = 0;
+
+        while(true){
+            StagedModel job;
+            {
+                std::lock_guard<std::mutex> lock(stagedMutex);
+                if(staged.empty()) break;
+
+                // J3DUltra's load can't be split, so leave a model that's predicted to overrun for the next pump.
+                // Always finish at least one so a model bigger than the budget still gets through.
+                std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+                if(finished > 0 && elapsed.count() + staged.front().Data.Size * msPerByte > budgetMs) break;
+
+                job = std::move(staged.front());
+                staged.pop_front();
+            }
+
+            auto loadStart = std::chrono::steady_clock::now();
+            std::shared_ptr<J3DModelData> data = job.UseCache ? ModelCache::Find(job.Key) : nullptr;
+            if(data == nullptr){
+                Instances::ModelRecord record = job.Prepared ? std::move(job.Record) : Instances::PrepareModel(job.Data.Data, job.Data.Size);
+                data = ModelCache::LoadPrepared(job.Key, job.Data.Data, job.Data.Size, job.Data.Patchable, std::move(record), job.UseCache);
+
+                double sample = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - loadStart).count() / std::max<size_t>(job.Data.Size, 1);
+                msPerByte = msPerByte == 0.0 ? sample : msPerByte * 0.75 + sample * 0.25;
+            }
+
+            if(data == nullptr){
+                job.Handle->Fail("Couldn't parse model " + job.Handle->GetName());
+            }
+            else {
+                job.Handle->Finish(Instances::CreateInstance(data));
+            }
+            finished++;
+
+            std::chrono::duration<float, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+            if(elapsed.count() >= budgetMs) break;
+        }
+
+        return finished;
+    }
+
+    size_t GetPendingCount(){
+        std::lock_guard<std::mutex> lock(stagedMutex);
+        return staged.size();
+    }
+
+    void CancelStaged(){
+        std::lock_guard<std::mutex> lock(stagedMutex);
+        for(StagedModel& job : staged){
+            job.Handle->Fail("Load cancelled by cleanup");
+        }
+        staged.clear();
+    }
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "FileUtil.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+class J3DModelInstance;
+namespace J3DAnimation { class J3DAnimationInstance; }
+
+namespace PyJ3D::AsyncLoader {
+    enum class LoadState : uint8_t {
+        Reading,  // worker is reading/parsing
+        Staged,   // waiting for PumpUploads to finish on the GL thread
+        Ready,
+        Failed
+    };
+
+    class LoadHandle {
+        std::atomic<LoadState> mState { LoadState::Reading };
+        std::string mName;
+        std::string mError;
+        std::shared_ptr<J3DModelInstance> mModel;
+        std::shared_ptr<J3DAnimation::J3DAnimationInstance> mAnimation;
+
+    public:
+        LoadHandle(std::string name) : mName(name) {}
+
+        LoadState GetState() const { return mState.load(std::memory_order_acquire); }
+        bool IsDone() const { return GetState() == LoadState::Ready || GetState() == LoadState::Failed; }
+        const std::string& GetName() const { return mName; }
+
+        // Only valid once IsDone() returns true.
+        const std::string& GetError() const { return mError; }
+        std::shared_ptr<J3DModelInstance> GetModel() const { return mModel; }
+        std::shared_ptr<J3DAnimation::J3DAnimationInstance> GetAnimation() const { return mAnimation; }
+
+        void Stage() { mState.store(LoadState::Staged, std::memory_order_release); }
+        void Fail(std::string error) { mError = error; mState.store(LoadState::Failed, std::memory_order_release); }
+        void Finish(std::shared_ptr<J3DModelInstance> model) { mModel = model; mState.store(LoadState::Ready, std::memory_order_release); }
+        void Finish(std::shared_ptr<J3DAnimation::J3DAnimationInstance> anim) { mAnimation = anim; mState.store(LoadState::Ready, std::memory_order_release); }
+    };
+
+    // Files are memory-mapped and in-memory data is referenced, not copied, until the load finishes.
+    // Models are read, hashed and have their bounds and raycast BVH built on the worker pool. J3DUltra's own parse
+    // creates GL objects as it goes, so it runs in PumpUploads on the GL thread.
+    std::shared_ptr<LoadHandle> LoadModel(const std::string& path, bool useCache);
+    std::shared_ptr<LoadHandle> LoadModel(Files::SharedBytes data, bool useCache);
+
+    // Animations have no GL state, so they are parsed entirely on the worker pool.
+    std::shared_ptr<LoadHandle> LoadAnimation(const std::string& path);
+    std::shared_ptr<LoadHandle> LoadAnimation(Files::SharedBytes data);
+
+    // Finish staged model loads until budgetMs has elapsed, returns the number finished. Must run on the GL thread.
+    // Models predicted not to fit in what's left of the budget wait for the next call, but one always runs.
+    uint32_t PumpUploads(float budgetMs);
+    size_t GetPendingCount();
+
+    // Fail everything still staged, used on cleanup before the GL context goes away.
+    void CancelStaged();
+}
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <array>
+#include <memory>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <pybind11/pybind11.h>
+
+#include "FileUtil.hpp"
+
+namespace PyJ3D::Buffers {
+    namespace py = pybind11;
+
+    template<typename T>
+    void CopyStrided(const py::buffer_info& info, float* out){
+        std::vector<py::ssize_t> index(info.ndim, 0);
+
+        for(py::ssize_t i = 0; i < info.size; i++){
+            const uint8_t* element = (const uint8_t*)info.ptr;
+            for(py::ssize_t axis = 0; axis < info.ndim; axis++){
+                element += index[axis] * info.strides[axis];
+            }
+            out[i] = (float)*(const T*)element;
+
+            // advance the C-order index, last axis fastest
+            for(py::ssize_t axis = info.ndim - 1; axis >= 0; axis--){
+                if(++index[axis] < info.shape[axis]) break;
+                index[axis] = 0;
+            }
+        }
+    }
+
+    // Reads exactly count floats from any float32/float64 buffer (numpy arrays, memoryviews, array.array)
+    // in C order without going through Python objects. Contiguous float32 input is a single memcpy.
+    inline void ReadFloats(const py::buffer& buffer, float* out, size_t count){
+        py::buffer_info info = buffer.request();
+
+        if((size_t)info.size != count){
+            throw py::value_error("expected " + std::to_string(count) + " values, got " + std::to_string(info.size));
+        }
+
+        bool contiguous = true;
+        py::ssize_t expected = info.itemsize;
+        for(py::ssize_t axis = info.ndim - 1; axis >= 0; axis--){
+            contiguous &= info.strides[axis] == expected;
+            expected *= info.shape[axis];
+        }
+
+        if(info.format == py::format_descriptor<float>::format()){
+            if(contiguous){
+                std::memcpy(out, info.ptr, count * sizeof(float));
+            }
+            else {
+                CopyStrided<float>(info, out);
+            }
+        }
+        else if(info.format == py::format_descriptor<double>::format()){
+            CopyStrided<double>(info, out);
+        }
+        else {
+            throw py::type_error("expected a float32 or float64 buffer, got format '" + info.format + "'");
+        }
+    }
+
+    template<size_t N>
+    std::array<float, N> ReadArray(const py::buffer& buffer){
+        std::array<float, N> values;
+        ReadFloats(buffer, values.data(), N);
+        return values;
+    }
+
+    // Raw bytes of a C-contiguous buffer request, only valid while the request is.
+    inline void GetBytes(const py::buffer_info& info, const uint8_t*& data, size_t& size){
+        py::ssize_t expected = info.itemsize;
+        for(py::ssize_t axis = info.ndim - 1; axis >= 0; axis--){
+            if(info.shape[axis] > 1 && info.strides[axis] != expected) throw py::value_error("expected a contiguous buffer");
+            expected *= info.shape[axis];
+        }
+
+        data = (const uint8_t*)info.ptr;
+        size = (size_t)(info.size * info.itemsize);
+    }
+
+    // Raw bytes of any C-contiguous buffer (bytes, bytearray, memoryview slices, numpy arrays), no copy.
+    inline void GetBytes(const py::buffer& buffer, const uint8_t*& data, size_t& size){
+        GetBytes(buffer.request(), data, size);
+    }
+
+    // The buffer object and its request, held so the exporter keeps the memory pinned (a bytearray can't be
+    // resized while a request is open) until the last C++ user is done.
+    struct BufferOwner {
+        py::buffer Buffer;
+        py::buffer_info Info;
+    };
+
+    // Owners whose last reference dropped on a thread without the GIL. Workers never take the GIL, it may be held
+    // by a thread waiting on them or the interpreter may be finalizing, so these wait for ReleasePending.
+    inline std::mutex& GetPendingMutex(){
+        static std::mutex mutex;
+        return mutex;
+    }
+
+    inline std::vector<BufferOwner*>& GetPendingOwners(){
+        static std::vector<BufferOwner*>* owners = new std::vector<BufferOwner*>(); // leaked, never freed without the GIL
+        return *owners;
+    }
+
+    // Frees owners dropped by workers, call with the GIL held.
+    inline void ReleasePending(){
+        std::vector<BufferOwner*> owners;
+        {
+            std::lock_guard<std::mutex> lock(GetPendingMutex());
+            owners.swap(GetPendingOwners());
+        }
+
+        for(BufferOwner* owner : owners){
+            delete owner;
+        }
+    }
+
+    // Shares a buffer's memory with C++ code that may outlive the call, such as worker threads.
+    // The buffer must not be modified until the load using it finishes.
+    inline Files::SharedBytes ShareBytes(const py::buffer& buffer){
+        ReleasePending();
+
+        BufferOwner* owner = new BufferOwner { buffer, buffer.request() };
+
+        Files::SharedBytes bytes;
+        GetBytes(owner->Info, bytes.Data, bytes.Size);
+
+        bytes.Owner = std::shared_ptr<const void>(owner, [](const void* released){
+            if(PyGILState_Check()){
+                delete (const BufferOwner*)released;
+                return;
+            }
+
+            std::lock_guard<std::mutex> lock(GetPendingMutex());
+            GetPendingOwners().push_back((BufferOwner*)released);
+        });
+        return bytes;
+    }
+}
@@ -0,0 +1,362 @@
+#include "Collision.hpp"
+#include "J3DFile.hpp"
+#include "InstanceRegistry.hpp"
+#include "DiskCache.hpp"
+#include "Culling.hpp"
+#include "JointAnimation.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+#include <glm/gtc/quaternion.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+namespace PyJ3D::Collision {
+    static const uint32_t MaxLeafTriangles = 4;
+
+    uint32_t TriangleBvh::BuildNode(std::vector<uint32_t>& order, std::vector<glm::vec3>& centroids, const std::vector<glm::vec3>& vertices, uint32_t begin, uint32_t end){
+        uint32_t nodeIndex = (uint32_t)mNodes.size();
+        mNodes.emplace_back();
+
+        glm::vec3 min(INFINITY), max(-INFINITY), centerMin(INFINITY), centerMax(-INFINITY);
+        for(uint32_t i = begin; i < end; i++){
+            for(int v = 0; v < 3; v++){
+                min = glm::min(min, vertices[order[i] * 3 + v]);
+                max = glm::max(max, vertices[order[i] * 3 + v]);
+            }
+            centerMin = glm::min(centerMin, centroids[order[i]]);
+            centerMax = glm::max(centerMax, centroids[order[i]]);
+        }
+
+        mNodes[nodeIndex].Min = min;
+        mNodes[nodeIndex].Max = max;
+
+        glm::vec3 extent = centerMax - centerMin;
+        int axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+
+        if(end - begin <= MaxLeafTriangles || extent[axis] <= 0.0f){
+            mNodes[nodeIndex].First = begin;
+            mNodes[nodeIndex].Count = end - begin;
+            return nodeIndex;
+        }
+
+        // median split along the widest centroid axis
+        uint32_t middle = begin + (end - begin) / 2;
+        std::nth_element(order.begin() + begin, order.begin() + middle, order.begin() + end, [&](uint32_t a, uint32_t b){
+            return centroids[a][axis] < centroids[b][axis];
+        });
+
+        BuildNode(order, centroids, vertices, begin, middle);
+        uint32_t right = BuildNode(order, centroids, vertices, middle, end);
+
+        mNodes[nodeIndex].First = right;
+        mNodes[nodeIndex].Count = 0;
+        return nodeIndex;
+    }
+
+    void TriangleBvh::Build(const J3DFile::ModelGeometry& geometry){
+        uint32_t triangleCount = (uint32_t)(geometry.Vertices.size() / 3);
+
+        mNodes.clear();
+        mVertices.clear();
+        mTriangles.clear();
+        mMaterials.clear();
+        mShapes.clear();
+        mVertexDraws.clear();
+
+        if(triangleCount == 0) return;
+
+        std::vector<glm::vec3> centroids(triangleCount);
+        for(uint32_t i = 0; i < triangleCount; i++){
+            centroids[i] = (geometry.Vertices[i * 3] + geometry.Vertices[i * 3 + 1] + geometry.Vertices[i * 3 + 2]) / 3.0f;
+        }
+
+        std::vector<uint32_t> order(triangleCount);
+        std::iota(order.begin(), order.end(), 0);
+
+        mNodes.reserve(triangleCount * 2 / MaxLeafTriangles + 1);
+        BuildNode(order, centroids, geometry.Vertices, 0, triangleCount);
+
+        // store triangles in leaf order so each leaf reads a contiguous run
+        mVertices.reserve(triangleCount * 3);
+        for(uint32_t triangle : order){
+            mVertices.push_back(geometry.Vertices[triangle * 3]);
+            mVertices.push_back(geometry.Vertices[triangle * 3 + 1]);
+            mVertices.push_back(geometry.Vertices[triangle * 3 + 2]);
+            mTriangles.push_back(triangle);
+            mMaterials.push_back(geometry.Materials[triangle]);
+            mShapes.push_back(geometry.Shapes[triangle]);
+        }
+
+        // skinning tables only matter if every vertex has a draw matrix entry
+        bool skinned = geometry.VertexDraws.size() == geometry.Vertices.size() && !geometry.JointParents.empty();
+        if(skinned){
+            mVertexDraws.reserve(triangleCount * 3);
+            for(uint32_t triangle : order){
+                mVertexDraws.insert(mVertexDraws.end(), geometry.VertexDraws.begin() + triangle * 3, geometry.VertexDraws.begin() + triangle * 3 + 3);
+            }
+        }
+
+        mDrawFirst = skinned ? geometry.DrawFirst : std::vector<uint32_t>();
+        mInfluences = skinned ? geometry.Influences : std::vector<J3DFile::SkinInfluence>();
+        mJointParents = skinned ? geometry.JointParents : std::vector<int16_t>();
+        mInverseBind.clear();
+        for(size_t i = 0; skinned && i < geometry.BindJoints.size(); i++){
+            mInverseBind.push_back(glm::inverse(geometry.BindJoints[i]));
+        }
+    }
+
+    // Bounds from the vertices, children come after their parent so a reverse walk sees them first.
+    void TriangleBvh::Refit(){
+        for(size_t n = mNodes.size(); n-- > 0;){
+            Node& node = mNodes[n];
+            if(node.Count == 0){
+                const Node& left = mNodes[n + 1];
+                const Node& right = mNodes[node.First];
+                node.Min = glm::min(left.Min, right.Min);
+                node.Max = glm::max(left.Max, right.Max);
+                continue;
+            }
+
+            node.Min = glm::vec3(INFINITY);
+            node.Max = glm::vec3(-INFINITY);
+            for(uint32_t i = node.First * 3; i < (node.First + node.Count) * 3; i++){
+                node.Min = glm::min(node.Min, mVertices[i]);
+                node.Max = glm::max(node.Max, mVertices[i]);
+            }
+        }
+    }
+
+    bool TriangleBvh::Pose(const TriangleBvh& source, const float* pose, size_t jointCount){
+        if(source.mJointParents.empty() || source.mJointParents.size() != jointCount || source.mInverseBind.size() != jointCount) return false;
+
+        mNodes = source.mNodes;
+        mVertices = source.mVertices;
+        mTriangles = source.mTriangles;
+        mMaterials = source.mMaterials;
+        mShapes = source.mShapes;
+
+        // joint model matrices from the pose, parents resolved on demand since JNT1 order isn't hierarchical
+        std::vector<glm::mat4> joints(jointCount);
+        std::vector<uint8_t> resolved(jointCount, 0);
+        auto resolve = [&](size_t joint, auto& self) -> const glm::mat4& {
+            if(resolved[joint]) return joints[joint];
+
+            const float* value = pose + joint;
+            glm::vec3 scale(value[JointAnimation::ScaleX * jointCount], value[JointAnimation::ScaleY * jointCount], value[JointAnimation::ScaleZ * jointCount]);
+            glm::vec3 rotation(value[JointAnimation::RotationX * jointCount], value[JointAnimation::RotationY * jointCount], value[JointAnimation::RotationZ * jointCount]);
+            glm::vec3 translation(value[JointAnimation::TranslationX * jointCount], value[JointAnimation::TranslationY * jointCount], value[JointAnimation::TranslationZ * jointCount]);
+            glm::mat4 local = J3DFile::MakeJointMatrix(scale, glm::radians(rotation), translation);
+
+            // marked first so a malformed cycle ends instead of recursing forever
+            resolved[joint] = 1;
+            int16_t parent = source.mJointParents[joint];
+            joints[joint] = parent >= 0 && (size_t)parent < jointCount ? self((size_t)parent, self) * local : local;
+            return joints[joint];
+        };
+
+        // a draw matrix moves its vertices from the bind pose to the posed one
+        size_t drawCount = source.mDrawFirst.empty() ? 0 : source.mDrawFirst.size() - 1;
+        std::vector<glm::mat4> draws(drawCount, glm::mat4(0.0f));
+        for(size_t draw = 0; draw < drawCount; draw++){
+            for(uint32_t i = source.mDrawFirst[draw]; i < source.mDrawFirst[draw + 1]; i++){
+                const J3DFile::SkinInfluence& influence = source.mInfluences[i];
+                draws[draw] += influence.Weight * (resolve(influence.Joint, resolve) * source.mInverseBind[influence.Joint]);
+            }
+        }
+
+        for(size_t v = 0; v < mVertices.size(); v++){
+            uint16_t draw = source.mVertexDraws[v];
+            if(draw < drawCount) mVertices[v] = glm::vec3(draws[draw] * glm::vec4(mVertices[v], 1.0f));
+        }
+
+        Refit();
+        return true;
+    }
+
+    void TriangleBvh::Save(DiskCache::BlobWriter& writer) const {
+        writer.WriteArray(mNodes);
+        writer.WriteArray(mVertices);
+        writer.WriteArray(mTriangles);
+        writer.WriteArray(mMaterials);
+        writer.WriteArray(mShapes);
+        writer.WriteArray(mVertexDraws);
+        writer.WriteArray(mDrawFirst);
+        writer.WriteArray(mInfluences);
+        writer.WriteArray(mJointParents);
+        writer.WriteArray(mInverseBind);
+    }
+
+    bool TriangleBvh::Load(DiskCache::BlobReader& reader){
+        reader.ReadArray(mNodes);
+        reader.ReadArray(mVertices);
+        reader.ReadArray(mTriangles);
+        reader.ReadArray(mMaterials);
+        reader.ReadArray(mShapes);
+        reader.ReadArray(mVertexDraws);
+        reader.ReadArray(mDrawFirst);
+        reader.ReadArray(mInfluences);
+        reader.ReadArray(mJointParents);
+        reader.ReadArray(mInverseBind);
+
+        size_t count = mTriangles.size();
+        bool skinValid = mVertexDraws.empty() || (mVertexDraws.size() == count * 3 && mInverseBind.size() == mJointParents.size());
+        return mVertices.size() == count * 3 && mMaterials.size() == count && mShapes.size() == count && skinValid;
+    }
+
+    static bool IntersectBox(const glm::vec3& min, const glm::vec3& max, const glm::vec3& origin, const glm::vec3& invDir, float maxT){
+        glm::vec3 t0 = (min - origin) * invDir;
+        glm::vec3 t1 = (max - origin) * invDir;
+        glm::vec3 tNear = glm::min(t0, t1), tFar = glm::max(t0, t1);
+
+        float enter = glm::max(glm::max(tNear.x, tNear.y), glm::max(tNear.z, 0.0f));
+        float exit = glm::min(glm::min(tFar.x, tFar.y), glm::min(tFar.z, maxT));
+        return enter <= exit;
+    }
+
+    // Moller-Trumbore, double sided
+    static bool IntersectTriangle(const glm::vec3* tri, const glm::vec3& origin, const glm::vec3& dir, float& t){
+        glm::vec3 edge1 = tri[1] - tri[0], edge2 = tri[2] - tri[0];
+        glm::vec3 p = glm::cross(dir, edge2);
+        float det = glm::dot(edge1, p);
+        if(std::fabs(det) < 1e-12f) return false;
+
+        float invDet = 1.0f / det;
+        glm::vec3 s = origin - tri[0];
+        float u = glm::dot(s, p) * invDet;
+        if(u < 0.0f || u > 1.0f) return false;
+
+        glm::vec3 q = glm::cross(s, edge1);
+        float v = glm::dot(dir, q) * invDet;
+        if(v < 0.0f || u + v > 1.0f) return false;
+
+        t = glm::dot(edge2, q) * invDet;
+        return t >= 0.0f;
+    }
+
+    bool TriangleBvh::Intersect(const glm::vec3& origin, const glm::vec3& dir, float maxT, RayHit& hit) const {
+        if(mNodes.empty()) return false;
+
+        glm::vec3 invDir = 1.0f / dir;
+        bool found = false;
+
+        // median splits keep the depth near log2 of the triangle count, so the fixed stack only overflows into
+        // the heap for trees loaded from elsewhere
+        uint32_t fixedStack[64];
+        std::vector<uint32_t> heapStack;
+        uint32_t* stack = fixedStack;
+        size_t stackCapacity = 64;
+        uint32_t stackSize = 0;
+        stack[stackSize++] = 0;
+
+        while(stackSize > 0){
+            const Node& node = mNodes[stack[--stackSize]];
+            if(!IntersectBox(node.Min, node.Max, origin, invDir, maxT)) continue;
+
+            if(node.Count == 0){
+                uint32_t left = (uint32_t)(&node - mNodes.data()) + 1;
+                if(stackSize + 2 > stackCapacity){
+                    if(heapStack.empty()) heapStack.assign(fixedStack, fixedStack + stackSize);
+                    stackCapacity *= 2;
+                    heapStack.resize(stackCapacity);
+                    stack = heapStack.data();
+                }
+                stack[stackSize++] = node.First;
+                stack[stackSize++] = left;
+                continue;
+            }
+
+            for(uint32_t i = node.First; i < node.First + node.Count; i++){
+                float t;
+                if(IntersectTriangle(&mVertices[i * 3], origin, dir, t) && t < maxT){
+                    maxT = t;
+                    hit.Distance = t;
+                    hit.Triangle = mTriangles[i];
+                    hit.Material = mMaterials[i];
+                    hit.Shape = mShapes[i];
+                    found = true;
+                }
+            }
+        }
+
+        return found;
+    }
+
+    bool GetInstanceMatrix(J3DModelInstance* instance, glm::mat4& out){
+        Instances::InstanceRecord* record = Instances::Find(instance);
+        if(record == nullptr) return false;
+
+        out = glm::translate(glm::mat4(1.0f), record->Translation);
+        out *= glm::mat4_cast(glm::quat(glm::radians(record->Rotation)));
+        out = glm::scale(out, record->Scale);
+        return true;
+    }
+
+    // The posed copy is rebuilt only when JointAnimation has sampled a new pose since the last raycast.
+    static const TriangleBvh* GetPosedGeometry(Instances::InstanceRecord* record, const TriangleBvh& bind){
+        if(record->Player.Clip == nullptr || record->Pose.empty()) return &bind;
+
+        if(record->PosedGeometry == nullptr || record->PosedVersion != record->PoseVersion){
+            if(record->PosedGeometry == nullptr) record->PosedGeometry = std::make_shared<TriangleBvh>();
+            if(!record->PosedGeometry->Pose(bind, record->Pose.data(), record->Pose.size() / JointAnimation::ComponentCount)){
+                record->PosedGeometry = nullptr;
+                return &bind;
+            }
+            record->PosedVersion = record->PoseVersion;
+        }
+
+        return record->PosedGeometry.get();
+    }
+
+    bool RaycastInstances(J3DModelInstance* const* instances, size_t count, const glm::vec3& origin, const glm::vec3& dir, float maxDistance, RayHit& hit){
+        glm::vec3 worldDir = glm::normalize(dir);
+        bool found = false;
+
+        for(size_t i = 0; i < count; i++){
+            Instances::InstanceRecord* record = Instances::Find(instances[i]);
+            if(record == nullptr) continue;
+
+            Instances::ModelRecord* model = Instances::FindModel(record->Data);
+            if(model == nullptr || model->Geometry == nullptr) continue;
+
+            // reject on the conservative world sphere before transforming the ray, padded for animated instances
+            glm::vec4 sphere;
+            if(Culling::GetCullSphere(instances[i], sphere)){
+                glm::vec3 toCenter = glm::vec3(sphere) - origin;
+                float along = glm::dot(toCenter, worldDir);
+                float distSq = glm::dot(toCenter, toCenter) - along * along;
+                if(distSq > sphere.w * sphere.w || along + sphere.w < 0.0f || along - sphere.w > maxDistance) continue;
+            }
+
+            glm::mat4 model2World;
+            if(!GetInstanceMatrix(instances[i], model2World)) continue;
+
+            // an unnormalized local direction keeps t equal to the world distance
+            glm::mat4 world2Model = glm::inverse(model2World);
+            glm::vec3 localOrigin = glm::vec3(world2Model * glm::vec4(origin, 1.0f));
+            glm::vec3 localDir = glm::vec3(world2Model * glm::vec4(worldDir, 0.0f));
+
+            const TriangleBvh* geometry = GetPosedGeometry(record, *model->Geometry);
+
+            RayHit candidate;
+            if(geometry->Intersect(localOrigin, localDir, maxDistance, candidate)){
+                maxDistance = candidate.Distance;
+                candidate.Index = i;
+                hit = candidate;
+                found = true;
+            }
+        }
+
+        return found;
+    }
+
+    void ScreenRay(const glm::mat4& view, const glm::mat4& proj, float x, float y, float width, float height, glm::vec3& origin, glm::vec3& dir){
+        glm::vec4 viewport(0.0f, 0.0f, width, height);
+        glm::vec3 nearPoint = glm::unProject(glm::vec3(x, y, 0.0f), view, proj, viewport);
+        glm::vec3 farPoint = glm::unProject(glm::vec3(x, y, 1.0f), view, proj, viewport);
+
+        origin = nearPoint;
+        dir = glm::normalize(farPoint - nearPoint);
+    }
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "J3DFile.hpp"
+
+#include <glm/glm.hpp>
+
+class J3DModelInstance;
+
+namespace PyJ3D::DiskCache { class BlobWriter; class BlobReader; }
+
+namespace PyJ3D::Collision {
+    struct RayHit {
+        float Distance = 0.0f;
+        uint32_t Triangle = 0;
+        uint16_t Material = 0;
+        uint16_t Shape = 0;
+        size_t Index = 0; // which of the tested instances was hit
+    };
+
+    // Bounding volume hierarchy over a model's bind pose triangles, built once per model data.
+    // Animated instances get a posed copy whose vertices are skinned and whose bounds are refit.
+    class TriangleBvh {
+        struct Node {
+            glm::vec3 Min;
+            uint32_t First; // first triangle for leaves, right child otherwise (left child is the next node)
+            glm::vec3 Max;
+            uint32_t Count; // 0 for interior nodes
+        };
+
+        std::vector<Node> mNodes;
+        std::vector<glm::vec3> mVertices; // three per triangle, in BVH order
+        std::vector<uint32_t> mTriangles; // original triangle index of each BVH triangle
+        std::vector<uint16_t> mMaterials;
+        std::vector<uint16_t> mShapes;
+
+        // skinning, indexed like J3DFile::ModelGeometry but with vertices in BVH order
+        std::vector<uint16_t> mVertexDraws;
+        std::vector<uint32_t> mDrawFirst;
+        std::vector<J3DFile::SkinInfluence> mInfluences;
+        std::vector<int16_t> mJointParents;
+        std::vector<glm::mat4> mInverseBind;
+
+        uint32_t BuildNode(std::vector<uint32_t>& order, std::vector<glm::vec3>& centroids, const std::vector<glm::vec3>& vertices, uint32_t begin, uint32_t end);
+        void Refit();
+
+    public:
+        void Build(const J3DFile::ModelGeometry& geometry);
+        bool IsEmpty() const { return mNodes.empty(); }
+
+        // Flat native-endian copy for the disk cache, Load returns false on a truncated or mismatched blob.
+        void Save(DiskCache::BlobWriter& writer) const;
+        bool Load(DiskCache::BlobReader& reader);
+        size_t GetTriangleCount() const { return mTriangles.size(); }
+        size_t GetJointCount() const { return mJointParents.size(); }
+
+        // Becomes a copy of source with its triangles moved into pose, laid out like JointAnimation::Sample's
+        // output. False if the pose is for a different skeleton.
+        bool Pose(const TriangleBvh& source, const float* pose, size_t jointCount);
+
+        // Nearest hit along origin + dir * t for t in [0, maxT), dir doesn't need to be normalized.
+        bool Intersect(const glm::vec3& origin, const glm::vec3& dir, float maxT, RayHit& hit) const;
+    };
+
+    // World space model matrix from the transform the instance registry mirrors, rotation as euler degrees.
+    bool GetInstanceMatrix(J3DModelInstance* instance, glm::mat4& out);
+
+    // Nearest hit against the instances' geometry, instances without geometry are skipped. Instances playing a joint
+    // clip are tested in their last sampled pose, everything else in the bind pose.
+    bool RaycastInstances(J3DModelInstance* const* instances, size_t count, const glm::vec3& origin, const glm::vec3& dir, float maxDistance, RayHit& hit);
+
+    // Ray through a framebuffer pixel (origin bottom left) from the camera matrices, dir is normalized.
+    void ScreenRay(const glm::mat4& view, const glm::mat4& proj, float x, float y, float width, float height, glm::vec3& origin, glm::vec3& dir);
+}
@@ -0,0 +1,143 @@
+#include "Culling.hpp"
+#include "InstanceRegistry.hpp"
+#include "Profiler.hpp"
+#include "Simd.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include <J3D/Data/J3DModelInstance.hpp>
+
+namespace PyJ3D::Culling {
+    static CullSettings settings = {};
+    static CullStats stats = {};
+
+    // scratch reused by CullInstances
+    static SphereBatch batchSpheres = {};
+    static std::vector<uint32_t> batchIndices = {};
+    static std::vector<uint8_t> batchVisible = {};
+
+    void SetSettings(const CullSettings& newSettings){
+        settings = newSettings;
+    }
+
+    const CullSettings& GetSettings(){
+        return settings;
+    }
+
+    const CullStats& GetStats(){
+        return stats;
+    }
+
+    void Cull(const SphereBatch& spheres, const glm::mat4& view, const glm::mat4& proj, const glm::vec3& cameraPos, uint8_t* visible){
+        size_t count = spheres.Size();
+        const float* x = spheres.X.data();
+        const float* y = spheres.Y.data();
+        const float* z = spheres.Z.data();
+        const float* r = spheres.Radius.data();
+        float boundsScale = settings.BoundsScale;
+
+        // Gribb/Hartmann plane extraction, rows of the clip matrix
+        glm::mat4 clip = proj * view;
+        glm::vec4 rows[4];
+        for(int i = 0; i < 4; i++){
+            rows[i] = glm::vec4(clip[0][i], clip[1][i], clip[2][i], clip[3][i]);
+        }
+
+        glm::vec4 planes[6] = {
+            rows[3] + rows[0], rows[3] - rows[0],
+            rows[3] + rows[1], rows[3] - rows[1],
+            rows[3] + rows[2], rows[3] - rows[2]
+        };
+        for(glm::vec4& plane : planes){
+            plane /= glm::length(glm::vec3(plane));
+        }
+
+        Simd::GetKernels().CullSpheres(x, y, z, r, count, planes, boundsScale, visible);
+
+        uint32_t frustumCulled = 0, distanceCulled = 0, sizeCulled = 0;
+        for(size_t i = 0; i < count; i++){
+            frustumCulled += visible[i] == 0;
+        }
+
+        // perspective projections only, proj[1][1] is cot(fov / 2)
+        bool sizeTest = settings.MinScreenSize > 0.0f && proj[2][3] != 0.0f;
+        if(settings.MaxDistance > 0.0f || sizeTest){
+            float maxDist = settings.MaxDistance > 0.0f ? settings.MaxDistance : INFINITY;
+            float minSize = sizeTest ? settings.MinScreenSize : 0.0f;
+
+            for(size_t i = 0; i < count; i++){
+                if(!visible[i]) continue;
+
+                float dx = x[i] - cameraPos.x, dy = y[i] - cameraPos.y, dz = z[i] - cameraPos.z;
+                float dist = glm::sqrt(dx * dx + dy * dy + dz * dz);
+                float radius = r[i] * boundsScale;
+
+                if(dist - radius > maxDist){
+                    visible[i] = 0;
+                    distanceCulled++;
+                }
+                else if(dist > radius && (radius * proj[1][1]) / dist < minSize){
+                    visible[i] = 0;
+                    sizeCulled++;
+                }
+            }
+        }
+
+        stats.Tested = (uint32_t)count;
+        stats.FrustumCulled = frustumCulled;
+        stats.DistanceCulled = distanceCulled;
+        stats.SizeCulled = sizeCulled;
+        stats.Visible = (uint32_t)count - frustumCulled - distanceCulled - sizeCulled;
+        stats.Unbounded = 0;
+
+        PYJ3D_PROFILE_COUNT(CulledInstances, frustumCulled + distanceCulled + sizeCulled);
+    }
+
+    bool GetCullSphere(J3DModelInstance* instance, glm::vec4& out){
+        if(!Instances::GetWorldSphere(instance, out)) return false;
+
+        Instances::InstanceRecord* record = Instances::Find(instance);
+        bool animated = (record != nullptr && record->Player.Clip != nullptr) ||
+                        instance->GetJointAnimation() != nullptr || instance->GetJointFullAnimation() != nullptr;
+        if(animated) out.w *= settings.AnimatedBoundsScale;
+        return true;
+    }
+
+    void RecordUnbounded(uint32_t count){
+        stats.Unbounded += count;
+        stats.Visible += count;
+    }
+
+    void CullInstances(std::vector<std::shared_ptr<J3DModelInstance>>& instances, const glm::mat4& view, const glm::mat4& proj, const glm::vec3& cameraPos){
+        PYJ3D_PROFILE_STAGE(Cull);
+
+        if(!settings.Enabled){
+            stats = CullStats();
+            stats.Visible = (uint32_t)instances.size();
+            return;
+        }
+
+        batchSpheres.Clear();
+        batchIndices.clear();
+
+        for(uint32_t i = 0; i < instances.size(); i++){
+            glm::vec4 sphere;
+            if(GetCullSphere(instances[i].get(), sphere)){
+                batchSpheres.Push(sphere);
+                batchIndices.push_back(i);
+            }
+        }
+
+        batchVisible.resize(batchSpheres.Size());
+        Cull(batchSpheres, view, proj, cameraPos, batchVisible.data());
+
+        RecordUnbounded((uint32_t)(instances.size() - batchIndices.size()));
+
+        // null out culled entries, then compact keeping draw order
+        for(size_t i = 0; i < batchIndices.size(); i++){
+            if(!batchVisible[i]) instances[batchIndices[i]] = nullptr;
+        }
+        instances.erase(std::remove(instances.begin(), instances.end(), nullptr), instances.end());
+    }
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+class J3DModelInstance;
+
+namespace PyJ3D::Culling {
+    // Off by default, bounds come from the bind pose and a culled instance simply isn't drawn.
+    struct CullSettings {
+        bool Enabled = false;
+        float MaxDistance = 0.0f;   // 0 disables distance culling
+        float MinScreenSize = 0.0f; // projected diameter as a fraction of viewport height, 0 disables
+        float BoundsScale = 1.0f;   // grows every bound
+        float AnimatedBoundsScale = 2.0f; // further growth for instances with joint animation, whose pose can leave the bind pose bounds
+    };
+
+    struct CullStats {
+        uint32_t Tested = 0;
+        uint32_t Visible = 0;
+        uint32_t FrustumCulled = 0;
+        uint32_t DistanceCulled = 0;
+        uint32_t SizeCulled = 0;
+        uint32_t Unbounded = 0; // no bounds known, always drawn
+    };
+
+    // Structure-of-arrays sphere list so the plane tests vectorize.
+    struct SphereBatch {
+        std::vector<float> X, Y, Z, Radius;
+
+        void Clear(){ X.clear(); Y.clear(); Z.clear(); Radius.clear(); }
+        void Push(const glm::vec4& sphere){ X.push_back(sphere.x); Y.push_back(sphere.y); Z.push_back(sphere.z); Radius.push_back(sphere.w); }
+        size_t Size() const { return X.size(); }
+    };
+
+    void SetSettings(const CullSettings& settings);
+    const CullSettings& GetSettings();
+
+    // Counters from the most recent Cull/CullInstances call.
+    const CullStats& GetStats();
+
+    // Writes 1 to visible[i] for spheres that pass frustum/distance/size tests and 0 otherwise.
+    void Cull(const SphereBatch& spheres, const glm::mat4& view, const glm::mat4& proj, const glm::vec3& cameraPos, uint8_t* visible);
+
+    // World sphere of an instance with the animated padding applied, false if its bounds are unknown.
+    bool GetCullSphere(J3DModelInstance* instance, glm::vec4& out);
+
+    // Count instances that were drawn without a test because their bounds are unknown.
+    void RecordUnbounded(uint32_t count);
+
+    // Removes culled instances from the list in place, instances without bounds are kept.
+    void CullInstances(std::vector<std::shared_ptr<J3DModelInstance>>& instances, const glm::mat4& view, const glm::mat4& proj, const glm::vec3& cameraPos);
+}
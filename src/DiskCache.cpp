@@ -0,0 +1,152 @@
+#include "DiskCache.hpp"
+#include "Hash.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <mutex>
+
+#ifndef PYJ3D_LIBRARY_VERSION
+#define PYJ3D_LIBRARY_VERSION "unknown"
+#endif
+
+namespace PyJ3D::DiskCache {
+    // bump when any blob layout changes
+    static const uint32_t FormatVersion = 2;
+    static const char BlobMagic[4] = { 'P', 'J', '3', 'C' };
+
+    struct BlobHeader {
+        char Magic[4];
+        uint32_t Version;
+        uint32_t Kind;
+        uint32_t Reserved;
+        uint64_t Key;
+        uint64_t PayloadSize;
+        uint64_t PayloadHash;
+    };
+
+    // model records are read and written from the async loader's workers
+    static std::mutex cacheMutex;
+    static std::string directory = "";
+    static DiskCacheStats stats = {};
+
+    static std::string GetBlobName(uint32_t kind, uint64_t key){
+        char name[48];
+        std::snprintf(name, sizeof(name), "%u-%016llx.bin", kind, (unsigned long long)key);
+        return name;
+    }
+
+    static std::string GetBlobPath(BlobKind kind, uint64_t key){
+        return (std::filesystem::path(GetDirectory()) / GetBlobName((uint32_t)kind, key)).string();
+    }
+
+    // Only names that format back to themselves, so clearing never touches files we didn't write.
+    static bool IsBlobName(const std::string& name){
+        unsigned int kind = 0;
+        unsigned long long key = 0;
+        if(std::sscanf(name.c_str(), "%u-%16llx.bin", &kind, &key) != 2) return false;
+        return GetBlobName(kind, key) == name;
+    }
+
+    bool SetDirectory(const std::string& path){
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        directory = "";
+        if(path.empty()) return true;
+
+        std::error_code err;
+        std::filesystem::create_directories(path, err);
+        if(err || !std::filesystem::is_directory(path, err)) return false;
+
+        directory = path;
+        return true;
+    }
+
+    std::string GetDirectory(){
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        return directory;
+    }
+
+    bool IsEnabled(){
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        return !directory.empty();
+    }
+
+    uint64_t MakeKey(const uint8_t* data, size_t size, uint64_t salt){
+        static const uint64_t versionSeed = HashBytes((const uint8_t*)PYJ3D_LIBRARY_VERSION, std::strlen(PYJ3D_LIBRARY_VERSION), FormatVersion);
+        return HashBytes(data, size, versionSeed ^ salt);
+    }
+
+    bool Read(BlobKind kind, uint64_t key, Blob& out){
+        if(!IsEnabled()) return false;
+
+        if(!out.File.Open(GetBlobPath(kind, key))){
+            std::lock_guard<std::mutex> lock(cacheMutex);
+            stats.Misses++;
+            return false;
+        }
+
+        // validate before handing out anything, a bad blob is treated as a miss and rewritten
+        BlobHeader header;
+        const uint8_t* data = out.File.GetData();
+        bool valid = out.File.GetSize() >= sizeof(BlobHeader);
+        if(valid){
+            std::memcpy(&header, data, sizeof(BlobHeader));
+            valid = std::memcmp(header.Magic, BlobMagic, 4) == 0 && header.Version == FormatVersion && header.Kind == (uint32_t)kind &&
+                    header.Key == key && header.PayloadSize == out.File.GetSize() - sizeof(BlobHeader) &&
+                    header.PayloadHash == HashBytes(data + sizeof(BlobHeader), (size_t)header.PayloadSize);
+        }
+
+        if(!valid){
+            out.File.Close();
+            std::lock_guard<std::mutex> lock(cacheMutex);
+            stats.Rejected++;
+            stats.Misses++;
+            return false;
+        }
+
+        out.Payload = data + sizeof(BlobHeader);
+        out.Size = (size_t)header.PayloadSize;
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        stats.Hits++;
+        stats.BytesRead += out.Size;
+        return true;
+    }
+
+    bool Write(BlobKind kind, uint64_t key, const void* payload, size_t size){
+        if(!IsEnabled()) return false;
+
+        BlobHeader header;
+        std::memcpy(header.Magic, BlobMagic, 4);
+        header.Version = FormatVersion;
+        header.Kind = (uint32_t)kind;
+        header.Reserved = 0;
+        header.Key = key;
+        header.PayloadSize = size;
+        header.PayloadHash = HashBytes((const uint8_t*)payload, size);
+
+        std::vector<uint8_t> bytes(sizeof(BlobHeader) + size);
+        std::memcpy(bytes.data(), &header, sizeof(BlobHeader));
+        std::memcpy(bytes.data() + sizeof(BlobHeader), payload, size);
+
+        if(!Files::WriteFileAtomic(GetBlobPath(kind, key), bytes.data(), bytes.size())) return false;
+
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        stats.Writes++;
+        stats.BytesWritten += size;
+        return true;
+    }
+
+    void Clear(){
+        if(!IsEnabled()) return;
+
+        std::error_code err;
+        for(const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator(GetDirectory(), err)){
+            if(entry.is_regular_file(err) && IsBlobName(entry.path().filename().string())) std::filesystem::remove(entry.path(), err);
+        }
+    }
+
+    DiskCacheStats GetStats(){
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        return stats;
+    }
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include "FileUtil.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace PyJ3D::DiskCache {
+    // What a blob holds, part of the file name so kinds never collide.
+    enum class BlobKind : uint32_t {
+        ModelData = 1,     // bounds and raycast BVH derived from a model file
+        ProgramBinary = 2, // linked GL program binary
+        TextureLevel = 3   // one TEX1 level decoded to RGBA8
+    };
+
+    struct DiskCacheStats {
+        uint64_t Hits = 0;
+        uint64_t Misses = 0;
+        uint64_t Writes = 0;
+        uint64_t Rejected = 0; // present but stale or corrupt
+        uint64_t BytesRead = 0;
+        uint64_t BytesWritten = 0;
+    };
+
+    // A mapped blob, Payload points into the mapping and is valid while the Blob lives.
+    struct Blob {
+        Files::MappedFile File;
+        const uint8_t* Payload = nullptr;
+        size_t Size = 0;
+    };
+
+    // Empty path disables the cache (the default). The directory is created if needed.
+    // Reads and writes are safe from worker threads.
+    bool SetDirectory(const std::string& path);
+    std::string GetDirectory();
+    bool IsEnabled();
+
+    // Key for content plus everything that changes how it's processed: cache format and library version.
+    uint64_t MakeKey(const uint8_t* data, size_t size, uint64_t salt = 0);
+
+    bool Read(BlobKind kind, uint64_t key, Blob& out);
+    bool Write(BlobKind kind, uint64_t key, const void* payload, size_t size);
+
+    // Deletes every blob in the directory, other files are left alone.
+    void Clear();
+    DiskCacheStats GetStats();
+
+    // Little helpers for the flat native-endian payloads blobs hold.
+    class BlobWriter {
+        std::vector<uint8_t> mBytes;
+
+    public:
+        template<typename T>
+        void Write(const T& value){
+            const uint8_t* bytes = (const uint8_t*)&value;
+            mBytes.insert(mBytes.end(), bytes, bytes + sizeof(T));
+        }
+
+        template<typename T>
+        void WriteArray(const std::vector<T>& values){
+            Write((uint64_t)values.size());
+            const uint8_t* bytes = (const uint8_t*)values.data();
+            mBytes.insert(mBytes.end(), bytes, bytes + values.size() * sizeof(T));
+        }
+
+        const std::vector<uint8_t>& GetBytes() const { return mBytes; }
+    };
+
+    class BlobReader {
+        const uint8_t* mData;
+        size_t mSize;
+        size_t mOffset = 0;
+        bool mFailed = false;
+
+    public:
+        BlobReader(const uint8_t* data, size_t size) : mData(data), mSize(size) {}
+
+        template<typename T>
+        T Read(){
+            T value = {};
+            if(mFailed || mOffset + sizeof(T) > mSize){
+                mFailed = true;
+                return value;
+            }
+            std::memcpy(&value, mData + mOffset, sizeof(T));
+            mOffset += sizeof(T);
+            return value;
+        }
+
+        template<typename T>
+        void ReadArray(std::vector<T>& out){
+            uint64_t count = Read<uint64_t>();
+            if(mFailed || count > (mSize - mOffset) / sizeof(T)){
+                mFailed = true;
+                return;
+            }
+            out.resize((size_t)count);
+            std::memcpy(out.data(), mData + mOffset, (size_t)count * sizeof(T));
+            mOffset += (size_t)count * sizeof(T);
+        }
+
+        // true if every read stayed in bounds and the whole payload was consumed
+        bool IsComplete() const { return !mFailed && mOffset == mSize; }
+    };
+}
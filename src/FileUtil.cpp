@@ -0,0 +1,135 @@
+#include "FileUtil.hpp"
+
+#include <chrono>
+#include <fstream>
+#include <filesystem>
+#include <functional>
+#include <thread>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace PyJ3D::Files {
+    bool ReadFile(const std::string& path, std::vector<uint8_t>& out){
+        std::ifstream file(path, std::ios::binary | std::ios::ate);
+        if(!file.is_open()) return false;
+
+        std::streamsize size = file.tellg();
+        file.seekg(0, std::ios::beg);
+
+        out.resize((size_t)size);
+        return (bool)file.read((char*)out.data(), size);
+    }
+
+    bool WriteFileAtomic(const std::string& path, const void* data, size_t size){
+        // unique per writer so concurrent processes and threads populating the same cache don't interleave
+        std::string tempPath = path + "." + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()) + "-" +
+                               std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".tmp";
+        {
+            std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+            if(!file.is_open()) return false;
+            if(!file.write((const char*)data, size)) return false;
+        }
+
+        std::error_code err;
+        std::filesystem::rename(tempPath, path, err);
+        if(err) std::filesystem::remove(tempPath, err);
+        return !err;
+    }
+
+    bool MapFile(const std::string& path, SharedBytes& out, bool copyOnWrite){
+        std::shared_ptr<MappedFile> file = std::make_shared<MappedFile>();
+        if(!file->Open(path, copyOnWrite)) return false;
+
+        out.Data = file->GetData();
+        out.Size = file->GetSize();
+        out.Owner = file;
+        out.Patchable = file->GetPatchableData();
+        return true;
+    }
+
+    SharedBytes FromVector(std::vector<uint8_t> data){
+        std::shared_ptr<std::vector<uint8_t>> owner = std::make_shared<std::vector<uint8_t>>(std::move(data));
+        return { owner->data(), owner->size(), owner };
+    }
+
+#ifdef _WIN32
+    bool MappedFile::Open(const std::string& path, bool copyOnWrite){
+        Close();
+
+        HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if(file == INVALID_HANDLE_VALUE) return false;
+
+        LARGE_INTEGER size;
+        if(!GetFileSizeEx(file, &size) || size.QuadPart == 0){
+            CloseHandle(file);
+            return false;
+        }
+
+        HANDLE mapping = CreateFileMappingA(file, nullptr, copyOnWrite ? PAGE_WRITECOPY : PAGE_READONLY, 0, 0, nullptr);
+        const void* view = mapping != nullptr ? MapViewOfFile(mapping, copyOnWrite ? FILE_MAP_COPY : FILE_MAP_READ, 0, 0, 0) : nullptr;
+        if(view == nullptr){
+            if(mapping != nullptr) CloseHandle(mapping);
+            CloseHandle(file);
+            return false;
+        }
+
+        mFile = file;
+        mMapping = mapping;
+        mData = (const uint8_t*)view;
+        mSize = (size_t)size.QuadPart;
+        mCopyOnWrite = copyOnWrite;
+        return true;
+    }
+
+    void MappedFile::Close(){
+        if(mData != nullptr) UnmapViewOfFile(mData);
+        if(mMapping != nullptr) CloseHandle(mMapping);
+        if(mFile != nullptr) CloseHandle(mFile);
+
+        mData = nullptr;
+        mMapping = mFile = nullptr;
+        mSize = 0;
+        mCopyOnWrite = false;
+    }
+#else
+    bool MappedFile::Open(const std::string& path, bool copyOnWrite){
+        Close();
+
+        int fd = open(path.c_str(), O_RDONLY);
+        if(fd < 0) return false;
+
+        struct stat info;
+        if(fstat(fd, &info) != 0 || info.st_size == 0){
+            close(fd);
+            return false;
+        }
+
+        // the mapping stays valid after the descriptor is closed, MAP_PRIVATE keeps writes out of the file
+        void* view = mmap(nullptr, (size_t)info.st_size, copyOnWrite ? PROT_READ | PROT_WRITE : PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if(view == MAP_FAILED) return false;
+
+        mData = (const uint8_t*)view;
+        mSize = (size_t)info.st_size;
+        mCopyOnWrite = copyOnWrite;
+        return true;
+    }
+
+    void MappedFile::Close(){
+        if(mData != nullptr) munmap((void*)mData, mSize);
+
+        mData = nullptr;
+        mSize = 0;
+        mCopyOnWrite = false;
+    }
+#endif
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace PyJ3D::Files {
+    // Reads a whole file into out, false if it couldn't be opened or read.
+    bool ReadFile(const std::string& path, std::vector<uint8_t>& out);
+
+    // Writes to a temporary next to path and renames it over path, so readers never see a partial file.
+    bool WriteFileAtomic(const std::string& path, const void* data, size_t size);
+
+    // Read-only bytes plus whatever keeps them alive: a mapping, a vector or a Python buffer.
+    struct SharedBytes {
+        const uint8_t* Data = nullptr;
+        size_t Size = 0;
+        std::shared_ptr<const void> Owner;
+        uint8_t* Patchable = nullptr; // Data again when it is a private copy-on-write mapping, null otherwise
+    };
+
+    // Maps path and hands out the mapping as SharedBytes, the file is unmapped when the last copy goes.
+    bool MapFile(const std::string& path, SharedBytes& out, bool copyOnWrite = false);
+    SharedBytes FromVector(std::vector<uint8_t> data);
+
+    // Read-only mapping of a whole file, unmapped on Close or destruction. Opened copy-on-write it can be patched
+    // through GetPatchableData, only the pages written to get private copies and the file itself never changes.
+    class MappedFile {
+        const uint8_t* mData = nullptr;
+        size_t mSize = 0;
+        bool mCopyOnWrite = false;
+#ifdef _WIN32
+        void* mFile = nullptr;
+        void* mMapping = nullptr;
+#endif
+
+    public:
+        MappedFile() = default;
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+        ~MappedFile() { Close(); }
+
+        bool Open(const std::string& path, bool copyOnWrite = false);
+        void Close();
+
+        bool IsOpen() const { return mData != nullptr; }
+        const uint8_t* GetData() const { return mData; }
+        size_t GetSize() const { return mSize; }
+        uint8_t* GetPatchableData() const { return mCopyOnWrite ? (uint8_t*)mData : nullptr; }
+    };
+}
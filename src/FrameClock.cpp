@@ -0,0 +1,21 @@
+#include "FrameClock.hpp"
+
+#include <atomic>
+
+namespace PyJ3D::FrameClock {
+    static std::atomic<uint64_t> frame { 1 };
+    static std::atomic<bool> manual { false };
+
+    uint64_t GetFrame(){
+        return frame.load(std::memory_order_acquire);
+    }
+
+    void BeginFrame(){
+        manual.store(true, std::memory_order_release);
+        frame.fetch_add(1, std::memory_order_acq_rel);
+    }
+
+    void BeginRender(){
+        if(!manual.load(std::memory_order_acquire)) frame.fetch_add(1, std::memory_order_acq_rel);
+    }
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <cstdint>
+
+namespace PyJ3D::FrameClock {
+    // Id of the frame being rendered. Animation state advances at most once per id, so several renderers, scenes
+    // or views drawing the same instance in one frame don't speed its animation up.
+    uint64_t GetFrame();
+
+    // Starts a new frame. After the first call frames only advance here, before it every render call starts one.
+    void BeginFrame();
+
+    // Called by the renderers as a render starts, advances the frame unless BeginFrame has taken over.
+    void BeginRender();
+}
@@ -0,0 +1,281 @@
+#include "GlRedirect.hpp"
+
+#include <algorithm>
+#include <vector>
+
+namespace PyJ3D::GlRedirect {
+    // One indexed binding point the library bound its UBO to, size 0 for glBindBufferBase.
+    struct UboBinding {
+        GLuint Index;
+        GLintptr Offset;
+        GLsizeiptr Size;
+    };
+
+    static GLuint libraryUbo = 0;
+    static GLsizeiptr uboSize = 0;
+    static std::vector<UboBinding> uboBindings = {};
+
+    static GLuint libraryPickFramebuffer = 0;
+    static uint32_t pickWidth = 0, pickHeight = 0;
+    static GLenum pickFormat = GL_NONE;
+    static std::vector<GLuint> rendererFramebuffers = {};
+
+    // what the bound Targets stand in with on this thread, 0 while none is bound
+    static thread_local GLuint activeUbo = 0;
+    static thread_local GLuint activePickFramebuffer = 0;
+
+    static PFNGLBINDBUFFERPROC realBindBuffer = nullptr;
+    static PFNGLBINDBUFFERBASEPROC realBindBufferBase = nullptr;
+    static PFNGLBINDBUFFERRANGEPROC realBindBufferRange = nullptr;
+    static PFNGLNAMEDBUFFERSUBDATAPROC realNamedBufferSubData = nullptr;
+    static PFNGLBINDFRAMEBUFFERPROC realBindFramebuffer = nullptr;
+    static PFNGLCLEARNAMEDFRAMEBUFFERIVPROC realClearNamedFramebufferiv = nullptr;
+    static PFNGLCLEARNAMEDFRAMEBUFFERUIVPROC realClearNamedFramebufferuiv = nullptr;
+    static PFNGLCLEARNAMEDFRAMEBUFFERFVPROC realClearNamedFramebufferfv = nullptr;
+    static PFNGLCLEARNAMEDFRAMEBUFFERFIPROC realClearNamedFramebufferfi = nullptr;
+
+    static GLuint Ubo(GLuint buffer){
+        return activeUbo != 0 && buffer != 0 && buffer == libraryUbo ? activeUbo : buffer;
+    }
+
+    static GLuint UniformBuffer(GLenum target, GLuint buffer){
+        return target == GL_UNIFORM_BUFFER ? Ubo(buffer) : buffer;
+    }
+
+    static GLuint Framebuffer(GLuint framebuffer){
+        return activePickFramebuffer != 0 && framebuffer != 0 && framebuffer == libraryPickFramebuffer ? activePickFramebuffer : framebuffer;
+    }
+
+    static void APIENTRY RedirectBindBuffer(GLenum target, GLuint buffer){
+        realBindBuffer(target, UniformBuffer(target, buffer));
+    }
+
+    static void APIENTRY RedirectBindBufferBase(GLenum target, GLuint index, GLuint buffer){
+        realBindBufferBase(target, index, UniformBuffer(target, buffer));
+    }
+
+    static void APIENTRY RedirectBindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size){
+        realBindBufferRange(target, index, UniformBuffer(target, buffer), offset, size);
+    }
+
+    static void APIENTRY RedirectNamedBufferSubData(GLuint buffer, GLintptr offset, GLsizeiptr size, const void* data){
+        realNamedBufferSubData(Ubo(buffer), offset, size, data);
+    }
+
+    static void APIENTRY RedirectBindFramebuffer(GLenum target, GLuint framebuffer){
+        realBindFramebuffer(target, Framebuffer(framebuffer));
+    }
+
+    static void APIENTRY RedirectClearNamedFramebufferiv(GLuint framebuffer, GLenum buffer, GLint drawbuffer, const GLint* value){
+        realClearNamedFramebufferiv(Framebuffer(framebuffer), buffer, drawbuffer, value);
+    }
+
+    static void APIENTRY RedirectClearNamedFramebufferuiv(GLuint framebuffer, GLenum buffer, GLint drawbuffer, const GLuint* value){
+        realClearNamedFramebufferuiv(Framebuffer(framebuffer), buffer, drawbuffer, value);
+    }
+
+    static void APIENTRY RedirectClearNamedFramebufferfv(GLuint framebuffer, GLenum buffer, GLint drawbuffer, const GLfloat* value){
+        realClearNamedFramebufferfv(Framebuffer(framebuffer), buffer, drawbuffer, value);
+    }
+
+    static void APIENTRY RedirectClearNamedFramebufferfi(GLuint framebuffer, GLenum buffer, GLint drawbuffer, GLfloat depth, GLint stencil){
+        realClearNamedFramebufferfi(Framebuffer(framebuffer), buffer, drawbuffer, depth, stencil);
+    }
+
+    template<typename Fn>
+    static void Wrap(Fn& entry, Fn& real, Fn wrapper){
+        if(entry == nullptr || real != nullptr) return;
+        real = entry;
+        entry = wrapper;
+    }
+
+    template<typename Fn>
+    static void Unwrap(Fn& entry, Fn& real){
+        if(real == nullptr) return;
+        entry = real;
+        real = nullptr;
+    }
+
+    static void BindUboBindings(GLuint buffer){
+        for(const UboBinding& binding : uboBindings){
+            if(binding.Size == 0) glBindBufferBase(GL_UNIFORM_BUFFER, binding.Index, buffer);
+            else glBindBufferRange(GL_UNIFORM_BUFFER, binding.Index, buffer, binding.Offset, binding.Size);
+        }
+    }
+
+    void Install(){
+        // the library binds its UBO once when it is created and nothing else has bound uniform buffers yet
+        GLint count = 0;
+        glGetIntegerv(GL_MAX_UNIFORM_BUFFER_BINDINGS, &count);
+        for(GLint i = 0; i < count; i++){
+            GLint buffer = 0;
+            glGetIntegeri_v(GL_UNIFORM_BUFFER_BINDING, i, &buffer);
+            if(buffer == 0 || (libraryUbo != 0 && (GLuint)buffer != libraryUbo)) continue;
+            libraryUbo = (GLuint)buffer;
+
+            GLint64 start = 0, size = 0;
+            glGetInteger64i_v(GL_UNIFORM_BUFFER_START, i, &start);
+            glGetInteger64i_v(GL_UNIFORM_BUFFER_SIZE, i, &size);
+            uboBindings.push_back({ (GLuint)i, (GLintptr)start, (GLsizeiptr)size });
+        }
+
+        if(libraryUbo != 0){
+            GLint previous = 0;
+            GLint64 size = 0;
+            glGetIntegerv(GL_COPY_READ_BUFFER_BINDING, &previous);
+            glBindBuffer(GL_COPY_READ_BUFFER, libraryUbo);
+            glGetBufferParameteri64v(GL_COPY_READ_BUFFER, GL_BUFFER_SIZE, &size);
+            glBindBuffer(GL_COPY_READ_BUFFER, (GLuint)previous);
+            uboSize = (GLsizeiptr)size;
+        }
+
+        Wrap(glad_glBindBuffer, realBindBuffer, RedirectBindBuffer);
+        Wrap(glad_glBindBufferBase, realBindBufferBase, RedirectBindBufferBase);
+        Wrap(glad_glBindBufferRange, realBindBufferRange, RedirectBindBufferRange);
+        Wrap(glad_glNamedBufferSubData, realNamedBufferSubData, RedirectNamedBufferSubData);
+        Wrap(glad_glBindFramebuffer, realBindFramebuffer, RedirectBindFramebuffer);
+        Wrap(glad_glClearNamedFramebufferiv, realClearNamedFramebufferiv, RedirectClearNamedFramebufferiv);
+        Wrap(glad_glClearNamedFramebufferuiv, realClearNamedFramebufferuiv, RedirectClearNamedFramebufferuiv);
+        Wrap(glad_glClearNamedFramebufferfv, realClearNamedFramebufferfv, RedirectClearNamedFramebufferfv);
+        Wrap(glad_glClearNamedFramebufferfi, realClearNamedFramebufferfi, RedirectClearNamedFramebufferfi);
+    }
+
+    void Uninstall(){
+        Unwrap(glad_glBindBuffer, realBindBuffer);
+        Unwrap(glad_glBindBufferBase, realBindBufferBase);
+        Unwrap(glad_glBindBufferRange, realBindBufferRange);
+        Unwrap(glad_glNamedBufferSubData, realNamedBufferSubData);
+        Unwrap(glad_glBindFramebuffer, realBindFramebuffer);
+        Unwrap(glad_glClearNamedFramebufferiv, realClearNamedFramebufferiv);
+        Unwrap(glad_glClearNamedFramebufferuiv, realClearNamedFramebufferuiv);
+        Unwrap(glad_glClearNamedFramebufferfv, realClearNamedFramebufferfv);
+        Unwrap(glad_glClearNamedFramebufferfi, realClearNamedFramebufferfi);
+
+        libraryUbo = 0;
+        uboSize = 0;
+        uboBindings.clear();
+        libraryPickFramebuffer = 0;
+        pickWidth = pickHeight = 0;
+        pickFormat = GL_NONE;
+        rendererFramebuffers.clear();
+    }
+
+    void SetPickingFramebuffer(GLuint framebuffer, uint32_t width, uint32_t height, GLenum colorFormat){
+        libraryPickFramebuffer = framebuffer;
+        pickWidth = width;
+        pickHeight = height;
+        pickFormat = colorFormat;
+    }
+
+    bool IsRendererFramebuffer(GLuint framebuffer){
+        return std::find(rendererFramebuffers.begin(), rendererFramebuffers.end(), framebuffer) != rendererFramebuffers.end();
+    }
+
+    static void DeleteFramebuffer(GLuint& framebuffer){
+        if(framebuffer == 0) return;
+        rendererFramebuffers.erase(std::remove(rendererFramebuffers.begin(), rendererFramebuffers.end(), framebuffer), rendererFramebuffers.end());
+        glDeleteFramebuffers(1, &framebuffer);
+        framebuffer = 0;
+    }
+
+    bool Targets::CreateUbo(){
+        if(libraryUbo == 0 || uboSize == 0) return false;
+
+        GLint previousRead = 0, previousWrite = 0;
+        glGetIntegerv(GL_COPY_READ_BUFFER_BINDING, &previousRead);
+        glGetIntegerv(GL_COPY_WRITE_BUFFER_BINDING, &previousWrite);
+
+        // starts from whatever the library's holds, state it only uploads once carries over
+        glGenBuffers(1, &mUbo);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, mUbo);
+        glBufferData(GL_COPY_WRITE_BUFFER, uboSize, nullptr, GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_COPY_READ_BUFFER, libraryUbo);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, uboSize);
+
+        glBindBuffer(GL_COPY_READ_BUFFER, (GLuint)previousRead);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, (GLuint)previousWrite);
+        return true;
+    }
+
+    // Follows the library's picking framebuffer size, the picks PickQueue reads back are in its pixels.
+    void Targets::ResizePicking(){
+        if(libraryPickFramebuffer == 0 || (mPickFramebuffer != 0 && mPickWidth == pickWidth && mPickHeight == pickHeight)) return;
+
+        DeleteFramebuffer(mPickFramebuffer);
+        if(mPickColor != 0) glDeleteTextures(1, &mPickColor);
+        if(mPickDepth != 0) glDeleteRenderbuffers(1, &mPickDepth);
+
+        GLint previousFramebuffer = 0, previousTexture = 0, previousRenderbuffer = 0;
+        glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previousFramebuffer);
+        glGetIntegerv(GL_TEXTURE_BINDING_2D, &previousTexture);
+        glGetIntegerv(GL_RENDERBUFFER_BINDING, &previousRenderbuffer);
+
+        bool unsignedFormat = pickFormat == GL_R32UI;
+        glGenTextures(1, &mPickColor);
+        glBindTexture(GL_TEXTURE_2D, mPickColor);
+        glTexImage2D(GL_TEXTURE_2D, 0, unsignedFormat ? GL_R32UI : GL_R32I, pickWidth, pickHeight, 0, GL_RED_INTEGER, unsignedFormat ? GL_UNSIGNED_INT : GL_INT, nullptr);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+        glGenRenderbuffers(1, &mPickDepth);
+        glBindRenderbuffer(GL_RENDERBUFFER, mPickDepth);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, pickWidth, pickHeight);
+
+        glGenFramebuffers(1, &mPickFramebuffer);
+        rendererFramebuffers.push_back(mPickFramebuffer);
+        glBindFramebuffer(GL_FRAMEBUFFER, mPickFramebuffer);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, mPickColor, 0);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, mPickDepth);
+
+        glBindFramebuffer(GL_FRAMEBUFFER, (GLuint)previousFramebuffer);
+        glBindTexture(GL_TEXTURE_2D, (GLuint)previousTexture);
+        glBindRenderbuffer(GL_RENDERBUFFER, (GLuint)previousRenderbuffer);
+
+        mPickWidth = pickWidth;
+        mPickHeight = pickHeight;
+    }
+
+    void Targets::Bind(){
+        if(mUbo == 0) CreateUbo();
+        ResizePicking();
+
+        activeUbo = mUbo;
+        activePickFramebuffer = libraryPickFramebuffer != 0 ? mPickFramebuffer : 0;
+        if(mUbo == 0) return;
+
+        BindUboBindings(mUbo);
+        GLint generic = 0;
+        glGetIntegerv(GL_UNIFORM_BUFFER_BINDING, &generic);
+        if((GLuint)generic == libraryUbo) glBindBuffer(GL_UNIFORM_BUFFER, mUbo);
+    }
+
+    void Targets::Unbind(){
+        // cleared first so the rebinds below aren't redirected straight back
+        activeUbo = 0;
+        activePickFramebuffer = 0;
+        if(mUbo == 0) return;
+
+        BindUboBindings(libraryUbo);
+        GLint generic = 0;
+        glGetIntegerv(GL_UNIFORM_BUFFER_BINDING, &generic);
+        if((GLuint)generic == mUbo) glBindBuffer(GL_UNIFORM_BUFFER, libraryUbo);
+    }
+
+    void Targets::Destroy(){
+        if(mUbo != 0) glDeleteBuffers(1, &mUbo);
+        DeleteFramebuffer(mPickFramebuffer);
+        if(mPickColor != 0) glDeleteTextures(1, &mPickColor);
+        if(mPickDepth != 0) glDeleteRenderbuffers(1, &mPickDepth);
+
+        mUbo = mPickColor = mPickDepth = 0;
+        mPickWidth = mPickHeight = 0;
+    }
+
+    ScopedTargets::ScopedTargets(Targets* targets) : mTargets(targets) {
+        if(mTargets != nullptr) mTargets->Bind();
+    }
+
+    ScopedTargets::~ScopedTargets(){
+        if(mTargets != nullptr) mTargets->Unbind();
+    }
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+
+#include <glad/glad.h>
+
+namespace PyJ3D::GlRedirect {
+    // Finds J3DUltra's material UBO by the uniform buffer bindings it left behind, and wraps the glad entry points
+    // that bind or write it or the picking framebuffer. Call once J3DUniformBufferObject::CreateUBO has run.
+    void Install();
+    void Uninstall();
+
+    // The library's picking framebuffer and its color format, as PickQueue finds it after init or resize. 0 when picking is off.
+    void SetPickingFramebuffer(GLuint framebuffer, uint32_t width, uint32_t height, GLenum colorFormat);
+
+    // Whether framebuffer is one of the renderers' own picking targets, which look just like the library's.
+    bool IsRendererFramebuffer(GLuint framebuffer);
+
+    // A renderer's own material UBO and picking target. While bound on a thread, J3DUltra's binds and writes of its
+    // UBO and picking framebuffer from that thread land on these instead, so renderers keep their camera and picks
+    // apart without re-uploading anything. Created on first bind, the UBO starts as a copy of the library's.
+    class Targets {
+        GLuint mUbo = 0;
+        GLuint mPickFramebuffer = 0;
+        GLuint mPickColor = 0;
+        GLuint mPickDepth = 0;
+        uint32_t mPickWidth = 0, mPickHeight = 0;
+
+        bool CreateUbo();
+        void ResizePicking();
+
+    public:
+        // Call with the context lock held, one Targets is bound per thread at a time.
+        void Bind();
+        void Unbind();
+
+        // GL objects aren't freed on destruction since the context may already be gone.
+        void Destroy();
+    };
+
+    // Binds targets for a scope, nothing when targets is null.
+    class ScopedTargets {
+        Targets* mTargets;
+
+    public:
+        explicit ScopedTargets(Targets* targets);
+        ~ScopedTargets();
+        ScopedTargets(const ScopedTargets&) = delete;
+        ScopedTargets& operator=(const ScopedTargets&) = delete;
+    };
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+namespace PyJ3D {
+    // 64-bit content hash, consumes 8 bytes per step so large archives hash at memory speed.
+    inline uint64_t HashBytes(const uint8_t* data, size_t size, uint64_t seed = 0x9E3779B97F4A7C15ull){
+        const uint64_t mul = 0xFF51AFD7ED558CCDull;
+        uint64_t h = seed ^ (size * mul);
+
+        size_t i = 0;
+        for(; i + 8 <= size; i += 8){
+            uint64_t k;
+            std::memcpy(&k, data + i, sizeof(k));
+            k *= mul;
+            k ^= k >> 33;
+            h = (h ^ k) * 0xC4CEB9FE1A85EC53ull;
+            h ^= h >> 29;
+        }
+
+        uint64_t tail = 0;
+        for(size_t s = 0; i < size; i++, s += 8){
+            tail |= (uint64_t)data[i] << s;
+        }
+        h ^= tail * mul;
+
+        h ^= h >> 33;
+        h *= 0xFF51AFD7ED558CCDull;
+        h ^= h >> 33;
+        h *= 0xC4CEB9FE1A85EC53ull;
+        h ^= h >> 33;
+        return h;
+    }
+}
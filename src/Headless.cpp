@@ -0,0 +1,226 @@
+#include "Headless.hpp"
+
+#include <algorithm>
+#include <vector>
+
+#ifdef PYJ3D_HAS_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+namespace PyJ3D::Headless {
+#ifdef PYJ3D_HAS_EGL
+    static EGLDisplay display = EGL_NO_DISPLAY;
+    static EGLContext context = EGL_NO_CONTEXT;
+
+    // Mesa's surfaceless platform needs no GPU or display server (llvmpipe on CI), fall back to the default display
+    static EGLDisplay OpenDisplay(){
+#ifdef EGL_PLATFORM_SURFACELESS_MESA
+        auto getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+        if(getPlatformDisplay != nullptr){
+            EGLDisplay surfaceless = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+            if(surfaceless != EGL_NO_DISPLAY) return surfaceless;
+        }
+#endif
+
+        return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    }
+
+    bool CreateContext(std::string& error){
+        if(context != EGL_NO_CONTEXT) return true;
+
+        display = OpenDisplay();
+        if(display == EGL_NO_DISPLAY || !eglInitialize(display, nullptr, nullptr)){
+            error = "Couldn't open an EGL display";
+            display = EGL_NO_DISPLAY;
+            return false;
+        }
+
+        if(!eglBindAPI(EGL_OPENGL_API)){
+            error = "EGL display doesn't support desktop OpenGL";
+            DestroyContext();
+            return false;
+        }
+
+        // newest core profile the driver will give us
+        static const EGLint versions[][2] = { { 4, 6 }, { 4, 5 }, { 4, 3 }, { 4, 1 }, { 3, 3 } };
+        for(const EGLint* version : versions){
+            const EGLint attributes[] = {
+                EGL_CONTEXT_MAJOR_VERSION, version[0],
+                EGL_CONTEXT_MINOR_VERSION, version[1],
+                EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+                EGL_NONE
+            };
+
+            context = eglCreateContext(display, EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT, attributes);
+            if(context != EGL_NO_CONTEXT) break;
+        }
+
+        if(context == EGL_NO_CONTEXT || !eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context)){
+            error = "Couldn't create a surfaceless OpenGL context";
+            DestroyContext();
+            return false;
+        }
+
+        return true;
+    }
+
+    void DestroyContext(){
+        if(display == EGL_NO_DISPLAY) return;
+
+        eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        if(context != EGL_NO_CONTEXT) eglDestroyContext(display, context);
+        eglTerminate(display);
+
+        context = EGL_NO_CONTEXT;
+        display = EGL_NO_DISPLAY;
+    }
+
+    bool HasContext(){
+        return context != EGL_NO_CONTEXT;
+    }
+
+    bool IsCurrent(){
+        return context != EGL_NO_CONTEXT && eglGetCurrentContext() == context;
+    }
+
+    bool MakeCurrent(){
+        if(context == EGL_NO_CONTEXT) return false;
+        return eglGetCurrentContext() == context || eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context);
+    }
+
+    void ReleaseCurrent(){
+        if(IsCurrent()) eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    }
+
+    void* GetProcAddress(const char* name){
+        return (void*)eglGetProcAddress(name);
+    }
+#else
+    bool CreateContext(std::string& error){
+        error = "J3DUltra was built without EGL, headless rendering is unavailable";
+        return false;
+    }
+
+    void DestroyContext(){}
+
+    bool HasContext(){
+        return false;
+    }
+
+    bool IsCurrent(){
+        return false;
+    }
+
+    bool MakeCurrent(){
+        return false;
+    }
+
+    void ReleaseCurrent(){}
+
+    void* GetProcAddress([[maybe_unused]] const char* name){
+        return nullptr;
+    }
+#endif
+
+    bool OffscreenTarget::Resize(uint32_t width, uint32_t height){
+        if(width == mWidth && height == mHeight && mFramebuffer != 0) return true;
+
+        Destroy();
+        mWidth = width;
+        mHeight = height;
+
+        glGenFramebuffers(1, &mFramebuffer);
+        glGenRenderbuffers(1, &mColor);
+        glGenRenderbuffers(1, &mDepth);
+
+        glBindRenderbuffer(GL_RENDERBUFFER, mColor);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+        glBindRenderbuffer(GL_RENDERBUFFER, mDepth);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT32F, width, height);
+        glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+        GLint previous = 0;
+        glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previous);
+
+        glBindFramebuffer(GL_FRAMEBUFFER, mFramebuffer);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, mColor);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, mDepth);
+        bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+        glBindFramebuffer(GL_FRAMEBUFFER, previous);
+
+        if(!complete) Destroy();
+        return complete;
+    }
+
+    void OffscreenTarget::Destroy(){
+        if(mFramebuffer != 0) glDeleteFramebuffers(1, &mFramebuffer);
+        if(mColor != 0) glDeleteRenderbuffers(1, &mColor);
+        if(mDepth != 0) glDeleteRenderbuffers(1, &mDepth);
+
+        mFramebuffer = mColor = mDepth = 0;
+        mWidth = mHeight = 0;
+    }
+
+    void OffscreenTarget::Bind(){
+        glGetIntegerv(GL_FRAMEBUFFER_BINDING, &mPreviousFramebuffer);
+        glGetIntegerv(GL_VIEWPORT, mPreviousViewport);
+
+        glBindFramebuffer(GL_FRAMEBUFFER, mFramebuffer);
+        glViewport(0, 0, mWidth, mHeight);
+    }
+
+    void OffscreenTarget::Unbind(){
+        glBindFramebuffer(GL_FRAMEBUFFER, mPreviousFramebuffer);
+        glViewport(mPreviousViewport[0], mPreviousViewport[1], mPreviousViewport[2], mPreviousViewport[3]);
+    }
+
+    template<typename T>
+    static void FlipRows(T* pixels, size_t rowLength, uint32_t rows){
+        if(rows < 2) return;
+
+        std::vector<T> scratch(rowLength);
+        for(uint32_t top = 0, bottom = rows - 1; top < bottom; top++, bottom--){
+            std::copy_n(pixels + top * rowLength, rowLength, scratch.data());
+            std::copy_n(pixels + bottom * rowLength, rowLength, pixels + top * rowLength);
+            std::copy_n(scratch.data(), rowLength, pixels + bottom * rowLength);
+        }
+    }
+
+    // Read framebuffer, pack buffer and alignment for one readback into client memory, put back as they were after.
+    struct ScopedReadback {
+        GLint ReadFramebuffer = 0, PackBuffer = 0, PackAlignment = 4;
+
+        ScopedReadback(GLuint framebuffer, GLint alignment){
+            glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &ReadFramebuffer);
+            glGetIntegerv(GL_PIXEL_PACK_BUFFER_BINDING, &PackBuffer);
+            glGetIntegerv(GL_PACK_ALIGNMENT, &PackAlignment);
+
+            glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+            glPixelStorei(GL_PACK_ALIGNMENT, alignment);
+        }
+
+        ~ScopedReadback(){
+            glBindFramebuffer(GL_READ_FRAMEBUFFER, ReadFramebuffer);
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, PackBuffer);
+            glPixelStorei(GL_PACK_ALIGNMENT, PackAlignment);
+        }
+    };
+
+    void OffscreenTarget::ReadColor(uint8_t* out){
+        {
+            ScopedReadback readback(mFramebuffer, 1);
+            glReadPixels(0, 0, mWidth, mHeight, GL_RGBA, GL_UNSIGNED_BYTE, out);
+        }
+        FlipRows(out, (size_t)mWidth * 4, mHeight);
+    }
+
+    void OffscreenTarget::ReadDepth(float* out){
+        {
+            ScopedReadback readback(mFramebuffer, 4);
+            glReadPixels(0, 0, mWidth, mHeight, GL_DEPTH_COMPONENT, GL_FLOAT, out);
+        }
+        FlipRows(out, (size_t)mWidth, mHeight);
+    }
+}
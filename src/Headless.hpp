@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include <glad/glad.h>
+
+namespace PyJ3D::Headless {
+    // Creates a surfaceless EGL context with no window or display server and makes it current.
+    // Only available when built against EGL, otherwise error explains why it failed.
+    bool CreateContext(std::string& error);
+    void DestroyContext();
+    bool HasContext();
+
+    // An EGL context is current on one thread at a time. Release it on the thread holding it before making it
+    // current on another, MakeCurrent fails while another thread still has it.
+    bool IsCurrent();
+    bool MakeCurrent();
+    void ReleaseCurrent();
+
+    // Loader for gladLoadGLLoader while the headless context is current.
+    void* GetProcAddress(const char* name);
+
+    // RGBA8 color + 32 bit float depth framebuffer, works under any current context.
+    class OffscreenTarget {
+        GLuint mFramebuffer = 0;
+        GLuint mColor = 0;
+        GLuint mDepth = 0;
+        uint32_t mWidth = 0, mHeight = 0;
+
+        GLint mPreviousFramebuffer = 0;
+        GLint mPreviousViewport[4] = { 0, 0, 0, 0 };
+
+    public:
+        // GL objects aren't freed on destruction since the context may already be gone, call Destroy while it's current.
+        bool Resize(uint32_t width, uint32_t height);
+        void Destroy();
+
+        uint32_t GetWidth() const { return mWidth; }
+        uint32_t GetHeight() const { return mHeight; }
+
+        // Binds the target and its viewport, Unbind restores whatever was bound before.
+        void Bind();
+        void Unbind();
+
+        // Rows are written top first so the result matches image conventions. out must hold width * height texels.
+        void ReadColor(uint8_t* out);
+        void ReadDepth(float* out);
+    };
+}
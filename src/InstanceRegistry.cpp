@@ -0,0 +1,170 @@
+#include "InstanceRegistry.hpp"
+#include "J3DFile.hpp"
+#include "Collision.hpp"
+#include "DiskCache.hpp"
+
+#include <unordered_map>
+
+#include <J3D/Data/J3DModelData.hpp>
+#include <J3D/Data/J3DModelInstance.hpp>
+
+namespace PyJ3D::Instances {
+    static std::unordered_map<J3DModelData*, ModelRecord> models = {};
+    static std::unordered_map<J3DModelInstance*, InstanceRecord> records = {};
+    static size_t registrationsSincePrune = 0;
+
+    static void PruneExpired(){
+        for(auto it = records.begin(); it != records.end();){
+            if(it->second.Instance.expired()){
+                it = records.erase(it);
+            }
+            else {
+                ++it;
+            }
+        }
+
+        for(auto it = models.begin(); it != models.end();){
+            if(it->second.Data.expired()){
+                it = models.erase(it);
+            }
+            else {
+                ++it;
+            }
+        }
+
+        registrationsSincePrune = 0;
+    }
+
+    static void ParseModelRecord(ModelRecord& model, const uint8_t* fileData, size_t fileSize){
+        J3DFile::ModelBounds bounds;
+        if(J3DFile::ReadModelBounds(fileData, fileSize, bounds)){
+            model.HasBounds = true;
+            model.BoundsMin = bounds.Min;
+            model.BoundsMax = bounds.Max;
+
+            glm::vec3 center = (bounds.Min + bounds.Max) * 0.5f;
+            model.BoundingSphere = glm::vec4(center, glm::distance(center, bounds.Max));
+        }
+
+        J3DFile::ModelGeometry geometry;
+        if(J3DFile::ReadModelGeometry(fileData, fileSize, geometry)){
+            model.Geometry = std::make_shared<Collision::TriangleBvh>();
+            model.Geometry->Build(geometry);
+        }
+    }
+
+    static void SaveModelRecord(const ModelRecord& model, uint64_t key){
+        DiskCache::BlobWriter writer;
+        writer.Write((uint8_t)model.HasBounds);
+        writer.Write(model.BoundsMin);
+        writer.Write(model.BoundsMax);
+        writer.Write(model.BoundingSphere);
+        writer.Write((uint8_t)(model.Geometry != nullptr));
+        if(model.Geometry != nullptr) model.Geometry->Save(writer);
+
+        DiskCache::Write(DiskCache::BlobKind::ModelData, key, writer.GetBytes().data(), writer.GetBytes().size());
+    }
+
+    static bool LoadModelRecord(ModelRecord& model, uint64_t key){
+        DiskCache::Blob blob;
+        if(!DiskCache::Read(DiskCache::BlobKind::ModelData, key, blob)) return false;
+
+        DiskCache::BlobReader reader(blob.Payload, blob.Size);
+        model.HasBounds = reader.Read<uint8_t>() != 0;
+        model.BoundsMin = reader.Read<glm::vec3>();
+        model.BoundsMax = reader.Read<glm::vec3>();
+        model.BoundingSphere = reader.Read<glm::vec4>();
+
+        if(reader.Read<uint8_t>() != 0){
+            model.Geometry = std::make_shared<Collision::TriangleBvh>();
+            if(!model.Geometry->Load(reader)) return false;
+        }
+
+        return reader.IsComplete();
+    }
+
+    ModelRecord PrepareModel(const uint8_t* fileData, size_t fileSize){
+        ModelRecord model;
+        if(!DiskCache::IsEnabled()){
+            ParseModelRecord(model, fileData, fileSize);
+            return model;
+        }
+
+        uint64_t key = DiskCache::MakeKey(fileData, fileSize);
+        if(LoadModelRecord(model, key)) return model;
+
+        model = ModelRecord();
+        ParseModelRecord(model, fileData, fileSize);
+        SaveModelRecord(model, key);
+        return model;
+    }
+
+    void RegisterModel(const std::shared_ptr<J3DModelData>& data, ModelRecord prepared){
+        if(data == nullptr) return;
+
+        ModelRecord& model = models[data.get()];
+        model = std::move(prepared);
+        model.Data = data;
+    }
+
+    void RegisterModel(const std::shared_ptr<J3DModelData>& data, const uint8_t* fileData, size_t fileSize){
+        if(data == nullptr) return;
+        RegisterModel(data, PrepareModel(fileData, fileSize));
+    }
+
+    ModelRecord* FindModel(J3DModelData* data){
+        auto it = models.find(data);
+        if(it == models.end() || it->second.Data.expired()) return nullptr;
+        return &it->second;
+    }
+
+    void Register(const std::shared_ptr<J3DModelInstance>& instance, const std::shared_ptr<J3DModelData>& data){
+        if(instance == nullptr) return;
+
+        // an expired record can share an address with a new instance, so always overwrite
+        InstanceRecord& record = records[instance.get()];
+        record = InstanceRecord();
+        record.Instance = instance;
+        record.Data = data.get();
+
+        if(++registrationsSincePrune >= 1024) PruneExpired();
+    }
+
+    void Unregister(J3DModelInstance* instance){
+        records.erase(instance);
+    }
+
+    InstanceRecord* Find(J3DModelInstance* instance){
+        auto it = records.find(instance);
+        if(it == records.end() || it->second.Instance.expired()) return nullptr;
+        return &it->second;
+    }
+
+    std::shared_ptr<J3DModelInstance> CreateInstance(const std::shared_ptr<J3DModelData>& data){
+        std::shared_ptr<J3DModelInstance> instance = data->CreateInstance();
+        Register(instance, data);
+        return instance;
+    }
+
+    bool GetWorldSphere(J3DModelInstance* instance, glm::vec4& out){
+        InstanceRecord* record = Find(instance);
+        if(record == nullptr) return false;
+
+        ModelRecord* model = FindModel(record->Data);
+        if(model == nullptr || !model->HasBounds) return false;
+
+        glm::vec3 scale = glm::abs(record->Scale);
+        float maxScale = glm::max(scale.x, glm::max(scale.y, scale.z));
+
+        // reach of the local sphere from the model origin, which holds under any rotation
+        float reach = glm::length(glm::vec3(model->BoundingSphere)) + model->BoundingSphere.w;
+        out = glm::vec4(record->Translation, reach * maxScale);
+        return true;
+    }
+
+    void Clear(){
+        models.clear();
+        records.clear();
+        registrationsSincePrune = 0;
+    }
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "JointAnimation.hpp"
+#include "TextureUpload.hpp"
+
+#include <glm/glm.hpp>
+
+class J3DModelData;
+class J3DModelInstance;
+
+namespace PyJ3D::Collision { class TriangleBvh; }
+
+namespace PyJ3D::Instances {
+    // Data this module derives from a model file, shared by every instance of it.
+    struct ModelRecord {
+        std::weak_ptr<J3DModelData> Data;
+        bool HasBounds = false;
+        glm::vec3 BoundsMin = glm::vec3(0.0f);
+        glm::vec3 BoundsMax = glm::vec3(0.0f);
+        glm::vec4 BoundingSphere = glm::vec4(0.0f); // local center xyz, radius w
+        std::shared_ptr<Collision::TriangleBvh> Geometry; // bind pose triangles for raycasts, null if SHP1 couldn't be decoded
+        TextureUpload::TextureStats Textures; // filled in by ModelCache once the model is parsed
+    };
+
+    // Binding-side bookkeeping for instances created through this module.
+    struct InstanceRecord {
+        std::weak_ptr<J3DModelInstance> Instance;
+        J3DModelData* Data = nullptr; // kept alive by the instance itself
+
+        // mirrored from the transform setters since J3DModelInstance doesn't expose them
+        glm::vec3 Translation = glm::vec3(0.0f);
+        glm::vec3 Rotation = glm::vec3(0.0f); // euler degrees
+        glm::vec3 Scale = glm::vec3(1.0f);
+
+        // held by animation level of detail this frame, native clips skip sampling
+        bool AnimThrottled = false;
+        // frames between samples a throttled clip's pose blends across, 1 when it's held instead
+        uint32_t AnimInterval = 1;
+
+        // joint clips sampled natively by JointAnimation::Update, layers blend over the base player
+        JointAnimation::ClipPlayer Player;
+        std::vector<JointAnimation::ClipLayer> Layers;
+        uint32_t NextLayerId = 1;
+
+        // while a clip plays the BCA slot holds its sampled pose, and a BCK clip sets the user's BCA aside here
+        std::shared_ptr<J3DAnimation::J3DJointFullAnimationInstance> PoseAnimation;
+        uint64_t PoseInputs = 0; // what PoseAnimation was sampled from, see JointAnimation::Update
+        // an interpolating throttled clip shows PoseFrom blended toward PoseTo, its latest sample taken on PoseSampleFrame
+        std::vector<float> PoseFrom, PoseTo;
+        uint64_t PoseSampleFrame = 0;
+        std::shared_ptr<J3DAnimation::J3DJointFullAnimationInstance> UserFullAnimation;
+
+        // last pose JointAnimation sampled, PoseVersion counts samples so raycasts know when to re-pose their copy
+        std::vector<float> Pose;
+        uint32_t PoseVersion = 0;
+        std::shared_ptr<Collision::TriangleBvh> PosedGeometry;
+        uint32_t PosedVersion = 0;
+    };
+
+    // Parses what the bindings need out of the source file (bounds, raycast geometry), or reads it from the disk cache.
+    // Touches no registry state, so the async loader runs it on its workers.
+    ModelRecord PrepareModel(const uint8_t* fileData, size_t fileSize);
+
+    // Remembers a prepared record for data.
+    void RegisterModel(const std::shared_ptr<J3DModelData>& data, ModelRecord prepared);
+    void RegisterModel(const std::shared_ptr<J3DModelData>& data, const uint8_t* fileData, size_t fileSize);
+    ModelRecord* FindModel(J3DModelData* data);
+
+    void Register(const std::shared_ptr<J3DModelInstance>& instance, const std::shared_ptr<J3DModelData>& data);
+    void Unregister(J3DModelInstance* instance);
+
+    // nullptr for unknown or expired instances
+    InstanceRecord* Find(J3DModelInstance* instance);
+
+    // Creates an instance of data and registers it.
+    std::shared_ptr<J3DModelInstance> CreateInstance(const std::shared_ptr<J3DModelData>& data);
+
+    // World space bounding sphere (xyz center, w radius), false if the instance has no known bounds.
+    // Rotation is not tracked, so the sphere is centered on the instance origin and covers every orientation.
+    bool GetWorldSphere(J3DModelInstance* instance, glm::vec4& out);
+
+    void Clear();
+}
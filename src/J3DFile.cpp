@@ -0,0 +1,531 @@
+#include "J3DFile.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include <glm/gtc/constants.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <bstream.h>
+
+namespace PyJ3D::J3DFile {
+    static const size_t HeaderSize = 0x20;
+    static const size_t ShapeEntrySize = 0x28;
+    static const size_t JointEntrySize = 0x40;
+    static const size_t TextureEntrySize = 0x20;
+
+    // GX vertex attributes used by the geometry decode
+    static const uint32_t AttrPositionMatrix = 0;
+    static const uint32_t AttrTexMatrix7 = 8;
+    static const uint32_t AttrPosition = 9;
+    static const uint32_t AttrNull = 0xFF;
+
+    enum AttrType : uint32_t { None = 0, Direct = 1, Index8 = 2, Index16 = 3 };
+
+    struct ShapeAttribute {
+        uint32_t Attribute;
+        uint32_t Type;
+    };
+
+    struct PositionFormat {
+        size_t Offset = 0;
+        size_t Count = 0;
+        uint32_t Components = 3;
+        uint32_t Type = 4;
+        float Scale = 1.0f;
+        size_t Stride = 12;
+    };
+
+    glm::mat4 MakeJointMatrix(const glm::vec3& scale, const glm::vec3& rotation, const glm::vec3& translation){
+        glm::mat4 transform = glm::translate(glm::mat4(1.0f), translation);
+        transform = glm::rotate(transform, rotation.z, glm::vec3(0.0f, 0.0f, 1.0f));
+        transform = glm::rotate(transform, rotation.y, glm::vec3(0.0f, 1.0f, 0.0f));
+        transform = glm::rotate(transform, rotation.x, glm::vec3(1.0f, 0.0f, 0.0f));
+        return glm::scale(transform, scale);
+    }
+
+    bool FindSection(const uint8_t* data, size_t size, const char* magic, Section& out){
+        if(size < HeaderSize) return false;
+
+        bStream::CMemoryStream stream((uint8_t*)data, size, bStream::Endianess::Big, bStream::OpenMode::In);
+
+        stream.seek(0x0C);
+        uint32_t sectionCount = stream.readUInt32();
+
+        size_t offset = HeaderSize;
+        for(uint32_t i = 0; i < sectionCount && offset + 8 <= size; i++){
+            stream.seek(offset + 4);
+            uint32_t sectionSize = stream.readUInt32();
+
+            if(sectionSize < 8 || offset + sectionSize > size) return false;
+
+            if(std::memcmp(data + offset, magic, 4) == 0){
+                out.Offset = offset;
+                out.Size = sectionSize;
+                return true;
+            }
+
+            offset += sectionSize;
+        }
+
+        return false;
+    }
+
+    bool ReadModelBounds(const uint8_t* data, size_t size, ModelBounds& out){
+        Section shp1;
+        if(!FindSection(data, size, "SHP1", shp1)) return false;
+
+        bStream::CMemoryStream stream((uint8_t*)data, size, bStream::Endianess::Big, bStream::OpenMode::In);
+
+        stream.seek(shp1.Offset + 0x08);
+        uint16_t shapeCount = stream.readUInt16();
+
+        stream.seek(shp1.Offset + 0x0C);
+        size_t shapesOffset = shp1.Offset + stream.readUInt32();
+
+        if(shapeCount == 0 || shapesOffset + shapeCount * ShapeEntrySize > shp1.Offset + shp1.Size) return false;
+
+        out.Min = glm::vec3(INFINITY);
+        out.Max = glm::vec3(-INFINITY);
+
+        for(uint16_t i = 0; i < shapeCount; i++){
+            // skip matrix type, packet counts and the bounding sphere radius
+            stream.seek(shapesOffset + i * ShapeEntrySize + 0x10);
+
+            glm::vec3 shapeMin, shapeMax;
+            shapeMin.x = stream.readFloat();
+            shapeMin.y = stream.readFloat();
+            shapeMin.z = stream.readFloat();
+            shapeMax.x = stream.readFloat();
+            shapeMax.y = stream.readFloat();
+            shapeMax.z = stream.readFloat();
+
+            out.Min = glm::min(out.Min, shapeMin);
+            out.Max = glm::max(out.Max, shapeMax);
+        }
+
+        return true;
+    }
+
+    static bool ReadJointMatrices(bStream::CMemoryStream& stream, const Section& inf1, const Section& jnt1, std::vector<glm::mat4>& joints,
+                                  std::vector<int16_t>& jointParents, std::vector<uint16_t>& shapeMaterials){
+        stream.seek(jnt1.Offset + 0x08);
+        uint16_t jointCount = stream.readUInt16();
+
+        stream.seek(jnt1.Offset + 0x0C);
+        size_t entriesOffset = jnt1.Offset + stream.readUInt32();
+        size_t remapOffset = jnt1.Offset + stream.readUInt32();
+
+        if(remapOffset + jointCount * 2 > jnt1.Offset + jnt1.Size) return false;
+
+        std::vector<glm::mat4> local(jointCount);
+        for(uint16_t i = 0; i < jointCount; i++){
+            stream.seek(remapOffset + i * 2);
+            size_t entry = entriesOffset + stream.readUInt16() * JointEntrySize;
+            if(entry + JointEntrySize > jnt1.Offset + jnt1.Size) return false;
+
+            stream.seek(entry + 0x04);
+            glm::vec3 scale, rotation, translation;
+            scale.x = stream.readFloat();
+            scale.y = stream.readFloat();
+            scale.z = stream.readFloat();
+            rotation.x = (int16_t)stream.readUInt16() * (glm::pi<float>() / 32768.0f);
+            rotation.y = (int16_t)stream.readUInt16() * (glm::pi<float>() / 32768.0f);
+            rotation.z = (int16_t)stream.readUInt16() * (glm::pi<float>() / 32768.0f);
+            stream.readUInt16();
+            translation.x = stream.readFloat();
+            translation.y = stream.readFloat();
+            translation.z = stream.readFloat();
+
+            local[i] = MakeJointMatrix(scale, rotation, translation);
+        }
+
+        joints.assign(jointCount, glm::mat4(1.0f));
+        jointParents.assign(jointCount, -1);
+
+        // INF1 scene graph gives joint parents and the material each shape is drawn with
+        stream.seek(inf1.Offset + 0x14);
+        size_t node = inf1.Offset + stream.readUInt32();
+
+        std::vector<int32_t> parents;
+        int32_t lastJoint = -1;
+        uint16_t lastMaterial = 0;
+
+        for(; node + 4 <= inf1.Offset + inf1.Size; node += 4){
+            stream.seek(node);
+            uint16_t type = stream.readUInt16();
+            uint16_t index = stream.readUInt16();
+
+            if(type == 0x00) break;
+
+            switch(type){
+                case 0x01:
+                    parents.push_back(lastJoint);
+                    break;
+                case 0x02:
+                    if(!parents.empty()) parents.pop_back();
+                    lastJoint = parents.empty() ? -1 : parents.back();
+                    break;
+                case 0x10:
+                    if(index >= jointCount) return false;
+                    joints[index] = (parents.empty() || parents.back() < 0) ? local[index] : joints[parents.back()] * local[index];
+                    jointParents[index] = parents.empty() ? -1 : (int16_t)parents.back();
+                    lastJoint = index;
+                    break;
+                case 0x11:
+                    lastMaterial = index;
+                    break;
+                case 0x12:
+                    if(index >= shapeMaterials.size()) shapeMaterials.resize(index + 1, 0);
+                    shapeMaterials[index] = lastMaterial;
+                    break;
+            }
+        }
+
+        return true;
+    }
+
+    // EVP1 envelopes in file order, each a list of joint/weight pairs.
+    static bool ReadEnvelopes(bStream::CMemoryStream& stream, const Section& evp1, std::vector<std::vector<SkinInfluence>>& out){
+        stream.seek(evp1.Offset + 0x08);
+        uint16_t envelopeCount = stream.readUInt16();
+
+        stream.seek(evp1.Offset + 0x0C);
+        size_t countsOffset = evp1.Offset + stream.readUInt32();
+        size_t indicesOffset = evp1.Offset + stream.readUInt32();
+        size_t weightsOffset = evp1.Offset + stream.readUInt32();
+
+        size_t end = evp1.Offset + evp1.Size;
+        if(countsOffset + envelopeCount > end) return false;
+
+        out.resize(envelopeCount);
+        size_t influence = 0;
+        for(uint16_t i = 0; i < envelopeCount; i++){
+            stream.seek(countsOffset + i);
+            uint8_t count = stream.readUInt8();
+            if(indicesOffset + (influence + count) * 2 > end || weightsOffset + (influence + count) * 4 > end) return false;
+
+            out[i].resize(count);
+            for(uint8_t k = 0; k < count; k++, influence++){
+                stream.seek(indicesOffset + influence * 2);
+                out[i][k].Joint = stream.readUInt16();
+                stream.seek(weightsOffset + influence * 4);
+                out[i][k].Weight = stream.readFloat();
+            }
+        }
+
+        return true;
+    }
+
+    static bool ReadPositionFormat(bStream::CMemoryStream& stream, const Section& vtx1, PositionFormat& out){
+        stream.seek(vtx1.Offset + 0x08);
+        size_t formatOffset = vtx1.Offset + stream.readUInt32();
+
+        size_t arrayOffsets[13];
+        for(size_t& offset : arrayOffsets){
+            offset = stream.readUInt32();
+        }
+        if(arrayOffsets[0] == 0) return false;
+
+        out.Offset = vtx1.Offset + arrayOffsets[0];
+
+        // the position array runs until the next array or the end of the section
+        size_t end = vtx1.Offset + vtx1.Size;
+        for(size_t offset : arrayOffsets){
+            if(offset != 0 && vtx1.Offset + offset > out.Offset) end = std::min(end, vtx1.Offset + offset);
+        }
+
+        for(size_t format = formatOffset; format + 0x10 <= vtx1.Offset + vtx1.Size; format += 0x10){
+            stream.seek(format);
+            uint32_t attribute = stream.readUInt32();
+            if(attribute == AttrNull) return false;
+            if(attribute != AttrPosition) continue;
+
+            out.Components = stream.readUInt32() == 0 ? 2 : 3;
+            out.Type = stream.readUInt32();
+            out.Scale = 1.0f / (float)(1 << stream.readUInt8());
+
+            static const size_t typeSizes[] = { 1, 1, 2, 2, 4 };
+            if(out.Type > 4) return false;
+
+            out.Stride = typeSizes[out.Type] * out.Components;
+            out.Count = (end - out.Offset) / out.Stride;
+            return true;
+        }
+
+        return false;
+    }
+
+    static glm::vec3 ReadPosition(bStream::CMemoryStream& stream, const PositionFormat& format, size_t index){
+        stream.seek(format.Offset + index * format.Stride);
+
+        float values[3] = { 0.0f, 0.0f, 0.0f };
+        for(uint32_t i = 0; i < format.Components; i++){
+            switch(format.Type){
+                case 0: values[i] = stream.readUInt8() * format.Scale; break;
+                case 1: values[i] = (int8_t)stream.readUInt8() * format.Scale; break;
+                case 2: values[i] = stream.readUInt16() * format.Scale; break;
+                case 3: values[i] = (int16_t)stream.readUInt16() * format.Scale; break;
+                case 4: values[i] = stream.readFloat(); break;
+            }
+        }
+
+        return glm::vec3(values[0], values[1], values[2]);
+    }
+
+    bool ReadModelGeometry(const uint8_t* data, size_t size, ModelGeometry& out){
+        Section inf1, vtx1, jnt1, drw1, shp1;
+        if(!FindSection(data, size, "INF1", inf1) || !FindSection(data, size, "VTX1", vtx1) || !FindSection(data, size, "JNT1", jnt1) ||
+           !FindSection(data, size, "DRW1", drw1) || !FindSection(data, size, "SHP1", shp1)) return false;
+
+        bStream::CMemoryStream stream((uint8_t*)data, size, bStream::Endianess::Big, bStream::OpenMode::In);
+
+        std::vector<glm::mat4> joints;
+        std::vector<int16_t> jointParents;
+        std::vector<uint16_t> shapeMaterials;
+        if(!ReadJointMatrices(stream, inf1, jnt1, joints, jointParents, shapeMaterials)) return false;
+
+        // models without weighted vertices have no EVP1
+        Section evp1;
+        std::vector<std::vector<SkinInfluence>> envelopes;
+        if(FindSection(data, size, "EVP1", evp1) && !ReadEnvelopes(stream, evp1, envelopes)) return false;
+
+        PositionFormat positions;
+        if(!ReadPositionFormat(stream, vtx1, positions)) return false;
+
+        // DRW1 maps draw matrix slots to a joint (rigid) or an envelope (weighted)
+        stream.seek(drw1.Offset + 0x08);
+        uint16_t drawCount = stream.readUInt16();
+        stream.seek(drw1.Offset + 0x0C);
+        size_t weightedOffset = drw1.Offset + stream.readUInt32();
+        size_t drawIndexOffset = drw1.Offset + stream.readUInt32();
+        if(drawIndexOffset + drawCount * 2 > drw1.Offset + drw1.Size) return false;
+
+        out.DrawFirst.clear();
+        out.Influences.clear();
+
+        std::vector<glm::mat4> drawMatrices(drawCount, glm::mat4(1.0f));
+        for(uint16_t i = 0; i < drawCount; i++){
+            stream.seek(weightedOffset + i);
+            bool weighted = stream.readUInt8() != 0;
+            stream.seek(drawIndexOffset + i * 2);
+            uint16_t index = stream.readUInt16();
+
+            out.DrawFirst.push_back((uint32_t)out.Influences.size());
+            if(!weighted && index < joints.size()){
+                drawMatrices[i] = joints[index];
+                out.Influences.push_back({ index, 1.0f });
+            }
+            else if(weighted && index < envelopes.size()){
+                for(const SkinInfluence& influence : envelopes[index]){
+                    if(influence.Joint < joints.size()) out.Influences.push_back(influence);
+                }
+            }
+        }
+        out.DrawFirst.push_back((uint32_t)out.Influences.size());
+
+        stream.seek(shp1.Offset + 0x08);
+        uint16_t shapeCount = stream.readUInt16();
+        stream.seek(shp1.Offset + 0x0C);
+        size_t shapesOffset = shp1.Offset + stream.readUInt32();
+        stream.readUInt32(); // remap table
+        stream.readUInt32(); // name table
+        size_t attributesOffset = shp1.Offset + stream.readUInt32();
+        size_t matrixTableOffset = shp1.Offset + stream.readUInt32();
+        size_t primitivesOffset = shp1.Offset + stream.readUInt32();
+        size_t matrixDataOffset = shp1.Offset + stream.readUInt32();
+        size_t packetsOffset = shp1.Offset + stream.readUInt32();
+
+        size_t shp1End = shp1.Offset + shp1.Size;
+        if(shapesOffset + shapeCount * ShapeEntrySize > shp1End) return false;
+
+        out.Vertices.clear();
+        out.Materials.clear();
+        out.Shapes.clear();
+        out.VertexDraws.clear();
+        out.JointParents = std::move(jointParents);
+        out.BindJoints = joints;
+
+        std::vector<ShapeAttribute> attributes;
+        std::vector<glm::vec3> primitive;
+        std::vector<uint16_t> primitiveDraws;
+
+        for(uint16_t shape = 0; shape < shapeCount; shape++){
+            stream.seek(shapesOffset + shape * ShapeEntrySize + 0x02);
+            uint16_t packetCount = stream.readUInt16();
+            uint16_t attributeOffset = stream.readUInt16();
+            uint16_t firstMatrixData = stream.readUInt16();
+            uint16_t firstPacket = stream.readUInt16();
+
+            attributes.clear();
+            for(size_t attr = attributesOffset + attributeOffset; attr + 8 <= shp1End; attr += 8){
+                stream.seek(attr);
+                ShapeAttribute attribute = { stream.readUInt32(), stream.readUInt32() };
+                if(attribute.Attribute == AttrNull) break;
+
+                // only matrix indices are sent direct in J3D files, anything else can't be sized here
+                if(attribute.Type == Direct && attribute.Attribute > AttrTexMatrix7) return false;
+                attributes.push_back(attribute);
+            }
+
+            uint16_t material = shape < shapeMaterials.size() ? shapeMaterials[shape] : 0;
+
+            // matrix slots persist across packets, 0xFFFF keeps the previous packet's entry
+            uint16_t slots[10];
+            std::fill(std::begin(slots), std::end(slots), 0xFFFF);
+
+            for(uint16_t packet = 0; packet < packetCount; packet++){
+                stream.seek(matrixDataOffset + (firstMatrixData + packet) * 8 + 0x02);
+                uint16_t slotCount = stream.readUInt16();
+                uint32_t firstSlot = stream.readUInt32();
+
+                for(uint16_t i = 0; i < slotCount && i < 10; i++){
+                    stream.seek(matrixTableOffset + (firstSlot + i) * 2);
+                    uint16_t drawIndex = stream.readUInt16();
+                    if(drawIndex != 0xFFFF) slots[i] = drawIndex;
+                }
+
+                stream.seek(packetsOffset + (firstPacket + packet) * 8);
+                uint32_t listSize = stream.readUInt32();
+                size_t list = primitivesOffset + stream.readUInt32();
+                size_t listEnd = std::min(list + listSize, shp1End);
+
+                size_t cursor = list;
+                while(cursor + 3 <= listEnd){
+                    stream.seek(cursor);
+                    uint8_t opcode = stream.readUInt8();
+                    if((opcode & 0x80) == 0) break; // padding after the last primitive
+
+                    uint16_t vertexCount = stream.readUInt16();
+                    cursor += 3;
+
+                    primitive.clear();
+                    primitiveDraws.clear();
+                    for(uint16_t v = 0; v < vertexCount; v++){
+                        uint32_t matrixSlot = 0;
+                        uint32_t positionIndex = 0;
+
+                        for(const ShapeAttribute& attribute : attributes){
+                            uint32_t value = 0;
+                            if(attribute.Type == Index16){
+                                value = stream.readUInt16();
+                                cursor += 2;
+                            }
+                            else if(attribute.Type != None){
+                                value = stream.readUInt8();
+                                cursor += 1;
+                            }
+
+                            if(attribute.Attribute == AttrPositionMatrix) matrixSlot = value / 3;
+                            else if(attribute.Attribute == AttrPosition) positionIndex = value;
+                        }
+
+                        if(cursor > listEnd || positionIndex >= positions.Count) return false;
+
+                        glm::vec3 position = ReadPosition(stream, positions, positionIndex);
+                        uint16_t drawIndex = matrixSlot < 10 ? slots[matrixSlot] : NoDraw;
+                        if(drawIndex < drawMatrices.size()) position = glm::vec3(drawMatrices[drawIndex] * glm::vec4(position, 1.0f));
+                        else drawIndex = NoDraw;
+
+                        primitive.push_back(position);
+                        primitiveDraws.push_back(drawIndex);
+                        stream.seek(cursor);
+                    }
+
+                    auto emit = [&](size_t a, size_t b, size_t c){
+                        out.Vertices.push_back(primitive[a]);
+                        out.Vertices.push_back(primitive[b]);
+                        out.Vertices.push_back(primitive[c]);
+                        out.VertexDraws.push_back(primitiveDraws[a]);
+                        out.VertexDraws.push_back(primitiveDraws[b]);
+                        out.VertexDraws.push_back(primitiveDraws[c]);
+                        out.Materials.push_back(material);
+                        out.Shapes.push_back(shape);
+                    };
+
+                    switch(opcode & 0xF8){
+                        case 0x80: // quads
+                            for(size_t i = 0; i + 3 < primitive.size(); i += 4){ emit(i, i + 1, i + 2); emit(i, i + 2, i + 3); }
+                            break;
+                        case 0x90: // triangles
+                            for(size_t i = 0; i + 2 < primitive.size(); i += 3) emit(i, i + 1, i + 2);
+                            break;
+                        case 0x98: // triangle strip
+                            for(size_t i = 2; i < primitive.size(); i++) emit(i - 2, i - 1, i);
+                            break;
+                        case 0xA0: // triangle fan
+                            for(size_t i = 2; i < primitive.size(); i++) emit(0, i - 1, i);
+                            break;
+                        default: // lines and points can't be hit
+                            break;
+                    }
+                }
+            }
+        }
+
+        return !out.Vertices.empty();
+    }
+
+    // J3D string table: count, padding, (hash, offset) per entry, then the null terminated strings.
+    static std::string ReadTableString(const uint8_t* data, size_t size, size_t table, uint32_t index){
+        if(table + 4 > size) return "";
+
+        uint16_t count = (uint16_t)(data[table] << 8 | data[table + 1]);
+        size_t entry = table + 4 + index * 4;
+        if(index >= count || entry + 4 > size) return "";
+
+        size_t start = table + (uint16_t)(data[entry + 2] << 8 | data[entry + 3]);
+        size_t end = start;
+        while(end < size && data[end] != 0) end++;
+
+        return start < size ? std::string((const char*)data + start, end - start) : "";
+    }
+
+    bool ReadTextures(const uint8_t* data, size_t size, std::vector<TextureHeader>& out){
+        out.clear();
+
+        Section tex1;
+        if(!FindSection(data, size, "TEX1", tex1)) return false;
+
+        bStream::CMemoryStream stream((uint8_t*)data, size, bStream::Endianess::Big, bStream::OpenMode::In);
+
+        stream.seek(tex1.Offset + 0x08);
+        uint16_t textureCount = stream.readUInt16();
+
+        stream.seek(tex1.Offset + 0x0C);
+        size_t headersOffset = tex1.Offset + stream.readUInt32();
+        size_t namesOffset = tex1.Offset + stream.readUInt32();
+
+        if(headersOffset + textureCount * TextureEntrySize > tex1.Offset + tex1.Size) return false;
+
+        out.resize(textureCount);
+        for(uint32_t i = 0; i < textureCount; i++){
+            TextureHeader& texture = out[i];
+            size_t header = headersOffset + i * TextureEntrySize;
+            texture.HeaderOffset = header;
+
+            stream.seek(header);
+            texture.Format = stream.readUInt8();
+
+            stream.seek(header + 0x02);
+            texture.Width = stream.readUInt16();
+            texture.Height = stream.readUInt16();
+
+            stream.seek(header + 0x09);
+            texture.PaletteFormat = stream.readUInt8();
+            texture.PaletteCount = stream.readUInt16();
+            texture.PaletteOffset = header + stream.readUInt32();
+
+            stream.seek(header + 0x18);
+            texture.MipCount = std::max<uint8_t>(stream.readUInt8(), 1);
+
+            stream.seek(header + 0x1C);
+            texture.DataOffset = header + stream.readUInt32();
+
+            texture.Name = ReadTableString(data, size, namesOffset, i);
+        }
+
+        return true;
+    }
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+namespace PyJ3D::J3DFile {
+    // Offset/size of a section inside a J3D file, both in bytes from the start of the file.
+    struct Section {
+        size_t Offset = 0;
+        size_t Size = 0;
+    };
+
+    struct ModelBounds {
+        glm::vec3 Min = glm::vec3(0.0f);
+        glm::vec3 Max = glm::vec3(0.0f);
+    };
+
+    struct SkinInfluence {
+        uint16_t Joint = 0;
+        float Weight = 1.0f;
+    };
+
+    // Triangles of every shape in the bind pose, in model space.
+    struct ModelGeometry {
+        std::vector<glm::vec3> Vertices; // three per triangle
+        std::vector<uint16_t> Materials; // INF1 material index of each triangle
+        std::vector<uint16_t> Shapes;    // SHP1 shape index of each triangle
+
+        // Skinning. Each vertex follows one DRW1 draw matrix, rigid ones bind a single joint and weighted ones
+        // blend an EVP1 envelope. Draw matrix i's influences run from DrawFirst[i] to DrawFirst[i + 1].
+        std::vector<uint16_t> VertexDraws; // parallel to Vertices, NoDraw when the vertex follows none
+        std::vector<uint32_t> DrawFirst;
+        std::vector<SkinInfluence> Influences;
+        std::vector<int16_t> JointParents; // -1 for roots
+        std::vector<glm::mat4> BindJoints; // model space bind matrix of each joint
+    };
+
+    static const uint16_t NoDraw = 0xFFFF;
+
+    // One TEX1 texture, offsets are from the start of the file. Several headers may share data.
+    struct TextureHeader {
+        std::string Name;
+        uint8_t Format = 0; // GX texture format, see TextureDecode::Format
+        uint16_t Width = 0;
+        uint16_t Height = 0;
+        uint8_t PaletteFormat = 0;
+        uint16_t PaletteCount = 0;
+        size_t PaletteOffset = 0;
+        uint8_t MipCount = 1;
+        size_t DataOffset = 0;
+        size_t HeaderOffset = 0; // the TEX1 entry this was read from
+    };
+
+    // J3D joint transform, scale then rotate X, Y, Z then translate. Rotation in radians.
+    glm::mat4 MakeJointMatrix(const glm::vec3& scale, const glm::vec3& rotation, const glm::vec3& translation);
+
+    // Walks the section table after the 0x20 byte J3D header, magic is a four character code like "SHP1".
+    bool FindSection(const uint8_t* data, size_t size, const char* magic, Section& out);
+
+    // Union of the bounding boxes SHP1 stores for every shape.
+    bool ReadModelBounds(const uint8_t* data, size_t size, ModelBounds& out);
+
+    // Decodes SHP1 display lists into triangles. Rigid vertices are placed by their joint's bind pose
+    // matrix from JNT1/INF1, weighted vertices are already stored in model space. The skinning tables
+    // let callers move the triangles into an animated pose.
+    bool ReadModelGeometry(const uint8_t* data, size_t size, ModelGeometry& out);
+
+    // TEX1 headers in file order, BMT material files carry the same section as BMD/BDL models.
+    // Data sizes aren't checked here, TextureDecode::GetDataSize tells how much each one needs.
+    bool ReadTextures(const uint8_t* data, size_t size, std::vector<TextureHeader>& out);
+}
@@ -0,0 +1,1241 @@
+#include "JointAnimation.hpp"
+#include "J3DFile.hpp"
+#include "ThreadPool.hpp"
+#include "InstanceRegistry.hpp"
+#include "ModelCache.hpp"
+#include "FileUtil.hpp"
+#include "Profiler.hpp"
+#include "Simd.hpp"
+#include "FrameClock.hpp"
+#include "AnimationLod.hpp"
+#include "Hash.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+#include <unordered_set>
+
+#include <J3D/Data/J3DModelInstance.hpp>
+#include <J3D/Animation/J3DAnimationLoader.hpp>
+#include <J3D/Animation/J3DJointAnimationInstance.hpp>
+#include <J3D/Animation/J3DJointFullAnimationInstance.hpp>
+#include <bstream.h>
+
+namespace PyJ3D::JointAnimation {
+    static const size_t KeyedJointEntrySize = 9 * 6; // count, first index, tangent mode per component
+    static const size_t FullJointEntrySize = 9 * 4;  // count, first index per component
+    static const float AngleScale = 180.0f / 32768.0f;
+
+    // poses are sampled and encoded in batches of at least this many instances per worker
+    static const size_t MinParallelBatch = 8;
+
+    static UpdateStats stats = {};
+
+    struct LayerJob {
+        std::shared_ptr<const JointClip> Clip;
+        float Frame;
+        float Weight;
+        BlendMode Mode;
+    };
+
+    struct PoseJob {
+        J3DModelInstance* Instance;
+        Instances::InstanceRecord* Record;
+        std::shared_ptr<const JointClip> Clip;
+        float Frame;
+        float Weight;
+        uint32_t LayerFirst; // into layerJobs
+        uint32_t LayerCount;
+        uint64_t Inputs;     // hash of everything the pose depends on
+        float Blend;         // how far from the record's PoseFrom to PoseTo to show, negative shows the sample as is
+        bool Resample;       // false on a throttled frame that only blends between the record's poses
+    };
+
+    // a drawn instance whose unblended player is on the same clip frame as an earlier job's, it gets that job's pose
+    struct SharedPose {
+        J3DModelInstance* Instance;
+        Instances::InstanceRecord* Record;
+        uint32_t Job;
+    };
+
+    struct PoseKey {
+        const JointClip* Clip;
+        float Frame;
+
+        bool operator==(const PoseKey& other) const { return Clip == other.Clip && Frame == other.Frame; }
+    };
+
+    struct PoseKeyHash {
+        size_t operator()(const PoseKey& key) const { return std::hash<const void*>()(key.Clip) ^ (std::hash<float>()(key.Frame) * 31); }
+    };
+
+    // weak so a clip goes away with its last player, an entry only stops identical loads from parsing again
+    static std::unordered_map<std::string, std::weak_ptr<JointClip>> cachedClips = {};
+
+    // instances with a player or layers, all of them advance every frame whether they are drawn or not
+    static std::unordered_set<J3DModelInstance*> playing = {};
+    static uint64_t advancedFrame = UINT64_MAX;
+    static ClipCacheStats cacheStats = {};
+    static size_t cacheSweepSize = 64;
+
+    // scratch reused by Update
+    static std::vector<PoseJob> poseJobs = {};
+    static std::vector<LayerJob> layerJobs = {};
+    static std::vector<SharedPose> sharedPoses = {};
+    static std::unordered_map<PoseKey, uint32_t, PoseKeyHash> unblendedJobs = {}; // job evaluating each clip frame
+    static std::vector<std::vector<float>> poseBuffers = {}; // one per job, swapped into the instance records
+    static std::vector<std::vector<uint8_t>> encodedPoses = {}; // one per job, the pose as a one frame BCA
+    static std::vector<J3DModelInstance*> batchInstances = {};
+
+    static bool IsRotation(uint32_t component){
+        return component == RotationX || component == RotationY || component == RotationZ;
+    }
+
+    // Keys of one component as stored in the file. Rotations stay raw 16 bit angles until UnitScale is applied.
+    struct RawTrack {
+        std::vector<float> Times, Values, InSlopes, OutSlopes;
+        float UnitScale = 1.0f;
+        bool Rotation = false;
+    };
+
+    // scratch for one track while a clip is read
+    static thread_local RawTrack rawTrack;
+
+    static float ReadTableValue(bStream::CMemoryStream& stream, size_t table, uint32_t index, bool rotation){
+        if(rotation){
+            stream.seek(table + index * 2);
+            return (float)stream.readInt16();
+        }
+
+        stream.seek(table + index * 4);
+        return stream.readFloat();
+    }
+
+    // Fits values into int16 as offset + raw * scale. With centered set the offset is fixed at 0.
+    // False when any value would move by more than tolerance.
+    static bool Quantize(const std::vector<float>& a, const std::vector<float>& b, bool centered, float tolerance, float& scale, float& offset){
+        float lo = INFINITY, hi = -INFINITY;
+        for(const std::vector<float>* values : { &a, &b }){
+            for(float value : *values){
+                lo = std::min(lo, value);
+                hi = std::max(hi, value);
+            }
+        }
+        if(a.empty() && b.empty()) lo = hi = 0.0f;
+
+        if(centered){
+            offset = 0.0f;
+            scale = std::max(std::abs(lo), std::abs(hi)) / 32767.0f;
+        }
+        else {
+            offset = (lo + hi) * 0.5f;
+            scale = (hi - lo) / 65534.0f;
+        }
+        if(scale == 0.0f) scale = 1.0f;
+
+        for(const std::vector<float>* values : { &a, &b }){
+            for(float value : *values){
+                if(std::abs(offset + std::round((value - offset) / scale) * scale - value) > tolerance) return false;
+            }
+        }
+        return true;
+    }
+
+    static int16_t PackValue(float value, float scale, float offset){
+        return (int16_t)std::clamp(std::lround((value - offset) / scale), -32768L, 32767L);
+    }
+
+    // Folds constant components into the pose and stores the rest as packed or float tracks.
+    // tolerance 0 keeps scale and translation keys as floats.
+    static void AddTrack(JointClip& clip, const RawTrack& raw, uint32_t target, float tolerance){
+        size_t count = raw.Values.size();
+
+        bool constant = true;
+        for(size_t key = 0; key < count && constant; key++){
+            constant = raw.Values[key] == raw.Values[0] && (clip.Stepped || (raw.InSlopes[key] == 0.0f && raw.OutSlopes[key] == 0.0f));
+        }
+
+        if(constant){
+            clip.ConstantPose[target] = raw.Values[0] * raw.UnitScale;
+            return;
+        }
+
+        ClipTrack track;
+        track.Target = target;
+        track.Count = (uint16_t)count;
+        track.SharedSlopes = clip.Stepped || raw.InSlopes == raw.OutSlopes;
+
+        bool wholeTimes = true;
+        float maxSpan = 1.0f;
+        for(size_t key = 0; key < raw.Times.size() && wholeTimes; key++){
+            float time = raw.Times[key];
+            wholeTimes = time >= 0.0f && time <= 65535.0f && time == std::floor(time);
+            if(key > 0) maxSpan = std::max(maxSpan, time - raw.Times[key - 1]);
+        }
+
+        // packing works in file units, rotations are packed as they are
+        float packScale = 1.0f, packOffset = 0.0f, slopePackScale = 1.0f;
+        if(raw.Rotation && wholeTimes){
+            track.Packed = true;
+        }
+        else if(!raw.Rotation && wholeTimes && tolerance > 0.0f){
+            // half the budget goes to the keys, whose basis weights sum to 1. The slopes' weights sum to
+            // at most a quarter of the key span, they get the other half.
+            float slopeTolerance = tolerance * 0.5f / std::max(1.0f, maxSpan * 0.25f);
+            float slopeOffset;
+            track.Packed = Quantize(raw.Values, raw.Values, false, tolerance * 0.5f, packScale, packOffset)
+                        && Quantize(raw.InSlopes, raw.OutSlopes, true, slopeTolerance, slopePackScale, slopeOffset);
+        }
+
+        if(track.Packed){
+            track.ValueScale = packScale * raw.UnitScale;
+            track.ValueOffset = packOffset * raw.UnitScale;
+            track.SlopeScale = slopePackScale * raw.UnitScale;
+
+            track.First = (uint32_t)clip.PackedValues.size();
+            for(size_t key = 0; key < count; key++){
+                clip.PackedValues.push_back(PackValue(raw.Values[key], packScale, packOffset));
+                if(clip.Stepped) continue;
+
+                clip.PackedTimes.push_back((uint16_t)raw.Times[key]);
+                clip.PackedInSlopes.push_back(PackValue(raw.InSlopes[key], slopePackScale, 0.0f));
+            }
+
+            if(!track.SharedSlopes){
+                track.OutFirst = (uint32_t)clip.PackedOutSlopes.size();
+                for(float slope : raw.OutSlopes) clip.PackedOutSlopes.push_back(PackValue(slope, slopePackScale, 0.0f));
+            }
+        }
+        else {
+            track.First = (uint32_t)clip.Values.size();
+            for(size_t key = 0; key < count; key++){
+                clip.Values.push_back(raw.Values[key] * raw.UnitScale);
+                if(clip.Stepped) continue;
+
+                clip.Times.push_back(raw.Times[key]);
+                clip.InSlopes.push_back(raw.InSlopes[key] * raw.UnitScale);
+            }
+
+            if(!track.SharedSlopes){
+                track.OutFirst = (uint32_t)clip.OutSlopes.size();
+                for(float slope : raw.OutSlopes) clip.OutSlopes.push_back(slope * raw.UnitScale);
+            }
+        }
+
+        clip.Tracks.push_back(track);
+    }
+
+    static float GetTolerance(uint32_t component, bool lossless){
+        if(lossless || IsRotation(component)) return 0.0f;
+        return component % 3 == 0 ? ScaleTolerance : TranslationTolerance;
+    }
+
+    static std::shared_ptr<JointClip> ReadKeyedClip(const uint8_t* data, size_t size, const J3DFile::Section& ank1, bool lossless){
+        bStream::CMemoryStream stream((uint8_t*)data, size, bStream::Endianess::Big, bStream::OpenMode::In);
+        std::shared_ptr<JointClip> clip = std::make_shared<JointClip>();
+
+        stream.seek(ank1.Offset + 0x08);
+        clip->Loop = (LoopMode)stream.readUInt8();
+        uint8_t angleShift = stream.readUInt8();
+        clip->Duration = stream.readUInt16();
+        clip->JointCount = stream.readUInt16();
+
+        uint16_t tableCounts[3];
+        for(uint16_t& count : tableCounts) count = stream.readUInt16();
+
+        size_t jointTable = ank1.Offset + stream.readUInt32();
+        size_t tables[3];
+        for(size_t& table : tables) table = ank1.Offset + stream.readUInt32();
+
+        if(jointTable + clip->JointCount * KeyedJointEntrySize > ank1.Offset + ank1.Size) return nullptr;
+
+        float angleScale = (float)(1 << angleShift) * AngleScale;
+        clip->ConstantPose.assign(clip->JointCount * ComponentCount, 0.0f);
+
+        RawTrack& raw = rawTrack;
+        for(uint32_t joint = 0; joint < clip->JointCount; joint++){
+            for(uint32_t component = 0; component < ComponentCount; component++){
+                stream.seek(jointTable + joint * KeyedJointEntrySize + component * 6);
+                uint16_t count = std::max<uint16_t>(stream.readUInt16(), 1);
+                uint16_t first = stream.readUInt16();
+                uint16_t tangentMode = stream.readUInt16();
+
+                // scale, rotation, translation repeat per axis
+                uint32_t kind = component % 3;
+                raw.Rotation = IsRotation(component);
+                raw.UnitScale = raw.Rotation ? angleScale : 1.0f;
+                raw.Times.clear();
+                raw.Values.clear();
+                raw.InSlopes.clear();
+                raw.OutSlopes.clear();
+
+                // a single key is the bare value, otherwise time, value, in slope and an out slope when
+                // tangentMode is 1, the in slope doubles as out otherwise
+                uint32_t stride = count == 1 ? 1 : (tangentMode == 1 ? 4 : 3);
+                size_t entrySize = raw.Rotation ? 2 : 4;
+                if((size_t)first + count * stride > tableCounts[kind] || tables[kind] + (first + count * stride) * entrySize > size) return nullptr;
+
+                for(uint32_t key = 0; key < count; key++){
+                    uint32_t index = first + key * stride;
+                    if(stride == 1){
+                        raw.Times.push_back(0.0f);
+                        raw.Values.push_back(ReadTableValue(stream, tables[kind], index, raw.Rotation));
+                        raw.InSlopes.push_back(0.0f);
+                        raw.OutSlopes.push_back(0.0f);
+                        continue;
+                    }
+
+                    raw.Times.push_back(ReadTableValue(stream, tables[kind], index, raw.Rotation));
+                    raw.Values.push_back(ReadTableValue(stream, tables[kind], index + 1, raw.Rotation));
+                    raw.InSlopes.push_back(ReadTableValue(stream, tables[kind], index + 2, raw.Rotation));
+                    raw.OutSlopes.push_back(stride == 4 ? ReadTableValue(stream, tables[kind], index + 3, raw.Rotation) : raw.InSlopes.back());
+                }
+
+                AddTrack(*clip, raw, component * clip->JointCount + joint, GetTolerance(component, lossless));
+            }
+        }
+
+        return clip;
+    }
+
+    static std::shared_ptr<JointClip> ReadFullClip(const uint8_t* data, size_t size, const J3DFile::Section& anf1, bool lossless){
+        bStream::CMemoryStream stream((uint8_t*)data, size, bStream::Endianess::Big, bStream::OpenMode::In);
+        std::shared_ptr<JointClip> clip = std::make_shared<JointClip>();
+        clip->Stepped = true;
+
+        stream.seek(anf1.Offset + 0x08);
+        clip->Loop = (LoopMode)stream.readUInt8();
+        stream.readUInt8();
+        clip->Duration = stream.readUInt16();
+        clip->JointCount = stream.readUInt16();
+
+        uint16_t tableCounts[3];
+        for(uint16_t& count : tableCounts) count = stream.readUInt16();
+
+        size_t jointTable = anf1.Offset + stream.readUInt32();
+        size_t tables[3];
+        for(size_t& table : tables) table = anf1.Offset + stream.readUInt32();
+
+        if(jointTable + clip->JointCount * FullJointEntrySize > anf1.Offset + anf1.Size) return nullptr;
+
+        clip->ConstantPose.assign(clip->JointCount * ComponentCount, 0.0f);
+
+        RawTrack& raw = rawTrack;
+        raw.Times.clear();
+        raw.InSlopes.clear();
+        raw.OutSlopes.clear();
+
+        for(uint32_t joint = 0; joint < clip->JointCount; joint++){
+            for(uint32_t component = 0; component < ComponentCount; component++){
+                stream.seek(jointTable + joint * FullJointEntrySize + component * 4);
+                uint16_t count = std::max<uint16_t>(stream.readUInt16(), 1);
+                uint16_t first = stream.readUInt16();
+
+                uint32_t kind = component % 3;
+                raw.Rotation = IsRotation(component);
+                raw.UnitScale = raw.Rotation ? AngleScale : 1.0f;
+                if((size_t)first + count > tableCounts[kind] || tables[kind] + (first + count) * (raw.Rotation ? 2 : 4) > size) return nullptr;
+
+                raw.Values.clear();
+                for(uint32_t frame = 0; frame < count; frame++){
+                    raw.Values.push_back(ReadTableValue(stream, tables[kind], first + frame, raw.Rotation));
+                }
+
+                AddTrack(*clip, raw, component * clip->JointCount + joint, GetTolerance(component, lossless));
+            }
+        }
+
+        return clip;
+    }
+
+    std::shared_ptr<JointClip> ReadClip(const uint8_t* data, size_t size, bool lossless){
+        J3DFile::Section section;
+        std::shared_ptr<JointClip> clip;
+        if(J3DFile::FindSection(data, size, "ANK1", section)) clip = ReadKeyedClip(data, size, section, lossless);
+        else if(J3DFile::FindSection(data, size, "ANF1", section)) clip = ReadFullClip(data, size, section, lossless);
+
+        if(clip == nullptr) return nullptr;
+
+        // the pools grew key by key, the clip lives on unchanged so drop their slack
+        clip->Tracks.shrink_to_fit();
+        for(std::vector<float>* pool : { &clip->Times, &clip->Values, &clip->InSlopes, &clip->OutSlopes }) pool->shrink_to_fit();
+        for(std::vector<int16_t>* pool : { &clip->PackedValues, &clip->PackedInSlopes, &clip->PackedOutSlopes }) pool->shrink_to_fit();
+        clip->PackedTimes.shrink_to_fit();
+
+        clip->ReferencePose.resize(clip->ConstantPose.size());
+        Sample(*clip, 0.0f, clip->ReferencePose.data());
+        return clip;
+    }
+
+    static std::string MakeCacheKey(std::string key, bool lossless){
+        return lossless ? key : key + "|packed";
+    }
+
+    static std::shared_ptr<JointClip> FindCached(const std::string& key){
+        auto it = cachedClips.find(key);
+        std::shared_ptr<JointClip> cached = it != cachedClips.end() ? it->second.lock() : nullptr;
+        if(cached != nullptr) cacheStats.Hits++;
+        return cached;
+    }
+
+    static void InsertCached(const std::string& key, const std::shared_ptr<JointClip>& clip){
+        cacheStats.Misses++;
+        if(clip == nullptr) return;
+
+        // drop entries whose clips have been released before the map grows
+        if(cachedClips.size() >= cacheSweepSize){
+            for(auto entry = cachedClips.begin(); entry != cachedClips.end();){
+                entry = entry->second.expired() ? cachedClips.erase(entry) : std::next(entry);
+            }
+            cacheSweepSize = std::max<size_t>(64, cachedClips.size() * 2);
+        }
+
+        cachedClips[key] = clip;
+    }
+
+    std::shared_ptr<JointClip> LoadClipFile(const std::string& path, bool lossless, bool useCache){
+        std::string key;
+        if(useCache){
+            std::string fileKey = ModelCache::MakeFileKey(path);
+            useCache = !fileKey.empty();
+            key = MakeCacheKey(fileKey, lossless);
+        }
+        if(useCache){
+            std::shared_ptr<JointClip> cached = FindCached(key);
+            if(cached != nullptr) return cached;
+        }
+
+        Files::MappedFile file;
+        if(!file.Open(path)) return nullptr;
+
+        std::shared_ptr<JointClip> clip = ReadClip(file.GetData(), file.GetSize(), lossless);
+        if(useCache) InsertCached(key, clip);
+        return clip;
+    }
+
+    std::shared_ptr<JointClip> LoadClipMemory(const uint8_t* data, size_t size, bool lossless, bool useCache){
+        std::string key;
+        if(useCache){
+            key = MakeCacheKey(ModelCache::MakeMemoryKey(data, size), lossless);
+            std::shared_ptr<JointClip> cached = FindCached(key);
+            if(cached != nullptr) return cached;
+        }
+
+        std::shared_ptr<JointClip> clip = ReadClip(data, size, lossless);
+        if(useCache) InsertCached(key, clip);
+        return clip;
+    }
+
+    ClipCacheStats GetCacheStats(){
+        ClipCacheStats current = cacheStats;
+        for(auto& [key, entry] : cachedClips){
+            std::shared_ptr<JointClip> clip = entry.lock();
+            if(clip == nullptr) continue;
+
+            current.Entries++;
+            current.BytesUsed += clip->GetMemorySize();
+        }
+        return current;
+    }
+
+    void ClearCache(){
+        cachedClips.clear();
+        cacheSweepSize = 64;
+        playing.clear();
+        advancedFrame = UINT64_MAX;
+    }
+
+    size_t JointClip::GetMemorySize() const {
+        return sizeof(JointClip)
+             + (ConstantPose.capacity() + ReferencePose.capacity()) * sizeof(float)
+             + Tracks.capacity() * sizeof(ClipTrack)
+             + (Times.capacity() + Values.capacity() + InSlopes.capacity() + OutSlopes.capacity()) * sizeof(float)
+             + PackedTimes.capacity() * sizeof(uint16_t)
+             + (PackedValues.capacity() + PackedInSlopes.capacity() + PackedOutSlopes.capacity()) * sizeof(int16_t);
+    }
+
+    float WrapFrame(float frame, float duration, LoopMode loop){
+        if(duration <= 0.0f || frame <= 0.0f) return 0.0f;
+
+        switch(loop){
+            case LoopMode::Loop:
+                return std::fmod(frame, duration);
+            case LoopMode::OnceReset:
+                return frame >= duration ? 0.0f : frame;
+            case LoopMode::MirroredOnce:
+                if(frame >= duration * 2.0f) return 0.0f;
+                return frame > duration ? duration * 2.0f - frame : frame;
+            case LoopMode::MirroredLoop: {
+                float phase = std::fmod(frame, duration * 2.0f);
+                return phase > duration ? duration * 2.0f - phase : phase;
+            }
+            case LoopMode::Once:
+            default:
+                return std::min(frame, duration);
+        }
+    }
+
+    float GetPlayerFrame(const ClipPlayer& player){
+        if(player.Clip == nullptr) return 0.0f;
+        return WrapFrame(player.Frame, player.Clip->Duration, player.Loop);
+    }
+
+    // Keeps the accumulated frame within one cycle so it doesn't lose precision over long sessions.
+    static void AdvancePlayer(ClipPlayer& player, float dt){
+        if(player.FadeRate > 0.0f){
+            float step = player.FadeRate * dt;
+            if(std::abs(player.TargetWeight - player.Weight) <= step){
+                player.Weight = player.TargetWeight;
+                player.FadeRate = 0.0f;
+            }
+            else {
+                player.Weight += player.TargetWeight > player.Weight ? step : -step;
+            }
+        }
+
+        if(player.Paused) return;
+
+        float duration = player.Clip->Duration;
+        player.Frame += dt * FramesPerSecond * player.Speed;
+
+        if(player.Loop == LoopMode::Loop || player.Loop == LoopMode::MirroredLoop){
+            float cycle = player.Loop == LoopMode::Loop ? duration : duration * 2.0f;
+            if(cycle <= 0.0f){
+                player.Frame = 0.0f;
+                return;
+            }
+
+            player.Frame = std::fmod(player.Frame, cycle);
+            if(player.Frame < 0.0f) player.Frame += cycle;
+        }
+        else {
+            player.Frame = std::clamp(player.Frame, 0.0f, duration * 2.0f);
+        }
+    }
+
+    // Segment of each track around the sampled frame, laid out so the interpolation runs as one flat loop.
+    struct SampleBatch {
+        std::vector<float> U, Value0, Value1, Slope0, Slope1, Result;
+
+        void Resize(size_t count){
+            for(std::vector<float>* column : { &U, &Value0, &Value1, &Slope0, &Slope1, &Result }) column->resize(count);
+        }
+    };
+
+    template<typename Time>
+    static void FindKeys(const Time* times, uint32_t count, float frame, uint32_t& prev, uint32_t& next, float& u, float& span){
+        u = 0.0f;
+        span = 0.0f;
+
+        if(frame <= (float)times[0]){
+            prev = next = 0;
+            return;
+        }
+        if(frame >= (float)times[count - 1]){
+            prev = next = count - 1;
+            return;
+        }
+
+        next = (uint32_t)(std::upper_bound(times, times + count, frame, [](float value, Time time){ return value < (float)time; }) - times);
+        prev = next - 1;
+        span = (float)times[next] - (float)times[prev];
+        u = (frame - (float)times[prev]) / span;
+    }
+
+    // Looks up the keys either side of frame and writes the segment's endpoints, slopes scaled by the span.
+    static void LocateTrack(const JointClip& clip, const ClipTrack& track, float frame, SampleBatch& batch, size_t i){
+        uint32_t prev, next;
+        float u, span;
+
+        if(clip.Stepped){
+            prev = next = std::min<uint32_t>((uint32_t)std::max(frame, 0.0f), track.Count - 1u);
+            u = span = 0.0f;
+        }
+        else if(track.Packed){
+            FindKeys(clip.PackedTimes.data() + track.First, track.Count, frame, prev, next, u, span);
+        }
+        else {
+            FindKeys(clip.Times.data() + track.First, track.Count, frame, prev, next, u, span);
+        }
+
+        batch.U[i] = u;
+        if(track.Packed){
+            const int16_t* values = clip.PackedValues.data() + track.First;
+            batch.Value0[i] = track.ValueOffset + values[prev] * track.ValueScale;
+            batch.Value1[i] = track.ValueOffset + values[next] * track.ValueScale;
+        }
+        else {
+            const float* values = clip.Values.data() + track.First;
+            batch.Value0[i] = values[prev];
+            batch.Value1[i] = values[next];
+        }
+
+        if(span == 0.0f){
+            batch.Slope0[i] = batch.Slope1[i] = 0.0f;
+            return;
+        }
+
+        if(track.Packed){
+            const int16_t* inSlopes = clip.PackedInSlopes.data() + track.First;
+            const int16_t* outSlopes = track.SharedSlopes ? inSlopes : clip.PackedOutSlopes.data() + track.OutFirst;
+            batch.Slope0[i] = outSlopes[prev] * track.SlopeScale * span;
+            batch.Slope1[i] = inSlopes[next] * track.SlopeScale * span;
+        }
+        else {
+            const float* inSlopes = clip.InSlopes.data() + track.First;
+            const float* outSlopes = track.SharedSlopes ? inSlopes : clip.OutSlopes.data() + track.OutFirst;
+            batch.Slope0[i] = outSlopes[prev] * span;
+            batch.Slope1[i] = inSlopes[next] * span;
+        }
+    }
+
+    void Sample(const JointClip& clip, float frame, float* pose){
+        thread_local SampleBatch batch;
+
+        size_t trackCount = clip.Tracks.size();
+        batch.Resize(trackCount);
+
+        for(size_t i = 0; i < trackCount; i++){
+            LocateTrack(clip, clip.Tracks[i], frame, batch, i);
+        }
+
+        // cubic hermite over every located track with the kernel picked for this CPU
+        Simd::GetKernels().Hermite(batch.U.data(), batch.Value0.data(), batch.Value1.data(), batch.Slope0.data(), batch.Slope1.data(), batch.Result.data(), trackCount);
+
+        std::copy(clip.ConstantPose.begin(), clip.ConstantPose.end(), pose);
+        for(size_t i = 0; i < trackCount; i++){
+            pose[clip.Tracks[i].Target] = batch.Result[i];
+        }
+    }
+
+    static void PutU16(uint8_t* out, uint16_t value){
+        out[0] = (uint8_t)(value >> 8);
+        out[1] = (uint8_t)value;
+    }
+
+    static void PutU32(uint8_t* out, uint32_t value){
+        out[0] = (uint8_t)(value >> 24);
+        out[1] = (uint8_t)(value >> 16);
+        out[2] = (uint8_t)(value >> 8);
+        out[3] = (uint8_t)value;
+    }
+
+    static void PutF32(uint8_t* out, float value){
+        uint32_t bits;
+        std::memcpy(&bits, &value, 4);
+        PutU32(out, bits);
+    }
+
+    static size_t Align32(size_t offset){
+        return (offset + 31) & ~(size_t)31;
+    }
+
+    void WritePose(const float* pose, uint16_t jointCount, std::vector<uint8_t>& out){
+        const size_t sectionStart = 0x20;
+        const size_t jointTable = 0x40;
+        uint32_t valueCount = jointCount * 3u;
+
+        // section relative offsets of the scale, rotation and translation tables
+        size_t scaleTable = Align32(jointTable + jointCount * FullJointEntrySize);
+        size_t rotationTable = Align32(scaleTable + valueCount * 4);
+        size_t translationTable = Align32(rotationTable + valueCount * 2);
+        size_t sectionSize = Align32(translationTable + valueCount * 4);
+
+        out.assign(sectionStart + sectionSize, 0);
+        uint8_t* file = out.data();
+        uint8_t* section = file + sectionStart;
+
+        std::memcpy(file, "J3D1bca1", 8);
+        PutU32(file + 0x08, (uint32_t)out.size());
+        PutU32(file + 0x0C, 1);
+        std::memcpy(file + 0x10, "SVR1", 4);
+        std::memset(file + 0x14, 0xFF, 12);
+
+        std::memcpy(section, "ANF1", 4);
+        PutU32(section + 0x04, (uint32_t)sectionSize);
+        section[0x08] = (uint8_t)LoopMode::Once;
+        section[0x09] = 0xFF;
+        PutU16(section + 0x0A, 1);
+        PutU16(section + 0x0C, jointCount);
+        PutU16(section + 0x0E, (uint16_t)valueCount);
+        PutU16(section + 0x10, (uint16_t)valueCount);
+        PutU16(section + 0x12, (uint16_t)valueCount);
+        PutU32(section + 0x14, (uint32_t)jointTable);
+        PutU32(section + 0x18, (uint32_t)scaleTable);
+        PutU32(section + 0x1C, (uint32_t)rotationTable);
+        PutU32(section + 0x20, (uint32_t)translationTable);
+
+        // every track is a single value, stored axis-major per joint so index = joint * 3 + axis
+        for(uint32_t joint = 0; joint < jointCount; joint++){
+            uint8_t* entry = section + jointTable + joint * FullJointEntrySize;
+            for(uint32_t component = 0; component < ComponentCount; component++){
+                uint32_t index = joint * 3 + component / 3;
+                PutU16(entry + component * 4, 1);
+                PutU16(entry + component * 4 + 2, (uint16_t)index);
+
+                float value = pose[component * jointCount + joint];
+                switch(component % 3){
+                    case 0:
+                        PutF32(section + scaleTable + index * 4, value);
+                        break;
+                    case 1: {
+                        // wrap to [-180, 180) so the angle survives the 16 bit encode
+                        float wrapped = value - 360.0f * std::floor((value + 180.0f) / 360.0f);
+                        PutU16(section + rotationTable + index * 2, (uint16_t)(int16_t)std::lround(std::clamp(wrapped / AngleScale, -32768.0f, 32767.0f)));
+                        break;
+                    }
+                    case 2:
+                        PutF32(section + translationTable + index * 4, value);
+                        break;
+                }
+            }
+        }
+    }
+
+    static bool IsFullClip(const std::shared_ptr<const JointClip>& clip){
+        return clip != nullptr && clip->Stepped;
+    }
+
+    // Hands the slots the playing clip took back: the user's BCA returns after a BCK clip, a BCA clip leaves its slot empty.
+    static void ReleaseSlots(Instances::InstanceRecord& record, J3DModelInstance* instance){
+        if(record.Player.Clip == nullptr) return;
+
+        instance->SetJointFullAnimation(IsFullClip(record.Player.Clip) ? nullptr : record.UserFullAnimation);
+        record.UserFullAnimation = nullptr;
+        record.PoseAnimation = nullptr;
+    }
+
+    // The BCA slot carries the sampled pose. A BCK clip replaces the BCK slot and sets the user's BCA aside,
+    // a BCA clip replaces the BCA slot and leaves the BCK slot alone.
+    static void TakeSlots(Instances::InstanceRecord& record, J3DModelInstance* instance){
+        if(!IsFullClip(record.Player.Clip)){
+            record.UserFullAnimation = instance->GetJointFullAnimation();
+            instance->SetJointAnimation(nullptr);
+        }
+        instance->SetJointFullAnimation(nullptr);
+    }
+
+    // Swaps the base player's clip, the pose of the new one goes in at the next Update.
+    static void SetBaseClip(Instances::InstanceRecord& record, J3DModelInstance* instance, std::shared_ptr<const JointClip> clip){
+        ReleaseSlots(record, instance);
+
+        record.Player = ClipPlayer();
+        record.Player.Clip = clip;
+        if(clip == nullptr) return;
+
+        record.Player.Loop = clip->Loop;
+        playing.insert(instance);
+        TakeSlots(record, instance);
+    }
+
+    void Attach(J3DModelInstance* instance, std::shared_ptr<const JointClip> clip){
+        Instances::InstanceRecord* record = Instances::Find(instance);
+        if(record == nullptr) return;
+
+        SetBaseClip(*record, instance, clip);
+
+        // fading crossfade sources belonged to the clip being replaced
+        record->Layers.erase(std::remove_if(record->Layers.begin(), record->Layers.end(), [](const ClipLayer& layer){ return layer.RemoveWhenFaded; }), record->Layers.end());
+        if(clip == nullptr){
+            record->Layers.clear();
+            record->Pose.clear();
+            playing.erase(instance);
+        }
+    }
+
+    std::shared_ptr<J3DAnimation::J3DJointAnimationInstance> GetJointAnimation(J3DModelInstance* instance){
+        return instance->GetJointAnimation();
+    }
+
+    std::shared_ptr<J3DAnimation::J3DJointFullAnimationInstance> GetJointFullAnimation(J3DModelInstance* instance){
+        Instances::InstanceRecord* record = Instances::Find(instance);
+        if(record != nullptr && record->Player.Clip != nullptr){
+            return IsFullClip(record->Player.Clip) ? nullptr : record->UserFullAnimation;
+        }
+        return instance->GetJointFullAnimation();
+    }
+
+    void SetJointAnimation(J3DModelInstance* instance, std::shared_ptr<J3DAnimation::J3DJointAnimationInstance> anim){
+        Instances::InstanceRecord* record = Instances::Find(instance);
+        if(record != nullptr && record->Player.Clip != nullptr && !IsFullClip(record->Player.Clip)) Attach(instance, nullptr);
+
+        instance->SetJointAnimation(anim);
+    }
+
+    void SetJointFullAnimation(J3DModelInstance* instance, std::shared_ptr<J3DAnimation::J3DJointFullAnimationInstance> anim){
+        Instances::InstanceRecord* record = Instances::Find(instance);
+        if(record != nullptr && IsFullClip(record->Player.Clip)) Attach(instance, nullptr);
+
+        if(record != nullptr && record->Player.Clip != nullptr){
+            record->UserFullAnimation = anim;
+            return;
+        }
+        instance->SetJointFullAnimation(anim);
+    }
+
+    ClipPlayer* FindPlayer(J3DModelInstance* instance){
+        Instances::InstanceRecord* record = Instances::Find(instance);
+        return record != nullptr ? &record->Player : nullptr;
+    }
+
+    void FadeWeight(ClipPlayer& player, float weight, float duration){
+        player.TargetWeight = weight;
+        if(duration <= 0.0f){
+            player.Weight = weight;
+            player.FadeRate = 0.0f;
+            return;
+        }
+
+        player.FadeRate = std::abs(weight - player.Weight) / duration;
+    }
+
+    void Crossfade(J3DModelInstance* instance, std::shared_ptr<const JointClip> clip, float duration){
+        Instances::InstanceRecord* record = Instances::Find(instance);
+        if(record == nullptr) return;
+
+        if(record->Player.Clip == nullptr || clip == nullptr || duration <= 0.0f){
+            Attach(instance, clip);
+            return;
+        }
+
+        ClipLayer outgoing;
+        outgoing.Player = record->Player;
+        outgoing.Id = record->NextLayerId++;
+        outgoing.RemoveWhenFaded = true;
+        FadeWeight(outgoing.Player, 0.0f, duration);
+        record->Layers.push_back(outgoing);
+
+        SetBaseClip(*record, instance, clip);
+        record->Player.Weight = 0.0f;
+        FadeWeight(record->Player, 1.0f, duration);
+    }
+
+    uint32_t AddLayer(J3DModelInstance* instance, std::shared_ptr<const JointClip> clip, float weight, BlendMode mode){
+        Instances::InstanceRecord* record = Instances::Find(instance);
+        if(record == nullptr || clip == nullptr) return 0;
+
+        ClipLayer layer;
+        layer.Player.Clip = clip;
+        layer.Player.Loop = clip->Loop;
+        layer.Player.Weight = layer.Player.TargetWeight = weight;
+        layer.Mode = mode;
+        layer.Id = record->NextLayerId++;
+        record->Layers.push_back(layer);
+        playing.insert(instance);
+
+        return layer.Id;
+    }
+
+    ClipLayer* FindLayer(J3DModelInstance* instance, uint32_t id){
+        Instances::InstanceRecord* record = Instances::Find(instance);
+        if(record == nullptr) return nullptr;
+
+        for(ClipLayer& layer : record->Layers){
+            if(layer.Id == id) return &layer;
+        }
+        return nullptr;
+    }
+
+    bool RemoveLayer(J3DModelInstance* instance, uint32_t id){
+        Instances::InstanceRecord* record = Instances::Find(instance);
+        if(record == nullptr) return false;
+
+        auto it = std::find_if(record->Layers.begin(), record->Layers.end(), [id](const ClipLayer& layer){ return layer.Id == id; });
+        if(it == record->Layers.end()) return false;
+
+        record->Layers.erase(it);
+        return true;
+    }
+
+    const UpdateStats& GetStats(){
+        return stats;
+    }
+
+    // Joint rotations blend as quaternions. Euler angles compose as Rz * Ry * Rx like J3DFile::MakeJointMatrix.
+    struct Quat {
+        float W = 1.0f, X = 0.0f, Y = 0.0f, Z = 0.0f;
+    };
+
+    static const float DegreesToRadians = 3.14159265358979f / 180.0f;
+
+    static Quat Multiply(const Quat& a, const Quat& b){
+        return {
+            a.W * b.W - a.X * b.X - a.Y * b.Y - a.Z * b.Z,
+            a.W * b.X + a.X * b.W + a.Y * b.Z - a.Z * b.Y,
+            a.W * b.Y - a.X * b.Z + a.Y * b.W + a.Z * b.X,
+            a.W * b.Z + a.X * b.Y - a.Y * b.X + a.Z * b.W
+        };
+    }
+
+    static Quat Conjugate(const Quat& q){
+        return { q.W, -q.X, -q.Y, -q.Z };
+    }
+
+    static Quat FromEuler(float x, float y, float z){
+        float cx = std::cos(x * 0.5f * DegreesToRadians), sx = std::sin(x * 0.5f * DegreesToRadians);
+        float cy = std::cos(y * 0.5f * DegreesToRadians), sy = std::sin(y * 0.5f * DegreesToRadians);
+        float cz = std::cos(z * 0.5f * DegreesToRadians), sz = std::sin(z * 0.5f * DegreesToRadians);
+
+        return {
+            cx * cy * cz + sx * sy * sz,
+            sx * cy * cz - cx * sy * sz,
+            cx * sy * cz + sx * cy * sz,
+            cx * cy * sz - sx * sy * cz
+        };
+    }
+
+    static void ToEuler(const Quat& q, float& x, float& y, float& z){
+        // y and z from the rotation matrix's first column
+        float r00 = 1.0f - 2.0f * (q.Y * q.Y + q.Z * q.Z), r10 = 2.0f * (q.X * q.Y + q.W * q.Z);
+        float r20 = 2.0f * (q.X * q.Z - q.W * q.Y);
+        float zRadians = std::atan2(r10, r00);
+        y = std::atan2(-r20, std::sqrt(r00 * r00 + r10 * r10)) / DegreesToRadians;
+        z = zRadians / DegreesToRadians;
+
+        // x from Rz^-1 * R = Ry * Rx, which stays well conditioned near +-90 degrees of y where z is mostly noise
+        float r01 = 2.0f * (q.X * q.Y - q.W * q.Z), r02 = 2.0f * (q.X * q.Z + q.W * q.Y);
+        float r11 = 1.0f - 2.0f * (q.X * q.X + q.Z * q.Z), r12 = 2.0f * (q.Y * q.Z - q.W * q.X);
+        float cz = std::cos(zRadians), sz = std::sin(zRadians);
+        x = std::atan2(sz * r02 - cz * r12, cz * r11 - sz * r01) / DegreesToRadians;
+    }
+
+    // Shortest path, falls back to a normalized lerp when the rotations are too close for the sine to be stable.
+    static Quat Slerp(const Quat& a, Quat b, float t){
+        float cosTheta = a.W * b.W + a.X * b.X + a.Y * b.Y + a.Z * b.Z;
+        if(cosTheta < 0.0f){
+            b = { -b.W, -b.X, -b.Y, -b.Z };
+            cosTheta = -cosTheta;
+        }
+
+        float wa = 1.0f - t, wb = t;
+        if(cosTheta < 0.9995f){
+            float theta = std::acos(cosTheta), sinTheta = std::sin(theta);
+            wa = std::sin((1.0f - t) * theta) / sinTheta;
+            wb = std::sin(t * theta) / sinTheta;
+        }
+
+        Quat q = { wa * a.W + wb * b.W, wa * a.X + wb * b.X, wa * a.Y + wb * b.Y, wa * a.Z + wb * b.Z };
+        float length = std::sqrt(q.W * q.W + q.X * q.X + q.Y * q.Y + q.Z * q.Z);
+        return { q.W / length, q.X / length, q.Y / length, q.Z / length };
+    }
+
+    static Quat GetRotation(const float* pose, uint32_t jointCount, uint32_t joint){
+        return FromEuler(pose[RotationX * jointCount + joint], pose[RotationY * jointCount + joint], pose[RotationZ * jointCount + joint]);
+    }
+
+    static void SetRotation(float* pose, uint32_t jointCount, uint32_t joint, const Quat& rotation){
+        ToEuler(rotation, pose[RotationX * jointCount + joint], pose[RotationY * jointCount + joint], pose[RotationZ * jointCount + joint]);
+    }
+
+    // Adds weight * (layer - base) into sum for scales and translations, rotations are left to BlendRotations.
+    static void AccumulateOverride(const float* base, const float* layer, float weight, float* sum, uint32_t jointCount){
+        for(uint32_t component = 0; component < ComponentCount; component++){
+            if(IsRotation(component)) continue;
+
+            size_t begin = component * jointCount, end = begin + jointCount;
+            for(size_t i = begin; i < end; i++) sum[i] += weight * (layer[i] - base[i]);
+        }
+    }
+
+    // Folds one more override layer into the running weighted average, share is its weight over the total so far.
+    static void BlendRotations(Quat* rotations, const float* layer, float share, uint32_t jointCount){
+        for(uint32_t joint = 0; joint < jointCount; joint++){
+            rotations[joint] = Slerp(rotations[joint], GetRotation(layer, jointCount, joint), share);
+        }
+    }
+
+    // Applies the layer's offset from its reference pose, scales multiply so a layer at rest leaves them unchanged.
+    // The rotation offset is turned by weight and applied in the joint's local frame.
+    static void ApplyAdditive(float* pose, Quat* rotations, const float* layer, const float* reference, float weight, uint32_t jointCount){
+        for(uint32_t component = 0; component < ComponentCount; component++){
+            size_t begin = component * jointCount, end = begin + jointCount;
+            switch(component % 3){
+                case 0:
+                    for(size_t i = begin; i < end; i++){
+                        float ratio = reference[i] != 0.0f ? layer[i] / reference[i] : 1.0f;
+                        pose[i] *= 1.0f + weight * (ratio - 1.0f);
+                    }
+                    break;
+                case 2:
+                    for(size_t i = begin; i < end; i++) pose[i] += weight * (layer[i] - reference[i]);
+                    break;
+            }
+        }
+
+        for(uint32_t joint = 0; joint < jointCount; joint++){
+            Quat offset = Multiply(Conjugate(GetRotation(reference, jointCount, joint)), GetRotation(layer, jointCount, joint));
+            rotations[joint] = Multiply(rotations[joint], Slerp(Quat(), offset, weight));
+        }
+    }
+
+    // Folds the job's layers into the sampled base pose.
+    static void BlendLayers(const PoseJob& job, std::vector<float>& pose){
+        thread_local std::vector<float> layerPose, blendSum;
+        thread_local std::vector<Quat> rotations;
+
+        uint32_t jointCount = job.Clip->JointCount;
+        size_t poseSize = pose.size();
+        layerPose.resize(poseSize);
+
+        rotations.resize(jointCount);
+        for(uint32_t joint = 0; joint < jointCount; joint++){
+            rotations[joint] = GetRotation(pose.data(), jointCount, joint);
+        }
+
+        // override layers first so additive ones land on the blended result
+        float totalWeight = job.Weight;
+        bool blended = false;
+        blendSum.assign(poseSize, 0.0f);
+
+        for(uint32_t l = job.LayerFirst; l < job.LayerFirst + job.LayerCount; l++){
+            const LayerJob& layer = layerJobs[l];
+            if(layer.Mode != BlendMode::Override) continue;
+
+            Sample(*layer.Clip, layer.Frame, layerPose.data());
+            AccumulateOverride(pose.data(), layerPose.data(), layer.Weight, blendSum.data(), jointCount);
+            totalWeight += layer.Weight;
+            if(totalWeight > 0.0f) BlendRotations(rotations.data(), layerPose.data(), layer.Weight / totalWeight, jointCount);
+            blended = true;
+        }
+
+        if(blended && totalWeight > 0.0f){
+            float scale = 1.0f / totalWeight;
+            for(size_t k = 0; k < poseSize; k++) pose[k] += blendSum[k] * scale;
+        }
+
+        for(uint32_t l = job.LayerFirst; l < job.LayerFirst + job.LayerCount; l++){
+            const LayerJob& layer = layerJobs[l];
+            if(layer.Mode != BlendMode::Additive) continue;
+
+            Sample(*layer.Clip, layer.Frame, layerPose.data());
+            ApplyAdditive(pose.data(), rotations.data(), layerPose.data(), layer.Clip->ReferencePose.data(), layer.Weight, jointCount);
+        }
+
+        for(uint32_t joint = 0; joint < jointCount; joint++){
+            SetRotation(pose.data(), jointCount, joint, rotations[joint]);
+        }
+    }
+
+    // Scales and translations lerp, each rotation angle takes the short way round. Samples an interval apart
+    // are close enough that the angles don't need to go through quaternions.
+    static void LerpPose(const float* from, const float* to, float t, float* out, uint32_t jointCount){
+        for(uint32_t component = 0; component < ComponentCount; component++){
+            bool rotation = IsRotation(component);
+            size_t begin = component * jointCount, end = begin + jointCount;
+            for(size_t i = begin; i < end; i++){
+                float delta = to[i] - from[i];
+                if(rotation) delta -= 360.0f * std::floor((delta + 180.0f) / 360.0f);
+                out[i] = from[i] + t * delta;
+            }
+        }
+    }
+
+    static void EvaluatePoses(size_t begin, size_t end){
+        for(size_t i = begin; i < end; i++){
+            PoseJob& job = poseJobs[i];
+            Instances::InstanceRecord& record = *job.Record;
+            std::vector<float>& pose = poseBuffers[i];
+            uint32_t jointCount = job.Clip->JointCount;
+
+            pose.resize(jointCount * ComponentCount);
+            if(job.Resample){
+                Sample(*job.Clip, job.Frame, pose.data());
+                if(job.LayerCount > 0) BlendLayers(job, pose);
+
+                // a new sample to blend toward, starting from what's on screen. Each record has one job at most
+                // and Update only swaps record.Pose after the workers are done.
+                if(job.Blend >= 0.0f){
+                    record.PoseFrom = record.Pose.size() == pose.size() ? record.Pose : pose;
+                    record.PoseTo = pose;
+                }
+            }
+            if(job.Blend >= 0.0f) LerpPose(record.PoseFrom.data(), record.PoseTo.data(), job.Blend, pose.data(), jointCount);
+
+            WritePose(pose.data(), jointCount, encodedPoses[i]);
+        }
+    }
+
+    template<typename T>
+    static uint64_t HashValue(uint64_t hash, const T& value){
+        return HashBytes((const uint8_t*)&value, sizeof(T), hash);
+    }
+
+    // Clips, frames, weights and modes of the base and its layers, equal inputs sample to an equal pose.
+    static uint64_t HashInputs(const PoseJob& job){
+        uint64_t hash = HashValue(HashValue(HashValue(0, job.Clip.get()), job.Frame), job.Weight);
+        for(uint32_t l = job.LayerFirst; l < job.LayerFirst + job.LayerCount; l++){
+            const LayerJob& layer = layerJobs[l];
+            hash = HashValue(HashValue(HashValue(HashValue(hash, layer.Clip.get()), layer.Frame), layer.Weight), layer.Mode);
+        }
+        return hash;
+    }
+
+    // Advances every player once per frame, whether or not any renderer draws its instance.
+    static void AdvanceAll(float dt){
+        uint64_t frame = FrameClock::GetFrame();
+        if(frame == advancedFrame) return;
+        advancedFrame = frame;
+
+        for(auto it = playing.begin(); it != playing.end();){
+            Instances::InstanceRecord* record = Instances::Find(*it);
+            if(record == nullptr || (record->Player.Clip == nullptr && record->Layers.empty())){
+                it = playing.erase(it);
+                continue;
+            }
+
+            if(record->Player.Clip != nullptr) AdvancePlayer(record->Player, dt);
+            for(ClipLayer& layer : record->Layers){
+                AdvancePlayer(layer.Player, dt);
+            }
+            record->Layers.erase(std::remove_if(record->Layers.begin(), record->Layers.end(), [](const ClipLayer& layer){
+                return layer.RemoveWhenFaded && layer.Player.Weight <= 0.0f && layer.Player.FadeRate == 0.0f;
+            }), record->Layers.end());
+            ++it;
+        }
+    }
+
+    void Update(J3DModelInstance* const* instances, size_t count, float dt){
+        PYJ3D_PROFILE_STAGE(JointAnimation);
+
+        AdvanceAll(dt);
+        uint64_t frame = FrameClock::GetFrame();
+
+        stats = UpdateStats();
+        poseJobs.clear();
+        layerJobs.clear();
+        sharedPoses.clear();
+        unblendedJobs.clear();
+
+        for(size_t i = 0; i < count; i++){
+            Instances::InstanceRecord* record = Instances::Find(instances[i]);
+            if(record == nullptr || record->Player.Clip == nullptr) continue;
+
+            ClipPlayer& player = record->Player;
+            stats.Instances++;
+
+            PoseJob job = { instances[i], record, player.Clip, GetPlayerFrame(player), player.Weight, (uint32_t)layerJobs.size(), 0, 0, -1.0f, true };
+            uint32_t interval = record->AnimInterval;
+            size_t poseSize = player.Clip->JointCount * ComponentCount;
+
+            if(record->AnimThrottled){
+                // held, but interpolating moves the pose another step toward the last sample
+                if(interval <= 1 || record->PoseTo.size() != poseSize || record->PoseFrom.size() != poseSize){
+                    stats.Held++;
+                    continue;
+                }
+
+                job.Resample = false;
+                job.Blend = std::min((float)(frame - record->PoseSampleFrame + 1) / interval, 1.0f);
+                job.Inputs = HashValue(HashValue(0, record->PoseSampleFrame), job.Blend);
+                if(record->PoseAnimation != nullptr && record->PoseInputs == job.Inputs && instances[i]->GetJointFullAnimation() == record->PoseAnimation){
+                    stats.Reused++;
+                    continue;
+                }
+
+                poseJobs.push_back(job);
+                continue;
+            }
+
+            // another renderer already sampled this interpolating clip this frame, resampling would restart its blend
+            if(interval > 1){
+                if(record->PoseSampleFrame == frame && record->PoseAnimation != nullptr){
+                    stats.Reused++;
+                    continue;
+                }
+                job.Blend = 1.0f / interval;
+            }
+
+            for(const ClipLayer& layer : record->Layers){
+                // a layer for another skeleton can't be blended joint for joint
+                if(layer.Player.Weight <= 0.0f || layer.Player.Clip->JointCount != player.Clip->JointCount) continue;
+
+                layerJobs.push_back({ layer.Player.Clip, GetPlayerFrame(layer.Player), layer.Player.Weight, layer.Mode });
+                job.LayerCount++;
+            }
+
+            stats.Layers += job.LayerCount;
+
+            // paused, finished or otherwise unchanged since its last pose, the instance in the slot still shows it
+            job.Inputs = HashInputs(job);
+            if(record->PoseAnimation != nullptr && record->PoseInputs == job.Inputs && instances[i]->GetJointFullAnimation() == record->PoseAnimation){
+                layerJobs.resize(job.LayerFirst);
+                stats.Reused++;
+                continue;
+            }
+
+            // a crowd playing one clip in step samples and parses it once
+            if(job.LayerCount == 0 && job.Blend < 0.0f){
+                auto [it, added] = unblendedJobs.try_emplace({ job.Clip.get(), job.Frame }, (uint32_t)poseJobs.size());
+                if(!added){
+                    sharedPoses.push_back({ instances[i], record, it->second });
+                    continue;
+                }
+            }
+            poseJobs.push_back(job);
+        }
+
+        if(poseBuffers.size() < poseJobs.size()){
+            poseBuffers.resize(poseJobs.size());
+            encodedPoses.resize(poseJobs.size());
+        }
+        Jobs::ParallelFor(poseJobs.size(), MinParallelBatch, EvaluatePoses);
+
+        // the library's loader isn't thread safe and touches nothing the workers need, so poses are parsed here
+        J3DAnimation::J3DAnimationLoader Loader;
+        for(size_t i = 0; i < poseJobs.size(); i++){
+            PoseJob& job = poseJobs[i];
+            Instances::InstanceRecord& record = *job.Record;
+
+            // the record keeps the pose on screen for raycasts, its old buffer is reused next frame
+            record.Pose.swap(poseBuffers[i]);
+            record.PoseVersion++;
+
+            // a full rate sample ends any blend, the next throttled one starts from the pose on screen
+            if(job.Resample && job.Blend >= 0.0f) record.PoseSampleFrame = frame;
+            else if(job.Resample) record.PoseTo.clear();
+
+            std::vector<uint8_t>& encoded = encodedPoses[i];
+            std::shared_ptr<J3DAnimation::J3DJointFullAnimationInstance> pose = std::dynamic_pointer_cast<J3DAnimation::J3DJointFullAnimationInstance>(Loader.LoadAnimation((void*)encoded.data(), encoded.size()));
+            if(pose == nullptr) continue;
+
+            // a one frame clip, nothing for the library to tick
+            pose->SetPaused(true);
+            record.PoseAnimation = pose;
+            record.PoseInputs = job.Inputs;
+            job.Instance->SetJointFullAnimation(pose);
+
+            if(job.Resample){
+                stats.Evaluated++;
+                stats.Joints += job.Clip->JointCount;
+            }
+            else {
+                stats.Interpolated++;
+            }
+        }
+
+        for(const SharedPose& shared : sharedPoses){
+            Instances::InstanceRecord& source = *poseJobs[shared.Job].Record;
+            if(source.PoseAnimation == nullptr) continue;
+
+            shared.Record->Pose = source.Pose;
+            shared.Record->PoseVersion++;
+            shared.Record->PoseAnimation = source.PoseAnimation;
+            shared.Record->PoseInputs = source.PoseInputs;
+            shared.Record->PoseTo.clear();
+            shared.Instance->SetJointFullAnimation(source.PoseAnimation);
+            stats.Shared++;
+        }
+
+        PYJ3D_PROFILE_COUNT(AnimationEvaluations, stats.Evaluated);
+    }
+
+    void Update(const std::vector<std::shared_ptr<J3DModelInstance>>& instances, float dt){
+        batchInstances.clear();
+        for(const std::shared_ptr<J3DModelInstance>& instance : instances){
+            batchInstances.push_back(instance.get());
+        }
+
+        Update(batchInstances.data(), batchInstances.size(), dt);
+    }
+}
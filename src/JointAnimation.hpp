@@ -0,0 +1,187 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+class J3DModelInstance;
+namespace J3DAnimation {
+    class J3DAnimationInstance;
+    class J3DJointAnimationInstance;
+    class J3DJointFullAnimationInstance;
+}
+
+namespace PyJ3D::JointAnimation {
+    enum class LoopMode : uint8_t {
+        Once = 0,
+        OnceReset = 1,
+        Loop = 2,
+        MirroredOnce = 3,
+        MirroredLoop = 4
+    };
+
+    // Components of a joint in the order the file's joint table lists them.
+    enum Component : uint32_t {
+        ScaleX, RotationX, TranslationX,
+        ScaleY, RotationY, TranslationY,
+        ScaleZ, RotationZ, TranslationZ,
+        ComponentCount
+    };
+
+    // An animated component. Packed tracks hold 16 bit keys decoded as Offset + raw * Scale,
+    // the rest keep float keys. Key k lives at First + k in its pool, the out slope at OutFirst + k.
+    struct ClipTrack {
+        uint32_t Target = 0; // pose index, component * JointCount + joint
+        uint32_t First = 0;
+        uint32_t OutFirst = 0;
+        uint16_t Count = 0;
+        bool Packed = false;
+        bool SharedSlopes = true; // in slope doubles as the out slope, OutFirst is unused
+        float ValueScale = 1.0f;
+        float ValueOffset = 0.0f;
+        float SlopeScale = 1.0f;
+    };
+
+    // Keyframes of a BCK (ANK1) or BCA (ANF1) with rotations in degrees. Components that never change
+    // are folded into ConstantPose and only animated ones keep a track. Never modified after ReadClip,
+    // so one clip can be sampled by any number of instances and threads.
+    struct JointClip {
+        LoopMode Loop = LoopMode::Once;
+        uint16_t Duration = 0;
+        uint16_t JointCount = 0;
+        bool Stepped = false; // BCA stores one value per frame, keys are frames and have no times or slopes
+
+        std::vector<float> ConstantPose; // laid out like Sample's output
+        std::vector<float> ReferencePose; // the first frame, what an additive layer's offsets are taken from
+        std::vector<ClipTrack> Tracks;
+
+        // structure-of-arrays key pools
+        std::vector<float> Times, Values, InSlopes, OutSlopes;
+        std::vector<uint16_t> PackedTimes;
+        std::vector<int16_t> PackedValues, PackedInSlopes, PackedOutSlopes;
+
+        size_t GetMemorySize() const;
+    };
+
+    // Playback state of one instance. The clip is shared, this is all an extra playing instance costs.
+    struct ClipPlayer {
+        std::shared_ptr<const JointClip> Clip;
+        float Frame = 0.0f; // accumulated frames, wrapped by Loop when sampled
+        float Speed = 1.0f;
+        LoopMode Loop = LoopMode::Once;
+        bool Paused = false;
+
+        // blend weight, moved toward TargetWeight by FadeRate per second
+        float Weight = 1.0f;
+        float TargetWeight = 1.0f;
+        float FadeRate = 0.0f;
+    };
+
+    enum class BlendMode : uint8_t {
+        Override, // weighted average with the base clip and the other override layers, rotations by slerp
+        Additive  // adds the clip's offset from its first frame on top, scaled by weight
+    };
+
+    // A clip blended over an instance's base player. Every layer must animate the same skeleton as the base.
+    struct ClipLayer {
+        ClipPlayer Player;
+        BlendMode Mode = BlendMode::Override;
+        uint32_t Id = 0;
+        bool RemoveWhenFaded = false; // dropped once its weight fades out, set for crossfade sources
+    };
+
+    struct ClipCacheStats {
+        uint64_t Hits = 0;
+        uint64_t Misses = 0;
+        size_t Entries = 0;   // distinct clips still alive
+        size_t BytesUsed = 0; // GetMemorySize summed over them
+    };
+
+    struct UpdateStats {
+        uint32_t Instances = 0; // drawn instances playing a joint clip
+        uint32_t Evaluated = 0; // poses sampled this frame
+        uint32_t Shared = 0;    // unblended players on the same clip frame as an evaluated one, they reuse its pose
+        uint32_t Reused = 0;    // players whose clips, frames and weights didn't change, they keep last frame's pose
+        uint32_t Held = 0;      // kept their last pose because animation level of detail held them
+        uint32_t Interpolated = 0; // held, but moved another step between their last two samples
+        uint32_t Joints = 0;    // joints sampled across every evaluated pose
+        uint32_t Layers = 0;    // blend layers sampled on top of the base clips
+    };
+
+    // Clips advance this many frames per second of dt.
+    static const float FramesPerSecond = 30.0f;
+
+    // Largest error packing may introduce into a sampled scale or translation, keys and slopes included.
+    static const float ScaleTolerance = 1.0f / 4096.0f;
+    static const float TranslationTolerance = 1.0f / 64.0f;
+
+    // nullptr if the data holds neither an ANK1 nor an ANF1 section. Rotations are kept as the file's
+    // 16 bit angles, everything else as the file's floats. With lossless cleared, scale and translation tracks
+    // with whole frame times are packed to 16 bits when Sample stays within ScaleTolerance/TranslationTolerance
+    // of the lossless clip at every frame.
+    std::shared_ptr<JointClip> ReadClip(const uint8_t* data, size_t size, bool lossless = true);
+
+    // Load through the clip cache, keyed like the model cache on path and mtime or on content.
+    // The cache only holds weak references, a clip lives as long as a player or the caller keeps it.
+    std::shared_ptr<JointClip> LoadClipFile(const std::string& path, bool lossless = true, bool useCache = true);
+    std::shared_ptr<JointClip> LoadClipMemory(const uint8_t* data, size_t size, bool lossless = true, bool useCache = true);
+
+    ClipCacheStats GetCacheStats();
+
+    // Also forgets which instances are playing, used on cleanup.
+    void ClearCache();
+
+    // Maps accumulated frames onto [0, duration] following a loop mode.
+    float WrapFrame(float frame, float duration, LoopMode loop);
+    float GetPlayerFrame(const ClipPlayer& player);
+
+    // Writes ComponentCount arrays of JointCount values, pose[component * JointCount + joint].
+    // Every animated track is located first, then all of them are interpolated in one batched pass.
+    void Sample(const JointClip& clip, float frame, float* pose);
+
+    // Encodes a pose as a one frame BCA for the library's loader, how sampled poses reach the renderer.
+    void WritePose(const float* pose, uint16_t jointCount, std::vector<uint8_t>& out);
+
+    // Drive the instance's joints from clip. nullptr detaches. The player restarts at frame 0 with the clip's
+    // loop mode. The pose Update samples goes in the BCA slot: a BCK clip empties the BCK slot and sets the
+    // user's BCA aside until it's detached, a BCA clip replaces the BCA slot and leaves the BCK slot alone.
+    void Attach(J3DModelInstance* instance, std::shared_ptr<const JointClip> clip);
+
+    // The BCK/BCA slots as the user left them. While a clip plays the BCA slot holds its sampled pose,
+    // these return the user's BCA set aside by a BCK clip instead, and nothing for the clip's own slot.
+    std::shared_ptr<J3DAnimation::J3DJointAnimationInstance> GetJointAnimation(J3DModelInstance* instance);
+    std::shared_ptr<J3DAnimation::J3DJointFullAnimationInstance> GetJointFullAnimation(J3DModelInstance* instance);
+
+    // Set a slot to a library instance the caller loaded. A clip playing in that slot is detached first, and a BCA
+    // set while a BCK clip plays goes in once it's detached.
+    void SetJointAnimation(J3DModelInstance* instance, std::shared_ptr<J3DAnimation::J3DJointAnimationInstance> anim);
+    void SetJointFullAnimation(J3DModelInstance* instance, std::shared_ptr<J3DAnimation::J3DJointFullAnimationInstance> anim);
+
+    // nullptr for unknown instances, Clip is null while nothing is attached.
+    ClipPlayer* FindPlayer(J3DModelInstance* instance);
+
+    // Fade the base player over to clip in duration seconds. The outgoing clip keeps playing as a layer
+    // until it has faded out. Without a base clip, or with duration 0, this is the same as Attach.
+    void Crossfade(J3DModelInstance* instance, std::shared_ptr<const JointClip> clip, float duration);
+
+    // Returns the new layer's id, 0 if the instance is unknown.
+    uint32_t AddLayer(J3DModelInstance* instance, std::shared_ptr<const JointClip> clip, float weight, BlendMode mode);
+    ClipLayer* FindLayer(J3DModelInstance* instance, uint32_t id);
+    bool RemoveLayer(J3DModelInstance* instance, uint32_t id);
+
+    // Move a player's weight to weight over duration seconds, immediately when duration is 0.
+    void FadeWeight(ClipPlayer& player, float weight, float duration);
+
+    // Counters from the most recent Update call.
+    const UpdateStats& GetStats();
+
+    // Call for the instances about to be rendered, after AnimationLod::Update and before J3D::Rendering::Render.
+    // Every attached player advances once per FrameClock frame, drawn or not. Poses of the given instances are
+    // sampled, blended and encoded across the worker pool, this thread parses them and hands them to the BCA
+    // slot, so J3DUltra never samples a clip's curves itself. Unblended players on the same clip frame share
+    // one pose instance, and a player whose inputs haven't changed keeps its instance without resampling.
+    void Update(J3DModelInstance* const* instances, size_t count, float dt);
+    void Update(const std::vector<std::shared_ptr<J3DModelInstance>>& instances, float dt);
+}
@@ -0,0 +1,196 @@
+#include "ModelCache.hpp"
+#include "Hash.hpp"
+#include "FileUtil.hpp"
+#include "InstanceRegistry.hpp"
+#include "TextureUpload.hpp"
+#include "ShaderCache.hpp"
+
+#include <filesystem>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+#include <J3D/J3DModelLoader.hpp>
+#include <J3D/Data/J3DModelData.hpp>
+#include <bstream.h>
+
+namespace PyJ3D::ModelCache {
+    struct CacheEntry {
+        std::string Key;
+        std::shared_ptr<J3DModelData> Data;
+        size_t SourceBytes;
+        uint64_t TextureBytes;
+    };
+
+    // loads can come from the async loader's GL pump and Python threads at once
+    static std::mutex cacheMutex;
+
+    // front of the list is the most recently used entry
+    static std::list<CacheEntry> lruList = {};
+    static std::unordered_map<std::string, std::list<CacheEntry>::iterator> entries = {};
+    static CacheStats stats = {};
+    static size_t budget = 512 * 1024 * 1024;
+
+    // source files plus the texture memory the models uploaded, the two things a cached model keeps alive
+    static void EvictToBudget(){
+        while(budget != 0 && stats.SourceBytes + stats.TextureBytes > budget && lruList.size() > 1){
+            CacheEntry& victim = lruList.back();
+            stats.SourceBytes -= victim.SourceBytes;
+            stats.TextureBytes -= victim.TextureBytes;
+            stats.Evictions++;
+            entries.erase(victim.Key);
+            lruList.pop_back();
+        }
+    }
+
+    std::string MakeFileKey(const std::string& path){
+        std::error_code canonicalErr, timeErr;
+        std::filesystem::path canonical = std::filesystem::weakly_canonical(path, canonicalErr);
+        auto mtime = std::filesystem::last_write_time(path, timeErr);
+        if(canonicalErr || timeErr || canonical.empty()) return "";
+
+        return canonical.string() + "|" + std::to_string(mtime.time_since_epoch().count());
+    }
+
+    std::string MakeMemoryKey(const uint8_t* data, size_t size){
+        return "mem|" + std::to_string(size) + "|" + std::to_string(HashBytes(data, size));
+    }
+
+    std::shared_ptr<J3DModelData> Find(const std::string& key){
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        auto it = entries.find(key);
+        if(it == entries.end()){
+            stats.Misses++;
+            return nullptr;
+        }
+
+        stats.Hits++;
+        lruList.splice(lruList.begin(), lruList, it->second);
+        return it->second->Data;
+    }
+
+    bool Contains(const std::string& key){
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        return entries.count(key) != 0;
+    }
+
+    void Insert(const std::string& key, std::shared_ptr<J3DModelData> data, size_t sourceBytes){
+        if(data == nullptr || key.empty()) return;
+
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        uint64_t textureBytes = 0;
+        Instances::ModelRecord* record = Instances::FindModel(data.get());
+        if(record != nullptr) textureBytes = record->Textures.DecodedBytes + record->Textures.CompressedBytes;
+
+        auto it = entries.find(key);
+        if(it != entries.end()){
+            stats.SourceBytes -= it->second->SourceBytes;
+            stats.TextureBytes -= it->second->TextureBytes;
+            lruList.erase(it->second);
+            entries.erase(it);
+        }
+
+        lruList.push_front({ key, data, sourceBytes, textureBytes });
+        entries[key] = lruList.begin();
+        stats.SourceBytes += sourceBytes;
+        stats.TextureBytes += textureBytes;
+
+        EvictToBudget();
+    }
+
+    static std::shared_ptr<J3DModelData> LoadJ3D(const uint8_t* data, size_t size){
+        J3DModelLoader Loader;
+        bStream::CMemoryStream modelStream((uint8_t*)data, size, bStream::Endianess::Big, bStream::OpenMode::In);
+        return Loader.Load(&modelStream, NULL);
+    }
+
+    static std::shared_ptr<J3DModelData> ParseModel(const uint8_t* data, size_t size, uint8_t* patchable, Instances::ModelRecord prepared){
+        TextureUpload::TextureStats textureStats;
+        std::shared_ptr<J3DModelData> modelData;
+        bool missed = false;
+        {
+            TextureUpload::ScopedCapture capture(data, size, patchable, textureStats);
+            modelData = LoadJ3D(data, size);
+            missed = modelData != nullptr && !capture.AllReplaced();
+        }
+
+        // a stand-in J3DUltra uploaded past the wrappers would render as its tag, load again with the file untouched
+        if(missed){
+            modelData = nullptr;
+            TextureUpload::ScopedCapture capture(data, size, nullptr, textureStats);
+            modelData = LoadJ3D(data, size);
+        }
+        ShaderCache::SaveBinaries();
+
+        if(modelData == nullptr) return nullptr;
+
+        prepared.Textures = textureStats;
+        Instances::RegisterModel(modelData, std::move(prepared));
+        return modelData;
+    }
+
+    std::shared_ptr<J3DModelData> LoadPrepared(const std::string& key, const uint8_t* data, size_t size, uint8_t* patchable, Instances::ModelRecord prepared, bool useCache){
+        std::shared_ptr<J3DModelData> modelData = ParseModel(data, size, patchable, std::move(prepared));
+        if(useCache) Insert(key, modelData, size);
+
+        return modelData;
+    }
+
+    static std::shared_ptr<J3DModelData> LoadWithKey(const std::string& key, const uint8_t* data, size_t size, uint8_t* patchable, bool useCache){
+        return LoadPrepared(key, data, size, patchable, Instances::PrepareModel(data, size), useCache);
+    }
+
+    std::shared_ptr<J3DModelData> LoadFromFile(const std::string& path, bool useCache){
+        std::string key;
+        if(useCache){
+            // files whose path or time can't be read aren't cached, an empty key would collide
+            key = MakeFileKey(path);
+            useCache = !key.empty();
+        }
+        if(useCache){
+            std::shared_ptr<J3DModelData> cached = Find(key);
+            if(cached != nullptr) return cached;
+        }
+
+        // parsed straight out of the mapping, which is dropped once the model has been built. Copy-on-write so the
+        // texture stand-ins can be patched in without touching the file.
+        Files::MappedFile file;
+        if(!file.Open(path, true)) return nullptr;
+
+        return LoadWithKey(key, file.GetData(), file.GetSize(), file.GetPatchableData(), useCache);
+    }
+
+    std::shared_ptr<J3DModelData> LoadFromMemory(const uint8_t* data, size_t size, bool useCache){
+        std::string key;
+        if(useCache){
+            key = MakeMemoryKey(data, size);
+            std::shared_ptr<J3DModelData> cached = Find(key);
+            if(cached != nullptr) return cached;
+        }
+
+        // the caller's bytes are never written to, J3DUltra decodes their textures itself
+        return LoadWithKey(key, data, size, nullptr, useCache);
+    }
+
+    void SetBudget(size_t bytes){
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        budget = bytes;
+        EvictToBudget();
+    }
+
+    CacheStats GetStats(){
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        CacheStats current = stats;
+        current.Entries = entries.size();
+        current.Budget = budget;
+        return current;
+    }
+
+    void Clear(){
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        entries.clear();
+        lruList.clear();
+        stats.SourceBytes = 0;
+        stats.TextureBytes = 0;
+    }
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "InstanceRegistry.hpp"
+
+class J3DModelData;
+
+namespace PyJ3D::ModelCache {
+    struct CacheStats {
+        uint64_t Hits = 0;
+        uint64_t Misses = 0;
+        uint64_t Evictions = 0;
+        size_t Entries = 0;
+        size_t SourceBytes = 0; // size of the files the cached models were parsed from
+        size_t Budget = 0;      // applies to SourceBytes + TextureBytes
+        uint64_t TextureBytes = 0; // GL texture memory the cached models uploaded
+    };
+
+    // Keys are "canonical path|mtime" for files and a content hash for in-memory data. MakeFileKey returns an
+    // empty key when either can't be read, such files aren't cached.
+    std::string MakeFileKey(const std::string& path);
+    std::string MakeMemoryKey(const uint8_t* data, size_t size);
+
+    // All cache functions are safe to call from any thread, parsing happens outside the lock.
+    std::shared_ptr<J3DModelData> Find(const std::string& key);
+    bool Contains(const std::string& key); // doesn't count as a hit or touch the LRU order
+    void Insert(const std::string& key, std::shared_ptr<J3DModelData> data, size_t sourceBytes);
+
+    // Load through the cache, parsing only on a miss. useCache = false bypasses it entirely.
+    std::shared_ptr<J3DModelData> LoadFromFile(const std::string& path, bool useCache = true);
+    std::shared_ptr<J3DModelData> LoadFromMemory(const uint8_t* data, size_t size, bool useCache = true);
+
+    // Parse data whose record was already prepared off the GL thread, inserting it under key when useCache is set.
+    // patchable is data when its TEX1 entries may be patched in place during the load, see TextureUpload::ScopedCapture.
+    std::shared_ptr<J3DModelData> LoadPrepared(const std::string& key, const uint8_t* data, size_t size, uint8_t* patchable, Instances::ModelRecord prepared, bool useCache);
+
+    // Eviction is driven by the summed size of the source files plus the texture memory the models uploaded,
+    // 0 means unlimited. Evicted data stays alive while instances still use it.
+    void SetBudget(size_t bytes);
+    CacheStats GetStats();
+    void Clear();
+}
@@ -0,0 +1,247 @@
+#include "PickQueue.hpp"
+#include "GlRedirect.hpp"
+#include "Profiler.hpp"
+
+#include <algorithm>
+
+#include <J3D/Picking/J3DPicking.hpp>
+
+namespace PyJ3D::PickQueue {
+    static std::vector<std::shared_ptr<PickHandle>> queued = {};
+    static std::vector<std::shared_ptr<PickHandle>> reading = {};
+    static std::vector<GLuint> freePbos = {};
+    static uint32_t fbWidth = 0, fbHeight = 0;
+
+    // The picking framebuffer is private to the library, it is looked up once per init or resize.
+    static GLuint pickingFramebuffer = 0;
+
+    // framebuffer names searched for the picking target, the library creates it among the first few
+    static const GLuint MaxFramebufferName = 4096;
+
+    // J3D::Picking::Query's format, a single R32I texel with the model id in the low and material id in the high half
+    static const PickHit BackgroundHit = { 0, 0 };
+
+    // The picking target is the only framebuffer whose first color attachment is a single channel 32 bit integer
+    // texture of the picking size, renderer targets are RGBA8 and renderers' own picking targets are skipped.
+    static GLuint FindPickingFramebuffer(GLenum& colorFormat){
+        GLint previousRead = 0, previousTexture = 0;
+        glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &previousRead);
+        glGetIntegerv(GL_TEXTURE_BINDING_2D, &previousTexture);
+
+        GLuint found = 0;
+        for(GLuint name = 1; name <= MaxFramebufferName && found == 0; name++){
+            if(!glIsFramebuffer(name) || GlRedirect::IsRendererFramebuffer(name)) continue;
+
+            glBindFramebuffer(GL_READ_FRAMEBUFFER, name);
+            GLint type = GL_NONE, texture = 0;
+            glGetFramebufferAttachmentParameteriv(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_FRAMEBUFFER_ATTACHMENT_OBJECT_TYPE, &type);
+            if(type != GL_TEXTURE) continue;
+            glGetFramebufferAttachmentParameteriv(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_FRAMEBUFFER_ATTACHMENT_OBJECT_NAME, &texture);
+
+            GLint width = 0, height = 0, format = GL_NONE;
+            glBindTexture(GL_TEXTURE_2D, texture);
+            glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &width);
+            glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &height);
+            glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_INTERNAL_FORMAT, &format);
+            if((uint32_t)width == fbWidth && (uint32_t)height == fbHeight && (format == GL_R32I || format == GL_R32UI)){
+                found = name;
+                colorFormat = (GLenum)format;
+            }
+        }
+
+        glBindTexture(GL_TEXTURE_2D, previousTexture);
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, previousRead);
+        return found;
+    }
+
+    static GLuint AcquirePbo(){
+        if(freePbos.empty()){
+            GLuint pbo;
+            glGenBuffers(1, &pbo);
+            return pbo;
+        }
+
+        GLuint pbo = freePbos.back();
+        freePbos.pop_back();
+        return pbo;
+    }
+
+    static void ReleasePbo(PickHandle& handle){
+        if(handle.Fence != nullptr) glDeleteSync(handle.Fence);
+        if(handle.Pbo != 0) freePbos.push_back(handle.Pbo);
+        handle.Fence = nullptr;
+        handle.Pbo = 0;
+    }
+
+    // Unpacked the way Query does it, the cleared background is dropped.
+    static std::vector<PickHit> DecodeHits(const uint32_t* texels, size_t count){
+        std::vector<PickHit> hits;
+        hits.reserve(count);
+
+        for(size_t i = 0; i < count; i++){
+            PickHit hit = { (uint16_t)(texels[i] & 0x0000FFFF), (uint16_t)((texels[i] & 0xFFFF0000) >> 16) };
+            if(hit != BackgroundHit) hits.push_back(hit);
+        }
+
+        std::sort(hits.begin(), hits.end());
+        hits.erase(std::unique(hits.begin(), hits.end()), hits.end());
+        return hits;
+    }
+
+    static void IssueReadback(PickHandle& handle){
+        size_t bytes = (size_t)handle.Width * handle.Height * sizeof(uint32_t);
+
+        handle.Pbo = AcquirePbo();
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, handle.Pbo);
+        glBufferData(GL_PIXEL_PACK_BUFFER, bytes, nullptr, GL_STREAM_READ);
+        glReadPixels(handle.X, handle.Y, handle.Width, handle.Height, GL_RED_INTEGER, GL_INT, nullptr);
+        handle.Fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        handle.Read();
+    }
+
+    static bool Complete(PickHandle& handle){
+        GLenum status = glClientWaitSync(handle.Fence, 0, 0);
+        if(status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) return false;
+
+        size_t count = (size_t)handle.Width * handle.Height;
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, handle.Pbo);
+        const uint32_t* texels = (const uint32_t*)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, count * sizeof(uint32_t), GL_MAP_READ_BIT);
+        handle.Finish(texels != nullptr ? DecodeHits(texels, count) : std::vector<PickHit>());
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+        ReleasePbo(handle);
+        return true;
+    }
+
+    void SetFramebufferSize(uint32_t width, uint32_t height){
+        fbWidth = width;
+        fbHeight = height;
+        GLenum format = GL_NONE;
+        pickingFramebuffer = J3D::Picking::IsPickingEnabled() ? FindPickingFramebuffer(format) : 0;
+        GlRedirect::SetPickingFramebuffer(pickingFramebuffer, width, height, format);
+    }
+
+    std::shared_ptr<PickHandle> Request(int32_t x, int32_t y, int32_t width, int32_t height){
+        // clamp to the framebuffer, a region entirely outside it completes with no hits
+        int32_t x0 = std::clamp(x, 0, (int32_t)fbWidth), y0 = std::clamp(y, 0, (int32_t)fbHeight);
+        int32_t x1 = std::clamp(x + std::max(width, 1), 0, (int32_t)fbWidth), y1 = std::clamp(y + std::max(height, 1), 0, (int32_t)fbHeight);
+
+        std::shared_ptr<PickHandle> handle = std::make_shared<PickHandle>(x0, y0, x1 - x0, y1 - y0);
+        if(!J3D::Picking::IsPickingEnabled()){
+            handle->Disable();
+        }
+        else if(handle->Width == 0 || handle->Height == 0){
+            handle->Finish({});
+        }
+        else {
+            queued.push_back(handle);
+        }
+
+        return handle;
+    }
+
+    bool HasQueued(){
+        return !queued.empty();
+    }
+
+    void Render(glm::mat4& view, glm::mat4& proj, J3D::Rendering::RenderPacketVector& packets, bool fullScene){
+        if(!J3D::Picking::IsPickingEnabled()){
+            for(std::shared_ptr<PickHandle>& handle : queued){
+                handle->Disable();
+            }
+            queued.clear();
+            return;
+        }
+
+        if(!fullScene && queued.empty()) return;
+
+        GLboolean scissorEnabled = glIsEnabled(GL_SCISSOR_TEST);
+        GLint scissorBox[4];
+        glGetIntegerv(GL_SCISSOR_BOX, scissorBox);
+
+        if(!fullScene){
+            // one scissored render covering every queued region
+            int32_t x0 = INT32_MAX, y0 = INT32_MAX, x1 = 0, y1 = 0;
+            for(std::shared_ptr<PickHandle>& handle : queued){
+                x0 = std::min(x0, handle->X);
+                y0 = std::min(y0, handle->Y);
+                x1 = std::max(x1, handle->X + handle->Width);
+                y1 = std::max(y1, handle->Y + handle->Height);
+            }
+
+            glEnable(GL_SCISSOR_TEST);
+            glScissor(x0, y0, x1 - x0, y1 - y0);
+        }
+
+        J3D::Picking::RenderPickingScene(view, proj, packets);
+
+        // one picking program for every packet
+        PYJ3D_PROFILE_COUNT(DrawCalls, packets.size());
+        PYJ3D_PROFILE_COUNT(ShaderBinds, 1);
+
+        if(!fullScene){
+            if(!scissorEnabled) glDisable(GL_SCISSOR_TEST);
+            glScissor(scissorBox[0], scissorBox[1], scissorBox[2], scissorBox[3]);
+        }
+
+        if(queued.empty()) return;
+        if(pickingFramebuffer == 0){
+            // the picking target wasn't found, there is nothing to read back from
+            for(std::shared_ptr<PickHandle>& handle : queued){
+                handle->Disable();
+            }
+            queued.clear();
+            return;
+        }
+
+        GLint previousRead = 0, previousPack = 0;
+        glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &previousRead);
+        glGetIntegerv(GL_PIXEL_PACK_BUFFER_BINDING, &previousPack);
+
+        // a renderer with its own picking target drew into that, the bind is redirected to it
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, pickingFramebuffer);
+        glReadBuffer(GL_COLOR_ATTACHMENT0);
+        for(std::shared_ptr<PickHandle>& handle : queued){
+            IssueReadback(*handle);
+            reading.push_back(handle);
+        }
+        queued.clear();
+
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, previousRead);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, previousPack);
+    }
+
+    uint32_t Poll(){
+        uint32_t completed = 0;
+        for(size_t i = 0; i < reading.size();){
+            if(Complete(*reading[i])){
+                reading[i] = reading.back();
+                reading.pop_back();
+                completed++;
+            }
+            else {
+                i++;
+            }
+        }
+
+        return completed;
+    }
+
+    void Clear(){
+        for(std::shared_ptr<PickHandle>& handle : reading){
+            ReleasePbo(*handle);
+            handle->Disable();
+        }
+        for(std::shared_ptr<PickHandle>& handle : queued){
+            handle->Disable();
+        }
+        reading.clear();
+        queued.clear();
+
+        if(!freePbos.empty()) glDeleteBuffers((GLsizei)freePbos.size(), freePbos.data());
+        freePbos.clear();
+        pickingFramebuffer = 0;
+        GlRedirect::SetPickingFramebuffer(0, 0, 0, GL_NONE);
+    }
+}
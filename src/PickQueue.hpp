@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <J3D/Rendering/J3DRendering.hpp>
+
+namespace PyJ3D::PickQueue {
+    enum class PickState : uint8_t {
+        Queued,   // waiting for the next picking render
+        Reading,  // readback issued, waiting on its fence
+        Ready,
+        Disabled  // picking framebuffer not initialised, Hits stays empty
+    };
+
+    // (model id, material id) as J3D::Picking::Query returns them
+    using PickHit = std::pair<uint16_t, uint16_t>;
+
+    class PickHandle {
+        PickState mState = PickState::Queued;
+        std::vector<PickHit> mHits;
+
+    public:
+        // Region in framebuffer pixels, origin bottom left like glReadPixels.
+        int32_t X, Y, Width, Height;
+        GLuint Pbo = 0;
+        GLsync Fence = nullptr;
+
+        PickHandle(int32_t x, int32_t y, int32_t w, int32_t h) : X(x), Y(y), Width(w), Height(h) {}
+
+        PickState GetState() const { return mState; }
+        bool IsDone() const { return mState == PickState::Ready || mState == PickState::Disabled; }
+
+        // Unique pairs found in the region, sorted, without the background. Only valid once IsDone() returns true.
+        const std::vector<PickHit>& GetHits() const { return mHits; }
+
+        void Read() { mState = PickState::Reading; }
+        void Finish(std::vector<PickHit> hits) { mHits = std::move(hits); mState = PickState::Ready; }
+        void Disable() { mState = PickState::Disabled; }
+    };
+
+    // Call after initialising or resizing the picking framebuffer, looks its GL name up again.
+    void SetFramebufferSize(uint32_t width, uint32_t height);
+
+    // Queue a pick of a region, rendered and read back by the next Render call and completed by Poll a frame later.
+    std::shared_ptr<PickHandle> Request(int32_t x, int32_t y, int32_t width, int32_t height);
+    bool HasQueued();
+
+    // Renders the picking scene and issues readbacks for queued requests. Without fullScene the picking render is
+    // skipped when nothing is queued and otherwise scissored to the queued regions.
+    void Render(glm::mat4& view, glm::mat4& proj, J3D::Rendering::RenderPacketVector& packets, bool fullScene);
+
+    // Completes readbacks whose fences have signalled, never blocks. Returns the number completed.
+    uint32_t Poll();
+
+    // Drops queued and in-flight requests and frees the pixel buffers, must run on the GL thread.
+    void Clear();
+}
@@ -0,0 +1,234 @@
+#include "Profiler.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+
+#include <glad/glad.h>
+
+namespace PyJ3D::Profiler {
+    struct PendingQuery {
+        uint64_t Frame;
+        Stage QueryStage;
+        GLuint Query;
+    };
+
+    // read without the lock so a disabled profiler stays one branch
+    static std::atomic<bool> enabled = false;
+    static bool gpuTimersEnabled = false;
+    static bool inFrame = false;
+    static bool gpuStageActive = false;
+    static size_t historyLimit = 120;
+    static uint64_t frameIndex = 0;
+    static std::chrono::steady_clock::time_point epoch = {};
+
+    // renderers on other threads add to the same frame, everything touching current or history holds this
+    static std::mutex frameMutex;
+    static FrameStats current = {};
+    static std::deque<FrameStats> history = {};
+    static std::deque<PendingQuery> pendingQueries = {};
+    static std::vector<GLuint> freeQueries = {};
+
+    static const char* stageNames[StageCount] = { "cull", "gather", "sort", "animation", "jointAnimation", "render", "picking", "readback" };
+    static const char* counterNames[CounterCount] = { "packets", "drawCalls", "stateChanges", "shaderBinds", "textureBinds", "culledInstances", "animationEvaluations" };
+
+    static double NowUs(){
+        return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - epoch).count();
+    }
+
+    static void DeleteQueries(){
+        if(glad_glDeleteQueries == nullptr) return;
+
+        for(PendingQuery& pending : pendingQueries) freeQueries.push_back(pending.Query);
+        pendingQueries.clear();
+
+        if(!freeQueries.empty()) glDeleteQueries((GLsizei)freeQueries.size(), freeQueries.data());
+        freeQueries.clear();
+    }
+
+    // Collects finished timer queries in submission order without waiting on the GPU.
+    static void ResolveQueries(){
+        while(!pendingQueries.empty()){
+            PendingQuery& pending = pendingQueries.front();
+
+            GLint available = 0;
+            glGetQueryObjectiv(pending.Query, GL_QUERY_RESULT_AVAILABLE, &available);
+            if(!available) break;
+
+            GLuint64 elapsed = 0;
+            glGetQueryObjectui64v(pending.Query, GL_QUERY_RESULT, &elapsed);
+
+            for(FrameStats& frame : history){
+                if(frame.Index != pending.Frame) continue;
+
+                double& gpuMs = frame.GpuMs[(size_t)pending.QueryStage];
+                gpuMs = std::max(gpuMs, 0.0) + elapsed / 1e6;
+                break;
+            }
+
+            freeQueries.push_back(pending.Query);
+            pendingQueries.pop_front();
+        }
+    }
+
+    const char* GetStageName(Stage stage){
+        return stage < Stage::Count ? stageNames[(size_t)stage] : "unknown";
+    }
+
+    const char* GetCounterName(Counter counter){
+        return counter < Counter::Count ? counterNames[(size_t)counter] : "unknown";
+    }
+
+    void SetEnabled(bool enable, bool gpuTimers, size_t historySize){
+#if !PYJ3D_PROFILING
+        enable = false;
+#endif
+        std::lock_guard<std::mutex> lock(frameMutex);
+        historyLimit = std::max<size_t>(historySize, 1);
+        while(history.size() > historyLimit) history.pop_front();
+
+        if(enable && !enabled){
+            epoch = std::chrono::steady_clock::now();
+            history.clear();
+        }
+        else if(!enable && enabled){
+            DeleteQueries();
+            inFrame = false;
+        }
+
+        enabled = enable;
+        gpuTimersEnabled = enable && gpuTimers && glad_glGetQueryObjectui64v != nullptr;
+    }
+
+    bool IsEnabled(){
+        return enabled;
+    }
+
+    void BeginFrame(){
+        if(!enabled) return;
+
+        std::lock_guard<std::mutex> lock(frameMutex);
+        if(gpuTimersEnabled) ResolveQueries();
+
+        current = FrameStats();
+        current.Index = frameIndex++;
+        current.StartUs = NowUs();
+        current.GpuMs.fill(-1.0);
+        inFrame = true;
+    }
+
+    void EndFrame(){
+        if(!enabled) return;
+
+        std::lock_guard<std::mutex> lock(frameMutex);
+        if(!inFrame) return;
+
+        current.FrameMs = (NowUs() - current.StartUs) / 1000.0;
+        inFrame = false;
+
+        history.push_back(std::move(current));
+        while(history.size() > historyLimit) history.pop_front();
+    }
+
+    void Add(Counter counter, uint64_t value){
+        if(!enabled) return;
+
+        std::lock_guard<std::mutex> lock(frameMutex);
+        if(inFrame) current.Counters[(size_t)counter] += value;
+    }
+
+    ScopedStage::ScopedStage(Stage stage, bool gpu) : mStage(stage), mStartUs(0.0), mQuery(0), mActive(false) {
+        if(!enabled) return;
+
+        std::lock_guard<std::mutex> lock(frameMutex);
+        mActive = inFrame;
+        if(!mActive) return;
+
+        mStartUs = NowUs();
+        if(gpu && gpuTimersEnabled && !gpuStageActive){
+            if(freeQueries.empty()){
+                GLuint query;
+                glGenQueries(1, &query);
+                freeQueries.push_back(query);
+            }
+
+            mQuery = freeQueries.back();
+            freeQueries.pop_back();
+            glBeginQuery(GL_TIME_ELAPSED, mQuery);
+            gpuStageActive = true;
+        }
+    }
+
+    ScopedStage::~ScopedStage(){
+        if(!mActive) return;
+
+        std::lock_guard<std::mutex> lock(frameMutex);
+        if(!inFrame) return;
+
+        double cpuUs = NowUs() - mStartUs;
+        current.CpuMs[(size_t)mStage] += cpuUs / 1000.0;
+        current.Events.push_back({ mStage, mStartUs, cpuUs });
+
+        if(mQuery != 0){
+            glEndQuery(GL_TIME_ELAPSED);
+            pendingQueries.push_back({ current.Index, mStage, mQuery });
+            gpuStageActive = false;
+        }
+    }
+
+    std::deque<FrameStats> GetHistory(){
+        std::lock_guard<std::mutex> lock(frameMutex);
+        return history;
+    }
+
+    bool WriteChromeTrace(const std::string& path){
+        std::lock_guard<std::mutex> lock(frameMutex);
+        FILE* file = std::fopen(path.c_str(), "w");
+        if(file == nullptr) return false;
+
+        // cpu stages on thread 1, gpu durations on thread 2 aligned to their cpu start, counters per frame
+        std::fprintf(file, "{\"traceEvents\":[\n");
+        std::fprintf(file, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"cpu\"}},\n");
+        std::fprintf(file, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,\"args\":{\"name\":\"gpu\"}}");
+
+        for(const FrameStats& frame : history){
+            std::fprintf(file, ",\n{\"name\":\"frame %llu\",\"cat\":\"frame\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%.3f,\"dur\":%.3f}",
+                         (unsigned long long)frame.Index, frame.StartUs, frame.FrameMs * 1000.0);
+
+            for(const TraceEvent& event : frame.Events){
+                std::fprintf(file, ",\n{\"name\":\"%s\",\"cat\":\"cpu\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%.3f,\"dur\":%.3f}",
+                             GetStageName(event.EventStage), event.StartUs, event.CpuUs);
+            }
+
+            for(size_t stage = 0; stage < StageCount; stage++){
+                if(frame.GpuMs[stage] < 0.0) continue;
+
+                double startUs = frame.StartUs;
+                for(const TraceEvent& event : frame.Events){
+                    if((size_t)event.EventStage == stage){
+                        startUs = event.StartUs;
+                        break;
+                    }
+                }
+
+                std::fprintf(file, ",\n{\"name\":\"%s\",\"cat\":\"gpu\",\"ph\":\"X\",\"pid\":1,\"tid\":2,\"ts\":%.3f,\"dur\":%.3f}",
+                             stageNames[stage], startUs, frame.GpuMs[stage] * 1000.0);
+            }
+
+            std::fprintf(file, ",\n{\"name\":\"counters\",\"ph\":\"C\",\"pid\":1,\"ts\":%.3f,\"args\":{", frame.StartUs);
+            for(size_t counter = 0; counter < CounterCount; counter++){
+                std::fprintf(file, "%s\"%s\":%llu", counter == 0 ? "" : ",", counterNames[counter], (unsigned long long)frame.Counters[counter]);
+            }
+            std::fprintf(file, "}}");
+        }
+
+        std::fprintf(file, "\n]}\n");
+        return std::fclose(file) == 0;
+    }
+
+    void Shutdown(){
+        SetEnabled(false, false, historyLimit);
+    }
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+
+// Built with -DPYJ3D_PROFILING=0 every stage and counter macro compiles to nothing.
+#ifndef PYJ3D_PROFILING
+#define PYJ3D_PROFILING 1
+#endif
+
+namespace PyJ3D::Profiler {
+    enum class Stage : uint8_t {
+        Cull,
+        Gather,         // retained scene packet gathering
+        Sort,
+        Animation,      // level of detail and library animation bookkeeping
+        JointAnimation, // native clip sampling and blending
+        Render,         // J3D::Rendering::Render, includes UBO uploads and draw submission
+        Picking,
+        Readback,       // offscreen view color/depth reads
+        Count
+    };
+
+    enum class Counter : uint8_t {
+        Packets,
+        // counted at the draw sites from the packets in draw order, see RenderSort::CountDraws
+        DrawCalls,      // one per packet drawn, picking passes included
+        StateChanges,   // material switches, each re-applies blend, depth, cull and color mask state
+        ShaderBinds,    // program switches
+        TextureBinds,   // texture slots whose texture differs from the previous packet's
+        CulledInstances,
+        AnimationEvaluations,
+        Count
+    };
+
+    static const size_t StageCount = (size_t)Stage::Count;
+    static const size_t CounterCount = (size_t)Counter::Count;
+
+    struct TraceEvent {
+        Stage EventStage;
+        double StartUs; // since the profiler was enabled
+        double CpuUs;
+    };
+
+    struct FrameStats {
+        uint64_t Index = 0;
+        double StartUs = 0.0;
+        double FrameMs = 0.0;
+        std::array<double, StageCount> CpuMs = {};
+        std::array<double, StageCount> GpuMs = {}; // negative until the stage's timer query resolves, or without one
+        std::array<uint64_t, CounterCount> Counters = {};
+        std::vector<TraceEvent> Events;
+    };
+
+    const char* GetStageName(Stage stage);
+    const char* GetCounterName(Counter counter);
+
+    // A disabled profiler costs one branch per stage and counter. gpuTimers needs GL 3.3 timer queries.
+    void SetEnabled(bool enabled, bool gpuTimers, size_t historySize);
+    bool IsEnabled();
+
+    // A frame is one render call. GPU timings land on their frame a few frames later once the queries resolve.
+    void BeginFrame();
+    void EndFrame();
+
+    void Add(Counter counter, uint64_t value);
+
+    // Times a stage on the CPU, and on the GPU too when gpu is set. GPU stages must not nest.
+    class ScopedStage {
+        Stage mStage;
+        double mStartUs;
+        uint32_t mQuery;
+        bool mActive;
+
+    public:
+        ScopedStage(Stage stage, bool gpu = false);
+        ~ScopedStage();
+    };
+
+    // A copy of the completed frames, oldest first, other threads may be ending frames meanwhile.
+    std::deque<FrameStats> GetHistory();
+
+    // Writes the history in Chrome's trace event format, viewable in chrome://tracing or Perfetto.
+    bool WriteChromeTrace(const std::string& path);
+
+    // Deletes timer queries, call before the context goes away.
+    void Shutdown();
+}
+
+#if PYJ3D_PROFILING
+#define PYJ3D_PROFILE_STAGE(stage) PyJ3D::Profiler::ScopedStage profileStage(PyJ3D::Profiler::Stage::stage)
+#define PYJ3D_PROFILE_GPU_STAGE(stage) PyJ3D::Profiler::ScopedStage profileStage(PyJ3D::Profiler::Stage::stage, true)
+#define PYJ3D_PROFILE_COUNT(counter, value) PyJ3D::Profiler::Add(PyJ3D::Profiler::Counter::counter, (uint64_t)(value))
+#define PYJ3D_PROFILE_BEGIN_FRAME() PyJ3D::Profiler::BeginFrame()
+#define PYJ3D_PROFILE_END_FRAME() PyJ3D::Profiler::EndFrame()
+#else
+#define PYJ3D_PROFILE_STAGE(stage) ((void)0)
+#define PYJ3D_PROFILE_GPU_STAGE(stage) ((void)0)
+#define PYJ3D_PROFILE_COUNT(counter, value) ((void)0)
+#define PYJ3D_PROFILE_BEGIN_FRAME() ((void)0)
+#define PYJ3D_PROFILE_END_FRAME() ((void)0)
+#endif
@@ -0,0 +1,286 @@
+#include "RenderSort.hpp"
+#include "InstanceRegistry.hpp"
+#include "Profiler.hpp"
+
+#include <algorithm>
+#include <array>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <J3D/Material/J3DMaterial.hpp>
+
+namespace PyJ3D::RenderSort {
+    struct SortEntry {
+        uint64_t Key;
+        uint32_t Index;
+    };
+
+    static SortMode sortMode = SortMode::Keyed;
+
+    // Scratch storage kept between frames so steady-state sorting never allocates.
+    static std::vector<SortEntry> sortEntries = {};
+    static J3D::Rendering::RenderPacketVector sortScratch = {};
+
+    // The textures a material samples. TEX1 indices are per model, so the model they index into is part of the set.
+    struct TextureSet {
+        const void* Model;
+        std::array<uint16_t, 8> Indices;
+
+        bool operator==(const TextureSet& other) const {
+            return Model == other.Model && Indices == other.Indices;
+        }
+    };
+
+    struct TextureSetHash {
+        size_t operator()(const TextureSet& set) const {
+            uint64_t hash = (uint64_t)(uintptr_t)set.Model;
+            for(uint16_t index : set.Indices) hash = hash * 0x100000001B3ull + index;
+            return (size_t)hash;
+        }
+    };
+
+    struct SetEntry {
+        uint32_t Id;
+        uint32_t Users; // live materials interned to this set
+    };
+
+    using SetMap = std::unordered_map<TextureSet, SetEntry, TextureSetHash>;
+
+    // The weak pointer catches a freed material whose address was reused, expired entries are swept every so often.
+    struct MaterialEntry {
+        std::weak_ptr<J3DMaterial> Material;
+        SetMap::iterator Set;
+        uint32_t Slot; // orders materials sharing a program and texture set
+    };
+
+    static std::unordered_map<const J3DMaterial*, MaterialEntry> materialIds = {};
+    static SetMap textureSets = {};
+    static std::vector<uint32_t> freeSetIds = {};
+    static std::vector<uint32_t> freeSlots = {};
+    static uint32_t nextSlot = 0;
+    static size_t internsSinceSweep = 0;
+
+    static TextureSet MakeTextureSet(const J3DMaterial* material, J3DModelInstance* instance){
+        // without a record the material stands in for its model, it then only groups with itself
+        Instances::InstanceRecord* record = Instances::Find(instance);
+        TextureSet set = { record != nullptr ? (const void*)record->Data : (const void*)material, {} };
+        for(int i = 0; i < 8; i++) set.Indices[i] = material->TevBlock->mTextureIndices[i];
+        return set;
+    }
+
+    static void ReleaseEntry(const MaterialEntry& entry){
+        freeSlots.push_back(entry.Slot);
+        if(--entry.Set->second.Users != 0) return;
+        freeSetIds.push_back(entry.Set->second.Id);
+        textureSets.erase(entry.Set);
+    }
+
+    static void SweepExpired(){
+        for(auto it = materialIds.begin(); it != materialIds.end();){
+            if(it->second.Material.expired()){
+                ReleaseEntry(it->second);
+                it = materialIds.erase(it);
+            }
+            else {
+                ++it;
+            }
+        }
+        internsSinceSweep = 0;
+    }
+
+    // Program in the high half so opaque packets switch programs as rarely as possible, then the texture set so
+    // packets sampling the same textures draw together, then the material itself. The 16 bit ids are recycled
+    // as materials are freed, past 65536 live sets or materials they wrap and only the grouping suffers.
+    static uint64_t MakeMaterialId(int32_t program, const MaterialEntry& entry){
+        return ((uint64_t)(uint32_t)program << 32) | ((uint64_t)(entry.Set->second.Id & 0xFFFF) << 16) | (entry.Slot & 0xFFFF);
+    }
+
+    static uint64_t GetMaterialId(const std::shared_ptr<J3DMaterial>& material, J3DModelInstance* instance){
+        auto it = materialIds.find(material.get());
+        if(it != materialIds.end()){
+            if(!it->second.Material.expired()) return MakeMaterialId(material->GetShaderProgram(), it->second);
+
+            ReleaseEntry(it->second);
+            materialIds.erase(it);
+        }
+
+        if(++internsSinceSweep >= 1024) SweepExpired();
+
+        auto setIt = textureSets.find(MakeTextureSet(material.get(), instance));
+        if(setIt == textureSets.end()){
+            uint32_t id = (uint32_t)textureSets.size();
+            if(!freeSetIds.empty()){
+                id = freeSetIds.back();
+                freeSetIds.pop_back();
+            }
+            setIt = textureSets.emplace(MakeTextureSet(material.get(), instance), SetEntry{ id, 0 }).first;
+        }
+        setIt->second.Users++;
+
+        uint32_t slot = nextSlot;
+        if(!freeSlots.empty()){
+            slot = freeSlots.back();
+            freeSlots.pop_back();
+        }
+        else {
+            nextSlot++;
+        }
+
+        MaterialEntry& entry = materialIds[material.get()] = { material, setIt, slot };
+        return MakeMaterialId(material->GetShaderProgram(), entry);
+    }
+
+    // Bit 63 splits opaque from translucent. Opaque packets sort on material id, translucent packets on
+    // inverted depth first so farther packets draw first. GatherRenderPackets stores the camera distance
+    // in the low 23 bits of SortKey, next to the 0x00800000 opaque bit.
+    uint64_t MakeSortKey(const J3DRenderPacket& packet){
+        uint64_t materialId = GetMaterialId(packet.Material, packet.Instance);
+
+        if((packet.SortKey & 0x00800000) != 0){
+            return materialId & 0x7FFFFFFFFFFFFFFFull;
+        }
+
+        uint64_t depth = packet.SortKey & 0x007FFFFF;
+        return (1ull << 63) | ((0x007FFFFF - depth) << 32) | (materialId & 0xFFFFFFFF);
+    }
+
+    void NameSortFunc(J3D::Rendering::RenderPacketVector& packets){
+        std::vector<J3DRenderPacket> opaquePackets;
+        std::vector<J3DRenderPacket> xluPackets;
+
+        for (J3DRenderPacket packet : packets) {
+            if ((packet.SortKey & 0x00800000) != 0) {
+                opaquePackets.push_back(packet);
+            }
+            else {
+                xluPackets.push_back(packet);
+            }
+        }
+
+        std::sort(
+            opaquePackets.begin(),
+            opaquePackets.end(),
+            [](const J3DRenderPacket& a, const J3DRenderPacket& b) -> bool {
+                return a.Material->Name < b.Material->Name;
+            }
+        );
+        std::sort(
+            xluPackets.begin(),
+            xluPackets.end(),
+            [](const J3DRenderPacket& a, const J3DRenderPacket& b) -> bool {
+                return a.Material->Name < b.Material->Name;
+            }
+        );
+
+        packets.clear();
+
+        for (J3DRenderPacket packet : opaquePackets) {
+            packets.push_back(packet);
+        }
+        for (J3DRenderPacket packet : xluPackets) {
+            packets.push_back(packet);
+        }
+    }
+
+    void KeyedSort(J3D::Rendering::RenderPacketVector& packets, std::vector<uint64_t>* keys){
+        sortEntries.clear();
+        for(uint32_t i = 0; i < packets.size(); i++){
+            sortEntries.push_back({ MakeSortKey(packets[i]), i });
+        }
+
+        // ties fall back to gather order, which keeps a model's packets in their authored order
+        std::sort(sortEntries.begin(), sortEntries.end(), [](const SortEntry& a, const SortEntry& b){
+            return a.Key != b.Key ? a.Key < b.Key : a.Index < b.Index;
+        });
+
+        sortScratch.clear();
+        for(const SortEntry& entry : sortEntries){
+            sortScratch.push_back(std::move(packets[entry.Index]));
+        }
+
+        // swapping hands the old packet storage back as next frame's scratch
+        packets.swap(sortScratch);
+
+        if(keys != nullptr){
+            keys->clear();
+            for(const SortEntry& entry : sortEntries){
+                keys->push_back(entry.Key);
+            }
+        }
+    }
+
+    void KeyedSortFunc(J3D::Rendering::RenderPacketVector& packets){
+        KeyedSort(packets, nullptr);
+    }
+
+    void SetSortMode(SortMode mode){
+        sortMode = mode;
+        J3D::Rendering::SetSortFunction(mode == SortMode::Keyed ? KeyedSortFunc : NameSortFunc);
+    }
+
+    SortMode GetSortMode(){
+        return sortMode;
+    }
+
+    void Sort(J3D::Rendering::RenderPacketVector& packets){
+        if(sortMode == SortMode::Keyed){
+            KeyedSortFunc(packets);
+        }
+        else {
+            NameSortFunc(packets);
+        }
+    }
+
+    void CountDraws(const J3D::Rendering::RenderPacketVector& packets){
+#if PYJ3D_PROFILING
+        if(!Profiler::IsEnabled()) return;
+
+        uint64_t programs = 0, materials = 0, textures = 0;
+        const J3DMaterial* lastMaterial = nullptr;
+        const J3DModelData* lastModel = nullptr;
+        int32_t lastProgram = -1;
+        uint16_t lastTextures[8];
+        std::fill(std::begin(lastTextures), std::end(lastTextures), 0xFFFF);
+
+        for(const J3DRenderPacket& packet : packets){
+            const J3DMaterial* material = packet.Material.get();
+            if(material == lastMaterial) continue;
+            materials++;
+
+            int32_t program = material->GetShaderProgram();
+            if(program != lastProgram) programs++;
+
+            // texture indices are into the model's TEX1, another model's index 0 is another texture
+            Instances::InstanceRecord* record = Instances::Find(packet.Instance);
+            const J3DModelData* model = record != nullptr ? record->Data : nullptr;
+            for(int i = 0; i < 8; i++){
+                uint16_t texture = material->TevBlock->mTextureIndices[i];
+                if(texture != 0xFFFF && (texture != lastTextures[i] || model != lastModel)) textures++;
+                lastTextures[i] = texture;
+            }
+
+            lastMaterial = material;
+            lastModel = model;
+            lastProgram = program;
+        }
+
+        Profiler::Add(Profiler::Counter::DrawCalls, packets.size());
+        Profiler::Add(Profiler::Counter::StateChanges, materials);
+        Profiler::Add(Profiler::Counter::ShaderBinds, programs);
+        Profiler::Add(Profiler::Counter::TextureBinds, textures);
+#else
+        (void)packets;
+#endif
+    }
+
+    void ResetMaterialIds(){
+        materialIds.clear();
+        textureSets.clear();
+        freeSetIds.clear();
+        freeSlots.clear();
+        nextSlot = 0;
+        internsSinceSweep = 0;
+    }
+}
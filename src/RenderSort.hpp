@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <J3D/Rendering/J3DRendering.hpp>
+
+namespace PyJ3D::RenderSort {
+    enum class SortMode : uint8_t {
+        Name,   // original material-name sort
+        Keyed   // integer key sort with persistent scratch buffers
+    };
+
+    // Opaque packets first, each group sorted by material name.
+    void NameSortFunc(J3D::Rendering::RenderPacketVector& packets);
+
+    // Opaque packets first grouped by shader program, textures and material, then translucent packets back to front.
+    void KeyedSortFunc(J3D::Rendering::RenderPacketVector& packets);
+
+    // The keyed sort, also filling keys with each sorted packet's key for callers that merge later changes in.
+    void KeyedSort(J3D::Rendering::RenderPacketVector& packets, std::vector<uint64_t>* keys);
+
+    // A packet's key in the keyed sort, stable for as long as its material is alive.
+    uint64_t MakeSortKey(const J3DRenderPacket& packet);
+
+    // Installs the matching function with J3D::Rendering::SetSortFunction.
+    void SetSortMode(SortMode mode);
+    SortMode GetSortMode();
+
+    // Run the active sort on an already gathered packet list.
+    void Sort(J3D::Rendering::RenderPacketVector& packets);
+
+    // Adds what drawing packets in this order costs to the profiler's counters: a draw per packet, and a program,
+    // material or texture switch wherever a packet's differs from the one drawn before it. The library draws
+    // internally, so this runs at the call sites that hand it packets. Free while profiling is off.
+    void CountDraws(const J3D::Rendering::RenderPacketVector& packets);
+
+    // Forget interned material ids. Ids of freed materials are also recycled on their own as sorting goes.
+    void ResetMaterialIds();
+}
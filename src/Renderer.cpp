@@ -0,0 +1,254 @@
+#include "Renderer.hpp"
+#include "Scene.hpp"
+#include "Culling.hpp"
+#include "RenderSort.hpp"
+#include "JointAnimation.hpp"
+#include "PickQueue.hpp"
+#include "Profiler.hpp"
+#include "FrameClock.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+
+#include <glad/glad.h>
+#include <J3D/Material/J3DUniformBufferObject.hpp>
+#include <J3D/Rendering/J3DRendering.hpp>
+#include <J3D/Data/J3DModelInstance.hpp>
+
+namespace PyJ3D {
+    // One GL context, so only one thread submits at a time.
+    static std::recursive_mutex contextMutex;
+    // Instances, animations, scenes, renderers and J3DUltra's sort function.
+    static std::recursive_mutex registryMutex;
+
+    static std::mutex renderersMutex;
+    static std::vector<std::weak_ptr<Renderer>>& GetRegistry(){
+        static std::vector<std::weak_ptr<Renderer>> renderers;
+        return renderers;
+    }
+
+    static double MsSince(std::chrono::steady_clock::time_point start){
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    RegistryLock::RegistryLock() : mLock(registryMutex) {}
+
+    ContextLock::ContextLock(bool makeCurrent) : mLock(contextMutex) {
+        if(!makeCurrent || !Headless::HasContext() || Headless::IsCurrent()) return;
+
+        if(!Headless::MakeCurrent()){
+            throw std::runtime_error("The headless context is current on another thread, call releaseContext() on it first");
+        }
+        mAcquired = true;
+    }
+
+    ContextLock::~ContextLock(){
+        if(mAcquired) Headless::ReleaseCurrent();
+    }
+
+    void Renderer::UploadCamera(const glm::mat4& view, const glm::mat4& proj){
+        glm::mat4 v = view, p = proj;
+        J3DUniformBufferObject::SetProjAndViewMatrices(p, v);
+    }
+
+    void Renderer::Animate(const std::vector<std::shared_ptr<J3DModelInstance>>& instances, float dt, const glm::vec3& cameraPos){
+        mAnimated.clear();
+        for(const std::shared_ptr<J3DModelInstance>& instance : instances){
+            if(instance != nullptr) mAnimated.push_back(instance.get());
+        }
+
+        AnimationLod::Update(mAnimated.data(), mAnimated.size(), dt, cameraPos, mLodPolicy.value_or(AnimationLod::GetPolicy()));
+        JointAnimation::Update(mAnimated.data(), mAnimated.size(), dt);
+        mStats.Animated += (uint32_t)mAnimated.size();
+    }
+
+    J3D::Rendering::RenderPacketVector Renderer::SortView(const std::vector<std::shared_ptr<J3DModelInstance>>& instances, const glm::mat4& view, const glm::mat4& proj, const glm::vec3& cameraPos){
+        mViewBatch = instances;
+        Culling::CullInstances(mViewBatch, view, proj, cameraPos);
+
+        RenderSort::SetSortMode(mSortMode);
+        PYJ3D_PROFILE_STAGE(Sort);
+        return J3D::Rendering::SortPackets(mViewBatch, cameraPos);
+    }
+
+    void Renderer::DrawView(float dt, const glm::mat4& view, const glm::mat4& proj, J3D::Rendering::RenderPacketVector& packets, bool renderPicking, bool pickPass){
+        glm::mat4 v = view, p = proj;
+
+        PYJ3D_PROFILE_COUNT(Packets, packets.size());
+        {
+            PYJ3D_PROFILE_GPU_STAGE(Render);
+            J3D::Rendering::Render(dt, v, p, packets);
+            RenderSort::CountDraws(packets);
+        }
+        if(pickPass){
+            PYJ3D_PROFILE_GPU_STAGE(Picking);
+            PickQueue::Render(v, p, packets, renderPicking);
+        }
+
+        mStats.Drawn += (uint32_t)mViewBatch.size();
+        mStats.Packets += (uint32_t)packets.size();
+    }
+
+    void Renderer::Render(float dt, const glm::vec3& cameraPos, bool renderPicking){
+        RegistryLock registry;
+        auto start = std::chrono::steady_clock::now();
+        mStats = {};
+        mStats.Views = 1;
+        mStats.Instances = (uint32_t)mBatch.size();
+
+        {
+            ContextLock context;
+            PYJ3D_PROFILE_BEGIN_FRAME();
+        }
+        FrameClock::BeginRender();
+
+        // animate everything submitted, not just what's in view, so culled animations keep time
+        Animate(mBatch, dt, cameraPos);
+        J3D::Rendering::RenderPacketVector packets = SortView(mBatch, mView, mProj, cameraPos);
+        {
+            ContextLock context;
+            GlRedirect::ScopedTargets targets(mOwnTargets ? &mTargets : nullptr);
+            glDepthMask(true); // gotta make sure the depth mask is ON!
+            if(mPicking) PickQueue::Poll();
+            UploadCamera(mView, mProj);
+            DrawView(dt, mView, mProj, packets, renderPicking, mPicking);
+        }
+
+        mBatch.clear();
+        mViewBatch.clear();
+        PYJ3D_PROFILE_END_FRAME();
+
+        mStats.CpuMs = MsSince(start);
+    }
+
+    void Renderer::RenderScene(Scene& scene, float dt, const glm::vec3& cameraPos, bool renderPicking){
+        RegistryLock registry;
+        auto start = std::chrono::steady_clock::now();
+        mStats = {};
+        mStats.Views = 1;
+
+        ContextLock context;
+        GlRedirect::ScopedTargets targets(mOwnTargets ? &mTargets : nullptr);
+        PYJ3D_PROFILE_BEGIN_FRAME();
+        FrameClock::BeginRender();
+        glDepthMask(true);
+        if(mPicking) PickQueue::Poll();
+        UploadCamera(mView, mProj);
+
+        RenderSort::SetSortMode(mSortMode);
+        scene.Render(dt, cameraPos, mView, mProj, renderPicking, true, mPicking);
+        PYJ3D_PROFILE_END_FRAME();
+
+        mStats.CpuMs = MsSince(start);
+    }
+
+    bool Renderer::RenderViews(Scene* scene, float dt, const glm::mat4* views, size_t count, const glm::mat4& proj, uint32_t width, uint32_t height,
+                               const glm::vec4& clearColor, const std::function<void(size_t)>& readback){
+        if(count == 0) return false;
+
+        RegistryLock registry;
+        {
+            ContextLock context;
+            if(!mTarget.Resize(width, height)) return false;
+            PYJ3D_PROFILE_BEGIN_FRAME();
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        mStats = {};
+        mStats.Views = (uint32_t)count;
+        mStats.Instances = (uint32_t)mBatch.size();
+        FrameClock::BeginRender();
+
+        // The batch is taken for this render so submits made while it waits on readbacks queue for the next one.
+        std::vector<std::shared_ptr<J3DModelInstance>> batch;
+        batch.swap(mBatch);
+
+        // Animation runs once for everything any view could draw, LOD distances come from the first camera.
+        // dt = 0 leaves poses as they are, like the still renders renderViews did before.
+        glm::vec3 firstCamera = glm::vec3(glm::inverse(views[0])[3]);
+        if(dt > 0.0f){
+            if(scene != nullptr){
+                scene->Animate(dt, firstCamera, false);
+            } else {
+                Animate(batch, dt, firstCamera);
+            }
+        }
+
+        glm::mat4 projection = proj;
+        for(size_t i = 0; i < count; i++){
+            glm::mat4 view = views[i];
+            glm::vec3 cameraPos = glm::vec3(glm::inverse(view)[3]);
+
+            // material animation only advances with the first view
+            float viewDt = i == 0 ? dt : 0.0f;
+            J3D::Rendering::RenderPacketVector packets;
+            if(scene == nullptr) packets = SortView(batch, view, projection, cameraPos);
+            {
+                ContextLock context;
+                GlRedirect::ScopedTargets targets(mOwnTargets ? &mTargets : nullptr);
+                mTarget.Bind();
+                UploadCamera(view, projection);
+
+                glDepthMask(true);
+                glClearColor(clearColor.r, clearColor.g, clearColor.b, clearColor.a);
+                glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+                if(scene != nullptr){
+                    RenderSort::SetSortMode(mSortMode);
+                    scene->Render(viewDt, cameraPos, view, projection, false, false, false);
+                } else {
+                    DrawView(viewDt, view, projection, packets, false, false);
+                }
+                mTarget.Unbind();
+            }
+
+            registry.Unlock();
+            {
+                ContextLock context;
+                mTarget.Bind();
+                PYJ3D_PROFILE_GPU_STAGE(Readback);
+                readback(i);
+                mTarget.Unbind();
+            }
+            registry.Lock();
+        }
+
+        // a renderer drawing through the library's UBO leaves the camera it was given for the next render
+        if(!mOwnTargets){
+            ContextLock context;
+            UploadCamera(mView, mProj);
+        }
+        mViewBatch.clear();
+        PYJ3D_PROFILE_END_FRAME();
+
+        mStats.CpuMs = MsSince(start);
+        return true;
+    }
+
+    void Renderer::Destroy(){
+        mTarget.Destroy();
+        mTargets.Destroy();
+        mBatch.clear();
+        mViewBatch.clear();
+    }
+
+    void DestroyRenderers(){
+        std::lock_guard<std::mutex> lock(renderersMutex);
+        for(std::weak_ptr<Renderer>& weak : GetRegistry()){
+            if(std::shared_ptr<Renderer> renderer = weak.lock()) renderer->Destroy();
+        }
+        GetRegistry().clear();
+    }
+
+    std::shared_ptr<Renderer> CreateRenderer(){
+        std::shared_ptr<Renderer> renderer = std::make_shared<Renderer>();
+
+        std::lock_guard<std::mutex> lock(renderersMutex);
+        std::vector<std::weak_ptr<Renderer>>& renderers = GetRegistry();
+        renderers.erase(std::remove_if(renderers.begin(), renderers.end(), [](const std::weak_ptr<Renderer>& weak){ return weak.expired(); }), renderers.end());
+        renderers.push_back(renderer);
+
+        return renderer;
+    }
+}
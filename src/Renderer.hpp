@@ -0,0 +1,132 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+#include "AnimationLod.hpp"
+#include "GlRedirect.hpp"
+#include "Headless.hpp"
+#include "RenderSort.hpp"
+
+#include <glm/glm.hpp>
+
+class J3DModelInstance;
+
+namespace PyJ3D {
+    class Scene;
+
+    struct RendererStats {
+        uint32_t Views = 0;
+        uint32_t Instances = 0;     // submitted for the frame
+        uint32_t Animated = 0;      // animation updates, once per instance however many views drew it
+        uint32_t Drawn = 0;         // instances drawn summed over views
+        uint32_t Packets = 0;       // summed over views
+        double CpuMs = 0.0;
+    };
+
+    // Serializes the instance, animation, scene and renderer state renders read, and J3DUltra's process-wide sort function.
+    // Renders hold it for culling, sorting and drawing, since J3DUltra ticks material animations as it draws, but
+    // not while they wait on readbacks. Take it before the context lock, never after.
+    // Bindings take it with the GIL held, renders release the GIL first, and nothing holding it takes the GIL back.
+    // It's recursive so guarded bindings can call helpers that lock too.
+    class RegistryLock {
+        std::unique_lock<std::recursive_mutex> mLock;
+
+    public:
+        RegistryLock();
+
+        // Lets other threads' renders cull and sort while this one waits on the GPU.
+        void Unlock() { mLock.unlock(); }
+        void Lock() { mLock.lock(); }
+    };
+
+    // Holds the one GL context, made current on the calling thread for the duration when no other thread holds it.
+    // makeCurrent = false only serializes, for creating, releasing or destroying the context itself.
+    // Renderers keep their own material UBO and picking target, so only GL submission takes turns.
+    class ContextLock {
+        std::unique_lock<std::recursive_mutex> mLock;
+        bool mAcquired = false;
+
+    public:
+        explicit ContextLock(bool makeCurrent = true);
+        ~ContextLock();
+    };
+
+    // Camera, instance batch, sort mode, picking and offscreen target for one viewport, so editor views or
+    // render jobs don't clobber each other. Each renderer draws through its own material UBO and picking target
+    // unless it's made with ownTargets = false, which draws through J3DUltra's like the module level functions.
+    class Renderer {
+        glm::mat4 mView = glm::mat4(1.0f);
+        glm::mat4 mProj = glm::mat4(1.0f);
+        std::vector<std::shared_ptr<J3DModelInstance>> mBatch;
+        std::vector<std::shared_ptr<J3DModelInstance>> mViewBatch;
+        std::vector<J3DModelInstance*> mAnimated;
+
+        RenderSort::SortMode mSortMode = RenderSort::SortMode::Keyed;
+        std::optional<AnimationLod::LodPolicy> mLodPolicy;
+        bool mPicking = false;
+
+        Headless::OffscreenTarget mTarget;
+        GlRedirect::Targets mTargets;
+        bool mOwnTargets = true;
+        RendererStats mStats;
+
+        void UploadCamera(const glm::mat4& view, const glm::mat4& proj);
+        void Animate(const std::vector<std::shared_ptr<J3DModelInstance>>& instances, float dt, const glm::vec3& cameraPos);
+        // Culls instances into mViewBatch for one view and sorts what's left, no GL.
+        J3D::Rendering::RenderPacketVector SortView(const std::vector<std::shared_ptr<J3DModelInstance>>& instances, const glm::mat4& view, const glm::mat4& proj, const glm::vec3& cameraPos);
+        void DrawView(float dt, const glm::mat4& view, const glm::mat4& proj, J3D::Rendering::RenderPacketVector& packets, bool renderPicking, bool pickPass);
+
+    public:
+        Renderer() = default;
+        explicit Renderer(bool ownTargets) : mOwnTargets(ownTargets) {}
+
+        void SetCamera(const glm::mat4& proj, const glm::mat4& view) { mProj = proj; mView = view; }
+        glm::mat4& GetView() { return mView; }
+        glm::mat4& GetProj() { return mProj; }
+
+        // Queued until the next render, which clears the batch. Call with the registry lock held, renders read the batch.
+        void Submit(const std::shared_ptr<J3DModelInstance>& instance) { mBatch.push_back(instance); }
+        void Submit(const std::vector<std::shared_ptr<J3DModelInstance>>& instances) { mBatch.insert(mBatch.end(), instances.begin(), instances.end()); }
+        void ClearBatch() { mBatch.clear(); }
+        size_t GetBatchSize() const { return mBatch.size(); }
+
+        void SetSortMode(RenderSort::SortMode mode) { mSortMode = mode; }
+        RenderSort::SortMode GetSortMode() const { return mSortMode; }
+
+        // Animation level of detail for this renderer's batch, overriding the global policy.
+        void SetAnimationLod(const AnimationLod::LodPolicy& policy) { mLodPolicy = policy; }
+        void ClearAnimationLod() { mLodPolicy.reset(); }
+
+        // Only the renderer the pick coordinates belong to should run the picking pass.
+        void SetPicking(bool enabled) { mPicking = enabled; }
+        bool GetPicking() const { return mPicking; }
+
+        const RendererStats& GetStats() const { return mStats; }
+
+        // Draws the batch into whatever framebuffer is bound. Takes the registry and context locks itself.
+        void Render(float dt, const glm::vec3& cameraPos, bool renderPicking);
+        void RenderScene(Scene& scene, float dt, const glm::vec3& cameraPos, bool renderPicking);
+
+        // Renders the batch, or scene when given, once per view matrix into this renderer's offscreen target.
+        // Animation is advanced once for the frame with the first view's camera and reused by the others.
+        // readback is called after each view with the target bound, holding the context lock but not the registry's.
+        bool RenderViews(Scene* scene, float dt, const glm::mat4* views, size_t count, const glm::mat4& proj, uint32_t width, uint32_t height,
+                         const glm::vec4& clearColor, const std::function<void(size_t)>& readback);
+
+        Headless::OffscreenTarget& GetTarget() { return mTarget; }
+
+        // Frees the offscreen and picking targets and the UBO, GL objects aren't freed on destruction since the context may already be gone.
+        void Destroy();
+    };
+
+    // Destroys the GL objects of every renderer still alive, before the context goes away.
+    void DestroyRenderers();
+
+    // Renderers register themselves so DestroyRenderers can find them.
+    std::shared_ptr<Renderer> CreateRenderer();
+}
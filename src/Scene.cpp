@@ -0,0 +1,421 @@
+#include "Scene.hpp"
+#include "RenderSort.hpp"
+#include "InstanceRegistry.hpp"
+#include "PickQueue.hpp"
+#include "JointAnimation.hpp"
+#include "Profiler.hpp"
+
+#include <algorithm>
+#include <mutex>
+
+#include <J3D/Data/J3DModelInstance.hpp>
+
+namespace PyJ3D {
+    static std::mutex sceneListMutex;
+    static std::vector<Scene*>& GetScenes(){
+        static std::vector<Scene*> scenes;
+        return scenes;
+    }
+
+    Scene::Scene(){
+        std::lock_guard<std::mutex> lock(sceneListMutex);
+        GetScenes().push_back(this);
+    }
+
+    Scene::~Scene(){
+        std::lock_guard<std::mutex> lock(sceneListMutex);
+        std::vector<Scene*>& scenes = GetScenes();
+        scenes.erase(std::remove(scenes.begin(), scenes.end(), this), scenes.end());
+    }
+
+    void Scene::NotifyMoved(J3DModelInstance* instance){
+        std::lock_guard<std::mutex> lock(sceneListMutex);
+        for(Scene* scene : GetScenes()){
+            auto slot = scene->mSlotLookup.find(instance);
+            if(slot != scene->mSlotLookup.end()) scene->MarkMoved(slot->second);
+        }
+    }
+
+    uint32_t Scene::Add(std::shared_ptr<J3DModelInstance> instance){
+        auto existing = mSlotLookup.find(instance.get());
+        if(existing != mSlotLookup.end()) return existing->second;
+
+        uint32_t slot;
+        if(!mFreeSlots.empty()){
+            slot = mFreeSlots.back();
+            mFreeSlots.pop_back();
+        }
+        else {
+            slot = (uint32_t)mEntries.size();
+            mEntries.emplace_back();
+            mSlotChanged.push_back(0);
+        }
+
+        mEntries[slot] = SceneEntry();
+        mEntries[slot].Instance = instance;
+        mSlotLookup[instance.get()] = slot;
+        MarkChanged(slot);
+
+        return slot;
+    }
+
+    bool Scene::Remove(uint32_t slot){
+        if(!IsValidSlot(slot)) return false;
+
+        mSlotLookup.erase(mEntries[slot].Instance.get());
+        mEntries[slot] = SceneEntry();
+        mFreeSlots.push_back(slot);
+        MarkChanged(slot);
+
+        return true;
+    }
+
+    bool Scene::Remove(std::shared_ptr<J3DModelInstance> instance){
+        int64_t slot = FindSlot(instance);
+        return slot >= 0 && Remove((uint32_t)slot);
+    }
+
+    void Scene::Clear(){
+        mEntries.clear();
+        mFreeSlots.clear();
+        mSlotLookup.clear();
+        mSortedPackets.clear();
+        mSortedKeys.clear();
+        mSortedSlots.clear();
+        mChangedSlots.clear();
+        mSlotChanged.clear();
+        mFullResort = true;
+        mOrderDirty = true;
+    }
+
+    bool Scene::IsValidSlot(uint32_t slot) const {
+        return slot < mEntries.size() && mEntries[slot].Instance != nullptr;
+    }
+
+    int64_t Scene::FindSlot(const std::shared_ptr<J3DModelInstance>& instance) const {
+        auto it = mSlotLookup.find(instance.get());
+        return it != mSlotLookup.end() ? (int64_t)it->second : -1;
+    }
+
+    std::shared_ptr<J3DModelInstance> Scene::GetInstance(uint32_t slot) const {
+        return IsValidSlot(slot) ? mEntries[slot].Instance : nullptr;
+    }
+
+    void Scene::SetVisible(uint32_t slot, bool visible){
+        if(!IsValidSlot(slot) || mEntries[slot].Visible == visible) return;
+
+        mEntries[slot].Visible = visible;
+        MarkChanged(slot);
+    }
+
+    bool Scene::GetVisible(uint32_t slot) const {
+        return IsValidSlot(slot) && mEntries[slot].Visible;
+    }
+
+    void Scene::MarkDirty(uint32_t slot){
+        if(!IsValidSlot(slot)) return;
+
+        mEntries[slot].Dirty = true;
+        MarkChanged(slot);
+    }
+
+    void Scene::MarkAllDirty(){
+        for(SceneEntry& entry : mEntries){
+            entry.Dirty = true;
+        }
+        mFullResort = true;
+        mOrderDirty = true;
+    }
+
+    void Scene::MarkMoved(uint32_t slot){
+        if(!IsValidSlot(slot) || !mEntries[slot].HasTranslucent) return;
+
+        mEntries[slot].Dirty = true;
+        MarkChanged(slot);
+    }
+
+    void Scene::MarkChanged(uint32_t slot){
+        mOrderDirty = true;
+        if(mSlotChanged[slot] != 0) return;
+
+        mSlotChanged[slot] = 1;
+        mChangedSlots.push_back(slot);
+    }
+
+    void Scene::GatherEntry(SceneEntry& entry, const glm::vec3& cameraPos){
+        // SortPackets over a single instance is the library's packet gather for that instance
+        mGatherBatch.clear();
+        mGatherBatch.push_back(entry.Instance);
+        entry.Packets = J3D::Rendering::SortPackets(mGatherBatch, cameraPos);
+        mGatherBatch.clear();
+
+        entry.HasTranslucent = false;
+        for(const J3DRenderPacket& packet : entry.Packets){
+            if((packet.SortKey & 0x00800000) == 0){
+                entry.HasTranslucent = true;
+                break;
+            }
+        }
+
+        entry.Dirty = false;
+    }
+
+    size_t Scene::GroupKeyHash::operator()(const GroupKey& key) const {
+        size_t hash = 0;
+        for(const void* ptr : key){
+            hash = hash * 31 + std::hash<const void*>()(ptr);
+        }
+        return hash;
+    }
+
+    bool Scene::MakeGroupKey(const SceneEntry& entry, GroupKey& key) const {
+        Instances::InstanceRecord* record = Instances::Find(entry.Instance.get());
+        // natively posed instances get a fresh joint slot every frame, so they never share packets
+        if(record == nullptr || record->Player.Clip != nullptr) return false;
+
+        J3DModelInstance* instance = entry.Instance.get();
+        key = {
+            record->Data,
+            instance->GetRegisterColorAnimation().get(),
+            instance->GetTexIndexAnimation().get(),
+            instance->GetTexMatrixAnimation().get(),
+            instance->GetJointAnimation().get(),
+            instance->GetJointFullAnimation().get(),
+            instance->GetVisibilityAnimation().get()
+        };
+        return true;
+    }
+
+    void Scene::CopyLeaderPackets(const SceneEntry& leader, SceneEntry& entry){
+        entry.Packets = leader.Packets;
+        for(J3DRenderPacket& packet : entry.Packets){
+            packet.Instance = entry.Instance.get();
+        }
+
+        entry.HasTranslucent = false;
+        entry.Dirty = false;
+    }
+
+    void Scene::CullEntries(const glm::vec3& cameraPos, const glm::mat4& view, const glm::mat4& proj){
+        PYJ3D_PROFILE_STAGE(Cull);
+
+        mCullSpheres.Clear();
+        mCullSlots.clear();
+
+        bool enabled = Culling::GetSettings().Enabled;
+        uint32_t unbounded = 0;
+
+        for(uint32_t slot = 0; slot < mEntries.size(); slot++){
+            SceneEntry& entry = mEntries[slot];
+            if(entry.Instance == nullptr || !entry.Visible) continue;
+
+            glm::vec4 sphere;
+            if(enabled && Culling::GetCullSphere(entry.Instance.get(), sphere)){
+                mCullSpheres.Push(sphere);
+                mCullSlots.push_back(slot);
+            }
+            else {
+                if(entry.Culled){
+                    entry.Dirty |= entry.HasTranslucent;
+                    entry.Culled = false;
+                    MarkChanged(slot);
+                }
+                unbounded++;
+            }
+        }
+
+        mCullVisible.resize(mCullSpheres.Size());
+        Culling::Cull(mCullSpheres, view, proj, cameraPos, mCullVisible.data());
+        Culling::RecordUnbounded(unbounded);
+
+        // the merged packet list only changes when an instance enters or leaves the view
+        for(size_t i = 0; i < mCullSlots.size(); i++){
+            SceneEntry& entry = mEntries[mCullSlots[i]];
+            bool culled = mCullVisible[i] == 0;
+            if(entry.Culled == culled) continue;
+
+            // translucent depth went stale while the instance was off screen
+            if(!culled && entry.HasTranslucent) entry.Dirty = true;
+            entry.Culled = culled;
+            MarkChanged(mCullSlots[i]);
+        }
+    }
+
+    void Scene::Rebuild(const glm::vec3& cameraPos, const glm::mat4& view, const glm::mat4& proj){
+        CullEntries(cameraPos, view, proj);
+
+        // translucent order depends on camera distance, refresh it once the camera has travelled far enough
+        bool cameraMoved = glm::distance(cameraPos, mSortCameraPos) > mResortDistance;
+        if(cameraMoved) mSortCameraPos = cameraPos;
+
+        {
+            PYJ3D_PROFILE_STAGE(Gather);
+
+            mGroupLeaders.clear();
+            mSharedGatherStats = SharedGatherStats();
+
+            for(uint32_t slot = 0; slot < mEntries.size(); slot++){
+                SceneEntry& entry = mEntries[slot];
+                if(entry.Instance == nullptr || !entry.Visible || entry.Culled) continue;
+
+                GroupKey key;
+                bool grouped = mSharedGather && MakeGroupKey(entry, key);
+
+                if(entry.Dirty || (cameraMoved && entry.HasTranslucent)){
+                    // translucent packets carry per-instance depth, only opaque-only groups can share
+                    auto leader = grouped ? mGroupLeaders.find(key) : mGroupLeaders.end();
+                    if(leader != mGroupLeaders.end() && !mEntries[leader->second].HasTranslucent){
+                        CopyLeaderPackets(mEntries[leader->second], entry);
+                        mSharedGatherStats.Reused++;
+                    }
+                    else {
+                        GatherEntry(entry, cameraPos);
+                        mSharedGatherStats.Gathered++;
+                    }
+                    MarkChanged(slot);
+                }
+
+                if(grouped) mGroupLeaders.try_emplace(key, slot);
+            }
+        }
+
+        mSharedGatherStats.Groups = (uint32_t)mGroupLeaders.size();
+
+        if(!mOrderDirty) return;
+
+        PYJ3D_PROFILE_STAGE(Sort);
+        bool keyed = RenderSort::GetSortMode() == RenderSort::SortMode::Keyed;
+        if(!keyed || !mSortedKeyed || mFullResort || mChangedSlots.size() * 4 > mSlotLookup.size()){
+            SortAll(keyed);
+        }
+        else {
+            MergeChanged();
+        }
+
+        for(uint32_t slot : mChangedSlots){
+            mSlotChanged[slot] = 0;
+        }
+        mChangedSlots.clear();
+        mFullResort = false;
+        mOrderDirty = false;
+    }
+
+    void Scene::SortAll(bool keyed){
+        mSortedPackets.clear();
+        for(SceneEntry& entry : mEntries){
+            if(entry.Instance == nullptr || !entry.Visible || entry.Culled) continue;
+            mSortedPackets.insert(mSortedPackets.end(), entry.Packets.begin(), entry.Packets.end());
+        }
+
+        mSortedKeyed = keyed;
+        if(!keyed){
+            RenderSort::Sort(mSortedPackets);
+            return;
+        }
+
+        RenderSort::KeyedSort(mSortedPackets, &mSortedKeys);
+        mSortedSlots.clear();
+        for(const J3DRenderPacket& packet : mSortedPackets){
+            mSortedSlots.push_back(mSlotLookup[packet.Instance]);
+        }
+    }
+
+    // Drops the changed slots' old packets, sorts their current ones on their own and merges the two sorted runs.
+    void Scene::MergeChanged(){
+        size_t kept = 0;
+        for(size_t i = 0; i < mSortedPackets.size(); i++){
+            if(mSlotChanged[mSortedSlots[i]] != 0) continue;
+
+            if(kept != i){
+                mSortedPackets[kept] = std::move(mSortedPackets[i]);
+                mSortedKeys[kept] = mSortedKeys[i];
+                mSortedSlots[kept] = mSortedSlots[i];
+            }
+            kept++;
+        }
+        mSortedPackets.resize(kept);
+        mSortedKeys.resize(kept);
+        mSortedSlots.resize(kept);
+
+        mMergePackets.clear();
+        for(uint32_t slot : mChangedSlots){
+            const SceneEntry& entry = mEntries[slot];
+            if(entry.Instance == nullptr || !entry.Visible || entry.Culled) continue;
+            mMergePackets.insert(mMergePackets.end(), entry.Packets.begin(), entry.Packets.end());
+        }
+        if(mMergePackets.empty()) return;
+
+        RenderSort::KeyedSort(mMergePackets, &mMergeKeys);
+
+        // on equal keys the packets already in place stay first
+        mMergedPackets.clear();
+        mMergedKeys.clear();
+        mMergedSlots.clear();
+        size_t a = 0, b = 0;
+        while(a < mSortedPackets.size() || b < mMergePackets.size()){
+            if(b == mMergePackets.size() || (a < mSortedPackets.size() && mSortedKeys[a] <= mMergeKeys[b])){
+                mMergedPackets.push_back(std::move(mSortedPackets[a]));
+                mMergedKeys.push_back(mSortedKeys[a]);
+                mMergedSlots.push_back(mSortedSlots[a]);
+                a++;
+            }
+            else {
+                mMergedSlots.push_back(mSlotLookup[mMergePackets[b].Instance]);
+                mMergedPackets.push_back(std::move(mMergePackets[b]));
+                mMergedKeys.push_back(mMergeKeys[b]);
+                b++;
+            }
+        }
+
+        mSortedPackets.swap(mMergedPackets);
+        mSortedKeys.swap(mMergedKeys);
+        mSortedSlots.swap(mMergedSlots);
+    }
+
+    bool Scene::Raycast(const glm::vec3& origin, const glm::vec3& dir, float maxDistance, Collision::RayHit& hit){
+        mDrawInstances.clear();
+        mDrawSlots.clear();
+        for(uint32_t slot = 0; slot < mEntries.size(); slot++){
+            if(mEntries[slot].Instance == nullptr || !mEntries[slot].Visible) continue;
+            mDrawInstances.push_back(mEntries[slot].Instance.get());
+            mDrawSlots.push_back(slot);
+        }
+
+        if(!Collision::RaycastInstances(mDrawInstances.data(), mDrawInstances.size(), origin, dir, maxDistance, hit)) return false;
+
+        hit.Index = mDrawSlots[hit.Index];
+        return true;
+    }
+
+    J3D::Rendering::RenderPacketVector& Scene::GetPackets(const glm::vec3& cameraPos, const glm::mat4& view, const glm::mat4& proj){
+        Rebuild(cameraPos, view, proj);
+        return mSortedPackets;
+    }
+
+    void Scene::Animate(float dt, const glm::vec3& cameraPos, bool skipCulled){
+        mDrawInstances.clear();
+        for(SceneEntry& entry : mEntries){
+            if(entry.Instance == nullptr || !entry.Visible || (skipCulled && entry.Culled)) continue;
+            mDrawInstances.push_back(entry.Instance.get());
+        }
+        AnimationLod::Update(mDrawInstances.data(), mDrawInstances.size(), dt, cameraPos, mLodPolicy.value_or(AnimationLod::GetPolicy()));
+        JointAnimation::Update(mDrawInstances.data(), mDrawInstances.size(), dt);
+    }
+
+    void Scene::Render(float dt, const glm::vec3& cameraPos, glm::mat4& view, glm::mat4& proj, bool renderPicking, bool animate, bool pickPass){
+        Rebuild(cameraPos, view, proj);
+
+        if(animate) Animate(dt, cameraPos, true);
+
+        PYJ3D_PROFILE_COUNT(Packets, mSortedPackets.size());
+        {
+            PYJ3D_PROFILE_GPU_STAGE(Render);
+            J3D::Rendering::Render(dt, view, proj, mSortedPackets);
+            RenderSort::CountDraws(mSortedPackets);
+        }
+        if(pickPass){
+            PYJ3D_PROFILE_GPU_STAGE(Picking);
+            PickQueue::Render(view, proj, mSortedPackets, renderPicking);
+        }
+    }
+}
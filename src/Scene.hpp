@@ -0,0 +1,154 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+#include "Culling.hpp"
+#include "AnimationLod.hpp"
+#include "Collision.hpp"
+
+#include <glm/glm.hpp>
+#include <J3D/Rendering/J3DRendering.hpp>
+
+class J3DModelInstance;
+
+namespace PyJ3D {
+    struct SharedGatherStats {
+        uint32_t Groups = 0;
+        uint32_t Gathered = 0;  // instances whose packets were gathered by the library
+        uint32_t Reused = 0;    // instances that copied their group leader's packets instead
+    };
+
+
+    // Retained set of model instances. Each instance's packets are gathered once and kept until
+    // the instance is marked dirty. With the keyed sort, only the packets of changed instances are sorted
+    // and merged into the existing order.
+    class Scene {
+        struct SceneEntry {
+            std::shared_ptr<J3DModelInstance> Instance;
+            J3D::Rendering::RenderPacketVector Packets;
+            bool Visible = true;
+            bool Culled = false;
+            bool Dirty = true;
+            bool HasTranslucent = false;
+        };
+
+        std::vector<SceneEntry> mEntries;
+        std::vector<uint32_t> mFreeSlots;
+        std::unordered_map<J3DModelInstance*, uint32_t> mSlotLookup;
+
+        J3D::Rendering::RenderPacketVector mSortedPackets;
+        std::vector<std::shared_ptr<J3DModelInstance>> mGatherBatch;
+
+        // Keyed sort results kept so changes can be merged in instead of re-sorting everything.
+        // Keys and owning slots run parallel to mSortedPackets.
+        std::vector<uint64_t> mSortedKeys;
+        std::vector<uint32_t> mSortedSlots;
+        bool mSortedKeyed = false;
+
+        // slots whose packets changed since the last rebuild, the flags outlive the entries so removals are seen
+        std::vector<uint32_t> mChangedSlots;
+        std::vector<uint8_t> mSlotChanged;
+        bool mFullResort = true;
+
+        // merge scratch
+        J3D::Rendering::RenderPacketVector mMergePackets, mMergedPackets;
+        std::vector<uint64_t> mMergeKeys, mMergedKeys;
+        std::vector<uint32_t> mMergedSlots;
+
+        // model data plus every animation slot, instances with equal keys produce identical opaque packets
+        using GroupKey = std::array<const void*, 7>;
+        struct GroupKeyHash {
+            size_t operator()(const GroupKey& key) const;
+        };
+
+        bool mSharedGather = false;
+        std::unordered_map<GroupKey, uint32_t, GroupKeyHash> mGroupLeaders;
+        SharedGatherStats mSharedGatherStats;
+
+        // scratch for the per-frame cull, slots run parallel to the spheres
+        Culling::SphereBatch mCullSpheres;
+        std::vector<uint32_t> mCullSlots;
+        std::vector<uint8_t> mCullVisible;
+
+        // falls back to the global policy when unset
+        std::optional<AnimationLod::LodPolicy> mLodPolicy;
+        std::vector<J3DModelInstance*> mDrawInstances;
+        std::vector<uint32_t> mDrawSlots;
+
+        glm::vec3 mSortCameraPos = glm::vec3(0.0f);
+        float mResortDistance = 100.0f;
+        bool mOrderDirty = true;
+
+        void GatherEntry(SceneEntry& entry, const glm::vec3& cameraPos);
+        bool MakeGroupKey(const SceneEntry& entry, GroupKey& key) const;
+        void CopyLeaderPackets(const SceneEntry& leader, SceneEntry& entry);
+        void MarkChanged(uint32_t slot);
+        void CullEntries(const glm::vec3& cameraPos, const glm::mat4& view, const glm::mat4& proj);
+        void SortAll(bool keyed);
+        void MergeChanged();
+        void Rebuild(const glm::vec3& cameraPos, const glm::mat4& view, const glm::mat4& proj);
+
+    public:
+        // Scenes keep a list of themselves so moving an instance through its own setters can reach them.
+        Scene();
+        ~Scene();
+        Scene(const Scene&) = delete;
+        Scene& operator=(const Scene&) = delete;
+
+        // MarkMoved on the instance's slot in every scene holding it, for transforms set outside a scene.
+        static void NotifyMoved(J3DModelInstance* instance);
+
+        // Returns the slot the instance lives in, adding an instance twice returns its existing slot.
+        uint32_t Add(std::shared_ptr<J3DModelInstance> instance);
+        bool Remove(uint32_t slot);
+        bool Remove(std::shared_ptr<J3DModelInstance> instance);
+        void Clear();
+
+        bool IsValidSlot(uint32_t slot) const;
+        int64_t FindSlot(const std::shared_ptr<J3DModelInstance>& instance) const;
+        std::shared_ptr<J3DModelInstance> GetInstance(uint32_t slot) const;
+        J3DModelInstance* GetInstancePtr(uint32_t slot) const { return IsValidSlot(slot) ? mEntries[slot].Instance.get() : nullptr; }
+        size_t GetCount() const { return mSlotLookup.size(); }
+
+        void SetVisible(uint32_t slot, bool visible);
+        bool GetVisible(uint32_t slot) const;
+
+        // Regather an instance's packets next frame, call after moving it or changing its materials.
+        void MarkDirty(uint32_t slot);
+        void MarkAllDirty();
+
+        // Only translucent packets depend on position, so moved opaque-only instances keep their packets.
+        void MarkMoved(uint32_t slot);
+
+        // Camera travel that forces translucent packets to be re-ordered.
+        void SetResortDistance(float distance) { mResortDistance = distance; }
+        float GetResortDistance() const { return mResortDistance; }
+
+        // Shared gather: copies of the same model data in the same animation state are grouped, and only the first
+        // of a group has its packets gathered by the library, the rest copy them. This is not instancing, every copy
+        // is still its own set of draws. J3DUltra's shaders take one model matrix per draw, so draw count scales with copies.
+        void SetSharedGather(bool enabled) { mSharedGather = enabled; MarkAllDirty(); }
+        bool GetSharedGather() const { return mSharedGather; }
+        SharedGatherStats GetSharedGatherStats() const { return mSharedGatherStats; }
+
+        // Animation level of detail for this scene's instances, overriding the global policy.
+        void SetAnimationLod(const AnimationLod::LodPolicy& policy) { mLodPolicy = policy; }
+        void ClearAnimationLod() { mLodPolicy.reset(); }
+
+        // Nearest visible instance along the ray, hit.Index is the slot.
+        bool Raycast(const glm::vec3& origin, const glm::vec3& dir, float maxDistance, Collision::RayHit& hit);
+
+        J3D::Rendering::RenderPacketVector& GetPackets(const glm::vec3& cameraPos, const glm::mat4& view, const glm::mat4& proj);
+        // Samples joint poses for visible instances, culled ones too unless skipCulled. Every player advances either way.
+        // Multi-view rendering calls this once per frame and renders each view with animate = false.
+        void Animate(float dt, const glm::vec3& cameraPos, bool skipCulled);
+
+        // pickPass = false skips picking for views the queued picks weren't made against.
+        void Render(float dt, const glm::vec3& cameraPos, glm::mat4& view, glm::mat4& proj, bool renderPicking, bool animate = true, bool pickPass = true);
+    };
+}
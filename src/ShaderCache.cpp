@@ -0,0 +1,388 @@
+#include "ShaderCache.hpp"
+#include "DiskCache.hpp"
+#include "Hash.hpp"
+
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <glad/glad.h>
+
+namespace PyJ3D::ShaderCache {
+    // A linked program's binary, handed to glProgramBinary for every later program built from the same state.
+    struct CachedBinary {
+        GLenum Format = 0;
+        std::vector<uint8_t> Data;
+    };
+
+    static PFNGLSHADERSOURCEPROC realShaderSource = nullptr;
+    static PFNGLCOMPILESHADERPROC realCompileShader = nullptr;
+    static PFNGLGETSHADERIVPROC realGetShaderiv = nullptr;
+    static PFNGLGETSHADERINFOLOGPROC realGetShaderInfoLog = nullptr;
+    static PFNGLDELETESHADERPROC realDeleteShader = nullptr;
+    static PFNGLATTACHSHADERPROC realAttachShader = nullptr;
+    static PFNGLLINKPROGRAMPROC realLinkProgram = nullptr;
+    static PFNGLDELETEPROGRAMPROC realDeleteProgram = nullptr;
+    static PFNGLBINDATTRIBLOCATIONPROC realBindAttribLocation = nullptr;
+    static PFNGLBINDFRAGDATALOCATIONPROC realBindFragDataLocation = nullptr;
+    static PFNGLTRANSFORMFEEDBACKVARYINGSPROC realTransformFeedbackVaryings = nullptr;
+
+    // State set on a program before linking that a binary bakes in, so it's part of the key.
+    struct PreLinkState {
+        std::string Bindings; // attribute and fragment output locations in call order
+        std::string Varyings; // transform feedback varyings, replaced by every call
+    };
+
+    static std::unordered_map<GLuint, std::string> shaderSources = {};
+    static std::unordered_map<GLuint, std::vector<GLuint>> programShaders = {};
+    static std::unordered_set<GLuint> pendingCompiles = {};
+    static std::unordered_map<uint64_t, CachedBinary> binaries = {};
+    static std::unordered_map<GLuint, uint64_t> programKeys = {}; // linked library program to its key
+    static std::unordered_map<uint64_t, GLuint> unreadBinaries = {}; // linked from source, binary not read back yet
+    static std::unordered_map<GLuint, PreLinkState> preLinkStates = {};
+    static uint64_t driverSalt = 0;
+    static bool binariesSupported = false;
+    static ShaderCacheStats stats = {};
+
+    // Drops comments and collapses whitespace so sources that differ only in formatting share a program.
+    // Newlines are kept since the preprocessor needs them.
+    static void AppendCanonical(std::string& out, const char* source, size_t length){
+        bool space = false;
+        for(size_t i = 0; i < length; i++){
+            char c = source[i];
+            if(c == '/' && i + 1 < length && source[i + 1] == '/'){
+                while(i + 1 < length && source[i + 1] != '\n') i++;
+                continue;
+            }
+            if(c == '/' && i + 1 < length && source[i + 1] == '*'){
+                i += 2;
+                while(i + 1 < length && !(source[i] == '*' && source[i + 1] == '/')) i++;
+                i++;
+                space = true;
+                continue;
+            }
+
+            if(c == ' ' || c == '\t' || c == '\r'){
+                space = true;
+                continue;
+            }
+            if(c == '\n'){
+                if(out.empty() || out.back() != '\n') out += '\n';
+                space = false;
+                continue;
+            }
+
+            if(space && !out.empty() && out.back() != '\n') out += ' ';
+            space = false;
+            out += c;
+        }
+    }
+
+    static void APIENTRY CaptureShaderSource(GLuint shader, GLsizei count, const GLchar* const* strings, const GLint* lengths){
+        realShaderSource(shader, count, strings, lengths);
+
+        std::string& source = shaderSources[shader];
+        source.clear();
+        for(GLsizei i = 0; i < count; i++){
+            size_t length = lengths != nullptr && lengths[i] >= 0 ? (size_t)lengths[i] : std::strlen(strings[i]);
+            AppendCanonical(source, strings[i], length);
+        }
+    }
+
+    static void CompileNow(GLuint shader){
+        if(pendingCompiles.erase(shader) == 0) return;
+        realCompileShader(shader);
+        stats.Compiled++;
+    }
+
+    static void APIENTRY CaptureCompileShader(GLuint shader){
+        pendingCompiles.insert(shader);
+    }
+
+    // compile status and logs are the only things that need the deferred compile to have happened
+    static void APIENTRY CaptureGetShaderiv(GLuint shader, GLenum name, GLint* params){
+        if(name == GL_COMPILE_STATUS || name == GL_INFO_LOG_LENGTH) CompileNow(shader);
+        realGetShaderiv(shader, name, params);
+    }
+
+    static void APIENTRY CaptureGetShaderInfoLog(GLuint shader, GLsizei size, GLsizei* length, GLchar* log){
+        CompileNow(shader);
+        realGetShaderInfoLog(shader, size, length, log);
+    }
+
+    static void APIENTRY CaptureDeleteShader(GLuint shader){
+        realDeleteShader(shader);
+        shaderSources.erase(shader);
+        if(pendingCompiles.erase(shader) != 0) stats.CompilesAvoided++;
+    }
+
+    static void APIENTRY CaptureAttachShader(GLuint program, GLuint shader){
+        realAttachShader(program, shader);
+        programShaders[program].push_back(shader);
+    }
+
+    static void APIENTRY CaptureBindAttribLocation(GLuint program, GLuint index, const GLchar* name){
+        realBindAttribLocation(program, index, name);
+        preLinkStates[program].Bindings += "a" + std::to_string(index) + "=" + name + ";";
+    }
+
+    static void APIENTRY CaptureBindFragDataLocation(GLuint program, GLuint color, const GLchar* name){
+        realBindFragDataLocation(program, color, name);
+        preLinkStates[program].Bindings += "f" + std::to_string(color) + "=" + name + ";";
+    }
+
+    static void APIENTRY CaptureTransformFeedbackVaryings(GLuint program, GLsizei count, const GLchar* const* varyings, GLenum bufferMode){
+        realTransformFeedbackVaryings(program, count, varyings, bufferMode);
+
+        std::string& state = preLinkStates[program].Varyings;
+        state = std::to_string(bufferMode) + ":";
+        for(GLsizei i = 0; i < count; i++){
+            state += varyings[i];
+            state += ";";
+        }
+    }
+
+    static void APIENTRY CaptureDeleteProgram(GLuint program){
+        realDeleteProgram(program);
+        programShaders.erase(program);
+        preLinkStates.erase(program);
+        programKeys.erase(program);
+    }
+
+    // Key over the attached sources in attach order and the pre-link state, false if any source wasn't seen.
+    static bool MakeProgramKey(GLuint program, const std::vector<GLuint>& shaders, uint64_t& key){
+        if(shaders.empty()) return false;
+
+        std::string combined;
+        for(GLuint shader : shaders){
+            auto source = shaderSources.find(shader);
+            if(source == shaderSources.end()) return false;
+
+            combined += source->second;
+            combined += '\0';
+        }
+
+        auto state = preLinkStates.find(program);
+        if(state != preLinkStates.end()){
+            combined += state->second.Bindings;
+            combined += '\0';
+            combined += state->second.Varyings;
+        }
+
+        key = DiskCache::MakeKey((const uint8_t*)combined.data(), combined.size(), driverSalt);
+        return true;
+    }
+
+    static bool ApplyBinary(GLuint program, const CachedBinary& binary){
+        glProgramBinary(program, binary.Format, binary.Data.data(), (GLsizei)binary.Data.size());
+
+        // drivers reject binaries from other versions, the caller falls back to a normal link
+        GLint linked = GL_FALSE;
+        glGetProgramiv(program, GL_LINK_STATUS, &linked);
+        return linked == GL_TRUE;
+    }
+
+    static bool ReadBinary(GLuint program, CachedBinary& out){
+        GLint linked = GL_FALSE;
+        glGetProgramiv(program, GL_LINK_STATUS, &linked);
+        if(linked != GL_TRUE) return false;
+
+        GLint length = 0;
+        glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+        if(length <= 0) return false;
+
+        out.Data.resize(length);
+        glGetProgramBinary(program, length, nullptr, &out.Format, out.Data.data());
+        return true;
+    }
+
+    // Reads back the binary of a program linked from source, keeps it for later links and writes it to the disk cache.
+    static const CachedBinary* CollectBinary(uint64_t key, GLuint program){
+        // deleted or relinked since, the binary would be for something else
+        auto linked = programKeys.find(program);
+        if(linked == programKeys.end() || linked->second != key) return nullptr;
+
+        CachedBinary binary;
+        if(!ReadBinary(program, binary)) return nullptr;
+
+        if(DiskCache::IsEnabled()){
+            std::vector<uint8_t> payload(sizeof(GLenum) + binary.Data.size());
+            std::memcpy(payload.data(), &binary.Format, sizeof(GLenum));
+            std::memcpy(payload.data() + sizeof(GLenum), binary.Data.data(), binary.Data.size());
+            DiskCache::Write(DiskCache::BlobKind::ProgramBinary, key, payload.data(), payload.size());
+        }
+
+        return &(binaries[key] = std::move(binary));
+    }
+
+    // Binary for the key from this process, reading back an earlier program linked from the same state if needed.
+    static const CachedBinary* FindSharedBinary(uint64_t key){
+        auto cached = binaries.find(key);
+        if(cached != binaries.end()) return &cached->second;
+
+        auto unread = unreadBinaries.find(key);
+        if(unread == unreadBinaries.end()) return nullptr;
+
+        GLuint program = unread->second;
+        unreadBinaries.erase(unread);
+        return CollectBinary(key, program);
+    }
+
+    static const CachedBinary* LoadDiskBinary(uint64_t key){
+        DiskCache::Blob blob;
+        if(!DiskCache::Read(DiskCache::BlobKind::ProgramBinary, key, blob) || blob.Size <= sizeof(GLenum)) return nullptr;
+
+        CachedBinary binary;
+        std::memcpy(&binary.Format, blob.Payload, sizeof(GLenum));
+        binary.Data.assign(blob.Payload + sizeof(GLenum), blob.Payload + blob.Size);
+        return &(binaries[key] = std::move(binary));
+    }
+
+    static void APIENTRY CaptureLinkProgram(GLuint program){
+        std::vector<GLuint> shaders;
+        auto attached = programShaders.find(program);
+        if(attached != programShaders.end()){
+            shaders = std::move(attached->second);
+            programShaders.erase(attached);
+        }
+        programKeys.erase(program);
+
+        uint64_t key = 0;
+        bool keyed = MakeProgramKey(program, shaders, key);
+
+        // every material keeps its own program object and uniform state, matching ones just skip the compile
+        if(keyed && binariesSupported){
+            const CachedBinary* shared = FindSharedBinary(key);
+            if(shared != nullptr && ApplyBinary(program, *shared)){
+                programKeys[program] = key;
+                stats.Reused++;
+                return;
+            }
+
+            const CachedBinary* stored = shared == nullptr && DiskCache::IsEnabled() ? LoadDiskBinary(key) : nullptr;
+            if(stored != nullptr && ApplyBinary(program, *stored)){
+                programKeys[program] = key;
+                stats.LoadedBinary++;
+                return;
+            }
+
+            // rejected, link from source and replace it
+            binaries.erase(key);
+            glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+        }
+
+        for(GLuint shader : shaders){
+            CompileNow(shader);
+        }
+
+        realLinkProgram(program);
+        stats.Linked++;
+
+        GLint linked = GL_FALSE;
+        glGetProgramiv(program, GL_LINK_STATUS, &linked);
+        if(!keyed || linked != GL_TRUE) return;
+
+        // read back by SaveBinaries once the load is done, or by the next link from the same state
+        programKeys[program] = key;
+        if(binariesSupported) unreadBinaries[key] = program;
+    }
+
+    template<typename Fn>
+    static void Wrap(Fn& entry, Fn& real, Fn wrapper){
+        if(entry == nullptr || real != nullptr) return;
+        real = entry;
+        entry = wrapper;
+    }
+
+    template<typename Fn>
+    static void Unwrap(Fn& entry, Fn& real){
+        if(real == nullptr) return;
+        entry = real;
+        real = nullptr;
+    }
+
+    void Install(){
+        if(realLinkProgram != nullptr) return;
+
+        // binaries are only valid for the driver that produced them
+        std::string driver;
+        for(GLenum name : { GL_VENDOR, GL_RENDERER, GL_VERSION }){
+            const GLubyte* value = glGetString(name);
+            if(value != nullptr) driver += (const char*)value;
+        }
+        driverSalt = HashBytes((const uint8_t*)driver.data(), driver.size());
+
+        GLint formats = 0;
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+        binariesSupported = formats > 0 && glad_glProgramBinary != nullptr && glad_glGetProgramBinary != nullptr;
+
+        Wrap(glad_glShaderSource, realShaderSource, CaptureShaderSource);
+        Wrap(glad_glCompileShader, realCompileShader, CaptureCompileShader);
+        Wrap(glad_glGetShaderiv, realGetShaderiv, CaptureGetShaderiv);
+        Wrap(glad_glGetShaderInfoLog, realGetShaderInfoLog, CaptureGetShaderInfoLog);
+        Wrap(glad_glDeleteShader, realDeleteShader, CaptureDeleteShader);
+        Wrap(glad_glAttachShader, realAttachShader, CaptureAttachShader);
+        Wrap(glad_glLinkProgram, realLinkProgram, CaptureLinkProgram);
+        Wrap(glad_glDeleteProgram, realDeleteProgram, CaptureDeleteProgram);
+        Wrap(glad_glBindAttribLocation, realBindAttribLocation, CaptureBindAttribLocation);
+        Wrap(glad_glBindFragDataLocation, realBindFragDataLocation, CaptureBindFragDataLocation);
+        Wrap(glad_glTransformFeedbackVaryings, realTransformFeedbackVaryings, CaptureTransformFeedbackVaryings);
+    }
+
+    void Uninstall(){
+        if(realLinkProgram == nullptr) return;
+
+        Unwrap(glad_glShaderSource, realShaderSource);
+        Unwrap(glad_glCompileShader, realCompileShader);
+        Unwrap(glad_glGetShaderiv, realGetShaderiv);
+        Unwrap(glad_glGetShaderInfoLog, realGetShaderInfoLog);
+        Unwrap(glad_glDeleteShader, realDeleteShader);
+        Unwrap(glad_glAttachShader, realAttachShader);
+        Unwrap(glad_glLinkProgram, realLinkProgram);
+        Unwrap(glad_glDeleteProgram, realDeleteProgram);
+        Unwrap(glad_glBindAttribLocation, realBindAttribLocation);
+        Unwrap(glad_glBindFragDataLocation, realBindFragDataLocation);
+        Unwrap(glad_glTransformFeedbackVaryings, realTransformFeedbackVaryings);
+
+        // only called as the context goes away, the programs go with it
+        shaderSources.clear();
+        programShaders.clear();
+        pendingCompiles.clear();
+        binaries.clear();
+        programKeys.clear();
+        unreadBinaries.clear();
+        preLinkStates.clear();
+    }
+
+    void SaveBinaries(){
+        if(!binariesSupported) return;
+
+        for(const std::pair<const uint64_t, GLuint>& unread : unreadBinaries) CollectBinary(unread.first, unread.second);
+        unreadBinaries.clear();
+    }
+
+    uint32_t ClearUnused(){
+        std::unordered_set<uint64_t> live;
+        for(const std::pair<const GLuint, uint64_t>& program : programKeys) live.insert(program.second);
+
+        uint32_t freed = 0;
+        for(auto it = binaries.begin(); it != binaries.end();){
+            if(live.count(it->first) != 0){
+                ++it;
+                continue;
+            }
+
+            it = binaries.erase(it);
+            freed++;
+        }
+        return freed;
+    }
+
+    ShaderCacheStats GetStats(){
+        ShaderCacheStats current = stats;
+        current.Programs = (uint32_t)binaries.size();
+        return current;
+    }
+}
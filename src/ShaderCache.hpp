@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+
+namespace PyJ3D::ShaderCache {
+    struct ShaderCacheStats {
+        uint32_t Linked = 0;        // programs linked from source
+        uint32_t LoadedBinary = 0;  // programs restored from a disk cached binary instead
+        uint32_t Reused = 0;        // programs given the binary of one linked earlier in the process from the same state
+        uint32_t Compiled = 0;      // shaders compiled
+        uint32_t CompilesAvoided = 0; // shaders deleted without ever being compiled
+        uint32_t Programs = 0;      // distinct program binaries kept in memory
+    };
+
+    // Wraps the glad entry points the library compiles and links its material shaders through.
+    // Shader compiles are deferred to link time. Programs are keyed on their sources (comments and whitespace aside)
+    // plus the attribute, fragment output and transform feedback bindings made before the link. When the driver
+    // supports program binaries, a link whose key matches a program linked earlier in the process loads that
+    // program's binary into the library's own program object, so its shaders are never compiled while every
+    // material keeps its own program and uniform state. Other links try the disk cache when it is enabled.
+    // Without binary support every program is linked from source. Needs GL loaded.
+    void Install();
+    void Uninstall();
+
+    // Drops kept binaries that no live program was built from, returns how many were freed. They otherwise
+    // outlive their models so reloading or prewarming pays off.
+    uint32_t ClearUnused();
+
+    // Reads back the binaries of programs linked from source since the last call, for later links and the disk cache.
+    // Called once a model load returns, on the GL thread.
+    void SaveBinaries();
+
+    ShaderCacheStats GetStats();
+}
@@ -0,0 +1,404 @@
+#include "Simd.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define PYJ3D_SIMD_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// GCC and Clang need the instruction set enabled per function since the build targets baseline x86-64,
+// MSVC accepts the intrinsics anywhere.
+#if defined(__GNUC__) || defined(__clang__)
+#define PYJ3D_TARGET(isa) __attribute__((target(isa)))
+#else
+#define PYJ3D_TARGET(isa)
+#endif
+
+namespace PyJ3D::Simd {
+    static void CullSpheresScalar(const float* x, const float* y, const float* z, const float* radius, size_t count,
+                                  const glm::vec4* planes, float radiusScale, uint8_t* visible){
+        for(size_t i = 0; i < count; i++){
+            visible[i] = 1;
+        }
+
+        for(size_t p = 0; p < 6; p++){
+            const glm::vec4& plane = planes[p];
+            for(size_t i = 0; i < count; i++){
+                float dist = plane.x * x[i] + plane.y * y[i] + plane.z * z[i] + plane.w;
+                visible[i] &= (uint8_t)(dist >= -radius[i] * radiusScale);
+            }
+        }
+    }
+
+    static void HermiteScalar(const float* u, const float* value0, const float* value1, const float* slope0, const float* slope1, float* out, size_t count){
+        for(size_t i = 0; i < count; i++){
+            float t = u[i], t2 = t * t, t3 = t2 * t;
+            out[i] = value0[i] * (2.0f * t3 - 3.0f * t2 + 1.0f)
+                   + value1[i] * (3.0f * t2 - 2.0f * t3)
+                   + slope0[i] * (t3 - 2.0f * t2 + t)
+                   + slope1[i] * (t3 - t2);
+        }
+    }
+
+    static void DecodeRgb565Scalar(const uint8_t* in, uint8_t* out, size_t count){
+        for(size_t i = 0; i < count; i++){
+            uint32_t v = (uint32_t)(in[i * 2] << 8 | in[i * 2 + 1]);
+            uint32_t r = v >> 11, g = (v >> 5) & 0x3F, b = v & 0x1F;
+            out[i * 4 + 0] = (uint8_t)((r << 3) | (r >> 2));
+            out[i * 4 + 1] = (uint8_t)((g << 2) | (g >> 4));
+            out[i * 4 + 2] = (uint8_t)((b << 3) | (b >> 2));
+            out[i * 4 + 3] = 0xFF;
+        }
+    }
+
+    // Top bit set is opaque RGB555, clear is 3 bit alpha with RGB444.
+    static void DecodeRgb5a3Scalar(const uint8_t* in, uint8_t* out, size_t count){
+        for(size_t i = 0; i < count; i++){
+            uint32_t v = (uint32_t)(in[i * 2] << 8 | in[i * 2 + 1]);
+            if(v & 0x8000){
+                uint32_t r = (v >> 10) & 0x1F, g = (v >> 5) & 0x1F, b = v & 0x1F;
+                out[i * 4 + 0] = (uint8_t)((r << 3) | (r >> 2));
+                out[i * 4 + 1] = (uint8_t)((g << 3) | (g >> 2));
+                out[i * 4 + 2] = (uint8_t)((b << 3) | (b >> 2));
+                out[i * 4 + 3] = 0xFF;
+            }
+            else {
+                uint32_t a = (v >> 12) & 0x7;
+                out[i * 4 + 0] = (uint8_t)(((v >> 8) & 0xF) * 0x11);
+                out[i * 4 + 1] = (uint8_t)(((v >> 4) & 0xF) * 0x11);
+                out[i * 4 + 2] = (uint8_t)((v & 0xF) * 0x11);
+                out[i * 4 + 3] = (uint8_t)((a << 5) | (a << 2) | (a >> 1));
+            }
+        }
+    }
+
+#ifdef PYJ3D_SIMD_X86
+    PYJ3D_TARGET("sse4.2")
+    static void CullSpheresSse42(const float* x, const float* y, const float* z, const float* radius, size_t count,
+                                 const glm::vec4* planes, float radiusScale, uint8_t* visible){
+        __m128 px[6], py[6], pz[6], pw[6];
+        for(size_t p = 0; p < 6; p++){
+            px[p] = _mm_set1_ps(planes[p].x);
+            py[p] = _mm_set1_ps(planes[p].y);
+            pz[p] = _mm_set1_ps(planes[p].z);
+            pw[p] = _mm_set1_ps(planes[p].w);
+        }
+        __m128 negScale = _mm_set1_ps(-radiusScale);
+
+        size_t i = 0;
+        for(; i + 4 <= count; i += 4){
+            __m128 vx = _mm_loadu_ps(x + i), vy = _mm_loadu_ps(y + i), vz = _mm_loadu_ps(z + i);
+            __m128 limit = _mm_mul_ps(_mm_loadu_ps(radius + i), negScale);
+
+            __m128 inside = _mm_cmpeq_ps(vx, vx);
+            for(size_t p = 0; p < 6; p++){
+                __m128 dist = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(px[p], vx), _mm_mul_ps(py[p], vy)), _mm_mul_ps(pz[p], vz)), pw[p]);
+                inside = _mm_and_ps(inside, _mm_cmpge_ps(dist, limit));
+            }
+
+            int mask = _mm_movemask_ps(inside);
+            for(size_t k = 0; k < 4; k++) visible[i + k] = (uint8_t)((mask >> k) & 1);
+        }
+
+        CullSpheresScalar(x + i, y + i, z + i, radius + i, count - i, planes, radiusScale, visible + i);
+    }
+
+    PYJ3D_TARGET("sse4.2")
+    static void HermiteSse42(const float* u, const float* value0, const float* value1, const float* slope0, const float* slope1, float* out, size_t count){
+        const __m128 one = _mm_set1_ps(1.0f), two = _mm_set1_ps(2.0f), three = _mm_set1_ps(3.0f);
+
+        size_t i = 0;
+        for(; i + 4 <= count; i += 4){
+            __m128 t = _mm_loadu_ps(u + i), t2 = _mm_mul_ps(t, t), t3 = _mm_mul_ps(t2, t);
+
+            __m128 h00 = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(two, t3), _mm_mul_ps(three, t2)), one);
+            __m128 h01 = _mm_sub_ps(_mm_mul_ps(three, t2), _mm_mul_ps(two, t3));
+            __m128 h10 = _mm_add_ps(_mm_sub_ps(t3, _mm_mul_ps(two, t2)), t);
+            __m128 h11 = _mm_sub_ps(t3, t2);
+
+            __m128 result = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_loadu_ps(value0 + i), h00), _mm_mul_ps(_mm_loadu_ps(value1 + i), h01)),
+                                       _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(slope0 + i), h10), _mm_mul_ps(_mm_loadu_ps(slope1 + i), h11)));
+            _mm_storeu_ps(out + i, result);
+        }
+
+        HermiteScalar(u + i, value0 + i, value1 + i, slope0 + i, slope1 + i, out + i, count - i);
+    }
+
+    // The 16 bit kernels byteswap, widen each channel to 8 bits in its own 16 bit lane, then interleave
+    // the RG and BA lanes into RGBA8 texels.
+    PYJ3D_TARGET("sse4.2")
+    static void DecodeRgb565Sse42(const uint8_t* in, uint8_t* out, size_t count){
+        const __m128i swap = _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+        const __m128i mask5 = _mm_set1_epi16(0x1F), mask6 = _mm_set1_epi16(0x3F), alpha = _mm_set1_epi16((short)0xFF00);
+
+        size_t i = 0;
+        for(; i + 8 <= count; i += 8){
+            __m128i v = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(in + i * 2)), swap);
+            __m128i r = _mm_srli_epi16(v, 11);
+            __m128i g = _mm_and_si128(_mm_srli_epi16(v, 5), mask6);
+            __m128i b = _mm_and_si128(v, mask5);
+            r = _mm_or_si128(_mm_slli_epi16(r, 3), _mm_srli_epi16(r, 2));
+            g = _mm_or_si128(_mm_slli_epi16(g, 2), _mm_srli_epi16(g, 4));
+            b = _mm_or_si128(_mm_slli_epi16(b, 3), _mm_srli_epi16(b, 2));
+
+            __m128i rg = _mm_or_si128(r, _mm_slli_epi16(g, 8));
+            __m128i ba = _mm_or_si128(b, alpha);
+            _mm_storeu_si128((__m128i*)(out + i * 4), _mm_unpacklo_epi16(rg, ba));
+            _mm_storeu_si128((__m128i*)(out + i * 4 + 16), _mm_unpackhi_epi16(rg, ba));
+        }
+
+        DecodeRgb565Scalar(in + i * 2, out + i * 4, count - i);
+    }
+
+    PYJ3D_TARGET("sse4.2")
+    static void DecodeRgb5a3Sse42(const uint8_t* in, uint8_t* out, size_t count){
+        const __m128i swap = _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+        const __m128i mask3 = _mm_set1_epi16(0x7), mask4 = _mm_set1_epi16(0xF), mask5 = _mm_set1_epi16(0x1F);
+        const __m128i opaqueAlpha = _mm_set1_epi16(0xFF), nibble = _mm_set1_epi16(0x11);
+
+        size_t i = 0;
+        for(; i + 8 <= count; i += 8){
+            __m128i v = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(in + i * 2)), swap);
+            __m128i opaque = _mm_srai_epi16(v, 15);
+
+            __m128i r5 = _mm_and_si128(_mm_srli_epi16(v, 10), mask5);
+            __m128i g5 = _mm_and_si128(_mm_srli_epi16(v, 5), mask5);
+            __m128i b5 = _mm_and_si128(v, mask5);
+            r5 = _mm_or_si128(_mm_slli_epi16(r5, 3), _mm_srli_epi16(r5, 2));
+            g5 = _mm_or_si128(_mm_slli_epi16(g5, 3), _mm_srli_epi16(g5, 2));
+            b5 = _mm_or_si128(_mm_slli_epi16(b5, 3), _mm_srli_epi16(b5, 2));
+
+            __m128i r4 = _mm_mullo_epi16(_mm_and_si128(_mm_srli_epi16(v, 8), mask4), nibble);
+            __m128i g4 = _mm_mullo_epi16(_mm_and_si128(_mm_srli_epi16(v, 4), mask4), nibble);
+            __m128i b4 = _mm_mullo_epi16(_mm_and_si128(v, mask4), nibble);
+            __m128i a3 = _mm_and_si128(_mm_srli_epi16(v, 12), mask3);
+            a3 = _mm_or_si128(_mm_or_si128(_mm_slli_epi16(a3, 5), _mm_slli_epi16(a3, 2)), _mm_srli_epi16(a3, 1));
+
+            __m128i r = _mm_blendv_epi8(r4, r5, opaque);
+            __m128i g = _mm_blendv_epi8(g4, g5, opaque);
+            __m128i b = _mm_blendv_epi8(b4, b5, opaque);
+            __m128i a = _mm_blendv_epi8(a3, opaqueAlpha, opaque);
+
+            __m128i rg = _mm_or_si128(r, _mm_slli_epi16(g, 8));
+            __m128i ba = _mm_or_si128(b, _mm_slli_epi16(a, 8));
+            _mm_storeu_si128((__m128i*)(out + i * 4), _mm_unpacklo_epi16(rg, ba));
+            _mm_storeu_si128((__m128i*)(out + i * 4 + 16), _mm_unpackhi_epi16(rg, ba));
+        }
+
+        DecodeRgb5a3Scalar(in + i * 2, out + i * 4, count - i);
+    }
+
+    PYJ3D_TARGET("avx2,fma")
+    static void CullSpheresAvx2(const float* x, const float* y, const float* z, const float* radius, size_t count,
+                                const glm::vec4* planes, float radiusScale, uint8_t* visible){
+        __m256 px[6], py[6], pz[6], pw[6];
+        for(size_t p = 0; p < 6; p++){
+            px[p] = _mm256_set1_ps(planes[p].x);
+            py[p] = _mm256_set1_ps(planes[p].y);
+            pz[p] = _mm256_set1_ps(planes[p].z);
+            pw[p] = _mm256_set1_ps(planes[p].w);
+        }
+        __m256 negScale = _mm256_set1_ps(-radiusScale);
+
+        size_t i = 0;
+        for(; i + 8 <= count; i += 8){
+            __m256 vx = _mm256_loadu_ps(x + i), vy = _mm256_loadu_ps(y + i), vz = _mm256_loadu_ps(z + i);
+            __m256 limit = _mm256_mul_ps(_mm256_loadu_ps(radius + i), negScale);
+
+            __m256 inside = _mm256_cmp_ps(vx, vx, _CMP_EQ_OQ);
+            for(size_t p = 0; p < 6; p++){
+                __m256 dist = _mm256_fmadd_ps(px[p], vx, _mm256_fmadd_ps(py[p], vy, _mm256_fmadd_ps(pz[p], vz, pw[p])));
+                inside = _mm256_and_ps(inside, _mm256_cmp_ps(dist, limit, _CMP_GE_OQ));
+            }
+
+            int mask = _mm256_movemask_ps(inside);
+            for(size_t k = 0; k < 8; k++) visible[i + k] = (uint8_t)((mask >> k) & 1);
+        }
+
+        CullSpheresScalar(x + i, y + i, z + i, radius + i, count - i, planes, radiusScale, visible + i);
+    }
+
+    PYJ3D_TARGET("avx2,fma")
+    static void HermiteAvx2(const float* u, const float* value0, const float* value1, const float* slope0, const float* slope1, float* out, size_t count){
+        const __m256 one = _mm256_set1_ps(1.0f), two = _mm256_set1_ps(2.0f), three = _mm256_set1_ps(3.0f);
+
+        size_t i = 0;
+        for(; i + 8 <= count; i += 8){
+            __m256 t = _mm256_loadu_ps(u + i), t2 = _mm256_mul_ps(t, t), t3 = _mm256_mul_ps(t2, t);
+
+            __m256 h00 = _mm256_fmsub_ps(two, t3, _mm256_fmsub_ps(three, t2, one));
+            __m256 h01 = _mm256_fmsub_ps(three, t2, _mm256_mul_ps(two, t3));
+            __m256 h10 = _mm256_add_ps(_mm256_fnmadd_ps(two, t2, t3), t);
+            __m256 h11 = _mm256_sub_ps(t3, t2);
+
+            __m256 result = _mm256_mul_ps(_mm256_loadu_ps(value0 + i), h00);
+            result = _mm256_fmadd_ps(_mm256_loadu_ps(value1 + i), h01, result);
+            result = _mm256_fmadd_ps(_mm256_loadu_ps(slope0 + i), h10, result);
+            result = _mm256_fmadd_ps(_mm256_loadu_ps(slope1 + i), h11, result);
+            _mm256_storeu_ps(out + i, result);
+        }
+
+        HermiteScalar(u + i, value0 + i, value1 + i, slope0 + i, slope1 + i, out + i, count - i);
+    }
+
+    // unpack works within 128 bit lanes, so the two halves are put back in texel order before storing
+    PYJ3D_TARGET("avx2,fma")
+    static void DecodeRgb565Avx2(const uint8_t* in, uint8_t* out, size_t count){
+        const __m256i swap = _mm256_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14,
+                                              1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+        const __m256i mask5 = _mm256_set1_epi16(0x1F), mask6 = _mm256_set1_epi16(0x3F), alpha = _mm256_set1_epi16((short)0xFF00);
+
+        size_t i = 0;
+        for(; i + 16 <= count; i += 16){
+            __m256i v = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i*)(in + i * 2)), swap);
+            __m256i r = _mm256_srli_epi16(v, 11);
+            __m256i g = _mm256_and_si256(_mm256_srli_epi16(v, 5), mask6);
+            __m256i b = _mm256_and_si256(v, mask5);
+            r = _mm256_or_si256(_mm256_slli_epi16(r, 3), _mm256_srli_epi16(r, 2));
+            g = _mm256_or_si256(_mm256_slli_epi16(g, 2), _mm256_srli_epi16(g, 4));
+            b = _mm256_or_si256(_mm256_slli_epi16(b, 3), _mm256_srli_epi16(b, 2));
+
+            __m256i rg = _mm256_or_si256(r, _mm256_slli_epi16(g, 8));
+            __m256i ba = _mm256_or_si256(b, alpha);
+            __m256i lo = _mm256_unpacklo_epi16(rg, ba), hi = _mm256_unpackhi_epi16(rg, ba);
+            _mm256_storeu_si256((__m256i*)(out + i * 4), _mm256_permute2x128_si256(lo, hi, 0x20));
+            _mm256_storeu_si256((__m256i*)(out + i * 4 + 32), _mm256_permute2x128_si256(lo, hi, 0x31));
+        }
+
+        DecodeRgb565Sse42(in + i * 2, out + i * 4, count - i);
+    }
+
+    PYJ3D_TARGET("avx2,fma")
+    static void DecodeRgb5a3Avx2(const uint8_t* in, uint8_t* out, size_t count){
+        const __m256i swap = _mm256_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14,
+                                              1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+        const __m256i mask3 = _mm256_set1_epi16(0x7), mask4 = _mm256_set1_epi16(0xF), mask5 = _mm256_set1_epi16(0x1F);
+        const __m256i opaqueAlpha = _mm256_set1_epi16(0xFF), nibble = _mm256_set1_epi16(0x11);
+
+        size_t i = 0;
+        for(; i + 16 <= count; i += 16){
+            __m256i v = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i*)(in + i * 2)), swap);
+            __m256i opaque = _mm256_srai_epi16(v, 15);
+
+            __m256i r5 = _mm256_and_si256(_mm256_srli_epi16(v, 10), mask5);
+            __m256i g5 = _mm256_and_si256(_mm256_srli_epi16(v, 5), mask5);
+            __m256i b5 = _mm256_and_si256(v, mask5);
+            r5 = _mm256_or_si256(_mm256_slli_epi16(r5, 3), _mm256_srli_epi16(r5, 2));
+            g5 = _mm256_or_si256(_mm256_slli_epi16(g5, 3), _mm256_srli_epi16(g5, 2));
+            b5 = _mm256_or_si256(_mm256_slli_epi16(b5, 3), _mm256_srli_epi16(b5, 2));
+
+            __m256i r4 = _mm256_mullo_epi16(_mm256_and_si256(_mm256_srli_epi16(v, 8), mask4), nibble);
+            __m256i g4 = _mm256_mullo_epi16(_mm256_and_si256(_mm256_srli_epi16(v, 4), mask4), nibble);
+            __m256i b4 = _mm256_mullo_epi16(_mm256_and_si256(v, mask4), nibble);
+            __m256i a3 = _mm256_and_si256(_mm256_srli_epi16(v, 12), mask3);
+            a3 = _mm256_or_si256(_mm256_or_si256(_mm256_slli_epi16(a3, 5), _mm256_slli_epi16(a3, 2)), _mm256_srli_epi16(a3, 1));
+
+            __m256i r = _mm256_blendv_epi8(r4, r5, opaque);
+            __m256i g = _mm256_blendv_epi8(g4, g5, opaque);
+            __m256i b = _mm256_blendv_epi8(b4, b5, opaque);
+            __m256i a = _mm256_blendv_epi8(a3, opaqueAlpha, opaque);
+
+            __m256i rg = _mm256_or_si256(r, _mm256_slli_epi16(g, 8));
+            __m256i ba = _mm256_or_si256(b, _mm256_slli_epi16(a, 8));
+            __m256i lo = _mm256_unpacklo_epi16(rg, ba), hi = _mm256_unpackhi_epi16(rg, ba);
+            _mm256_storeu_si256((__m256i*)(out + i * 4), _mm256_permute2x128_si256(lo, hi, 0x20));
+            _mm256_storeu_si256((__m256i*)(out + i * 4 + 32), _mm256_permute2x128_si256(lo, hi, 0x31));
+        }
+
+        DecodeRgb5a3Sse42(in + i * 2, out + i * 4, count - i);
+    }
+#endif
+
+    static const Kernels kernelTable[] = {
+        { CullSpheresScalar, HermiteScalar, DecodeRgb565Scalar, DecodeRgb5a3Scalar },
+#ifdef PYJ3D_SIMD_X86
+        { CullSpheresSse42, HermiteSse42, DecodeRgb565Sse42, DecodeRgb5a3Sse42 },
+        { CullSpheresAvx2, HermiteAvx2, DecodeRgb565Avx2, DecodeRgb5a3Avx2 }
+#endif
+    };
+
+    static CpuFeatures DetectFeatures(){
+        CpuFeatures detected;
+#if defined(PYJ3D_SIMD_X86) && defined(_MSC_VER)
+        int info[4];
+        __cpuid(info, 0);
+        int maxLeaf = info[0];
+
+        __cpuid(info, 1);
+        detected.Sse42 = (info[2] & (1 << 20)) != 0;
+        bool osSavesAvx = (info[2] & (1 << 27)) != 0 && (_xgetbv(0) & 6) == 6;
+        detected.Avx = osSavesAvx && (info[2] & (1 << 28)) != 0;
+        detected.Fma = detected.Avx && (info[2] & (1 << 12)) != 0;
+
+        if(maxLeaf >= 7){
+            __cpuidex(info, 7, 0);
+            detected.Avx2 = detected.Avx && (info[1] & (1 << 5)) != 0;
+        }
+#elif defined(PYJ3D_SIMD_X86)
+        // also checks that the OS saves the AVX registers
+        __builtin_cpu_init();
+        detected.Sse42 = __builtin_cpu_supports("sse4.2");
+        detected.Avx = __builtin_cpu_supports("avx");
+        detected.Avx2 = __builtin_cpu_supports("avx2");
+        detected.Fma = __builtin_cpu_supports("fma");
+#endif
+        return detected;
+    }
+
+    static const CpuFeatures cpuFeatures = DetectFeatures();
+
+    static Level DetectSupportedLevel(){
+        if(cpuFeatures.Avx2 && cpuFeatures.Fma) return Level::Avx2;
+        if(cpuFeatures.Sse42) return Level::Sse42;
+        return Level::Scalar;
+    }
+
+    static const Level supportedLevel = DetectSupportedLevel();
+
+    static Level InitialLevel(){
+        const char* requested = std::getenv("PYJ3D_SIMD");
+        if(requested == nullptr) return supportedLevel;
+
+        for(Level level : { Level::Scalar, Level::Sse42, Level::Avx2 }){
+            if(std::strcmp(requested, GetLevelName(level)) == 0) return std::min(level, supportedLevel);
+        }
+        return supportedLevel;
+    }
+
+    static Level activeLevel = InitialLevel();
+
+    const CpuFeatures& GetCpuFeatures(){
+        return cpuFeatures;
+    }
+
+    Level GetSupportedLevel(){
+        return supportedLevel;
+    }
+
+    Level GetLevel(){
+        return activeLevel;
+    }
+
+    Level SetLevel(Level level){
+        activeLevel = std::min(level, supportedLevel);
+        return activeLevel;
+    }
+
+    const char* GetLevelName(Level level){
+        switch(level){
+            case Level::Sse42: return "sse42";
+            case Level::Avx2: return "avx2";
+            default: return "scalar";
+        }
+    }
+
+    const Kernels& GetKernels(){
+        return kernelTable[(size_t)activeLevel];
+    }
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+namespace PyJ3D::Simd {
+    enum class Level : uint8_t {
+        Scalar,
+        Sse42,
+        Avx2 // with FMA
+    };
+
+    struct CpuFeatures {
+        bool Sse42 = false;
+        bool Avx = false;
+        bool Avx2 = false;
+        bool Fma = false;
+    };
+
+    // Hot loops with one variant per level. Every variant writes the same results up to float rounding.
+    struct Kernels {
+        // visible[i] = 1 when sphere i is on the inner side of all six normalized planes, 0 otherwise.
+        void (*CullSpheres)(const float* x, const float* y, const float* z, const float* radius, size_t count,
+                            const glm::vec4* planes, float radiusScale, uint8_t* visible);
+
+        // Cubic hermite per element, u in [0, 1] and slopes already scaled by the segment span.
+        void (*Hermite)(const float* u, const float* value0, const float* value1, const float* slope0, const float* slope1, float* out, size_t count);
+
+        // Big endian 16 bit GX texels to RGBA8, count texels. Variants match bit for bit.
+        void (*DecodeRgb565)(const uint8_t* in, uint8_t* out, size_t count);
+        void (*DecodeRgb5a3)(const uint8_t* in, uint8_t* out, size_t count);
+    };
+
+    // Detected once when the module loads.
+    const CpuFeatures& GetCpuFeatures();
+
+    // Best level the CPU and the build support.
+    Level GetSupportedLevel();
+
+    // Level in use. Starts at the supported level, or lower if the PYJ3D_SIMD environment variable
+    // (scalar, sse42 or avx2) asks for it.
+    Level GetLevel();
+
+    // Drops to or back up to level, clamped to what is supported. Returns the level now in use.
+    Level SetLevel(Level level);
+
+    const char* GetLevelName(Level level);
+
+    const Kernels& GetKernels();
+}
@@ -0,0 +1,338 @@
+#include "TextureDecode.hpp"
+#include "Simd.hpp"
+#include "ThreadPool.hpp"
+#include "DiskCache.hpp"
+#include "Hash.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace PyJ3D::TextureDecode {
+    struct FormatInfo {
+        uint32_t BlockWidth;
+        uint32_t BlockHeight;
+        uint32_t Bits;
+    };
+
+    // Tile rows per parallel chunk, small textures decode on the calling thread.
+    static const size_t MinTileRows = 4;
+
+    static bool GetFormatInfo(uint8_t format, FormatInfo& out){
+        switch((Format)format){
+            case Format::I4: case Format::C4: case Format::CMPR: out = { 8, 8, 4 }; return true;
+            case Format::I8: case Format::IA4: case Format::C8: out = { 8, 4, 8 }; return true;
+            case Format::IA8: case Format::RGB565: case Format::RGB5A3: case Format::C14X2: out = { 4, 4, 16 }; return true;
+            case Format::RGBA8: out = { 4, 4, 32 }; return true;
+            default: return false;
+        }
+    }
+
+    static bool IsPaletted(uint8_t format){
+        return format == (uint8_t)Format::C4 || format == (uint8_t)Format::C8 || format == (uint8_t)Format::C14X2;
+    }
+
+    bool IsSupported(uint8_t format){
+        FormatInfo info;
+        return GetFormatInfo(format, info);
+    }
+
+    uint32_t GetLevelWidth(const J3DFile::TextureHeader& texture, uint32_t level){
+        return std::max<uint32_t>(texture.Width >> level, 1);
+    }
+
+    uint32_t GetLevelHeight(const J3DFile::TextureHeader& texture, uint32_t level){
+        return std::max<uint32_t>(texture.Height >> level, 1);
+    }
+
+    size_t GetLevelSize(uint8_t format, uint32_t width, uint32_t height){
+        FormatInfo info;
+        if(!GetFormatInfo(format, info)) return 0;
+
+        size_t tilesX = (width + info.BlockWidth - 1) / info.BlockWidth;
+        size_t tilesY = (height + info.BlockHeight - 1) / info.BlockHeight;
+        return tilesX * tilesY * info.BlockWidth * info.BlockHeight * info.Bits / 8;
+    }
+
+    size_t GetDataSize(const J3DFile::TextureHeader& texture){
+        size_t total = 0;
+        for(uint32_t level = 0; level < texture.MipCount; level++){
+            total += GetLevelSize(texture.Format, GetLevelWidth(texture, level), GetLevelHeight(texture, level));
+        }
+        return total;
+    }
+
+    // Start of a level's data, nullptr if it doesn't fit in the file.
+    static const uint8_t* FindLevel(const uint8_t* data, size_t size, const J3DFile::TextureHeader& texture, uint32_t level){
+        if(level >= texture.MipCount || !IsSupported(texture.Format)) return nullptr;
+
+        size_t offset = texture.DataOffset;
+        for(uint32_t i = 0; i < level; i++){
+            offset += GetLevelSize(texture.Format, GetLevelWidth(texture, i), GetLevelHeight(texture, i));
+        }
+
+        size_t levelSize = GetLevelSize(texture.Format, GetLevelWidth(texture, level), GetLevelHeight(texture, level));
+        if(offset > size || size - offset < levelSize) return nullptr;
+
+        return data + offset;
+    }
+
+    static void DecodeIA8Row(const uint8_t* in, uint8_t* out, size_t count){
+        for(size_t i = 0; i < count; i++){
+            uint8_t alpha = in[i * 2], intensity = in[i * 2 + 1];
+            out[i * 4 + 0] = intensity;
+            out[i * 4 + 1] = intensity;
+            out[i * 4 + 2] = intensity;
+            out[i * 4 + 3] = alpha;
+        }
+    }
+
+    // Palette entries as RGBA8, indices past the end read transparent black.
+    static bool DecodePalette(const uint8_t* data, size_t size, const J3DFile::TextureHeader& texture, std::vector<uint32_t>& out){
+        if(texture.PaletteOffset > size || size - texture.PaletteOffset < texture.PaletteCount * 2u) return false;
+
+        // sized for the largest C14X2 index so lookups never need a bounds check
+        out.assign(1 << 14, 0);
+        const uint8_t* entries = data + texture.PaletteOffset;
+        uint8_t* rgba = (uint8_t*)out.data();
+        size_t count = std::min<size_t>(texture.PaletteCount, out.size());
+
+        switch((PaletteFormat)texture.PaletteFormat){
+            case PaletteFormat::IA8: DecodeIA8Row(entries, rgba, count); return true;
+            case PaletteFormat::RGB565: Simd::GetKernels().DecodeRgb565(entries, rgba, count); return true;
+            case PaletteFormat::RGB5A3: Simd::GetKernels().DecodeRgb5a3(entries, rgba, count); return true;
+            default: return false;
+        }
+    }
+
+    // One scanline of untiled texels, in holds the row at the format's native size.
+    static void DecodeRow(uint8_t format, const uint8_t* in, uint8_t* out, size_t count, const uint32_t* palette){
+        switch((Format)format){
+            case Format::I4:
+                for(size_t i = 0; i < count; i++){
+                    uint8_t value = (uint8_t)(((in[i >> 1] >> ((~i & 1) * 4)) & 0xF) * 0x11);
+                    std::memset(out + i * 4, value, 4);
+                }
+                break;
+            case Format::I8:
+                for(size_t i = 0; i < count; i++){
+                    std::memset(out + i * 4, in[i], 4);
+                }
+                break;
+            case Format::IA4:
+                for(size_t i = 0; i < count; i++){
+                    uint8_t intensity = (uint8_t)((in[i] & 0xF) * 0x11);
+                    out[i * 4 + 0] = intensity;
+                    out[i * 4 + 1] = intensity;
+                    out[i * 4 + 2] = intensity;
+                    out[i * 4 + 3] = (uint8_t)((in[i] >> 4) * 0x11);
+                }
+                break;
+            case Format::IA8:
+                DecodeIA8Row(in, out, count);
+                break;
+            case Format::RGB565:
+                Simd::GetKernels().DecodeRgb565(in, out, count);
+                break;
+            case Format::RGB5A3:
+                Simd::GetKernels().DecodeRgb5a3(in, out, count);
+                break;
+            case Format::C4:
+                for(size_t i = 0; i < count; i++){
+                    std::memcpy(out + i * 4, &palette[(in[i >> 1] >> ((~i & 1) * 4)) & 0xF], 4);
+                }
+                break;
+            case Format::C8:
+                for(size_t i = 0; i < count; i++){
+                    std::memcpy(out + i * 4, &palette[in[i]], 4);
+                }
+                break;
+            case Format::C14X2:
+                for(size_t i = 0; i < count; i++){
+                    std::memcpy(out + i * 4, &palette[((in[i * 2] << 8) | in[i * 2 + 1]) & 0x3FFF], 4);
+                }
+                break;
+            default:
+                break;
+        }
+    }
+
+    // RGBA8 tiles hold 16 AR pairs followed by 16 GB pairs.
+    static void DecodeRGBA8Tiles(const uint8_t* in, uint8_t* out, uint32_t width, uint32_t height, size_t tilesX, size_t begin, size_t end){
+        for(size_t ty = begin; ty < end; ty++){
+            for(size_t tx = 0; tx < tilesX; tx++){
+                const uint8_t* tile = in + (ty * tilesX + tx) * 64;
+                for(uint32_t texel = 0; texel < 16; texel++){
+                    size_t x = tx * 4 + (texel & 3), y = ty * 4 + (texel >> 2);
+                    if(x >= width || y >= height) continue;
+
+                    uint8_t* pixel = out + (y * width + x) * 4;
+                    pixel[0] = tile[texel * 2 + 1];
+                    pixel[1] = tile[32 + texel * 2];
+                    pixel[2] = tile[32 + texel * 2 + 1];
+                    pixel[3] = tile[texel * 2];
+                }
+            }
+        }
+    }
+
+    static void DecodeCMPRBlock(const uint8_t* block, uint8_t* out, uint32_t width, uint32_t height, size_t blockX, size_t blockY){
+        uint8_t colors[16];
+        Simd::GetKernels().DecodeRgb565(block, colors, 2);
+
+        uint16_t color0 = (uint16_t)(block[0] << 8 | block[1]), color1 = (uint16_t)(block[2] << 8 | block[3]);
+        for(uint32_t c = 0; c < 3; c++){
+            if(color0 > color1){
+                colors[8 + c] = (uint8_t)((2 * colors[c] + colors[4 + c]) / 3);
+                colors[12 + c] = (uint8_t)((colors[c] + 2 * colors[4 + c]) / 3);
+            }
+            else {
+                colors[8 + c] = (uint8_t)((colors[c] + colors[4 + c]) / 2);
+                colors[12 + c] = 0;
+            }
+        }
+        colors[11] = 0xFF;
+        colors[15] = color0 > color1 ? 0xFF : 0x00;
+
+        for(uint32_t row = 0; row < 4; row++){
+            size_t y = blockY * 4 + row;
+            if(y >= height) break;
+
+            uint8_t indices = block[4 + row];
+            for(uint32_t column = 0; column < 4; column++){
+                size_t x = blockX * 4 + column;
+                if(x >= width) break;
+
+                std::memcpy(out + (y * width + x) * 4, colors + ((indices >> (6 - column * 2)) & 3) * 4, 4);
+            }
+        }
+    }
+
+    bool DecodeLevel(const uint8_t* data, size_t size, const J3DFile::TextureHeader& texture, uint32_t level, std::vector<uint8_t>& out){
+        const uint8_t* in = FindLevel(data, size, texture, level);
+        if(in == nullptr) return false;
+
+        uint32_t width = GetLevelWidth(texture, level), height = GetLevelHeight(texture, level);
+        out.resize((size_t)width * height * 4);
+        uint8_t* pixels = out.data();
+
+        FormatInfo info;
+        GetFormatInfo(texture.Format, info);
+        size_t tilesX = (width + info.BlockWidth - 1) / info.BlockWidth;
+        size_t tilesY = (height + info.BlockHeight - 1) / info.BlockHeight;
+
+        if(texture.Format == (uint8_t)Format::RGBA8){
+            Jobs::ParallelFor(tilesY, MinTileRows, [&](size_t begin, size_t end){
+                DecodeRGBA8Tiles(in, pixels, width, height, tilesX, begin, end);
+            });
+            return true;
+        }
+
+        if(texture.Format == (uint8_t)Format::CMPR){
+            Jobs::ParallelFor(tilesY, MinTileRows, [&](size_t begin, size_t end){
+                for(size_t ty = begin; ty < end; ty++){
+                    for(size_t tx = 0; tx < tilesX; tx++){
+                        const uint8_t* tile = in + (ty * tilesX + tx) * 32;
+                        for(uint32_t block = 0; block < 4; block++){
+                            DecodeCMPRBlock(tile + block * 8, pixels, width, height, tx * 2 + (block & 1), ty * 2 + (block >> 1));
+                        }
+                    }
+                }
+            });
+            return true;
+        }
+
+        std::vector<uint32_t> palette;
+        if(IsPaletted(texture.Format) && !DecodePalette(data, size, texture, palette)) return false;
+
+        // untile one band of tile rows into scanlines, then decode each scanline in one call
+        size_t tileRowBytes = info.BlockWidth * info.Bits / 8;
+        size_t pitch = tilesX * tileRowBytes;
+        Jobs::ParallelFor(tilesY, MinTileRows, [&](size_t begin, size_t end){
+            thread_local std::vector<uint8_t> band;
+            band.resize(pitch * info.BlockHeight);
+
+            for(size_t ty = begin; ty < end; ty++){
+                for(size_t tx = 0; tx < tilesX; tx++){
+                    const uint8_t* tile = in + (ty * tilesX + tx) * tileRowBytes * info.BlockHeight;
+                    for(uint32_t row = 0; row < info.BlockHeight; row++){
+                        std::memcpy(band.data() + row * pitch + tx * tileRowBytes, tile + row * tileRowBytes, tileRowBytes);
+                    }
+                }
+
+                for(uint32_t row = 0; row < info.BlockHeight; row++){
+                    size_t y = ty * info.BlockHeight + row;
+                    if(y >= height) break;
+                    DecodeRow(texture.Format, band.data() + row * pitch, pixels + y * width * 4, width, palette.data());
+                }
+            }
+        });
+
+        return true;
+    }
+
+    // GX stores the first texel of a row in the top bits, BC1 in the bottom ones.
+    static uint8_t ReverseIndices(uint8_t row){
+        return (uint8_t)(((row & 0x03) << 6) | ((row & 0x0C) << 2) | ((row & 0x30) >> 2) | ((row & 0xC0) >> 6));
+    }
+
+    bool DecodeLevelCached(const uint8_t* data, size_t size, const J3DFile::TextureHeader& texture, uint32_t level, std::vector<uint8_t>& out){
+        const uint8_t* in = FindLevel(data, size, texture, level);
+        if(in == nullptr || !DiskCache::IsEnabled()) return DecodeLevel(data, size, texture, level, out);
+
+        uint32_t width = GetLevelWidth(texture, level), height = GetLevelHeight(texture, level);
+        uint64_t salt = HashBytes(&texture.Format, 1, ((uint64_t)width << 32) | height);
+        if(IsPaletted(texture.Format) && texture.PaletteOffset <= size && size - texture.PaletteOffset >= texture.PaletteCount * 2u){
+            salt = HashBytes(data + texture.PaletteOffset, texture.PaletteCount * 2u, salt ^ texture.PaletteFormat);
+        }
+        uint64_t key = DiskCache::MakeKey(in, GetLevelSize(texture.Format, width, height), salt);
+
+        size_t pixelBytes = (size_t)width * height * 4;
+        DiskCache::Blob blob;
+        if(DiskCache::Read(DiskCache::BlobKind::TextureLevel, key, blob) && blob.Size == pixelBytes){
+            out.assign(blob.Payload, blob.Payload + blob.Size);
+            return true;
+        }
+
+        if(!DecodeLevel(data, size, texture, level, out)) return false;
+        DiskCache::Write(DiskCache::BlobKind::TextureLevel, key, out.data(), out.size());
+        return true;
+    }
+
+    bool ConvertCmprToBc1(const uint8_t* data, size_t size, const J3DFile::TextureHeader& texture, uint32_t level, std::vector<uint8_t>& out){
+        if(texture.Format != (uint8_t)Format::CMPR) return false;
+
+        const uint8_t* in = FindLevel(data, size, texture, level);
+        if(in == nullptr) return false;
+
+        uint32_t width = GetLevelWidth(texture, level), height = GetLevelHeight(texture, level);
+        size_t blocksX = (width + 3) / 4, blocksY = (height + 3) / 4;
+        size_t tilesX = (width + 7) / 8, tilesY = (height + 7) / 8;
+
+        out.resize(blocksX * blocksY * 8);
+        uint8_t* blocks = out.data();
+
+        Jobs::ParallelFor(tilesY, MinTileRows * 4, [&](size_t begin, size_t end){
+            for(size_t ty = begin; ty < end; ty++){
+                for(size_t tx = 0; tx < tilesX; tx++){
+                    const uint8_t* tile = in + (ty * tilesX + tx) * 32;
+                    for(uint32_t block = 0; block < 4; block++){
+                        size_t bx = tx * 2 + (block & 1), by = ty * 2 + (block >> 1);
+                        if(bx >= blocksX || by >= blocksY) continue;
+
+                        const uint8_t* source = tile + block * 8;
+                        uint8_t* target = blocks + (by * blocksX + bx) * 8;
+                        target[0] = source[1];
+                        target[1] = source[0];
+                        target[2] = source[3];
+                        target[3] = source[2];
+                        for(uint32_t row = 0; row < 4; row++){
+                            target[4 + row] = ReverseIndices(source[4 + row]);
+                        }
+                    }
+                }
+            }
+        });
+
+        return true;
+    }
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "J3DFile.hpp"
+
+namespace PyJ3D::TextureDecode {
+    enum class Format : uint8_t {
+        I4 = 0x0,
+        I8 = 0x1,
+        IA4 = 0x2,
+        IA8 = 0x3,
+        RGB565 = 0x4,
+        RGB5A3 = 0x5,
+        RGBA8 = 0x6,
+        C4 = 0x8,
+        C8 = 0x9,
+        C14X2 = 0xA,
+        CMPR = 0xE
+    };
+
+    enum class PaletteFormat : uint8_t {
+        IA8 = 0,
+        RGB565 = 1,
+        RGB5A3 = 2
+    };
+
+    bool IsSupported(uint8_t format);
+
+    uint32_t GetLevelWidth(const J3DFile::TextureHeader& texture, uint32_t level);
+    uint32_t GetLevelHeight(const J3DFile::TextureHeader& texture, uint32_t level);
+
+    // Bytes one level takes in the file, padded out to whole tiles. 0 for unknown formats.
+    size_t GetLevelSize(uint8_t format, uint32_t width, uint32_t height);
+
+    // Bytes every level of the texture takes.
+    size_t GetDataSize(const J3DFile::TextureHeader& texture);
+
+    // Decodes one level to RGBA8 with rows top first. Tile rows are split across the worker pool, and
+    // the 16 bit formats are untiled into whole scanlines first so the SIMD kernels get long runs.
+    bool DecodeLevel(const uint8_t* data, size_t size, const J3DFile::TextureHeader& texture, uint32_t level, std::vector<uint8_t>& out);
+
+    // DecodeLevel through the disk cache when it is enabled, keyed on the level's texels, its palette and the header.
+    // Safe from worker threads.
+    bool DecodeLevelCached(const uint8_t* data, size_t size, const J3DFile::TextureHeader& texture, uint32_t level, std::vector<uint8_t>& out);
+
+    // CMPR is DXT1 with big endian colors, reversed index order and 2x2 blocks per tile, so it only has to
+    // be reordered into BC1 blocks, no decompression. out receives ceil(w / 4) * ceil(h / 4) * 8 bytes.
+    bool ConvertCmprToBc1(const uint8_t* data, size_t size, const J3DFile::TextureHeader& texture, uint32_t level, std::vector<uint8_t>& out);
+}
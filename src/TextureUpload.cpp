@@ -0,0 +1,531 @@
+#include "TextureUpload.hpp"
+#include "J3DFile.hpp"
+#include "TextureDecode.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+#include <glad/glad.h>
+
+namespace PyJ3D::TextureUpload {
+    // GL_COMPRESSED_RGBA_S3TC_DXT1_EXT, CMPR's punch through alpha needs the RGBA variant
+    static const GLenum Bc1Format = 0x83F1;
+
+    enum class UploadPath {
+        Image, // glTexImage2D on the bound texture
+        Storage, // glTexStorage2D on the bound texture
+        NamedStorage // glTextureStorage2D
+    };
+
+    // Replaced TEX1 entries point J3DUltra at a 4x4 RGBA8 stand-in per level, written over the start of their texels.
+    // Every stand-in texel is (TagMagic, index >> 8, index & 0xFF, 0xFF), so the pixels J3DUltra uploads say which entry
+    // a GL texture is for, whatever order it creates them in.
+    static const GLsizei StubSize = 4;
+    static const size_t StubLevelBytes = 64; // one RGBA8 tile
+    static const uint8_t TagMagic = 0x50;
+    static const size_t HeaderBytes = 0x20;
+
+    // Bytes of the file a stand-in overwrote, put back once J3DUltra is done with them.
+    struct Patch {
+        size_t Offset = 0;
+        std::vector<uint8_t> Original;
+    };
+
+    // Storage J3DUltra asked for at the stand-in size, held back until its pixels say which texture it is.
+    struct PendingStorage {
+        GLenum Target;
+        GLsizei Levels;
+        GLenum InternalFormat;
+        bool Named;
+    };
+
+    static bool compressedUpload = true;
+    static bool capturing = false;
+    static bool passthrough = false;
+    static TextureStats totals = {};
+
+    static TextureStats* captureStats = nullptr;
+    static const uint8_t* captureData = nullptr;
+    static size_t captureSize = 0;
+    static std::vector<J3DFile::TextureHeader> captureTextures = {};
+    static uint8_t* patchData = nullptr;
+    static std::vector<uint8_t> stubbed = {}; // per TEX1 index, 1 if the entry was pointed at a stand-in
+    static std::vector<uint8_t> replaced = {}; // per TEX1 index, 1 once its real levels were uploaded
+    static std::vector<Patch> headerPatches = {}; // per TEX1 index, empty for entries left alone
+    static std::vector<Patch> texelPatches = {};
+    static std::unordered_map<GLuint, PendingStorage> pendingStorage = {};
+    static std::unordered_map<GLuint, bool> replacedTextures = {}; // GL name to whether every level was supplied
+
+    // real entry points while the capture wrappers are installed
+    static PFNGLTEXIMAGE2DPROC realTexImage2D = nullptr;
+    static PFNGLTEXSTORAGE2DPROC realTexStorage2D = nullptr;
+    static PFNGLTEXSUBIMAGE2DPROC realTexSubImage2D = nullptr;
+    static PFNGLGENERATEMIPMAPPROC realGenerateMipmap = nullptr;
+    static PFNGLTEXTURESTORAGE2DPROC realTextureStorage2D = nullptr;
+    static PFNGLTEXTURESUBIMAGE2DPROC realTextureSubImage2D = nullptr;
+    static PFNGLGENERATETEXTUREMIPMAPPROC realGenerateTextureMipmap = nullptr;
+
+    TextureStats& TextureStats::operator+=(const TextureStats& other){
+        Textures += other.Textures;
+        Decoded += other.Decoded;
+        Passthrough += other.Passthrough;
+        DecodedBytes += other.DecodedBytes;
+        CompressedBytes += other.CompressedBytes;
+        SavedBytes += other.SavedBytes;
+        LoadMs += other.LoadMs;
+        UploadMs += other.UploadMs;
+        ConvertMs += other.ConvertMs;
+        return *this;
+    }
+
+    static double NowMs(){
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    static size_t TexelBytes(GLenum format, GLenum type){
+        if(type != GL_UNSIGNED_BYTE) return 2; // packed 16 bit types
+        switch(format){
+            case GL_RED: return 1;
+            case GL_RG: return 2;
+            case GL_RGB: case GL_BGR: return 3;
+            default: return 4;
+        }
+    }
+
+    static void CountDecoded(GLsizei width, GLsizei height, GLenum format, GLenum type, const void* pixels){
+        if(pixels != nullptr) captureStats->DecodedBytes += (uint64_t)width * height * TexelBytes(format, type);
+    }
+
+    static GLuint BoundTexture(){
+        GLint name = 0;
+        glGetIntegerv(GL_TEXTURE_BINDING_2D, &name);
+        return (GLuint)name;
+    }
+
+    static void PutU16(uint8_t* out, uint16_t value){
+        out[0] = (uint8_t)(value >> 8);
+        out[1] = (uint8_t)value;
+    }
+
+    // empty ranges overlap nothing
+    static bool Overlaps(size_t begin, size_t end, size_t otherBegin, size_t otherEnd){
+        return otherBegin < otherEnd && begin < otherEnd && otherBegin < end;
+    }
+
+    static size_t StubBytes(const J3DFile::TextureHeader& texture){
+        return StubLevelBytes * texture.MipCount;
+    }
+
+    static bool CanReplace(const J3DFile::TextureHeader& texture, size_t size){
+        if(!TextureDecode::IsSupported(texture.Format) || texture.HeaderOffset + HeaderBytes > size) return false;
+        size_t dataSize = TextureDecode::GetDataSize(texture);
+        if(texture.DataOffset > size || size - texture.DataOffset < dataSize || dataSize < StubBytes(texture)) return false;
+        return texture.PaletteOffset <= size && size - texture.PaletteOffset >= (size_t)texture.PaletteCount * 2;
+    }
+
+    // The stand-in may only cover bytes nothing but this entry's texels use, entries sharing texels are left to J3DUltra.
+    static bool OwnsStubRange(size_t index){
+        const J3DFile::TextureHeader& texture = captureTextures[index];
+        size_t begin = texture.DataOffset, end = begin + StubBytes(texture);
+
+        for(size_t i = 0; i < captureTextures.size(); i++){
+            const J3DFile::TextureHeader& other = captureTextures[i];
+            if(Overlaps(begin, end, other.HeaderOffset, other.HeaderOffset + HeaderBytes)) return false;
+            if(Overlaps(begin, end, other.PaletteOffset, other.PaletteOffset + (size_t)other.PaletteCount * 2)) return false;
+            if(i != index && Overlaps(begin, end, other.DataOffset, other.DataOffset + TextureDecode::GetDataSize(other))) return false;
+        }
+        return true;
+    }
+
+    static void Save(Patch& patch, size_t offset, size_t size){
+        patch.Offset = offset;
+        patch.Original.assign(patchData + offset, patchData + offset + size);
+    }
+
+    static void Restore(Patch& patch){
+        if(patch.Original.empty()) return;
+        std::memcpy(patchData + patch.Offset, patch.Original.data(), patch.Original.size());
+        patch.Original.clear();
+    }
+
+    // Points every entry TextureDecode can handle at a stand-in written over the start of its texels, in place.
+    static bool StubTextures(uint8_t* data, size_t size){
+        stubbed.assign(captureTextures.size(), 0);
+        for(size_t i = 0; i < captureTextures.size(); i++) stubbed[i] = i <= 0xFFFF && CanReplace(captureTextures[i], size) && OwnsStubRange(i);
+        if(std::find(stubbed.begin(), stubbed.end(), 1) == stubbed.end()){
+            stubbed.clear();
+            return false;
+        }
+
+        patchData = data;
+        replaced.assign(captureTextures.size(), 0);
+        headerPatches.assign(captureTextures.size(), Patch());
+        texelPatches.assign(captureTextures.size(), Patch());
+
+        for(size_t i = 0; i < captureTextures.size(); i++){
+            if(!stubbed[i]) continue;
+            const J3DFile::TextureHeader& texture = captureTextures[i];
+            Save(headerPatches[i], texture.HeaderOffset, HeaderBytes);
+            Save(texelPatches[i], texture.DataOffset, StubBytes(texture));
+
+            // GX RGBA8 tiles keep AR pairs in the first half and GB pairs in the second
+            for(size_t level = 0; level < texture.MipCount; level++){
+                uint8_t* tile = data + texture.DataOffset + level * StubLevelBytes;
+                for(size_t texel = 0; texel < 16; texel++){
+                    tile[texel * 2] = 0xFF;
+                    tile[texel * 2 + 1] = TagMagic;
+                    tile[32 + texel * 2] = (uint8_t)(i >> 8);
+                    tile[32 + texel * 2 + 1] = (uint8_t)i;
+                }
+            }
+
+            // the data offset stays, the stand-in sits where the texels start
+            uint8_t* header = data + texture.HeaderOffset;
+            header[0x00] = (uint8_t)TextureDecode::Format::RGBA8;
+            PutU16(header + 0x02, StubSize);
+            PutU16(header + 0x04, StubSize);
+            header[0x08] = 0; // palettes off
+            PutU16(header + 0x0A, 0);
+        }
+
+        return true;
+    }
+
+    static void RestoreAll(){
+        for(Patch& patch : headerPatches) Restore(patch);
+        for(Patch& patch : texelPatches) Restore(patch);
+        headerPatches.clear();
+        texelPatches.clear();
+        patchData = nullptr;
+    }
+
+    // TEX1 index of the stand-in these pixels are, -1 if they aren't one.
+    static int ReadTag(GLsizei width, GLsizei height, GLenum format, GLenum type, const void* pixels){
+        if(pixels == nullptr || width != StubSize || height != StubSize || format != GL_RGBA || type != GL_UNSIGNED_BYTE) return -1;
+
+        const uint8_t* texels = (const uint8_t*)pixels;
+        for(size_t texel = 1; texel < 16; texel++){
+            if(std::memcmp(texels, texels + texel * 4, 4) != 0) return -1;
+        }
+        if(texels[0] != TagMagic || texels[3] != 0xFF) return -1;
+
+        size_t index = ((size_t)texels[1] << 8) | texels[2];
+        return index < stubbed.size() && stubbed[index] ? (int)index : -1;
+    }
+
+    static GLsizei FullChainLevels(uint32_t width, uint32_t height){
+        GLsizei levels = 1;
+        for(uint32_t extent = std::max(width, height); extent > 1; extent >>= 1) levels++;
+        return levels;
+    }
+
+    // Uploads every level of a TEX1 entry in place of its stand-in, BC1 for CMPR when passthrough is on.
+    // requestedLevels is what J3DUltra allocated the stand-in with, more than one means it will generate mips.
+    static bool UploadReplacement(GLuint name, int index, UploadPath path, GLenum target, GLsizei requestedLevels){
+        const J3DFile::TextureHeader& texture = captureTextures[index];
+        bool bc1 = passthrough && texture.Format == (uint8_t)TextureDecode::Format::CMPR;
+
+        // J3DUltra has read the stand-in by the time it uploads it, the texels can go back for decoding
+        Restore(texelPatches[index]);
+
+        double convertStart = NowMs();
+        std::vector<std::vector<uint8_t>> levels(texture.MipCount);
+        for(uint32_t level = 0; level < texture.MipCount; level++){
+            bool converted = bc1 ? TextureDecode::ConvertCmprToBc1(captureData, captureSize, texture, level, levels[level])
+                                 : TextureDecode::DecodeLevelCached(captureData, captureSize, texture, level, levels[level]);
+            if(!converted) return false;
+        }
+        double uploadStart = NowMs();
+        captureStats->ConvertMs += uploadStart - convertStart;
+
+        // the file's own mips, or room for the ones J3DUltra generates when the file has none
+        GLsizei fileLevels = (GLsizei)texture.MipCount;
+        GLsizei storageLevels = !bc1 && fileLevels == 1 && requestedLevels > 1 ? FullChainLevels(texture.Width, texture.Height) : fileLevels;
+        GLenum internalFormat = bc1 ? Bc1Format : GL_RGBA8;
+        if(path == UploadPath::NamedStorage) realTextureStorage2D(name, storageLevels, internalFormat, texture.Width, texture.Height);
+        else if(path == UploadPath::Storage) realTexStorage2D(target, storageLevels, internalFormat, texture.Width, texture.Height);
+
+        for(uint32_t level = 0; level < texture.MipCount; level++){
+            GLsizei width = (GLsizei)TextureDecode::GetLevelWidth(texture, level), height = (GLsizei)TextureDecode::GetLevelHeight(texture, level);
+            GLsizei size = (GLsizei)levels[level].size();
+            const uint8_t* pixels = levels[level].data();
+
+            if(bc1){
+                switch(path){
+                    case UploadPath::Image: glCompressedTexImage2D(target, level, Bc1Format, width, height, 0, size, pixels); break;
+                    case UploadPath::Storage: glCompressedTexSubImage2D(target, level, 0, 0, width, height, Bc1Format, size, pixels); break;
+                    case UploadPath::NamedStorage: glCompressedTextureSubImage2D(name, level, 0, 0, width, height, Bc1Format, size, pixels); break;
+                }
+                captureStats->CompressedBytes += size;
+                captureStats->SavedBytes += (uint64_t)width * height * 4 - size;
+            }
+            else {
+                switch(path){
+                    case UploadPath::Image: realTexImage2D(target, level, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels); break;
+                    case UploadPath::Storage: realTexSubImage2D(target, level, 0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels); break;
+                    case UploadPath::NamedStorage: realTextureSubImage2D(name, level, 0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels); break;
+                }
+                captureStats->DecodedBytes += size;
+            }
+        }
+
+        // BC1 can't have mips generated, and the ones J3DUltra would generate are already in the file
+        bool complete = bc1 || fileLevels > 1;
+        if(complete && path == UploadPath::Image) glTexParameteri(target, GL_TEXTURE_MAX_LEVEL, fileLevels - 1);
+
+        captureStats->UploadMs += NowMs() - uploadStart;
+        if(bc1) captureStats->Passthrough++;
+        else captureStats->Decoded++;
+        replacedTextures[name] = complete;
+        replaced[index] = 1;
+        return true;
+    }
+
+    // Allocates storage that was held back as J3DUltra asked for it, for stand-in sized textures that turned out not to be one.
+    static void FlushPending(GLuint name){
+        auto it = pendingStorage.find(name);
+        if(it == pendingStorage.end()) return;
+
+        PendingStorage storage = it->second;
+        pendingStorage.erase(it);
+        if(storage.Named){
+            realTextureStorage2D(name, storage.Levels, storage.InternalFormat, StubSize, StubSize);
+            return;
+        }
+
+        GLuint bound = BoundTexture();
+        if(bound != name) glBindTexture(GL_TEXTURE_2D, name);
+        realTexStorage2D(storage.Target, storage.Levels, storage.InternalFormat, StubSize, StubSize);
+        if(bound != name) glBindTexture(GL_TEXTURE_2D, bound);
+    }
+
+    static bool IsReplaced(GLuint name){
+        return replacedTextures.count(name) != 0;
+    }
+
+    static bool HasAllLevels(GLuint name){
+        auto it = replacedTextures.find(name);
+        return it != replacedTextures.end() && it->second;
+    }
+
+    static void APIENTRY CaptureTexImage2D(GLenum target, GLint level, GLint internalFormat, GLsizei width, GLsizei height, GLint border, GLenum format, GLenum type, const void* pixels){
+        GLuint name = target == GL_TEXTURE_2D ? BoundTexture() : 0;
+        if(name != 0){
+            // J3DUltra's other stand-in levels
+            if(IsReplaced(name)) return;
+
+            int index = level == 0 ? ReadTag(width, height, format, type, pixels) : -1;
+            if(index >= 0 && UploadReplacement(name, index, UploadPath::Image, target, 1)) return;
+        }
+
+        CountDecoded(width, height, format, type, pixels);
+        double start = NowMs();
+        realTexImage2D(target, level, internalFormat, width, height, border, format, type, pixels);
+        captureStats->UploadMs += NowMs() - start;
+    }
+
+    static void APIENTRY CaptureTexStorage2D(GLenum target, GLsizei levels, GLenum internalFormat, GLsizei width, GLsizei height){
+        GLuint name = target == GL_TEXTURE_2D ? BoundTexture() : 0;
+        if(name != 0 && !stubbed.empty() && width == StubSize && height == StubSize){
+            pendingStorage[name] = { target, levels, internalFormat, false };
+            return;
+        }
+
+        double start = NowMs();
+        realTexStorage2D(target, levels, internalFormat, width, height);
+        captureStats->UploadMs += NowMs() - start;
+    }
+
+    static void APIENTRY CaptureTexSubImage2D(GLenum target, GLint level, GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type, const void* pixels){
+        GLuint name = target == GL_TEXTURE_2D ? BoundTexture() : 0;
+        if(name != 0){
+            if(IsReplaced(name)) return;
+
+            auto pending = pendingStorage.find(name);
+            if(pending != pendingStorage.end()){
+                int index = level == 0 && x == 0 && y == 0 ? ReadTag(width, height, format, type, pixels) : -1;
+                if(index >= 0){
+                    PendingStorage storage = pending->second;
+                    pendingStorage.erase(pending);
+                    if(UploadReplacement(name, index, UploadPath::Storage, target, storage.Levels)) return;
+                    pendingStorage[name] = storage;
+                }
+                FlushPending(name);
+            }
+        }
+
+        CountDecoded(width, height, format, type, pixels);
+        double start = NowMs();
+        realTexSubImage2D(target, level, x, y, width, height, format, type, pixels);
+        captureStats->UploadMs += NowMs() - start;
+    }
+
+    static void APIENTRY CaptureGenerateMipmap(GLenum target){
+        if(target == GL_TEXTURE_2D){
+            GLuint name = BoundTexture();
+            if(HasAllLevels(name)) return;
+            FlushPending(name);
+        }
+        realGenerateMipmap(target);
+    }
+
+    static void APIENTRY CaptureTextureStorage2D(GLuint texture, GLsizei levels, GLenum internalFormat, GLsizei width, GLsizei height){
+        if(!stubbed.empty() && width == StubSize && height == StubSize){
+            pendingStorage[texture] = { GL_TEXTURE_2D, levels, internalFormat, true };
+            return;
+        }
+
+        double start = NowMs();
+        realTextureStorage2D(texture, levels, internalFormat, width, height);
+        captureStats->UploadMs += NowMs() - start;
+    }
+
+    static void APIENTRY CaptureTextureSubImage2D(GLuint texture, GLint level, GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type, const void* pixels){
+        if(IsReplaced(texture)) return;
+
+        auto pending = pendingStorage.find(texture);
+        if(pending != pendingStorage.end()){
+            int index = level == 0 && x == 0 && y == 0 ? ReadTag(width, height, format, type, pixels) : -1;
+            if(index >= 0){
+                PendingStorage storage = pending->second;
+                pendingStorage.erase(pending);
+                if(UploadReplacement(texture, index, UploadPath::NamedStorage, GL_TEXTURE_2D, storage.Levels)) return;
+                pendingStorage[texture] = storage;
+            }
+            FlushPending(texture);
+        }
+
+        CountDecoded(width, height, format, type, pixels);
+        double start = NowMs();
+        realTextureSubImage2D(texture, level, x, y, width, height, format, type, pixels);
+        captureStats->UploadMs += NowMs() - start;
+    }
+
+    static void APIENTRY CaptureGenerateTextureMipmap(GLuint texture){
+        if(HasAllLevels(texture)) return;
+        FlushPending(texture);
+        realGenerateTextureMipmap(texture);
+    }
+
+    template<typename Fn>
+    static void Wrap(Fn& entry, Fn& real, Fn wrapper){
+        if(entry == nullptr || real != nullptr) return;
+        real = entry;
+        entry = wrapper;
+    }
+
+    template<typename Fn>
+    static void Unwrap(Fn& entry, Fn& real){
+        if(real == nullptr) return;
+        entry = real;
+        real = nullptr;
+    }
+
+    static void InstallHooks(){
+        Wrap(glad_glTexImage2D, realTexImage2D, CaptureTexImage2D);
+        Wrap(glad_glTexStorage2D, realTexStorage2D, CaptureTexStorage2D);
+        Wrap(glad_glTexSubImage2D, realTexSubImage2D, CaptureTexSubImage2D);
+        Wrap(glad_glGenerateMipmap, realGenerateMipmap, CaptureGenerateMipmap);
+        Wrap(glad_glTextureStorage2D, realTextureStorage2D, CaptureTextureStorage2D);
+        Wrap(glad_glTextureSubImage2D, realTextureSubImage2D, CaptureTextureSubImage2D);
+        Wrap(glad_glGenerateTextureMipmap, realGenerateTextureMipmap, CaptureGenerateTextureMipmap);
+    }
+
+    static void RemoveHooks(){
+        Unwrap(glad_glTexImage2D, realTexImage2D);
+        Unwrap(glad_glTexStorage2D, realTexStorage2D);
+        Unwrap(glad_glTexSubImage2D, realTexSubImage2D);
+        Unwrap(glad_glGenerateMipmap, realGenerateMipmap);
+        Unwrap(glad_glTextureStorage2D, realTextureStorage2D);
+        Unwrap(glad_glTextureSubImage2D, realTextureSubImage2D);
+        Unwrap(glad_glGenerateTextureMipmap, realGenerateTextureMipmap);
+    }
+
+    void SetCompressedUpload(bool enabled){
+        compressedUpload = enabled;
+    }
+
+    bool IsCompressedUpload(){
+        return compressedUpload;
+    }
+
+    bool IsCompressedUploadSupported(){
+        if(glad_glGetStringi == nullptr) return false;
+
+        GLint count = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+        for(GLint i = 0; i < count; i++){
+            const char* extension = (const char*)glGetStringi(GL_EXTENSIONS, i);
+            if(extension != nullptr && std::strcmp(extension, "GL_EXT_texture_compression_s3tc") == 0) return true;
+        }
+        return false;
+    }
+
+    ScopedCapture::ScopedCapture(const uint8_t* data, size_t size, uint8_t* patchable, TextureStats& stats) : mStats(stats), mStartMs(NowMs()) {
+        mStats = TextureStats();
+        if(capturing) return;
+
+        captureTextures.clear();
+        J3DFile::ReadTextures(data, size, captureTextures);
+        mStats.Textures = (uint32_t)captureTextures.size();
+
+        // no context, nothing will be uploaded
+        if(glad_glTexImage2D == nullptr) return;
+
+        bool hasCmpr = std::any_of(captureTextures.begin(), captureTextures.end(), [](const J3DFile::TextureHeader& texture){
+            return texture.Format == (uint8_t)TextureDecode::Format::CMPR;
+        });
+
+        capturing = true;
+        passthrough = compressedUpload && hasCmpr && IsCompressedUploadSupported();
+        captureStats = &mStats;
+        captureData = data;
+        captureSize = size;
+        if(patchable != nullptr) StubTextures(patchable, size);
+        InstallHooks();
+    }
+
+    ScopedCapture::~ScopedCapture(){
+        bool complete = AllReplaced();
+        if(captureStats == &mStats){
+            // stand-in sized textures that were never filled still get the storage J3DUltra asked for
+            std::vector<GLuint> pending;
+            for(const auto& entry : pendingStorage) pending.push_back(entry.first);
+            for(GLuint name : pending) FlushPending(name);
+
+            RemoveHooks();
+            RestoreAll();
+            capturing = false;
+            passthrough = false;
+            captureStats = nullptr;
+            captureData = nullptr;
+            captureSize = 0;
+            stubbed.clear();
+            replaced.clear();
+            replacedTextures.clear();
+        }
+
+        // a load that has to be redone is counted by the capture around the retry
+        mStats.LoadMs = NowMs() - mStartMs;
+        if(complete) totals += mStats;
+    }
+
+    bool ScopedCapture::AllReplaced() const {
+        if(captureStats != &mStats) return true;
+        for(size_t i = 0; i < stubbed.size(); i++){
+            if(stubbed[i] && !replaced[i]) return false;
+        }
+        return true;
+    }
+
+    const TextureStats& GetTotals(){
+        return totals;
+    }
+
+    void ResetTotals(){
+        totals = TextureStats();
+    }
+}
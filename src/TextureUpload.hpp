@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace PyJ3D::TextureUpload {
+    // Texture work done while one model file was loaded.
+    struct TextureStats {
+        uint32_t Textures = 0; // TEX1 entries in the file
+        uint32_t Decoded = 0; // textures decoded by TextureDecode instead of J3DUltra
+        uint32_t Passthrough = 0; // CMPR textures uploaded as BC1
+        uint64_t DecodedBytes = 0; // uncompressed texel bytes handed to GL
+        uint64_t CompressedBytes = 0; // BC1 bytes uploaded in their place
+        uint64_t SavedBytes = 0; // texture memory the passthrough avoided
+        double LoadMs = 0.0; // the whole model load
+        double UploadMs = 0.0; // inside GL texture upload calls
+        double ConvertMs = 0.0; // decoding and CMPR to BC1 reordering
+
+        TextureStats& operator+=(const TextureStats& other);
+    };
+
+    // Uploads CMPR textures as BC1 instead of the RGBA8 J3DUltra decodes them to, when the context has S3TC. On by default.
+    void SetCompressedUpload(bool enabled);
+    bool IsCompressedUpload();
+
+    // Whether the current context can take BC1 textures.
+    bool IsCompressedUploadSupported();
+
+    // Decodes the textures of one model file with TextureDecode instead of leaving it to J3DUltra, data must outlive the capture.
+    // When the file is patchable every TEX1 entry it can decode is pointed at a small tagged stand-in written over the start
+    // of the entry's own texels, so J3DUltra parses the same buffer and no copy of the file is made. J3DUltra's upload of a
+    // stand-in says which entry the GL texture is for, and the real levels are uploaded in its place. The overwritten bytes
+    // are put back as each entry is uploaded and when the capture ends, nobody else may read data meanwhile.
+    // Without a patchable buffer J3DUltra decodes everything itself. The GL upload entry points are only wrapped for the
+    // lifetime of the capture.
+    class ScopedCapture {
+        TextureStats& mStats;
+        double mStartMs;
+
+    public:
+        // patchable is data itself when it may be written to, a copy-on-write mapping is enough. Null leaves data alone.
+        ScopedCapture(const uint8_t* data, size_t size, uint8_t* patchable, TextureStats& stats);
+        ~ScopedCapture();
+
+        // False when a stand-in reached GL without being replaced, J3DUltra uploaded it some way the wrappers don't
+        // recognise or not at all. Its texture would show the tag, so the model has to be loaded again unpatched.
+        bool AllReplaced() const;
+    };
+
+    // Sum over every model loaded since the last reset.
+    const TextureStats& GetTotals();
+    void ResetTotals();
+}
@@ -0,0 +1,148 @@
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace PyJ3D::Jobs {
+    class WorkerPool {
+        std::vector<std::thread> mWorkers;
+        std::deque<std::function<void()>> mQueue;
+        std::mutex mMutex;
+        std::condition_variable mWake;
+        std::condition_variable mIdle;
+        size_t mRunning = 0;
+        bool mStopping = false;
+
+        void WorkerMain(){
+            while(true){
+                std::function<void()> job;
+                {
+                    std::unique_lock<std::mutex> lock(mMutex);
+                    mWake.wait(lock, [this](){ return mStopping || !mQueue.empty(); });
+
+                    if(mStopping && mQueue.empty()) return;
+
+                    job = std::move(mQueue.front());
+                    mQueue.pop_front();
+                    mRunning++;
+                }
+                job();
+                job = nullptr;
+
+                std::lock_guard<std::mutex> lock(mMutex);
+                if(--mRunning == 0 && mQueue.empty()) mIdle.notify_all();
+            }
+        }
+
+    public:
+        WorkerPool(){
+            size_t count = std::max(1u, std::thread::hardware_concurrency()) - 1;
+            count = std::max<size_t>(count, 1);
+
+            for(size_t i = 0; i < count; i++){
+                mWorkers.emplace_back(&WorkerPool::WorkerMain, this);
+            }
+        }
+
+        ~WorkerPool(){
+            {
+                std::lock_guard<std::mutex> lock(mMutex);
+                mStopping = true;
+            }
+            mWake.notify_all();
+
+            for(std::thread& worker : mWorkers){
+                worker.join();
+            }
+        }
+
+        void Push(std::function<void()> job){
+            {
+                std::lock_guard<std::mutex> lock(mMutex);
+                mQueue.push_back(std::move(job));
+            }
+            mWake.notify_one();
+        }
+
+        void WaitIdle(){
+            std::unique_lock<std::mutex> lock(mMutex);
+            mIdle.wait(lock, [this](){ return mRunning == 0 && mQueue.empty(); });
+        }
+
+        size_t Size() const { return mWorkers.size(); }
+    };
+
+    static WorkerPool& GetPool(){
+        static WorkerPool pool;
+        return pool;
+    }
+
+    void Submit(std::function<void()> job){
+        GetPool().Push(std::move(job));
+    }
+
+    size_t GetWorkerCount(){
+        return GetPool().Size();
+    }
+
+    void WaitIdle(){
+        GetPool().WaitIdle();
+    }
+
+    struct ParallelRange {
+        const std::function<void(size_t, size_t)>* Fn;
+        size_t Count;
+        size_t ChunkSize;
+        size_t ChunkCount;
+        std::atomic<size_t> NextChunk { 0 };
+        std::atomic<size_t> DoneChunks { 0 };
+        std::mutex DoneMutex;
+        std::condition_variable DoneWake;
+
+        // Claim chunks until none are left. Late starters find nothing to do and return straight away.
+        void Drain(){
+            size_t chunk;
+            while((chunk = NextChunk.fetch_add(1)) < ChunkCount){
+                size_t begin = chunk * ChunkSize;
+                (*Fn)(begin, std::min(begin + ChunkSize, Count));
+
+                if(DoneChunks.fetch_add(1) + 1 == ChunkCount){
+                    std::lock_guard<std::mutex> lock(DoneMutex);
+                    DoneWake.notify_all();
+                }
+            }
+        }
+    };
+
+    void ParallelFor(size_t count, size_t minChunk, const std::function<void(size_t, size_t)>& fn){
+        if(count == 0) return;
+
+        size_t threads = GetWorkerCount() + 1;
+        if(count <= minChunk || threads == 1){
+            fn(0, count);
+            return;
+        }
+
+        std::shared_ptr<ParallelRange> range = std::make_shared<ParallelRange>();
+        range->Fn = &fn;
+        range->Count = count;
+        range->ChunkSize = std::max(minChunk, (count + threads * 4 - 1) / (threads * 4));
+        range->ChunkCount = (count + range->ChunkSize - 1) / range->ChunkSize;
+
+        size_t helpers = std::min(threads - 1, range->ChunkCount - 1);
+        for(size_t i = 0; i < helpers; i++){
+            Submit([range](){ range->Drain(); });
+        }
+
+        range->Drain();
+
+        std::unique_lock<std::mutex> lock(range->DoneMutex);
+        range->DoneWake.wait(lock, [&range](){ return range->DoneChunks.load() == range->ChunkCount; });
+    }
+}
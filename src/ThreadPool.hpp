@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+
+namespace PyJ3D::Jobs {
+    // Queue a job on the shared worker pool. Jobs must not touch Python objects or the GL context.
+    void Submit(std::function<void()> job);
+
+    size_t GetWorkerCount();
+
+    // Block until every submitted job has finished, used on cleanup so no load outlives the module's state.
+    void WaitIdle();
+
+    // Split [0, count) into chunks of at least minChunk and run fn(begin, end) across the pool and the
+    // calling thread, returning once every chunk is done. Small ranges run inline.
+    void ParallelFor(size_t count, size_t minChunk, const std::function<void(size_t, size_t)>& fn);
+}
@@ -0,0 +1,85 @@
+#include "Transforms.hpp"
+#include "ThreadPool.hpp"
+#include "InstanceRegistry.hpp"
+
+#include <cmath>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <glm/gtx/matrix_decompose.hpp>
+
+#include <J3D/Data/J3DModelInstance.hpp>
+
+namespace PyJ3D::Transforms {
+    // below this many instances the pool hand-off costs more than the work
+    static const size_t MinParallelBatch = 256;
+
+    glm::vec3 ToEulerDegrees(const glm::quat& rotation){
+        // glm matrices are column major, m[col][row]
+        glm::mat3 m = glm::mat3_cast(rotation);
+
+        float sy = glm::clamp(-m[0][2], -1.0f, 1.0f);
+        float y = std::asin(sy), x, z;
+        if(std::abs(sy) < 0.99999f){
+            x = std::atan2(m[1][2], m[2][2]);
+            z = std::atan2(m[0][1], m[0][0]);
+        }
+        else {
+            // gimbal lock, x and z turn about the same axis so put it all on x
+            x = std::atan2(-m[2][1], m[1][1]);
+            z = 0.0f;
+        }
+
+        return glm::degrees(glm::vec3(x, y, z));
+    }
+
+    void ApplyVectors(J3DModelInstance* const* instances, Instances::InstanceRecord* const* records, const float* values, size_t count, Component component){
+        Jobs::ParallelFor(count, MinParallelBatch, [&](size_t begin, size_t end){
+            for(size_t i = begin; i < end; i++){
+                if(instances[i] == nullptr) continue;
+
+                glm::vec3 value(values[i * 3 + 0], values[i * 3 + 1], values[i * 3 + 2]);
+                switch(component){
+                    case Component::Translation:
+                        instances[i]->SetTranslation(value);
+                        if(records[i] != nullptr) records[i]->Translation = value;
+                        break;
+                    case Component::Rotation:
+                        instances[i]->SetRotation(value);
+                        if(records[i] != nullptr) records[i]->Rotation = value;
+                        break;
+                    case Component::Scale:
+                        instances[i]->SetScale(value);
+                        if(records[i] != nullptr) records[i]->Scale = value;
+                        break;
+                }
+            }
+        });
+    }
+
+    void ApplyMatrices(J3DModelInstance* const* instances, Instances::InstanceRecord* const* records, const float* matrices, size_t count){
+        Jobs::ParallelFor(count, MinParallelBatch, [&](size_t begin, size_t end){
+            for(size_t i = begin; i < end; i++){
+                if(instances[i] == nullptr) continue;
+
+                glm::mat4 transform = glm::make_mat4(matrices + i * 16);
+                glm::vec3 translation, scale, skew;
+                glm::quat orientation;
+                glm::vec4 perspective;
+
+                if(!glm::decompose(transform, scale, orientation, translation, skew, perspective)) continue;
+
+                instances[i]->SetTranslation(translation);
+                glm::vec3 rotation = ToEulerDegrees(orientation);
+                instances[i]->SetRotation(rotation);
+                instances[i]->SetScale(scale);
+
+                if(records[i] != nullptr){
+                    records[i]->Translation = translation;
+                    records[i]->Rotation = rotation;
+                    records[i]->Scale = scale;
+                }
+            }
+        });
+    }
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+class J3DModelInstance;
+
+namespace PyJ3D::Instances { struct InstanceRecord; }
+
+namespace PyJ3D::Transforms {
+    enum class Component : uint8_t {
+        Translation,
+        Rotation,
+        Scale
+    };
+
+    // Euler degrees for R = Rz * Ry * Rx, the order J3D composes SRT rotations in and SetRotation expects.
+    // glm::eulerAngles returns the same angles away from gimbal lock but picks a different pair at it.
+    glm::vec3 ToEulerDegrees(const glm::quat& rotation);
+
+    // values holds count packed xyz triples. Large batches are split across the worker pool, so every
+    // non-null instance must appear only once or rows would race on it.
+    // records runs parallel to instances (entries may be null) and receives the tracked transform,
+    // call with the context lock held since renders read the registry too.
+    void ApplyVectors(J3DModelInstance* const* instances, Instances::InstanceRecord* const* records, const float* values, size_t count, Component component);
+
+    // matrices holds count column-major 4x4 matrices, decomposed into translation, euler rotation in degrees and scale.
+    void ApplyMatrices(J3DModelInstance* const* instances, Instances::InstanceRecord* const* records, const float* matrices, size_t count);
+}
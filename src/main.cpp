@@ -1,6 +1,12 @@
+#include <cmath>
+#include <cstring>
 #include <filesystem>
+#include <functional>
+#include <optional>
+#include <unordered_map>
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
+#include <pybind11/numpy.h>
 
 #include <J3D/J3DModelLoader.hpp>
 #include <J3D/Data/J3DModelData.hpp>
@@ -22,91 +28,156 @@
 #include <glad/glad.h>
 #include <glm/gtc/type_ptr.hpp>
 
+#include "ModelCache.hpp"
+#include "AsyncLoader.hpp"
+#include "RenderSort.hpp"
+#include "Scene.hpp"
+#include "Transforms.hpp"
+#include "BufferUtil.hpp"
+#include "InstanceRegistry.hpp"
+#include "Culling.hpp"
+#include "AnimationLod.hpp"
+#include "FrameClock.hpp"
+#include "PickQueue.hpp"
+#include "Collision.hpp"
+#include "Headless.hpp"
+#include "DiskCache.hpp"
+#include "ShaderCache.hpp"
+#include "JointAnimation.hpp"
+#include "ThreadPool.hpp"
+#include "Profiler.hpp"
+#include "Simd.hpp"
+#include "J3DFile.hpp"
+#include "TextureDecode.hpp"
+#include "TextureUpload.hpp"
+#include "Renderer.hpp"
+#include "GlRedirect.hpp"
+
 namespace py = pybind11;
 using namespace py::literals;
 
 static bool init = false;
-static std::vector<std::shared_ptr<J3DModelInstance>> renderBatch = {};
-static glm::mat4 viewMtx = {}, projMtx = {};
-
-void DefaultSortFunc(J3D::Rendering::RenderPacketVector& packets) {
-	std::vector<J3DRenderPacket> opaquePackets;
-	std::vector<J3DRenderPacket> xluPackets;
-
-	for (J3DRenderPacket packet : packets) {
-		if ((packet.SortKey & 0x00800000) != 0) {
-			opaquePackets.push_back(packet);
-		}
-		else {
-			xluPackets.push_back(packet);
-		}
-	}
-
-	std::sort(
-		opaquePackets.begin(),
-		opaquePackets.end(),
-		[](const J3DRenderPacket& a, const J3DRenderPacket& b) -> bool {
-			return a.Material->Name < b.Material->Name;
-		}
-	);
-	std::sort(
-		xluPackets.begin(),
-		xluPackets.end(),
-		[](const J3DRenderPacket& a, const J3DRenderPacket& b) -> bool {
-			return a.Material->Name < b.Material->Name;
-		}
-	);
-
-	packets.clear();
-
-	for (J3DRenderPacket packet : opaquePackets) {
-		packets.push_back(packet);
-	}
-	for (J3DRenderPacket packet : xluPackets) {
-		packets.push_back(packet);
-	}
+// renderModel, setCamera and render draw through the default renderer, module level renderViews through its own
+// so the pending batch survives it. The default renderer draws through J3DUltra's UBO and picking framebuffer,
+// which initPicking and queryPicking work on.
+static std::shared_ptr<PyJ3D::Renderer> defaultRenderer = std::make_shared<PyJ3D::Renderer>(false);
+static PyJ3D::Renderer viewsRenderer = {};
+
+// Call guards for bindings that touch the instance, animation and renderer state renders read, and those that
+// also touch GL. Both lock with the GIL held, render bindings instead release the GIL and lock inside the render.
+using RegistryGuard = py::call_guard<PyJ3D::RegistryLock>;
+using GlGuard = py::call_guard<PyJ3D::RegistryLock, PyJ3D::ContextLock>;
+
+// init, cleanup, releaseContext and acquireContext manage the context themselves, so they only wait for it.
+struct SetupLock {
+    PyJ3D::RegistryLock Registry;
+    PyJ3D::ContextLock Context{ false };
+};
+using SetupGuard = py::call_guard<SetupLock>;
+
+// Shared setup once GL functions are loaded, by either init path.
+static bool FinishInit(){
+    init = true;
+
+    J3DUniformBufferObject::CreateUBO();
+    PyJ3D::GlRedirect::Install();
+    PyJ3D::ShaderCache::Install();
+
+    //set default sort
+    PyJ3D::RenderSort::SetSortMode(PyJ3D::RenderSort::SortMode::Keyed);
+    defaultRenderer->SetPicking(true);
+
+    return true;
 }
 
 bool InitJ3DUltra(){
     if(!init){
         if(gladLoadGL()){
-            init = true;
- 
-            J3DUniformBufferObject::CreateUBO();
- 
-            //set default sort
-            J3D::Rendering::SetSortFunction(DefaultSortFunc);
-
-            return true;
+            return FinishInit();
         }
     }
 
     return false;
 }
 
+// Creates its own surfaceless context instead of using the caller's, for batch rendering without a window.
+bool InitJ3DUltraHeadless(){
+    if(init) return false;
+
+    std::string error;
+    if(!PyJ3D::Headless::CreateContext(error)) throw std::runtime_error(error);
+
+    if(!gladLoadGLLoader((GLADloadproc)PyJ3D::Headless::GetProcAddress)){
+        PyJ3D::Headless::DestroyContext();
+        throw std::runtime_error("Couldn't load OpenGL functions for the headless context");
+    }
+
+    return FinishInit();
+}
+
 void SetCamera(std::vector<float> proj, std::vector<float> view){
+    if(proj.size() != 16 || view.size() != 16) throw py::value_error("expected 16 floats per matrix");
+
     if(init){
         glm::mat4 projection, viewm4;
 
         projection = glm::make_mat4(proj.data());
         viewm4 = glm::make_mat4(view.data());
 
-        viewMtx = viewm4;
-        projMtx = projection;
+        defaultRenderer->SetCamera(projection, viewm4);
 
         J3DUniformBufferObject::SetProjAndViewMatrices(projection, viewm4);
     }
 }
 
+// Reads straight out of numpy arrays/memoryviews, no lists or vectors in between. Both are read before either is
+// applied so a bad view doesn't leave the camera half updated.
+void SetCamera(py::buffer proj, py::buffer view){
+    if(init){
+        glm::mat4 projection, viewm4;
+        PyJ3D::Buffers::ReadFloats(proj, glm::value_ptr(projection), 16);
+        PyJ3D::Buffers::ReadFloats(view, glm::value_ptr(viewm4), 16);
+
+        defaultRenderer->SetCamera(projection, viewm4);
+        J3DUniformBufferObject::SetProjAndViewMatrices(defaultRenderer->GetProj(), defaultRenderer->GetView());
+    }
+}
+
+// Read-only (4, 4) view of a camera matrix in the same layout setCamera takes.
+py::array GetMatrixView(glm::mat4& matrix){
+    py::array_t<float> view({ 4, 4 }, { (py::ssize_t)(4 * sizeof(float)), (py::ssize_t)sizeof(float) }, glm::value_ptr(matrix), py::capsule(&matrix, [](void*){}));
+    view.attr("setflags")("write"_a=false);
+    return view;
+}
+
 void CleanupJ3DUltra(){
     if(init){
+        // take the headless context back if it was released to other threads' renderers
+        if(PyJ3D::Headless::HasContext()) PyJ3D::Headless::MakeCurrent();
         J3DUniformBufferObject::DestroyUBO();
-        renderBatch.clear();
+        defaultRenderer->Destroy();
+        viewsRenderer.Destroy();
+        PyJ3D::DestroyRenderers();
+        // finish the loads still on the workers so nothing they hold outlives the state cleared below
+        PyJ3D::Jobs::WaitIdle();
+        PyJ3D::AsyncLoader::CancelStaged();
+        PyJ3D::Buffers::ReleasePending();
+        PyJ3D::ModelCache::Clear();
+        PyJ3D::JointAnimation::ClearCache();
+        PyJ3D::AnimationLod::Clear();
+        PyJ3D::RenderSort::ResetMaterialIds();
+        PyJ3D::Instances::Clear();
+        PyJ3D::PickQueue::Clear();
+        PyJ3D::Profiler::Shutdown();
+        PyJ3D::ShaderCache::Uninstall();
+        PyJ3D::GlRedirect::Uninstall();
         if(J3D::Picking::IsPickingEnabled()) J3D::Picking::DestroyFramebuffer();
+        PyJ3D::Headless::DestroyContext();
+        init = false;
     }
 }
 
-std::shared_ptr<J3DModelInstance> LoadJ3DModel(std::string path){
+std::shared_ptr<J3DModelInstance> LoadJ3DModel(std::string path, bool cache){
     if(!init) return nullptr;
 
     if(!std::filesystem::exists(path)){
@@ -114,52 +185,274 @@ std::shared_ptr<J3DModelInstance> LoadJ3DModel(std::string path){
         return nullptr;
     }
 
-    J3DModelLoader Loader;
-    bStream::CFileStream modelStream(path, bStream::Endianess::Big, bStream::OpenMode::In);
-    
-    std::shared_ptr<J3DModelData> data = std::make_shared<J3DModelData>();
-    data = Loader.Load(&modelStream, NULL);
+    std::shared_ptr<J3DModelData> data = PyJ3D::ModelCache::LoadFromFile(path, cache);
+    if(data == nullptr) return nullptr;
 
-    return data->CreateInstance();
+    return PyJ3D::Instances::CreateInstance(data);
 }
 
-std::shared_ptr<J3DModelInstance> LoadJ3DModel(py::bytes data){
+std::shared_ptr<J3DModelInstance> LoadJ3DModel(py::buffer data, bool cache){
     if(!init) return nullptr;
 
-    py::buffer_info dataInfo(py::buffer(data).request());
+    const uint8_t* bytes;
+    size_t size;
+    PyJ3D::Buffers::GetBytes(data, bytes, size);
 
-    J3DModelLoader Loader;
-    bStream::CMemoryStream modelStream((uint8_t*)dataInfo.ptr, dataInfo.size, bStream::Endianess::Big, bStream::OpenMode::In);
-    
-    std::shared_ptr<J3DModelData> modelData = Loader.Load(&modelStream, NULL);
+    std::shared_ptr<J3DModelData> modelData = PyJ3D::ModelCache::LoadFromMemory(bytes, size, cache);
+    if(modelData == nullptr) return nullptr;
+
+    return PyJ3D::Instances::CreateInstance(modelData);
+}
+
+void SetModelCacheBudget(size_t bytes){
+    PyJ3D::ModelCache::SetBudget(bytes);
+}
+
+py::dict GetModelCacheStats(){
+    PyJ3D::ModelCache::CacheStats stats = PyJ3D::ModelCache::GetStats();
+    return py::dict("hits"_a=stats.Hits, "misses"_a=stats.Misses, "evictions"_a=stats.Evictions, "entries"_a=stats.Entries, "sourceBytes"_a=stats.SourceBytes,
+                    "budget"_a=stats.Budget, "textureBytes"_a=stats.TextureBytes);
+}
+
+void ClearModelCache(){
+    PyJ3D::ModelCache::Clear();
+}
+
+bool SetDiskCache(std::string path){
+    return PyJ3D::DiskCache::SetDirectory(path);
+}
+
+py::dict GetDiskCacheStats(){
+    PyJ3D::DiskCache::DiskCacheStats stats = PyJ3D::DiskCache::GetStats();
+    PyJ3D::ShaderCache::ShaderCacheStats shaderStats = PyJ3D::ShaderCache::GetStats();
+    return py::dict("hits"_a=stats.Hits, "misses"_a=stats.Misses, "writes"_a=stats.Writes, "rejected"_a=stats.Rejected, "bytesRead"_a=stats.BytesRead,
+                    "bytesWritten"_a=stats.BytesWritten, "programsLinked"_a=shaderStats.Linked, "programsLoaded"_a=shaderStats.LoadedBinary);
+}
+
+py::dict GetShaderCacheStats(){
+    PyJ3D::ShaderCache::ShaderCacheStats stats = PyJ3D::ShaderCache::GetStats();
+    return py::dict("programs"_a=stats.Programs, "linked"_a=stats.Linked, "loadedBinary"_a=stats.LoadedBinary, "reused"_a=stats.Reused,
+                    "compiled"_a=stats.Compiled, "compilesAvoided"_a=stats.CompilesAvoided);
+}
+
+// Parses each model once without caching it, its material program binaries stay in the shader cache.
+py::dict PrewarmShaders(const std::vector<std::string>& paths){
+    if(!init) throw std::runtime_error("J3DUltra isn't initialized");
+
+    uint32_t programsBefore = PyJ3D::ShaderCache::GetStats().Programs, loaded = 0;
+    for(const std::string& path : paths){
+        if(PyJ3D::ModelCache::LoadFromFile(path, false) != nullptr) loaded++;
+    }
+    return py::dict("models"_a=loaded, "failed"_a=paths.size() - loaded, "programsAdded"_a=PyJ3D::ShaderCache::GetStats().Programs - programsBefore);
+}
+
+std::shared_ptr<PyJ3D::AsyncLoader::LoadHandle> LoadJ3DModelAsync(std::string path, bool cache){
+    if(!init) return nullptr;
+    return PyJ3D::AsyncLoader::LoadModel(path, cache);
+}
+
+std::shared_ptr<PyJ3D::AsyncLoader::LoadHandle> LoadJ3DModelAsync(py::buffer data, bool cache){
+    if(!init) return nullptr;
+    return PyJ3D::AsyncLoader::LoadModel(PyJ3D::Buffers::ShareBytes(data), cache);
+}
 
-    return modelData->CreateInstance();
+std::shared_ptr<PyJ3D::AsyncLoader::LoadHandle> LoadAnimationAsync(std::string path){
+    return PyJ3D::AsyncLoader::LoadAnimation(path);
+}
+
+std::shared_ptr<PyJ3D::AsyncLoader::LoadHandle> LoadAnimationAsync(py::buffer data){
+    return PyJ3D::AsyncLoader::LoadAnimation(PyJ3D::Buffers::ShareBytes(data));
+}
+
+// Animations parse straight out of the caller's buffer or a mapping of the file, nothing is copied first.
+template<typename T>
+std::shared_ptr<T> LoadAnimationMemory(const uint8_t* data, size_t size){
+    J3DAnimation::J3DAnimationLoader Loader;
+    std::shared_ptr<J3DAnimation::J3DAnimationInstance> animLoaded = Loader.LoadAnimation((void*)data, size);
+    return std::dynamic_pointer_cast<T>(animLoaded);
 }
 
+template<typename T>
+std::shared_ptr<T> LoadAnimationBuffer(py::buffer data){
+    const uint8_t* bytes;
+    size_t size;
+    PyJ3D::Buffers::GetBytes(data, bytes, size);
+    return LoadAnimationMemory<T>(bytes, size);
+}
+
+template<typename T>
+std::shared_ptr<T> LoadAnimationFile(const std::string& path){
+    PyJ3D::Files::MappedFile file;
+    if(!file.Open(path)) return nullptr;
+    return LoadAnimationMemory<T>(file.GetData(), file.GetSize());
+}
+
+// Holds the context with the GIL held, the instance registry it fills is read by renders on other threads.
+uint32_t PumpUploads(float budgetMs){
+    if(!init) return 0;
+
+    PyJ3D::Buffers::ReleasePending();
+
+    PyJ3D::RegistryLock registry;
+    PyJ3D::ContextLock context;
+    return PyJ3D::AsyncLoader::PumpUploads(budgetMs);
+}
+
+// The per-instance setters also tell the scenes holding the instance, so their translucent order follows it.
 void setTranslation(std::shared_ptr<J3DModelInstance> instance, float x, float y, float z){
     instance->SetTranslation(glm::vec3(x, y, z));
+    if(PyJ3D::Instances::InstanceRecord* record = PyJ3D::Instances::Find(instance.get())) record->Translation = glm::vec3(x, y, z);
+    PyJ3D::Scene::NotifyMoved(instance.get());
 }
 
 void setRotation(std::shared_ptr<J3DModelInstance> instance, float x, float y, float z){
     instance->SetRotation(glm::vec3(x, y, z));
+    if(PyJ3D::Instances::InstanceRecord* record = PyJ3D::Instances::Find(instance.get())) record->Rotation = glm::vec3(x, y, z);
+    PyJ3D::Scene::NotifyMoved(instance.get());
 }
 
 void setScale(std::shared_ptr<J3DModelInstance> instance, float x, float y, float z){
     instance->SetScale(glm::vec3(x, y, z));
+    if(PyJ3D::Instances::InstanceRecord* record = PyJ3D::Instances::Find(instance.get())) record->Scale = glm::vec3(x, y, z);
+    PyJ3D::Scene::NotifyMoved(instance.get());
+}
+
+void setTranslation(std::shared_ptr<J3DModelInstance> instance, py::buffer value){
+    glm::vec3 translation;
+    PyJ3D::Buffers::ReadFloats(value, glm::value_ptr(translation), 3);
+    setTranslation(instance, translation.x, translation.y, translation.z);
+}
+
+void setRotation(std::shared_ptr<J3DModelInstance> instance, py::buffer value){
+    glm::vec3 rotation;
+    PyJ3D::Buffers::ReadFloats(value, glm::value_ptr(rotation), 3);
+    setRotation(instance, rotation.x, rotation.y, rotation.z);
+}
+
+void setScale(std::shared_ptr<J3DModelInstance> instance, py::buffer value){
+    glm::vec3 scale;
+    PyJ3D::Buffers::ReadFloats(value, glm::value_ptr(scale), 3);
+    setScale(instance, scale.x, scale.y, scale.z);
+}
+
+void setTransform(std::shared_ptr<J3DModelInstance> instance, py::buffer matrix){
+    glm::mat4 transform;
+    PyJ3D::Buffers::ReadFloats(matrix, glm::value_ptr(transform), 16);
+
+    J3DModelInstance* target = instance.get();
+    PyJ3D::Instances::InstanceRecord* record = PyJ3D::Instances::Find(target);
+    PyJ3D::Transforms::ApplyMatrices(&target, &record, glm::value_ptr(transform), 1);
+    PyJ3D::Scene::NotifyMoved(target);
+}
+
+J3DLight MakeLight(std::array<float, 3> position, std::array<float, 3> direction, std::array<float, 4> color, std::array<float, 3> angle_atten, std::array<float, 3> dist_atten, bool followCamera){
+    J3DLight light;
+
+    light.Position = glm::vec4(position[0], position[1], position[2], followCamera ? 0 : 1);
+    light.Direction = glm::vec4(direction[0], direction[1], direction[2], 1);
+    light.Color = glm::vec4(color[0], color[1], color[2], color[3]);
+    light.AngleAtten = glm::vec4(angle_atten[0], angle_atten[1], angle_atten[2], 1);;
+    light.DistAtten = glm::vec4(dist_atten[0], dist_atten[1], dist_atten[2], 1);;
+
+    return light;
+}
+
+using FloatArray = py::array_t<float, py::array::c_style | py::array::forcecast>;
+using SlotArray = py::array_t<uint32_t, py::array::c_style | py::array::forcecast>;
+
+// Accepts flat arrays or arrays shaped (N, ...) with width floats per row, returns N.
+size_t GetBatchRows(const FloatArray& values, size_t width){
+    size_t rowSize = 1;
+    for(py::ssize_t axis = 1; axis < values.ndim(); axis++){
+        rowSize *= (size_t)values.shape(axis);
+    }
+
+    if((size_t)values.size() % width != 0 || (values.ndim() > 1 && rowSize != width)){
+        throw py::value_error("expected an array of " + std::to_string(width) + "-float rows");
+    }
+    return (size_t)values.size() / width;
+}
+
+// Instance pointers and their registry records, resolved under the registry guard.
+// Rows for an instance that appears again later are skipped, so the last row wins like it would in a Python loop.
+struct TransformTargets {
+    std::vector<J3DModelInstance*> Instances;
+    std::vector<PyJ3D::Instances::InstanceRecord*> Records;
+    std::unordered_map<J3DModelInstance*, size_t> Rows;
+
+    void Push(J3DModelInstance* instance){
+        if(instance != nullptr){
+            auto [row, added] = Rows.try_emplace(instance, Instances.size());
+            if(!added){
+                Instances[row->second] = nullptr;
+                Records[row->second] = nullptr;
+                row->second = Instances.size();
+            }
+        }
+
+        Instances.push_back(instance);
+        Records.push_back(instance != nullptr ? PyJ3D::Instances::Find(instance) : nullptr);
+    }
+};
+
+TransformTargets GetInstanceTargets(const std::vector<std::shared_ptr<J3DModelInstance>>& instances, size_t rows){
+    if(rows != instances.size()) throw py::value_error("values must have one row per instance");
+
+    TransformTargets targets;
+    for(const std::shared_ptr<J3DModelInstance>& instance : instances){
+        targets.Push(instance.get());
+        if(instance != nullptr) PyJ3D::Scene::NotifyMoved(instance.get());
+    }
+
+    return targets;
+}
+
+// Without slots, row i goes to slot i.
+TransformTargets GetSceneTargets(PyJ3D::Scene& scene, const std::optional<SlotArray>& slots, size_t rows){
+    if(slots.has_value() && (size_t)slots->size() != rows) throw py::value_error("slots and values must have the same length");
+
+    TransformTargets targets;
+    for(size_t i = 0; i < rows; i++){
+        uint32_t slot = slots.has_value() ? slots->data()[i] : (uint32_t)i;
+        targets.Push(scene.GetInstancePtr(slot));
+        scene.MarkMoved(slot);
+    }
+
+    return targets;
+}
+
+void ApplyVectors(const TransformTargets& targets, const FloatArray& values, PyJ3D::Transforms::Component component){
+    PyJ3D::Transforms::ApplyVectors(targets.Instances.data(), targets.Records.data(), values.data(), targets.Instances.size(), component);
+}
+
+void ApplyMatrices(const TransformTargets& targets, const FloatArray& matrices){
+    PyJ3D::Transforms::ApplyMatrices(targets.Instances.data(), targets.Records.data(), matrices.data(), targets.Instances.size());
+}
+
+void SetInstanceVectors(std::vector<std::shared_ptr<J3DModelInstance>> instances, FloatArray values, PyJ3D::Transforms::Component component){
+    ApplyVectors(GetInstanceTargets(instances, GetBatchRows(values, 3)), values, component);
+}
+
+void SetInstanceTransforms(std::vector<std::shared_ptr<J3DModelInstance>> instances, FloatArray matrices){
+    ApplyMatrices(GetInstanceTargets(instances, GetBatchRows(matrices, 16)), matrices);
+}
+
+void SetSceneVectors(PyJ3D::Scene& scene, FloatArray values, std::optional<SlotArray> slots, PyJ3D::Transforms::Component component){
+    ApplyVectors(GetSceneTargets(scene, slots, GetBatchRows(values, 3)), values, component);
+}
+
+void SetSceneTransforms(PyJ3D::Scene& scene, FloatArray matrices, std::optional<SlotArray> slots){
+    ApplyMatrices(GetSceneTargets(scene, slots, GetBatchRows(matrices, 16)), matrices);
 }
 
 void renderModel(std::shared_ptr<J3DModelInstance> instance){
-    renderBatch.push_back(instance);
+    defaultRenderer->Submit(instance);
 }
 
-void attachBrk(std::shared_ptr<J3DModelInstance> instance, py::bytes data){
+void attachBrk(std::shared_ptr<J3DModelInstance> instance, py::buffer data){
     if(!init) return;
 
-    py::buffer_info dataInfo(py::buffer(data).request());
-
-    J3DAnimation::J3DAnimationLoader Loader;
-    std::shared_ptr<J3DAnimation::J3DAnimationInstance> animLoaded = Loader.LoadAnimation(dataInfo.ptr, dataInfo.size);
-    std::shared_ptr<J3DAnimation::J3DColorAnimationInstance> animInstance = std::dynamic_pointer_cast<J3DAnimation::J3DColorAnimationInstance>(animLoaded);
+    std::shared_ptr<J3DAnimation::J3DColorAnimationInstance> animInstance = LoadAnimationBuffer<J3DAnimation::J3DColorAnimationInstance>(data);
 
     instance->SetRegisterColorAnimation(animInstance);
 }
@@ -167,9 +460,7 @@ void attachBrk(std::shared_ptr<J3DModelInstance> instance, py::bytes data){
 void attachBrk(std::shared_ptr<J3DModelInstance> instance, std::string path){
     if(!init) return;
 
-    J3DAnimation::J3DAnimationLoader Loader;
-    
-    std::shared_ptr<J3DAnimation::J3DColorAnimationInstance> animInstance = Loader.LoadAnimation<J3DAnimation::J3DColorAnimationInstance>(path);
+    std::shared_ptr<J3DAnimation::J3DColorAnimationInstance> animInstance = LoadAnimationFile<J3DAnimation::J3DColorAnimationInstance>(path);
 
     instance->SetRegisterColorAnimation(animInstance);
 }
@@ -179,14 +470,10 @@ void attachBrk(std::shared_ptr<J3DModelInstance> instance, std::shared_ptr<J3DAn
     instance->SetRegisterColorAnimation(anim);
 }
 
-std::shared_ptr<J3DAnimation::J3DColorAnimationInstance> LoadBrk(py::bytes data){
+std::shared_ptr<J3DAnimation::J3DColorAnimationInstance> LoadBrk(py::buffer data){
     if(!init) return nullptr;
 
-    py::buffer_info dataInfo(py::buffer(data).request());
-
-    J3DAnimation::J3DAnimationLoader Loader;
-    std::shared_ptr<J3DAnimation::J3DAnimationInstance> animLoaded = Loader.LoadAnimation(dataInfo.ptr, dataInfo.size);
-    std::shared_ptr<J3DAnimation::J3DColorAnimationInstance> animInstance = std::dynamic_pointer_cast<J3DAnimation::J3DColorAnimationInstance>(animLoaded);
+    std::shared_ptr<J3DAnimation::J3DColorAnimationInstance> animInstance = LoadAnimationBuffer<J3DAnimation::J3DColorAnimationInstance>(data);
 
     return animInstance;
 }
@@ -194,21 +481,15 @@ std::shared_ptr<J3DAnimation::J3DColorAnimationInstance> LoadBrk(py::bytes data)
 std::shared_ptr<J3DAnimation::J3DColorAnimationInstance> LoadBrk(std::string path){
     if(!init) return nullptr;
 
-    J3DAnimation::J3DAnimationLoader Loader;
-    
-    std::shared_ptr<J3DAnimation::J3DColorAnimationInstance> animInstance = Loader.LoadAnimation<J3DAnimation::J3DColorAnimationInstance>(path);
+    std::shared_ptr<J3DAnimation::J3DColorAnimationInstance> animInstance = LoadAnimationFile<J3DAnimation::J3DColorAnimationInstance>(path);
 
     return animInstance;
 }
 
-void attachBtp(std::shared_ptr<J3DModelInstance> instance, py::bytes data){
+void attachBtp(std::shared_ptr<J3DModelInstance> instance, py::buffer data){
     if(!init) return;
 
-    py::buffer_info dataInfo(py::buffer(data).request());
-
-    J3DAnimation::J3DAnimationLoader Loader;
-    std::shared_ptr<J3DAnimation::J3DAnimationInstance> animLoaded = Loader.LoadAnimation(dataInfo.ptr, dataInfo.size);
-    std::shared_ptr<J3DAnimation::J3DTexIndexAnimationInstance> animInstance = std::dynamic_pointer_cast<J3DAnimation::J3DTexIndexAnimationInstance>(animLoaded);
+    std::shared_ptr<J3DAnimation::J3DTexIndexAnimationInstance> animInstance = LoadAnimationBuffer<J3DAnimation::J3DTexIndexAnimationInstance>(data);
 
     instance->SetTexIndexAnimation(animInstance);
 }
@@ -216,9 +497,7 @@ void attachBtp(std::shared_ptr<J3DModelInstance> instance, py::bytes data){
 void attachBtp(std::shared_ptr<J3DModelInstance> instance, std::string path){
     if(!init) return;
 
-    J3DAnimation::J3DAnimationLoader Loader;
-    
-    std::shared_ptr<J3DAnimation::J3DTexIndexAnimationInstance> animInstance = Loader.LoadAnimation<J3DAnimation::J3DTexIndexAnimationInstance>(path);
+    std::shared_ptr<J3DAnimation::J3DTexIndexAnimationInstance> animInstance = LoadAnimationFile<J3DAnimation::J3DTexIndexAnimationInstance>(path);
 
     instance->SetTexIndexAnimation(animInstance);
 }
@@ -228,14 +507,10 @@ void attachBtp(std::shared_ptr<J3DModelInstance> instance, std::shared_ptr<J3DAn
     instance->SetTexIndexAnimation(anim);
 }
 
-std::shared_ptr<J3DAnimation::J3DTexIndexAnimationInstance> LoadBtp(py::bytes data){
+std::shared_ptr<J3DAnimation::J3DTexIndexAnimationInstance> LoadBtp(py::buffer data){
     if(!init) return nullptr;
 
-    py::buffer_info dataInfo(py::buffer(data).request());
-
-    J3DAnimation::J3DAnimationLoader Loader;
-    std::shared_ptr<J3DAnimation::J3DAnimationInstance> animLoaded = Loader.LoadAnimation(dataInfo.ptr, dataInfo.size);
-    std::shared_ptr<J3DAnimation::J3DTexIndexAnimationInstance> animInstance = std::dynamic_pointer_cast<J3DAnimation::J3DTexIndexAnimationInstance>(animLoaded);
+    std::shared_ptr<J3DAnimation::J3DTexIndexAnimationInstance> animInstance = LoadAnimationBuffer<J3DAnimation::J3DTexIndexAnimationInstance>(data);
 
     return animInstance;
 }
@@ -243,21 +518,15 @@ std::shared_ptr<J3DAnimation::J3DTexIndexAnimationInstance> LoadBtp(py::bytes da
 std::shared_ptr<J3DAnimation::J3DTexIndexAnimationInstance> LoadBtp(std::string path){
     if(!init) return nullptr;
 
-    J3DAnimation::J3DAnimationLoader Loader;
-    
-    std::shared_ptr<J3DAnimation::J3DTexIndexAnimationInstance> animInstance = Loader.LoadAnimation<J3DAnimation::J3DTexIndexAnimationInstance>(path);
+    std::shared_ptr<J3DAnimation::J3DTexIndexAnimationInstance> animInstance = LoadAnimationFile<J3DAnimation::J3DTexIndexAnimationInstance>(path);
 
     return animInstance;
 }
 
-void attachBtk(std::shared_ptr<J3DModelInstance> instance, py::bytes data){
+void attachBtk(std::shared_ptr<J3DModelInstance> instance, py::buffer data){
     if(!init) return;
 
-    py::buffer_info dataInfo(py::buffer(data).request());
-
-    J3DAnimation::J3DAnimationLoader Loader;
-    std::shared_ptr<J3DAnimation::J3DAnimationInstance> animLoaded = Loader.LoadAnimation(dataInfo.ptr, dataInfo.size);
-    std::shared_ptr<J3DAnimation::J3DTexMatrixAnimationInstance> animInstance = std::dynamic_pointer_cast<J3DAnimation::J3DTexMatrixAnimationInstance>(animLoaded);
+    std::shared_ptr<J3DAnimation::J3DTexMatrixAnimationInstance> animInstance = LoadAnimationBuffer<J3DAnimation::J3DTexMatrixAnimationInstance>(data);
 
     instance->SetTexMatrixAnimation(animInstance);
 }
@@ -265,9 +534,7 @@ void attachBtk(std::shared_ptr<J3DModelInstance> instance, py::bytes data){
 void attachBtk(std::shared_ptr<J3DModelInstance> instance, std::string path){
     if(!init) return;
 
-    J3DAnimation::J3DAnimationLoader Loader;
-    
-    std::shared_ptr<J3DAnimation::J3DTexMatrixAnimationInstance> animInstance = Loader.LoadAnimation<J3DAnimation::J3DTexMatrixAnimationInstance>(path);
+    std::shared_ptr<J3DAnimation::J3DTexMatrixAnimationInstance> animInstance = LoadAnimationFile<J3DAnimation::J3DTexMatrixAnimationInstance>(path);
 
     instance->SetTexMatrixAnimation(animInstance);
 }
@@ -277,14 +544,10 @@ void attachBtk(std::shared_ptr<J3DModelInstance> instance, std::shared_ptr<J3DAn
     instance->SetTexMatrixAnimation(anim);
 }
 
-std::shared_ptr<J3DAnimation::J3DTexMatrixAnimationInstance> LoadBtk(py::bytes data){
+std::shared_ptr<J3DAnimation::J3DTexMatrixAnimationInstance> LoadBtk(py::buffer data){
     if(!init) return nullptr;
 
-    py::buffer_info dataInfo(py::buffer(data).request());
-
-    J3DAnimation::J3DAnimationLoader Loader;
-    std::shared_ptr<J3DAnimation::J3DAnimationInstance> animLoaded = Loader.LoadAnimation(dataInfo.ptr, dataInfo.size);
-    std::shared_ptr<J3DAnimation::J3DTexMatrixAnimationInstance> animInstance = std::dynamic_pointer_cast<J3DAnimation::J3DTexMatrixAnimationInstance>(animLoaded);
+    std::shared_ptr<J3DAnimation::J3DTexMatrixAnimationInstance> animInstance = LoadAnimationBuffer<J3DAnimation::J3DTexMatrixAnimationInstance>(data);
 
     return animInstance;
 }
@@ -292,75 +555,68 @@ std::shared_ptr<J3DAnimation::J3DTexMatrixAnimationInstance> LoadBtk(py::bytes d
 std::shared_ptr<J3DAnimation::J3DTexMatrixAnimationInstance> LoadBtk(std::string path){
     if(!init) return nullptr;
 
-    J3DAnimation::J3DAnimationLoader Loader;
-    
-    std::shared_ptr<J3DAnimation::J3DTexMatrixAnimationInstance> animInstance = Loader.LoadAnimation<J3DAnimation::J3DTexMatrixAnimationInstance>(path);
+    std::shared_ptr<J3DAnimation::J3DTexMatrixAnimationInstance> animInstance = LoadAnimationFile<J3DAnimation::J3DTexMatrixAnimationInstance>(path);
 
     return animInstance;
 }
 
-void attachBck(std::shared_ptr<J3DModelInstance> instance, py::bytes data){
-    if(!init) return;
-
-    py::buffer_info dataInfo(py::buffer(data).request());
+// BCK/BCA files attached by path or data play as cached joint clips, so they share keys between instances and
+// are sampled natively, getBck/getBca then read as empty for the clip's slot. A file of the other kind clears the
+// slot like the library's cast would.
+void AttachJointFile(std::shared_ptr<J3DModelInstance> instance, std::shared_ptr<PyJ3D::JointAnimation::JointClip> clip, bool full){
+    if(clip != nullptr && clip->Stepped == full){
+        PyJ3D::JointAnimation::Attach(instance.get(), clip);
+    }
+    else if(full){
+        PyJ3D::JointAnimation::SetJointFullAnimation(instance.get(), nullptr);
+    }
+    else {
+        PyJ3D::JointAnimation::SetJointAnimation(instance.get(), nullptr);
+    }
+}
 
-    J3DAnimation::J3DAnimationLoader Loader;
-    std::shared_ptr<J3DAnimation::J3DAnimationInstance> animLoaded = Loader.LoadAnimation(dataInfo.ptr, dataInfo.size);
-    std::shared_ptr<J3DAnimation::J3DJointAnimationInstance> animInstance = std::dynamic_pointer_cast<J3DAnimation::J3DJointAnimationInstance>(animLoaded);
+void attachBck(std::shared_ptr<J3DModelInstance> instance, py::buffer data){
+    if(!init) return;
 
-    instance->SetJointAnimation(animInstance);
+    const uint8_t* bytes;
+    size_t size;
+    PyJ3D::Buffers::GetBytes(data, bytes, size);
+    AttachJointFile(instance, PyJ3D::JointAnimation::LoadClipMemory(bytes, size), false);
 }
 
 void attachBck(std::shared_ptr<J3DModelInstance> instance, std::string path){
     if(!init) return;
-
-    J3DAnimation::J3DAnimationLoader Loader;
-    
-    std::shared_ptr<J3DAnimation::J3DJointAnimationInstance> animInstance = Loader.LoadAnimation<J3DAnimation::J3DJointAnimationInstance>(path);
-
-    instance->SetJointAnimation(animInstance);
+    AttachJointFile(instance, PyJ3D::JointAnimation::LoadClipFile(path), false);
 }
 
 void attachBck(std::shared_ptr<J3DModelInstance> instance, std::shared_ptr<J3DAnimation::J3DJointAnimationInstance> anim){
     if(!init) return;
-    instance->SetJointAnimation(anim);
+    PyJ3D::JointAnimation::SetJointAnimation(instance.get(), anim);
 }
 
-void attachBca(std::shared_ptr<J3DModelInstance> instance, py::bytes data){
+void attachBca(std::shared_ptr<J3DModelInstance> instance, py::buffer data){
     if(!init) return;
 
-    py::buffer_info dataInfo(py::buffer(data).request());
-
-    J3DAnimation::J3DAnimationLoader Loader;
-    std::shared_ptr<J3DAnimation::J3DAnimationInstance> animLoaded = Loader.LoadAnimation(dataInfo.ptr, dataInfo.size);
-    std::shared_ptr<J3DAnimation::J3DJointFullAnimationInstance> animInstance = std::dynamic_pointer_cast<J3DAnimation::J3DJointFullAnimationInstance>(animLoaded);
-
-    instance->SetJointFullAnimation(animInstance);
+    const uint8_t* bytes;
+    size_t size;
+    PyJ3D::Buffers::GetBytes(data, bytes, size);
+    AttachJointFile(instance, PyJ3D::JointAnimation::LoadClipMemory(bytes, size), true);
 }
 
 void attachBca(std::shared_ptr<J3DModelInstance> instance, std::string path){
     if(!init) return;
-
-    J3DAnimation::J3DAnimationLoader Loader;
-    
-    std::shared_ptr<J3DAnimation::J3DJointFullAnimationInstance> animInstance = Loader.LoadAnimation<J3DAnimation::J3DJointFullAnimationInstance>(path);
-
-    instance->SetJointFullAnimation(animInstance);
+    AttachJointFile(instance, PyJ3D::JointAnimation::LoadClipFile(path), true);
 }
 
 void attachBca(std::shared_ptr<J3DModelInstance> instance, std::shared_ptr<J3DAnimation::J3DJointFullAnimationInstance> anim){
     if(!init) return;
-    instance->SetJointFullAnimation(anim);
+    PyJ3D::JointAnimation::SetJointFullAnimation(instance.get(), anim);
 }
 
-std::shared_ptr<J3DAnimation::J3DJointFullAnimationInstance> LoadBca(py::bytes data){
+std::shared_ptr<J3DAnimation::J3DJointFullAnimationInstance> LoadBca(py::buffer data){
     if(!init) return nullptr;
 
-    py::buffer_info dataInfo(py::buffer(data).request());
-
-    J3DAnimation::J3DAnimationLoader Loader;
-    std::shared_ptr<J3DAnimation::J3DAnimationInstance> animLoaded = Loader.LoadAnimation(dataInfo.ptr, dataInfo.size);
-    std::shared_ptr<J3DAnimation::J3DJointFullAnimationInstance> animInstance = std::dynamic_pointer_cast<J3DAnimation::J3DJointFullAnimationInstance>(animLoaded);
+    std::shared_ptr<J3DAnimation::J3DJointFullAnimationInstance> animInstance = LoadAnimationBuffer<J3DAnimation::J3DJointFullAnimationInstance>(data);
 
     return animInstance;
 }
@@ -368,21 +624,15 @@ std::shared_ptr<J3DAnimation::J3DJointFullAnimationInstance> LoadBca(py::bytes d
 std::shared_ptr<J3DAnimation::J3DJointFullAnimationInstance> LoadBca(std::string path){
     if(!init) return nullptr;
 
-    J3DAnimation::J3DAnimationLoader Loader;
-    
-    std::shared_ptr<J3DAnimation::J3DJointFullAnimationInstance> animInstance = Loader.LoadAnimation<J3DAnimation::J3DJointFullAnimationInstance>(path);
+    std::shared_ptr<J3DAnimation::J3DJointFullAnimationInstance> animInstance = LoadAnimationFile<J3DAnimation::J3DJointFullAnimationInstance>(path);
 
     return animInstance;
 }
 
-void attachBva(std::shared_ptr<J3DModelInstance> instance, py::bytes data){
+void attachBva(std::shared_ptr<J3DModelInstance> instance, py::buffer data){
     if(!init) return;
 
-    py::buffer_info dataInfo(py::buffer(data).request());
-
-    J3DAnimation::J3DAnimationLoader Loader;
-    std::shared_ptr<J3DAnimation::J3DAnimationInstance> animLoaded = Loader.LoadAnimation(dataInfo.ptr, dataInfo.size);
-    std::shared_ptr<J3DAnimation::J3DVisibilityAnimationInstance> animInstance = std::dynamic_pointer_cast<J3DAnimation::J3DVisibilityAnimationInstance>(animLoaded);
+    std::shared_ptr<J3DAnimation::J3DVisibilityAnimationInstance> animInstance = LoadAnimationBuffer<J3DAnimation::J3DVisibilityAnimationInstance>(data);
 
     instance->SetVisibilityAnimation(animInstance);
 }
@@ -390,9 +640,7 @@ void attachBva(std::shared_ptr<J3DModelInstance> instance, py::bytes data){
 void attachBva(std::shared_ptr<J3DModelInstance> instance, std::string path){
     if(!init) return;
 
-    J3DAnimation::J3DAnimationLoader Loader;
-    
-    std::shared_ptr<J3DAnimation::J3DVisibilityAnimationInstance> animInstance = Loader.LoadAnimation<J3DAnimation::J3DVisibilityAnimationInstance>(path);
+    std::shared_ptr<J3DAnimation::J3DVisibilityAnimationInstance> animInstance = LoadAnimationFile<J3DAnimation::J3DVisibilityAnimationInstance>(path);
 
     instance->SetVisibilityAnimation(animInstance);
 }
@@ -402,14 +650,10 @@ void attachBva(std::shared_ptr<J3DModelInstance> instance, std::shared_ptr<J3DAn
     instance->SetVisibilityAnimation(anim);
 }
 
-std::shared_ptr<J3DAnimation::J3DVisibilityAnimationInstance> LoadBva(py::bytes data){
+std::shared_ptr<J3DAnimation::J3DVisibilityAnimationInstance> LoadBva(py::buffer data){
     if(!init) return nullptr;
 
-    py::buffer_info dataInfo(py::buffer(data).request());
-
-    J3DAnimation::J3DAnimationLoader Loader;
-    std::shared_ptr<J3DAnimation::J3DAnimationInstance> animLoaded = Loader.LoadAnimation(dataInfo.ptr, dataInfo.size);
-    std::shared_ptr<J3DAnimation::J3DVisibilityAnimationInstance> animInstance = std::dynamic_pointer_cast<J3DAnimation::J3DVisibilityAnimationInstance>(animLoaded);
+    std::shared_ptr<J3DAnimation::J3DVisibilityAnimationInstance> animInstance = LoadAnimationBuffer<J3DAnimation::J3DVisibilityAnimationInstance>(data);
 
     return animInstance;
 }
@@ -417,21 +661,15 @@ std::shared_ptr<J3DAnimation::J3DVisibilityAnimationInstance> LoadBva(py::bytes
 std::shared_ptr<J3DAnimation::J3DVisibilityAnimationInstance> LoadBva(std::string path){
     if(!init) return nullptr;
 
-    J3DAnimation::J3DAnimationLoader Loader;
-    
-    std::shared_ptr<J3DAnimation::J3DVisibilityAnimationInstance> animInstance = Loader.LoadAnimation<J3DAnimation::J3DVisibilityAnimationInstance>(path);
+    std::shared_ptr<J3DAnimation::J3DVisibilityAnimationInstance> animInstance = LoadAnimationFile<J3DAnimation::J3DVisibilityAnimationInstance>(path);
 
     return animInstance;
 }
 
-std::shared_ptr<J3DAnimation::J3DJointAnimationInstance> LoadBck(py::bytes data){
+std::shared_ptr<J3DAnimation::J3DJointAnimationInstance> LoadBck(py::buffer data){
     if(!init) return nullptr;
 
-    py::buffer_info dataInfo(py::buffer(data).request());
-
-    J3DAnimation::J3DAnimationLoader Loader;
-    std::shared_ptr<J3DAnimation::J3DAnimationInstance> animLoaded = Loader.LoadAnimation(dataInfo.ptr, dataInfo.size);
-    std::shared_ptr<J3DAnimation::J3DJointAnimationInstance> animInstance = std::dynamic_pointer_cast<J3DAnimation::J3DJointAnimationInstance>(animLoaded);
+    std::shared_ptr<J3DAnimation::J3DJointAnimationInstance> animInstance = LoadAnimationBuffer<J3DAnimation::J3DJointAnimationInstance>(data);
 
     return animInstance;
 }
@@ -439,9 +677,7 @@ std::shared_ptr<J3DAnimation::J3DJointAnimationInstance> LoadBck(py::bytes data)
 std::shared_ptr<J3DAnimation::J3DJointAnimationInstance> LoadBck(std::string path){
     if(!init) return nullptr;
 
-    J3DAnimation::J3DAnimationLoader Loader;
-    
-    std::shared_ptr<J3DAnimation::J3DJointAnimationInstance> animInstance = Loader.LoadAnimation<J3DAnimation::J3DJointAnimationInstance>(path);
+    std::shared_ptr<J3DAnimation::J3DJointAnimationInstance> animInstance = LoadAnimationFile<J3DAnimation::J3DJointAnimationInstance>(path);
 
     return animInstance;
 }
@@ -450,33 +686,418 @@ void setLight(std::shared_ptr<J3DModelInstance> instance, J3DLight light, int li
     instance->SetLight(light, lightIdx);
 }
 
+// x, y in framebuffer pixels of the current viewport, origin bottom left
 bool isClicked(std::shared_ptr<J3DModelInstance> instance, uint32_t x, uint32_t y){
-    //if(J3D::Picking::IsPickingEnabled()) return std::get<0>(J3D::Picking::Query(x,y)) == instance->GetModelId();
-    return false;
+    if(!init) return false;
+
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+
+    glm::vec3 origin, dir;
+    PyJ3D::Collision::ScreenRay(defaultRenderer->GetView(), defaultRenderer->GetProj(), (float)x + 0.5f, (float)y + 0.5f, (float)viewport[2], (float)viewport[3], origin, dir);
+
+    J3DModelInstance* target = instance.get();
+    PyJ3D::Collision::RayHit hit;
+    return PyJ3D::Collision::RaycastInstances(&target, 1, origin, dir, INFINITY, hit);
+}
+
+py::dict MakeRayHit(const PyJ3D::Collision::RayHit& hit, const glm::vec3& origin, const glm::vec3& dir){
+    glm::vec3 position = origin + glm::normalize(dir) * hit.Distance;
+    return py::dict("distance"_a=hit.Distance, "material"_a=hit.Material, "shape"_a=hit.Shape, "triangle"_a=hit.Triangle,
+                    "position"_a=std::array<float, 3>{ position.x, position.y, position.z });
 }
 
-std::tuple<uint16_t, uint16_t> QueryPicking(uint32_t x, uint32_t y){
+std::optional<py::dict> Raycast(std::vector<std::shared_ptr<J3DModelInstance>> instances, std::array<float, 3> origin, std::array<float, 3> direction, float maxDistance){
+    std::vector<J3DModelInstance*> targets;
+    for(const std::shared_ptr<J3DModelInstance>& instance : instances){
+        targets.push_back(instance.get());
+    }
+
+    glm::vec3 rayOrigin(origin[0], origin[1], origin[2]), rayDir(direction[0], direction[1], direction[2]);
+    PyJ3D::Collision::RayHit hit;
+    if(!PyJ3D::Collision::RaycastInstances(targets.data(), targets.size(), rayOrigin, rayDir, maxDistance, hit)) return std::nullopt;
+
+    py::dict result = MakeRayHit(hit, rayOrigin, rayDir);
+    result["instance"] = instances[hit.Index];
+    return result;
+}
+
+std::optional<py::dict> RaycastScene(PyJ3D::Scene& scene, std::array<float, 3> origin, std::array<float, 3> direction, float maxDistance){
+    glm::vec3 rayOrigin(origin[0], origin[1], origin[2]), rayDir(direction[0], direction[1], direction[2]);
+    PyJ3D::Collision::RayHit hit;
+    if(!scene.Raycast(rayOrigin, rayDir, maxDistance, hit)) return std::nullopt;
+
+    py::dict result = MakeRayHit(hit, rayOrigin, rayDir);
+    result["slot"] = hit.Index;
+    result["instance"] = scene.GetInstance((uint32_t)hit.Index);
+    return result;
+}
+
+std::tuple<std::array<float, 3>, std::array<float, 3>> ScreenRay(float x, float y, float width, float height){
+    glm::vec3 origin, dir;
+    PyJ3D::Collision::ScreenRay(defaultRenderer->GetView(), defaultRenderer->GetProj(), x, y, width, height, origin, dir);
+    return { { origin.x, origin.y, origin.z }, { dir.x, dir.y, dir.z } };
+}
+
+// None when picking hasn't been initialised
+std::optional<std::tuple<uint16_t, uint16_t>> QueryPicking(uint32_t x, uint32_t y){
     if(J3D::Picking::IsPickingEnabled()) return J3D::Picking::Query(x,y);
+    return std::nullopt;
 }
 
 void InitPicking(uint32_t w, uint32_t h){
     J3D::Picking::InitFramebuffer(w, h);
+    PyJ3D::PickQueue::SetFramebufferSize(w, h);
 }
 
 void ResizePickingFB(uint32_t w, uint32_t h){
-    if(J3D::Picking::IsPickingEnabled()) J3D::Picking::ResizeFramebuffer(w, h);
+    if(J3D::Picking::IsPickingEnabled()){
+        J3D::Picking::ResizeFramebuffer(w, h);
+        PyJ3D::PickQueue::SetFramebufferSize(w, h);
+    }
+}
+
+std::optional<std::tuple<uint16_t, uint16_t>> GetPickResult(const PyJ3D::PickQueue::PickHandle& handle){
+    if(handle.GetState() != PyJ3D::PickQueue::PickState::Ready || handle.GetHits().empty()) return std::nullopt;
+    return std::make_tuple(handle.GetHits().front().first, handle.GetHits().front().second);
+}
+
+void SetCulling(bool enabled, float maxDistance, float minScreenSize, float boundsScale, float animatedBoundsScale){
+    PyJ3D::Culling::CullSettings settings;
+    settings.Enabled = enabled;
+    settings.MaxDistance = maxDistance;
+    settings.MinScreenSize = minScreenSize;
+    settings.BoundsScale = boundsScale;
+    settings.AnimatedBoundsScale = animatedBoundsScale;
+    PyJ3D::Culling::SetSettings(settings);
+}
+
+py::dict GetCullingStats(){
+    const PyJ3D::Culling::CullStats& stats = PyJ3D::Culling::GetStats();
+    return py::dict("tested"_a=stats.Tested, "visible"_a=stats.Visible, "frustumCulled"_a=stats.FrustumCulled, "distanceCulled"_a=stats.DistanceCulled, "sizeCulled"_a=stats.SizeCulled, "unbounded"_a=stats.Unbounded);
+}
+
+py::dict GetCpuFeatures(){
+    const PyJ3D::Simd::CpuFeatures& features = PyJ3D::Simd::GetCpuFeatures();
+    return py::dict("sse42"_a=features.Sse42, "avx"_a=features.Avx, "avx2"_a=features.Avx2, "fma"_a=features.Fma,
+                    "supported"_a=PyJ3D::Simd::GetSupportedLevel(), "active"_a=PyJ3D::Simd::GetLevel());
+}
+
+py::dict MakeTextureStats(const PyJ3D::TextureUpload::TextureStats& stats){
+    return py::dict("textures"_a=stats.Textures, "decoded"_a=stats.Decoded, "passthrough"_a=stats.Passthrough, "decodedBytes"_a=stats.DecodedBytes, "compressedBytes"_a=stats.CompressedBytes,
+                    "savedBytes"_a=stats.SavedBytes, "loadMs"_a=stats.LoadMs, "uploadMs"_a=stats.UploadMs, "convertMs"_a=stats.ConvertMs);
+}
+
+py::dict GetTextureUploadStats(){
+    py::dict stats = MakeTextureStats(PyJ3D::TextureUpload::GetTotals());
+    stats["compressedUpload"] = PyJ3D::TextureUpload::IsCompressedUpload();
+    stats["compressedSupported"] = init && PyJ3D::TextureUpload::IsCompressedUploadSupported();
+    return stats;
+}
+
+std::optional<py::dict> getTextureStats(std::shared_ptr<J3DModelInstance> instance){
+    PyJ3D::Instances::InstanceRecord* record = PyJ3D::Instances::Find(instance.get());
+    PyJ3D::Instances::ModelRecord* model = record != nullptr ? PyJ3D::Instances::FindModel(record->Data) : nullptr;
+    if(model == nullptr) return std::nullopt;
+    return MakeTextureStats(model->Textures);
+}
+
+py::list GetTextures(const uint8_t* data, size_t size){
+    std::vector<PyJ3D::J3DFile::TextureHeader> textures;
+    if(!PyJ3D::J3DFile::ReadTextures(data, size, textures)) throw py::value_error("no TEX1 section");
+
+    py::list list;
+    for(const PyJ3D::J3DFile::TextureHeader& texture : textures){
+        list.append(py::dict("name"_a=texture.Name, "format"_a=texture.Format, "width"_a=texture.Width, "height"_a=texture.Height, "mipCount"_a=texture.MipCount,
+                             "supported"_a=PyJ3D::TextureDecode::IsSupported(texture.Format)));
+    }
+    return list;
+}
+
+py::array_t<uint8_t> DecodeTexture(const uint8_t* data, size_t size, uint32_t index, uint32_t level){
+    std::vector<PyJ3D::J3DFile::TextureHeader> textures;
+    if(!PyJ3D::J3DFile::ReadTextures(data, size, textures)) throw py::value_error("no TEX1 section");
+    if(index >= textures.size()) throw py::value_error("texture index out of range");
+
+    const PyJ3D::J3DFile::TextureHeader& texture = textures[index];
+    if(!PyJ3D::TextureDecode::IsSupported(texture.Format)) throw py::value_error("unsupported texture format " + std::to_string(texture.Format));
+    if(level >= texture.MipCount) throw py::value_error("texture has " + std::to_string(texture.MipCount) + " levels");
+
+    std::vector<uint8_t> pixels;
+    {
+        py::gil_scoped_release release;
+        if(!PyJ3D::TextureDecode::DecodeLevelCached(data, size, texture, level, pixels)) pixels.clear();
+    }
+    if(pixels.empty()) throw py::value_error("texture data is truncated");
+
+    uint32_t width = PyJ3D::TextureDecode::GetLevelWidth(texture, level), height = PyJ3D::TextureDecode::GetLevelHeight(texture, level);
+    py::array_t<uint8_t> image({ (py::ssize_t)height, (py::ssize_t)width, (py::ssize_t)4 });
+    std::memcpy(image.mutable_data(), pixels.data(), pixels.size());
+    return image;
+}
+
+py::list GetTextures(const std::string& path){
+    PyJ3D::Files::MappedFile file;
+    if(!file.Open(path)) throw std::runtime_error("Couldn't open " + path);
+    return GetTextures(file.GetData(), file.GetSize());
+}
+
+py::list GetTextures(py::buffer data){
+    const uint8_t* bytes;
+    size_t size;
+    PyJ3D::Buffers::GetBytes(data, bytes, size);
+    return GetTextures(bytes, size);
+}
+
+py::array_t<uint8_t> DecodeTexture(const std::string& path, uint32_t index, uint32_t level){
+    PyJ3D::Files::MappedFile file;
+    if(!file.Open(path)) throw std::runtime_error("Couldn't open " + path);
+    return DecodeTexture(file.GetData(), file.GetSize(), index, level);
+}
+
+py::array_t<uint8_t> DecodeTexture(py::buffer data, uint32_t index, uint32_t level){
+    const uint8_t* bytes;
+    size_t size;
+    PyJ3D::Buffers::GetBytes(data, bytes, size);
+    return DecodeTexture(bytes, size, index, level);
+}
+
+PyJ3D::AnimationLod::LodPolicy MakeLodPolicy(bool enabled, float nearDistance, float farDistance, uint32_t midInterval, uint32_t farInterval, bool interpolate){
+    PyJ3D::AnimationLod::LodPolicy policy;
+    policy.Enabled = enabled;
+    policy.NearDistance = nearDistance;
+    policy.FarDistance = farDistance;
+    policy.MidInterval = midInterval;
+    policy.FarInterval = farInterval;
+    policy.Interpolate = interpolate;
+    return policy;
+}
+
+void SetAnimationLod(bool enabled, float nearDistance, float farDistance, uint32_t midInterval, uint32_t farInterval, bool interpolate){
+    PyJ3D::AnimationLod::SetPolicy(MakeLodPolicy(enabled, nearDistance, farDistance, midInterval, farInterval, interpolate));
+}
+
+py::dict GetAnimationLodStats(){
+    const PyJ3D::AnimationLod::LodStats& stats = PyJ3D::AnimationLod::GetStats();
+    return py::dict("instances"_a=stats.Instances, "fullRate"_a=stats.FullRate, "updated"_a=stats.Updated, "throttled"_a=stats.Throttled);
+}
+
+std::shared_ptr<PyJ3D::JointAnimation::JointClip> LoadJointClip(py::buffer data, bool lossless, bool cache){
+    const uint8_t* bytes;
+    size_t size;
+    PyJ3D::Buffers::GetBytes(data, bytes, size);
+
+    return PyJ3D::JointAnimation::LoadClipMemory(bytes, size, lossless, cache);
+}
+
+std::shared_ptr<PyJ3D::JointAnimation::JointClip> LoadJointClip(std::string path, bool lossless, bool cache){
+    return PyJ3D::JointAnimation::LoadClipFile(path, lossless, cache);
+}
+
+void attachJointClip(std::shared_ptr<J3DModelInstance> instance, std::shared_ptr<PyJ3D::JointAnimation::JointClip> clip, float speed, std::optional<PyJ3D::JointAnimation::LoopMode> loop){
+    PyJ3D::JointAnimation::Attach(instance.get(), clip);
+
+    PyJ3D::JointAnimation::ClipPlayer* player = PyJ3D::JointAnimation::FindPlayer(instance.get());
+    if(player == nullptr) return;
+
+    player->Speed = speed;
+    if(loop.has_value()) player->Loop = *loop;
+}
+
+// Player setters are no-ops on instances without a clip attached.
+PyJ3D::JointAnimation::ClipPlayer* GetClipPlayer(const std::shared_ptr<J3DModelInstance>& instance){
+    PyJ3D::JointAnimation::ClipPlayer* player = PyJ3D::JointAnimation::FindPlayer(instance.get());
+    return player != nullptr && player->Clip != nullptr ? player : nullptr;
+}
+
+py::object getClipState(std::shared_ptr<J3DModelInstance> instance){
+    PyJ3D::JointAnimation::ClipPlayer* player = GetClipPlayer(instance);
+    if(player == nullptr) return py::none();
+
+    return py::dict("frame"_a=PyJ3D::JointAnimation::GetPlayerFrame(*player), "speed"_a=player->Speed, "loop"_a=player->Loop, "paused"_a=player->Paused, "weight"_a=player->Weight);
+}
+
+void crossfadeJointClip(std::shared_ptr<J3DModelInstance> instance, std::shared_ptr<PyJ3D::JointAnimation::JointClip> clip, float duration, float speed, std::optional<PyJ3D::JointAnimation::LoopMode> loop){
+    PyJ3D::JointAnimation::Crossfade(instance.get(), clip, duration);
+
+    PyJ3D::JointAnimation::ClipPlayer* player = GetClipPlayer(instance);
+    if(player == nullptr) return;
+
+    player->Speed = speed;
+    if(loop.has_value()) player->Loop = *loop;
+}
+
+uint32_t addJointLayer(std::shared_ptr<J3DModelInstance> instance, std::shared_ptr<PyJ3D::JointAnimation::JointClip> clip, float weight, PyJ3D::JointAnimation::BlendMode mode, float speed, std::optional<PyJ3D::JointAnimation::LoopMode> loop){
+    uint32_t id = PyJ3D::JointAnimation::AddLayer(instance.get(), clip, weight, mode);
+
+    PyJ3D::JointAnimation::ClipLayer* layer = PyJ3D::JointAnimation::FindLayer(instance.get(), id);
+    if(layer == nullptr) return 0;
+
+    layer->Player.Speed = speed;
+    if(loop.has_value()) layer->Player.Loop = *loop;
+    return id;
+}
+
+bool setJointLayerWeight(std::shared_ptr<J3DModelInstance> instance, uint32_t id, float weight, float fade){
+    PyJ3D::JointAnimation::ClipLayer* layer = PyJ3D::JointAnimation::FindLayer(instance.get(), id);
+    if(layer == nullptr) return false;
+
+    PyJ3D::JointAnimation::FadeWeight(layer->Player, weight, fade);
+    return true;
+}
+
+py::list getJointLayers(std::shared_ptr<J3DModelInstance> instance){
+    py::list layers;
+    PyJ3D::Instances::InstanceRecord* record = PyJ3D::Instances::Find(instance.get());
+    if(record == nullptr) return layers;
+
+    for(const PyJ3D::JointAnimation::ClipLayer& layer : record->Layers){
+        layers.append(py::dict("id"_a=layer.Id, "mode"_a=layer.Mode, "weight"_a=layer.Player.Weight, "targetWeight"_a=layer.Player.TargetWeight, "frame"_a=PyJ3D::JointAnimation::GetPlayerFrame(layer.Player), "fadingOut"_a=layer.RemoveWhenFaded));
+    }
+    return layers;
+}
+
+py::dict GetJointClipCacheStats(){
+    PyJ3D::JointAnimation::ClipCacheStats stats = PyJ3D::JointAnimation::GetCacheStats();
+    return py::dict("hits"_a=stats.Hits, "misses"_a=stats.Misses, "entries"_a=stats.Entries, "bytesUsed"_a=stats.BytesUsed);
+}
+
+py::dict GetJointAnimationStats(){
+    const PyJ3D::JointAnimation::UpdateStats& stats = PyJ3D::JointAnimation::GetStats();
+    return py::dict("instances"_a=stats.Instances, "evaluated"_a=stats.Evaluated, "shared"_a=stats.Shared, "reused"_a=stats.Reused, "held"_a=stats.Held, "interpolated"_a=stats.Interpolated, "joints"_a=stats.Joints, "layers"_a=stats.Layers, "workers"_a=PyJ3D::Jobs::GetWorkerCount());
+}
+
+void SetProfiling(bool enabled, bool gpuTimers, size_t history){
+    if(history == 0) throw py::value_error("history must be at least 1 frame");
+    if(!init) return;
+
+    PyJ3D::Profiler::SetEnabled(enabled, gpuTimers, history);
+}
+
+py::dict MakeFrameStats(const PyJ3D::Profiler::FrameStats& frame){
+    py::dict cpuMs, gpuMs, counters;
+    for(size_t i = 0; i < PyJ3D::Profiler::StageCount; i++){
+        const char* name = PyJ3D::Profiler::GetStageName((PyJ3D::Profiler::Stage)i);
+        cpuMs[name] = frame.CpuMs[i];
+        gpuMs[name] = frame.GpuMs[i] < 0.0 ? py::object(py::none()) : py::object(py::float_(frame.GpuMs[i]));
+    }
+    for(size_t i = 0; i < PyJ3D::Profiler::CounterCount; i++){
+        counters[PyJ3D::Profiler::GetCounterName((PyJ3D::Profiler::Counter)i)] = frame.Counters[i];
+    }
+
+    return py::dict("frame"_a=frame.Index, "frameMs"_a=frame.FrameMs, "cpuMs"_a=cpuMs, "gpuMs"_a=gpuMs, "counters"_a=counters);
+}
+
+// Most recent frame, GPU timings of it are usually still None and show up in getFrameHistory a few frames later.
+py::object GetFrameStats(){
+    std::deque<PyJ3D::Profiler::FrameStats> history = PyJ3D::Profiler::GetHistory();
+    if(history.empty()) return py::none();
+
+    return MakeFrameStats(history.back());
+}
+
+py::list GetFrameHistory(){
+    py::list frames;
+    for(const PyJ3D::Profiler::FrameStats& frame : PyJ3D::Profiler::GetHistory()){
+        frames.append(MakeFrameStats(frame));
+    }
+    return frames;
+}
+
+void WriteChromeTrace(std::string path){
+    if(!PyJ3D::Profiler::WriteChromeTrace(path)) throw std::runtime_error("Couldn't write trace to " + path);
 }
 
 void RenderScene(float dt, std::array<float, 3> cameraPos, bool renderPicking = false){
     if(init){
-        glDepthMask(true); // gotta make sure the depth mask is ON!
-        auto sortedPackets = J3D::Rendering::SortPackets(renderBatch, glm::vec3(cameraPos.at(0), cameraPos.at(1), cameraPos.at(2)));
-        J3D::Rendering::Render(dt, viewMtx, projMtx, sortedPackets);
-        
-        if(J3D::Picking::IsPickingEnabled() && renderPicking) J3D::Picking::RenderPickingScene(viewMtx, projMtx, sortedPackets);
+        defaultRenderer->Render(dt, glm::vec3(cameraPos.at(0), cameraPos.at(1), cameraPos.at(2)), renderPicking);
+    }
+}
+
+void RenderRetainedScene(PyJ3D::Scene& scene, float dt, std::array<float, 3> cameraPos, bool renderPicking = false){
+    if(init){
+        defaultRenderer->RenderScene(scene, dt, glm::vec3(cameraPos.at(0), cameraPos.at(1), cameraPos.at(2)), renderPicking);
+    }
+}
 
-        renderBatch.clear();
+// Renders once per (4, 4) view matrix into the renderer's offscreen target and reads the results straight into numpy arrays.
+// The GIL is released for the render so other threads' renderers can run alongside it, taking turns on the context.
+// prepare runs under the registry lock, held through the render, for setting up a renderer other threads render through too.
+py::tuple RenderViews(PyJ3D::Renderer& renderer, PyJ3D::Scene* scene, float dt, FloatArray views, py::buffer proj, uint32_t width, uint32_t height, std::array<float, 4> clearColor, bool readDepth,
+                      const std::function<void()>& prepare = {}){
+    if(!init) throw std::runtime_error("J3DUltra hasn't been initialised");
+    if(width == 0 || height == 0) throw py::value_error("width and height must be non-zero");
+
+    // a single (4, 4) matrix renders one view
+    size_t count = (views.ndim() == 2 && views.shape(0) == 4 && views.shape(1) == 4) ? 1 : GetBatchRows(views, 16);
+
+    glm::mat4 projection;
+    PyJ3D::Buffers::ReadFloats(proj, glm::value_ptr(projection), 16);
+
+    std::vector<glm::mat4> viewMatrices(count);
+    const float* viewData = views.data();
+    for(size_t i = 0; i < count; i++) viewMatrices[i] = glm::make_mat4(viewData + i * 16);
+
+    py::array_t<uint8_t> color({ (py::ssize_t)count, (py::ssize_t)height, (py::ssize_t)width, (py::ssize_t)4 });
+    py::array_t<float> depth = readDepth ? py::array_t<float>({ (py::ssize_t)count, (py::ssize_t)height, (py::ssize_t)width }) : py::array_t<float>();
+
+    uint8_t* colorOut = color.mutable_data();
+    float* depthOut = readDepth ? depth.mutable_data() : nullptr;
+    size_t texels = (size_t)width * height;
+
+    bool rendered;
+    {
+        py::gil_scoped_release release;
+        std::optional<PyJ3D::RegistryLock> registry;
+        if(prepare){
+            registry.emplace();
+            prepare();
+        }
+
+        rendered = renderer.RenderViews(scene, dt, viewMatrices.data(), count, projection, width, height,
+                                        glm::vec4(clearColor[0], clearColor[1], clearColor[2], clearColor[3]), [&](size_t i){
+            renderer.GetTarget().ReadColor(colorOut + i * texels * 4);
+            if(readDepth) renderer.GetTarget().ReadDepth(depthOut + i * texels);
+        });
     }
+    if(!rendered) throw std::runtime_error("Couldn't create the offscreen framebuffer");
+
+    return py::make_tuple(color, readDepth ? py::object(depth) : py::object(py::none()));
+}
+
+py::tuple RenderInstanceViews(std::vector<std::shared_ptr<J3DModelInstance>> instances, FloatArray views, py::buffer proj, uint32_t width, uint32_t height, std::array<float, 4> clearColor, bool readDepth){
+    return RenderViews(viewsRenderer, nullptr, 0.0f, views, proj, width, height, clearColor, readDepth, [&](){
+        viewsRenderer.SetSortMode(defaultRenderer->GetSortMode());
+        viewsRenderer.ClearBatch();
+        viewsRenderer.Submit(instances);
+    });
+}
+
+py::tuple RenderSceneViews(PyJ3D::Scene& scene, FloatArray views, py::buffer proj, uint32_t width, uint32_t height, std::array<float, 4> clearColor, bool readDepth){
+    return RenderViews(viewsRenderer, &scene, 0.0f, views, proj, width, height, clearColor, readDepth, [](){
+        viewsRenderer.SetSortMode(defaultRenderer->GetSortMode());
+    });
+}
+
+void SetSortMode(PyJ3D::RenderSort::SortMode mode){
+    PyJ3D::RenderSort::SetSortMode(mode);
+    defaultRenderer->SetSortMode(mode);
+}
+
+// Copy of a renderer's camera matrix, renderers can go away before the array does.
+py::array CopyMatrix(const glm::mat4& matrix){
+    return py::array_t<float>({ 4, 4 }, glm::value_ptr(matrix));
+}
+
+py::dict GetRendererStats(const PyJ3D::Renderer& renderer){
+    const PyJ3D::RendererStats& stats = renderer.GetStats();
+    return py::dict("views"_a=stats.Views, "instances"_a=stats.Instances, "animated"_a=stats.Animated, "drawn"_a=stats.Drawn,
+                    "packets"_a=stats.Packets, "cpuMs"_a=stats.CpuMs);
+}
+
+void AcquireContext(){
+    if(!PyJ3D::Headless::HasContext()) throw std::runtime_error("No headless context, initHeadless wasn't called");
+    if(!PyJ3D::Headless::IsCurrent() && !PyJ3D::Headless::MakeCurrent()) throw std::runtime_error("The headless context is current on another thread, call releaseContext() on it first");
 }
 
 PYBIND11_MODULE(J3DUltra, m) {
@@ -504,19 +1125,29 @@ PYBIND11_MODULE(J3DUltra, m) {
         .def_readwrite("b", &glm::vec4::b)
         .def_readwrite("a", &glm::vec4::a);
 
-    py::class_<J3DLight>(m, "J3DLight")
-        .def(py::init<>())
-        .def(py::init([](std::array<float, 3> position, std::array<float, 3> direction, std::array<float, 4> color, std::array<float, 3> angle_atten, std::array<float, 3> dist_atten, bool followCamera){
-            J3DLight light;
+    py::enum_<PyJ3D::RenderSort::SortMode>(m, "SortMode")
+        .value("Name", PyJ3D::RenderSort::SortMode::Name)
+        .value("Keyed", PyJ3D::RenderSort::SortMode::Keyed);
 
-            light.Position = glm::vec4(position[0], position[1], position[2], followCamera ? 0 : 1);
-            light.Direction = glm::vec4(direction[0], direction[1], direction[2], 1);
-            light.Color = glm::vec4(color[0], color[1], color[2], color[3]);
-            light.AngleAtten = glm::vec4(angle_atten[0], angle_atten[1], angle_atten[2], 1);;
-            light.DistAtten = glm::vec4(dist_atten[0], dist_atten[1], dist_atten[2], 1);;
+    py::enum_<PyJ3D::Simd::Level>(m, "SimdLevel")
+        .value("Scalar", PyJ3D::Simd::Level::Scalar)
+        .value("SSE42", PyJ3D::Simd::Level::Sse42)
+        .value("AVX2", PyJ3D::Simd::Level::Avx2);
 
-            return light;
+    py::class_<J3DLight>(m, "J3DLight")
+        .def(py::init<>())
+        // buffer overload first so numpy arrays are read directly, lists fall through to the array overload
+        .def(py::init([](py::buffer position, py::buffer direction, py::buffer color, py::buffer angle_atten, py::buffer dist_atten, bool followCamera){
+            return MakeLight(
+                PyJ3D::Buffers::ReadArray<3>(position),
+                PyJ3D::Buffers::ReadArray<3>(direction),
+                PyJ3D::Buffers::ReadArray<4>(color),
+                PyJ3D::Buffers::ReadArray<3>(angle_atten),
+                PyJ3D::Buffers::ReadArray<3>(dist_atten),
+                followCamera
+            );
         }))
+        .def(py::init(&MakeLight))
         .def_readwrite("position", &J3DLight::Position)
         .def_readwrite("direction", &J3DLight::Direction)
         .def_readwrite("color", &J3DLight::Color)
@@ -525,13 +1156,13 @@ PYBIND11_MODULE(J3DUltra, m) {
 
     py::class_<J3DModelData, std::shared_ptr<J3DModelData>>(m, "J3DModelData")
         .def(py::init<>())
-        .def("createInstance", &J3DModelData::CreateInstance);
+        .def("createInstance", &PyJ3D::Instances::CreateInstance, RegistryGuard());
 
     py::class_<J3DAnimation::J3DAnimationInstance, std::shared_ptr<J3DAnimation::J3DAnimationInstance>>(m, "J3DAnimation")
-        .def("setFrame", &J3DAnimation::J3DAnimationInstance::SetFrame)
-        .def("getFrame", &J3DAnimation::J3DAnimationInstance::GetFrame)
-        .def("setPaused", &J3DAnimation::J3DAnimationInstance::SetPaused)
-        .def("tick", &J3DAnimation::J3DAnimationInstance::Tick);
+        .def("setFrame", &J3DAnimation::J3DAnimationInstance::SetFrame, RegistryGuard())
+        .def("getFrame", &J3DAnimation::J3DAnimationInstance::GetFrame, RegistryGuard())
+        .def("setPaused", [](std::shared_ptr<J3DAnimation::J3DAnimationInstance> animation, bool paused){ PyJ3D::AnimationLod::SetPaused(animation, paused); }, RegistryGuard())
+        .def("tick", &J3DAnimation::J3DAnimationInstance::Tick, RegistryGuard());
 
     py::class_<J3DAnimation::J3DColorAnimationInstance, std::shared_ptr<J3DAnimation::J3DColorAnimationInstance>, J3DAnimation::J3DAnimationInstance>(m, "J3DColorAnimation")
         .def(py::init<>());
@@ -556,64 +1187,276 @@ PYBIND11_MODULE(J3DUltra, m) {
         .def_readwrite("name", &J3DMaterial::Name);
         //.def("getId", &J3DMaterial::GetMaterialId);
 
+    py::class_<PyJ3D::AsyncLoader::LoadHandle, std::shared_ptr<PyJ3D::AsyncLoader::LoadHandle>>(m, "LoadHandle")
+        .def("done", [](PyJ3D::AsyncLoader::LoadHandle& handle){
+            PyJ3D::Buffers::ReleasePending();
+            return handle.IsDone();
+        })
+        .def("failed", [](PyJ3D::AsyncLoader::LoadHandle& handle){ return handle.GetState() == PyJ3D::AsyncLoader::LoadState::Failed; })
+        .def("error", &PyJ3D::AsyncLoader::LoadHandle::GetError)
+        .def("result", [](PyJ3D::AsyncLoader::LoadHandle& handle) -> py::object {
+            if(handle.GetState() != PyJ3D::AsyncLoader::LoadState::Ready) return py::none();
+            if(handle.GetModel() != nullptr) return py::cast(handle.GetModel());
+            return py::cast(handle.GetAnimation());
+        }, "Loaded model instance or animation, None until done");
+
+    py::enum_<PyJ3D::PickQueue::PickState>(m, "PickState")
+        .value("Queued", PyJ3D::PickQueue::PickState::Queued)
+        .value("Reading", PyJ3D::PickQueue::PickState::Reading)
+        .value("Ready", PyJ3D::PickQueue::PickState::Ready)
+        .value("Disabled", PyJ3D::PickQueue::PickState::Disabled);
+
+    py::class_<PyJ3D::PickQueue::PickHandle, std::shared_ptr<PyJ3D::PickQueue::PickHandle>>(m, "PickHandle")
+        .def("state", &PyJ3D::PickQueue::PickHandle::GetState, RegistryGuard())
+        .def("done", &PyJ3D::PickQueue::PickHandle::IsDone, RegistryGuard())
+        .def("hits", &PyJ3D::PickQueue::PickHandle::GetHits, "Unique (model id, material id) pairs in the region", RegistryGuard())
+        .def("result", &GetPickResult, "First (model id, material id) pair, None until ready or when nothing was hit", RegistryGuard())
+        .def("poll", [](PyJ3D::PickQueue::PickHandle& handle){ PyJ3D::PickQueue::Poll(); return handle.IsDone(); }, "Complete finished readbacks without blocking, returns done", GlGuard());
+
+    py::class_<PyJ3D::Scene, std::shared_ptr<PyJ3D::Scene>>(m, "Scene")
+        .def(py::init<>())
+        .def("add", &PyJ3D::Scene::Add, "Add an instance and return its slot", py::arg("instance"), RegistryGuard())
+        .def("remove", py::overload_cast<uint32_t>(&PyJ3D::Scene::Remove), py::arg("slot"), RegistryGuard())
+        .def("remove", py::overload_cast<std::shared_ptr<J3DModelInstance>>(&PyJ3D::Scene::Remove), py::arg("instance"), RegistryGuard())
+        .def("clear", &PyJ3D::Scene::Clear, RegistryGuard())
+        .def("getSlot", &PyJ3D::Scene::FindSlot, "Slot of an instance, -1 if it isn't in the scene", py::arg("instance"), RegistryGuard())
+        .def("getInstance", &PyJ3D::Scene::GetInstance, py::arg("slot"), RegistryGuard())
+        .def("setVisible", &PyJ3D::Scene::SetVisible, py::arg("slot"), py::arg("visible"), RegistryGuard())
+        .def("isVisible", &PyJ3D::Scene::GetVisible, py::arg("slot"), RegistryGuard())
+        .def("markDirty", &PyJ3D::Scene::MarkDirty, "Regather a slot's packets after moving it or changing its materials", py::arg("slot"), RegistryGuard())
+        .def("markAllDirty", &PyJ3D::Scene::MarkAllDirty, RegistryGuard())
+        .def_property("resortDistance", py::cpp_function(&PyJ3D::Scene::GetResortDistance, RegistryGuard()), py::cpp_function(&PyJ3D::Scene::SetResortDistance, RegistryGuard()))
+        .def("setTranslations", [](PyJ3D::Scene& scene, FloatArray values, std::optional<SlotArray> slots){ SetSceneVectors(scene, values, slots, PyJ3D::Transforms::Component::Translation); }, "Set translations from an (N, 3) float32 array", py::arg("values"), py::arg("slots") = py::none(), RegistryGuard())
+        .def("setRotations", [](PyJ3D::Scene& scene, FloatArray values, std::optional<SlotArray> slots){ SetSceneVectors(scene, values, slots, PyJ3D::Transforms::Component::Rotation); }, "Set rotations from an (N, 3) float32 array", py::arg("values"), py::arg("slots") = py::none(), RegistryGuard())
+        .def("setScales", [](PyJ3D::Scene& scene, FloatArray values, std::optional<SlotArray> slots){ SetSceneVectors(scene, values, slots, PyJ3D::Transforms::Component::Scale); }, "Set scales from an (N, 3) float32 array", py::arg("values"), py::arg("slots") = py::none(), RegistryGuard())
+        .def("setTransforms", &SetSceneTransforms, "Set transforms from an (N, 4, 4) float32 array", py::arg("matrices"), py::arg("slots") = py::none(), RegistryGuard())
+        .def_property("sharedGather", py::cpp_function(&PyJ3D::Scene::GetSharedGather, RegistryGuard()), py::cpp_function(&PyJ3D::Scene::SetSharedGather, RegistryGuard()))
+        .def("getSharedGatherStats", [](PyJ3D::Scene& scene){
+            PyJ3D::SharedGatherStats stats = scene.GetSharedGatherStats();
+            return py::dict("groups"_a=stats.Groups, "gathered"_a=stats.Gathered, "reused"_a=stats.Reused);
+        }, "Shared gather counters from the last rebuild, groups share one packet gather but still draw once per copy", RegistryGuard())
+        .def("setAnimationLod", [](PyJ3D::Scene& scene, bool enabled, float nearDistance, float farDistance, uint32_t midInterval, uint32_t farInterval, bool interpolate){
+            scene.SetAnimationLod(MakeLodPolicy(enabled, nearDistance, farDistance, midInterval, farInterval, interpolate));
+        }, "Override the global animation level of detail policy for this scene", py::arg("enabled") = true, py::arg("nearDistance") = 1000.0f, py::arg("farDistance") = 4000.0f, py::arg("midInterval") = 2, py::arg("farInterval") = 4, py::arg("interpolate") = true, RegistryGuard())
+        .def("clearAnimationLod", &PyJ3D::Scene::ClearAnimationLod, "Use the global animation level of detail policy again", RegistryGuard())
+        .def("renderViews", &RenderSceneViews, "Render the scene once per view matrix offscreen, returns (color, depth or None) numpy arrays",
+             py::arg("views"), py::arg("proj"), py::arg("width"), py::arg("height"), py::arg("clearColor") = std::array<float, 4>{ 0.0f, 0.0f, 0.0f, 0.0f }, py::arg("depth") = false)
+        .def("raycast", &RaycastScene, "Nearest visible instance hit by a world space ray, None on a miss", py::arg("origin"), py::arg("direction"), py::arg("maxDistance") = INFINITY, RegistryGuard())
+        .def("render", &RenderRetainedScene, "Render every visible instance in the scene", py::arg("dt"), py::arg("cameraPos"), py::arg("renderPicking") = false)
+        .def("__len__", &PyJ3D::Scene::GetCount, RegistryGuard());
+
+    py::class_<PyJ3D::Renderer, std::shared_ptr<PyJ3D::Renderer>>(m, "Renderer", "Camera, batch, sort mode and offscreen target for one viewport, renders on any thread")
+        .def(py::init(&PyJ3D::CreateRenderer))
+        .def("setCamera", [](PyJ3D::Renderer& renderer, py::buffer proj, py::buffer view){
+            glm::mat4 projection, viewm4;
+            PyJ3D::Buffers::ReadFloats(proj, glm::value_ptr(projection), 16);
+            PyJ3D::Buffers::ReadFloats(view, glm::value_ptr(viewm4), 16);
+            renderer.SetCamera(projection, viewm4);
+        }, "Set Projection and View Matrices this renderer draws with", py::arg("proj"), py::arg("view"), RegistryGuard())
+        .def_property_readonly("view", py::cpp_function([](PyJ3D::Renderer& renderer){ return CopyMatrix(renderer.GetView()); }, RegistryGuard()))
+        .def_property_readonly("projection", py::cpp_function([](PyJ3D::Renderer& renderer){ return CopyMatrix(renderer.GetProj()); }, RegistryGuard()))
+        .def("submit", py::overload_cast<const std::shared_ptr<J3DModelInstance>&>(&PyJ3D::Renderer::Submit), "Queue an instance for the next render, waits for a render in progress", py::arg("instance"), RegistryGuard())
+        .def("submit", py::overload_cast<const std::vector<std::shared_ptr<J3DModelInstance>>&>(&PyJ3D::Renderer::Submit), "Queue instances for the next render", py::arg("instances"), RegistryGuard())
+        .def("clearBatch", &PyJ3D::Renderer::ClearBatch, RegistryGuard())
+        .def("__len__", &PyJ3D::Renderer::GetBatchSize, RegistryGuard())
+        .def_property("sortMode", py::cpp_function(&PyJ3D::Renderer::GetSortMode, RegistryGuard()), py::cpp_function(&PyJ3D::Renderer::SetSortMode, RegistryGuard()))
+        .def_property("picking", py::cpp_function(&PyJ3D::Renderer::GetPicking, RegistryGuard()), py::cpp_function(&PyJ3D::Renderer::SetPicking, RegistryGuard()), "Run the picking pass and resolve queued picks, only the default renderer does by default")
+        .def("setAnimationLod", [](PyJ3D::Renderer& renderer, bool enabled, float nearDistance, float farDistance, uint32_t midInterval, uint32_t farInterval, bool interpolate){
+            renderer.SetAnimationLod(MakeLodPolicy(enabled, nearDistance, farDistance, midInterval, farInterval, interpolate));
+        }, "Override the global animation level of detail policy for this renderer", py::arg("enabled") = true, py::arg("nearDistance") = 1000.0f, py::arg("farDistance") = 4000.0f, py::arg("midInterval") = 2, py::arg("farInterval") = 4, py::arg("interpolate") = true, RegistryGuard())
+        .def("clearAnimationLod", &PyJ3D::Renderer::ClearAnimationLod, "Use the global animation level of detail policy again", RegistryGuard())
+        .def("render", [](PyJ3D::Renderer& renderer, float dt, std::array<float, 3> cameraPos, bool renderPicking){
+            if(!init) throw std::runtime_error("J3DUltra hasn't been initialised");
+            py::gil_scoped_release release;
+            renderer.Render(dt, glm::vec3(cameraPos[0], cameraPos[1], cameraPos[2]), renderPicking);
+        }, "Render the submitted instances into the bound framebuffer", py::arg("dt"), py::arg("cameraPos"), py::arg("renderPicking") = false)
+        .def("renderScene", [](PyJ3D::Renderer& renderer, PyJ3D::Scene& scene, float dt, std::array<float, 3> cameraPos, bool renderPicking){
+            if(!init) throw std::runtime_error("J3DUltra hasn't been initialised");
+            py::gil_scoped_release release;
+            renderer.RenderScene(scene, dt, glm::vec3(cameraPos[0], cameraPos[1], cameraPos[2]), renderPicking);
+        }, "Render every visible instance in the scene into the bound framebuffer", py::arg("scene"), py::arg("dt"), py::arg("cameraPos"), py::arg("renderPicking") = false)
+        .def("renderViews", [](PyJ3D::Renderer& renderer, FloatArray views, py::buffer proj, uint32_t width, uint32_t height, std::array<float, 4> clearColor, bool readDepth, float dt){
+            return RenderViews(renderer, nullptr, dt, views, proj, width, height, clearColor, readDepth);
+        }, "Render the submitted instances once per view matrix offscreen, animating once with dt for all of them. Returns (color, depth or None) numpy arrays",
+             py::arg("views"), py::arg("proj"), py::arg("width"), py::arg("height"), py::arg("clearColor") = std::array<float, 4>{ 0.0f, 0.0f, 0.0f, 0.0f }, py::arg("depth") = false, py::arg("dt") = 0.0f)
+        .def("renderSceneViews", [](PyJ3D::Renderer& renderer, PyJ3D::Scene& scene, FloatArray views, py::buffer proj, uint32_t width, uint32_t height, std::array<float, 4> clearColor, bool readDepth, float dt){
+            return RenderViews(renderer, &scene, dt, views, proj, width, height, clearColor, readDepth);
+        }, "Render the scene once per view matrix offscreen, animating once with dt for all of them. Returns (color, depth or None) numpy arrays",
+             py::arg("scene"), py::arg("views"), py::arg("proj"), py::arg("width"), py::arg("height"), py::arg("clearColor") = std::array<float, 4>{ 0.0f, 0.0f, 0.0f, 0.0f }, py::arg("depth") = false, py::arg("dt") = 0.0f)
+        .def("getStats", &GetRendererStats, "Views, instances animated and drawn, packets and CPU time of the last render", RegistryGuard())
+        .def("destroy", [](PyJ3D::Renderer& renderer){
+            if(!init) return;
+            PyJ3D::RegistryLock registry;
+            PyJ3D::ContextLock context;
+            renderer.Destroy();
+        }, "Free the offscreen target now instead of at cleanup");
+
+    py::enum_<PyJ3D::JointAnimation::LoopMode>(m, "LoopMode")
+        .value("Once", PyJ3D::JointAnimation::LoopMode::Once)
+        .value("OnceReset", PyJ3D::JointAnimation::LoopMode::OnceReset)
+        .value("Loop", PyJ3D::JointAnimation::LoopMode::Loop)
+        .value("MirroredOnce", PyJ3D::JointAnimation::LoopMode::MirroredOnce)
+        .value("MirroredLoop", PyJ3D::JointAnimation::LoopMode::MirroredLoop);
+
+    py::enum_<PyJ3D::JointAnimation::BlendMode>(m, "BlendMode")
+        .value("Override", PyJ3D::JointAnimation::BlendMode::Override)
+        .value("Additive", PyJ3D::JointAnimation::BlendMode::Additive);
+
+    py::class_<PyJ3D::JointAnimation::JointClip, std::shared_ptr<PyJ3D::JointAnimation::JointClip>>(m, "JointClip")
+        .def("duration", [](const PyJ3D::JointAnimation::JointClip& clip){ return clip.Duration; }, "Length in frames")
+        .def("jointCount", [](const PyJ3D::JointAnimation::JointClip& clip){ return clip.JointCount; })
+        .def("loopMode", [](const PyJ3D::JointAnimation::JointClip& clip){ return clip.Loop; })
+        .def("trackCount", [](const PyJ3D::JointAnimation::JointClip& clip){ return clip.Tracks.size(); }, "Animated components, constant ones aren't counted")
+        .def("memorySize", &PyJ3D::JointAnimation::JointClip::GetMemorySize, "Bytes held by the clip's keys and tracks");
+
     py::class_<J3DModelInstance, std::shared_ptr<J3DModelInstance>>(m, "J3DModelInstance")
-        .def(py::init<std::shared_ptr<J3DModelData>, uint16_t>())
-        .def("render", &renderModel)
-        .def("setLight", &setLight, "Set Scene Light for J3D Render Functions")
-        // These don't work yet
-        .def("setTranslation", &setTranslation)
-        .def("setRotation", &setRotation)
-        .def("setScale", &setScale)
-        .def("isClicked", &isClicked)
-        .def("attachBrk", py::overload_cast<std::shared_ptr<J3DModelInstance>, py::bytes>(&attachBrk), py::kw_only(), py::arg("data"))
-        .def("attachBrk", py::overload_cast<std::shared_ptr<J3DModelInstance>, std::string>(&attachBrk), py::kw_only(), py::arg("path"))
-        .def("attachBrk", &J3DModelInstance::SetRegisterColorAnimation, py::kw_only(), py::arg("anim"))
-        .def("getBrk", &J3DModelInstance::GetRegisterColorAnimation)
-        .def("attachBtp", py::overload_cast<std::shared_ptr<J3DModelInstance>, py::bytes>(&attachBtp), py::kw_only(), py::arg("data"))
-        .def("attachBtp", py::overload_cast<std::shared_ptr<J3DModelInstance>, std::string>(&attachBtp), py::kw_only(), py::arg("path"))
-        .def("attachBtp", &J3DModelInstance::SetTexIndexAnimation, py::kw_only(), py::arg("anim"))
-        .def("getBtp", &J3DModelInstance::GetTexIndexAnimation)
-        .def("attachBtk", py::overload_cast<std::shared_ptr<J3DModelInstance>, py::bytes>(&attachBtk), py::kw_only(), py::arg("data"))
-        .def("attachBtk", py::overload_cast<std::shared_ptr<J3DModelInstance>, std::string>(&attachBtk), py::kw_only(), py::arg("path"))
-        .def("attachBtk", &J3DModelInstance::SetTexMatrixAnimation, py::kw_only(), py::arg("anim"))
-        .def("getBtk", &J3DModelInstance::GetTexMatrixAnimation)
-        .def("attachBck", py::overload_cast<std::shared_ptr<J3DModelInstance>, py::bytes>(&attachBck), py::kw_only(), py::arg("data"))
-        .def("attachBck", py::overload_cast<std::shared_ptr<J3DModelInstance>, std::string>(&attachBck), py::kw_only(), py::arg("path"))
-        .def("attachBck", &J3DModelInstance::SetJointAnimation, py::kw_only(), py::arg("anim"))
-        .def("getBck", &J3DModelInstance::GetJointAnimation)
-        .def("attachBca", py::overload_cast<std::shared_ptr<J3DModelInstance>, py::bytes>(&attachBca), py::kw_only(), py::arg("data"))
-        .def("attachBca", py::overload_cast<std::shared_ptr<J3DModelInstance>, std::string>(&attachBca), py::kw_only(), py::arg("path"))
-        .def("attachBca", &J3DModelInstance::SetJointFullAnimation, py::kw_only(), py::arg("anim"))
-        .def("getBca", &J3DModelInstance::GetJointFullAnimation)
-        .def("attachBva", py::overload_cast<std::shared_ptr<J3DModelInstance>, py::bytes>(&attachBva), py::kw_only(), py::arg("data"))
-        .def("attachBva", py::overload_cast<std::shared_ptr<J3DModelInstance>, std::string>(&attachBva), py::kw_only(), py::arg("path"))
-        .def("attachBva", &J3DModelInstance::SetVisibilityAnimation, py::kw_only(), py::arg("anim"))
-        .def("getBva", &J3DModelInstance::GetVisibilityAnimation)
+        .def(py::init([](std::shared_ptr<J3DModelData> data, uint16_t id){
+            std::shared_ptr<J3DModelInstance> instance = std::make_shared<J3DModelInstance>(data, id);
+            PyJ3D::Instances::Register(instance, data);
+            return instance;
+        }), RegistryGuard())
+        .def("render", &renderModel, RegistryGuard())
+        .def("setLight", &setLight, "Set Scene Light for J3D Render Functions", RegistryGuard())
+        .def("setTranslation", py::overload_cast<std::shared_ptr<J3DModelInstance>, float, float, float>(&setTranslation), RegistryGuard())
+        .def("setTranslation", py::overload_cast<std::shared_ptr<J3DModelInstance>, py::buffer>(&setTranslation), RegistryGuard())
+        .def("setRotation", py::overload_cast<std::shared_ptr<J3DModelInstance>, float, float, float>(&setRotation), RegistryGuard())
+        .def("setRotation", py::overload_cast<std::shared_ptr<J3DModelInstance>, py::buffer>(&setRotation), RegistryGuard())
+        .def("setScale", py::overload_cast<std::shared_ptr<J3DModelInstance>, float, float, float>(&setScale), RegistryGuard())
+        .def("setScale", py::overload_cast<std::shared_ptr<J3DModelInstance>, py::buffer>(&setScale), RegistryGuard())
+        .def("setTransform", &setTransform, "Set translation, rotation and scale from a 4x4 matrix buffer", RegistryGuard())
+        .def("isClicked", &isClicked, GlGuard())
+        .def("attachBrk", py::overload_cast<std::shared_ptr<J3DModelInstance>, py::buffer>(&attachBrk), py::kw_only(), py::arg("data"), RegistryGuard())
+        .def("attachBrk", py::overload_cast<std::shared_ptr<J3DModelInstance>, std::string>(&attachBrk), py::kw_only(), py::arg("path"), RegistryGuard())
+        .def("attachBrk", &J3DModelInstance::SetRegisterColorAnimation, py::kw_only(), py::arg("anim"), RegistryGuard())
+        .def("getBrk", &J3DModelInstance::GetRegisterColorAnimation, RegistryGuard())
+        .def("attachBtp", py::overload_cast<std::shared_ptr<J3DModelInstance>, py::buffer>(&attachBtp), py::kw_only(), py::arg("data"), RegistryGuard())
+        .def("attachBtp", py::overload_cast<std::shared_ptr<J3DModelInstance>, std::string>(&attachBtp), py::kw_only(), py::arg("path"), RegistryGuard())
+        .def("attachBtp", &J3DModelInstance::SetTexIndexAnimation, py::kw_only(), py::arg("anim"), RegistryGuard())
+        .def("getBtp", &J3DModelInstance::GetTexIndexAnimation, RegistryGuard())
+        .def("attachBtk", py::overload_cast<std::shared_ptr<J3DModelInstance>, py::buffer>(&attachBtk), py::kw_only(), py::arg("data"), RegistryGuard())
+        .def("attachBtk", py::overload_cast<std::shared_ptr<J3DModelInstance>, std::string>(&attachBtk), py::kw_only(), py::arg("path"), RegistryGuard())
+        .def("attachBtk", &J3DModelInstance::SetTexMatrixAnimation, py::kw_only(), py::arg("anim"), RegistryGuard())
+        .def("getBtk", &J3DModelInstance::GetTexMatrixAnimation, RegistryGuard())
+        .def("attachBck", py::overload_cast<std::shared_ptr<J3DModelInstance>, py::buffer>(&attachBck), py::kw_only(), py::arg("data"), RegistryGuard())
+        .def("attachBck", py::overload_cast<std::shared_ptr<J3DModelInstance>, std::string>(&attachBck), py::kw_only(), py::arg("path"), RegistryGuard())
+        .def("attachBck", py::overload_cast<std::shared_ptr<J3DModelInstance>, std::shared_ptr<J3DAnimation::J3DJointAnimationInstance>>(&attachBck), py::kw_only(), py::arg("anim"), RegistryGuard())
+        .def("getBck", [](std::shared_ptr<J3DModelInstance> instance){ return PyJ3D::JointAnimation::GetJointAnimation(instance.get()); }, RegistryGuard())
+        .def("attachBca", py::overload_cast<std::shared_ptr<J3DModelInstance>, py::buffer>(&attachBca), py::kw_only(), py::arg("data"), RegistryGuard())
+        .def("attachBca", py::overload_cast<std::shared_ptr<J3DModelInstance>, std::string>(&attachBca), py::kw_only(), py::arg("path"), RegistryGuard())
+        .def("attachBca", py::overload_cast<std::shared_ptr<J3DModelInstance>, std::shared_ptr<J3DAnimation::J3DJointFullAnimationInstance>>(&attachBca), py::kw_only(), py::arg("anim"), RegistryGuard())
+        .def("getBca", [](std::shared_ptr<J3DModelInstance> instance){ return PyJ3D::JointAnimation::GetJointFullAnimation(instance.get()); }, RegistryGuard())
+        .def("attachBva", py::overload_cast<std::shared_ptr<J3DModelInstance>, py::buffer>(&attachBva), py::kw_only(), py::arg("data"), RegistryGuard())
+        .def("attachBva", py::overload_cast<std::shared_ptr<J3DModelInstance>, std::string>(&attachBva), py::kw_only(), py::arg("path"), RegistryGuard())
+        .def("attachBva", &J3DModelInstance::SetVisibilityAnimation, py::kw_only(), py::arg("anim"), RegistryGuard())
+        .def("getBva", &J3DModelInstance::GetVisibilityAnimation, RegistryGuard())
+        .def("attachJointClip", &attachJointClip, "Play a shared clip on this instance. Takes the BCK or BCA slot matching the clip, loop defaults to the clip's own mode",
+             py::kw_only(), py::arg("clip"), py::arg("speed") = 1.0f, py::arg("loop") = py::none(), RegistryGuard())
+        .def("detachJointClip", [](std::shared_ptr<J3DModelInstance> instance){ PyJ3D::JointAnimation::Attach(instance.get(), nullptr); }, RegistryGuard())
+        .def("setClipFrame", [](std::shared_ptr<J3DModelInstance> instance, float frame){ if(auto player = GetClipPlayer(instance)) player->Frame = frame; }, "Jump this instance's clip to a frame", py::arg("frame"), RegistryGuard())
+        .def("setClipSpeed", [](std::shared_ptr<J3DModelInstance> instance, float speed){ if(auto player = GetClipPlayer(instance)) player->Speed = speed; }, "Playback rate of this instance's clip, negative plays backwards", py::arg("speed"), RegistryGuard())
+        .def("setClipLoop", [](std::shared_ptr<J3DModelInstance> instance, PyJ3D::JointAnimation::LoopMode loop){ if(auto player = GetClipPlayer(instance)) player->Loop = loop; }, py::arg("loop"), RegistryGuard())
+        .def("setClipPaused", [](std::shared_ptr<J3DModelInstance> instance, bool paused){ if(auto player = GetClipPlayer(instance)) player->Paused = paused; }, py::arg("paused"), RegistryGuard())
+        .def("getClipFrame", [](std::shared_ptr<J3DModelInstance> instance){ auto player = GetClipPlayer(instance); return player != nullptr ? PyJ3D::JointAnimation::GetPlayerFrame(*player) : 0.0f; }, "Current frame of this instance's clip", RegistryGuard())
+        .def("getClipState", &getClipState, "This instance's clip player as a dict (frame, speed, loop, paused, weight), None without a clip", RegistryGuard())
+        .def("crossfadeJointClip", &crossfadeJointClip, "Fade from the current clip to another over duration seconds, blended natively each frame",
+             py::kw_only(), py::arg("clip"), py::arg("duration"), py::arg("speed") = 1.0f, py::arg("loop") = py::none(), RegistryGuard())
+        .def("setClipWeight", [](std::shared_ptr<J3DModelInstance> instance, float weight, float fade){ if(auto player = GetClipPlayer(instance)) PyJ3D::JointAnimation::FadeWeight(*player, weight, fade); },
+             "Base clip's weight against override layers, reached over fade seconds", py::arg("weight"), py::arg("fade") = 0.0f, RegistryGuard())
+        .def("addJointLayer", &addJointLayer, "Blend another clip over the base clip, returns the layer id (0 on failure)",
+             py::kw_only(), py::arg("clip"), py::arg("weight") = 1.0f, py::arg("mode") = PyJ3D::JointAnimation::BlendMode::Override, py::arg("speed") = 1.0f, py::arg("loop") = py::none(), RegistryGuard())
+        .def("setJointLayerWeight", &setJointLayerWeight, "Move a layer's weight over fade seconds, False if the id is unknown", py::arg("id"), py::arg("weight"), py::arg("fade") = 0.0f, RegistryGuard())
+        .def("removeJointLayer", [](std::shared_ptr<J3DModelInstance> instance, uint32_t id){ return PyJ3D::JointAnimation::RemoveLayer(instance.get(), id); }, py::arg("id"), RegistryGuard())
+        .def("getJointLayers", &getJointLayers, "Blend layers as a list of dicts (id, mode, weight, targetWeight, frame, fadingOut)", RegistryGuard())
+        .def("getTextureStats", &getTextureStats, "Texture upload stats from when this instance's model was parsed, None if unknown", RegistryGuard())
     ;
     
-    m.def("loadModel", py::overload_cast<std::string>(&LoadJ3DModel), "Load BMD/BDL from filepath", py::kw_only(), py::arg("path"));
-    m.def("loadModel", py::overload_cast<py::bytes>(&LoadJ3DModel), "Load BMD/BDL from bytes object", py::kw_only(), py::arg("data"));
+    m.def("loadModel", py::overload_cast<std::string, bool>(&LoadJ3DModel), "Load BMD/BDL from filepath", py::kw_only(), py::arg("path"), py::arg("cache") = true, GlGuard());
+    m.def("loadModel", py::overload_cast<py::buffer, bool>(&LoadJ3DModel), "Load BMD/BDL from any bytes-like buffer", py::kw_only(), py::arg("data"), py::arg("cache") = true, GlGuard());
+
+    m.def("setModelCacheBudget", &SetModelCacheBudget, "Evict cached models once their source files and uploaded textures add up to more than bytes, 0 for unlimited", py::arg("bytes"), GlGuard());
+    m.def("getModelCacheStats", &GetModelCacheStats, "Get model cache hit/miss/eviction counters");
+    m.def("clearModelCache", &ClearModelCache, "Drop all cached model data", GlGuard());
+    m.def("setDiskCache", &SetDiskCache, "Keep derived model data and shader program binaries in a directory across runs, empty path disables", py::arg("path"));
+    m.def("getDiskCacheStats", &GetDiskCacheStats, "Get disk cache hit/miss/write counters");
+    m.def("clearDiskCache", &PyJ3D::DiskCache::Clear, "Delete every entry in the disk cache directory");
+    m.def("getShaderCacheStats", &GetShaderCacheStats, "Get material program counters: binaries kept, programs linked, reused or loaded from disk, compiles avoided", RegistryGuard());
+    m.def("clearShaderCache", &PyJ3D::ShaderCache::ClearUnused, "Drop kept material program binaries no loaded model uses, returns how many were freed", GlGuard());
+    m.def("prewarmShaders", &PrewarmShaders, "Compile the material programs of BMD/BDL files ahead of time so later loads reuse their binaries", py::arg("paths"), GlGuard());
+    m.def("setCompressedTextures", &PyJ3D::TextureUpload::SetCompressedUpload, "Upload CMPR textures as BC1 when the context supports S3TC, applies to models parsed afterwards", py::arg("enabled"), RegistryGuard());
+    m.def("getTextureUploadStats", &GetTextureUploadStats, "Get texture upload totals over every parsed model", RegistryGuard());
+    m.def("resetTextureUploadStats", &PyJ3D::TextureUpload::ResetTotals, "Zero the texture upload totals", RegistryGuard());
+    m.def("getTextures", py::overload_cast<const std::string&>(&GetTextures), "List a BMD/BDL's TEX1 textures from filepath", py::kw_only(), py::arg("path"));
+    m.def("getTextures", py::overload_cast<py::buffer>(&GetTextures), "List a BMD/BDL's TEX1 textures from any bytes-like buffer", py::kw_only(), py::arg("data"));
+    m.def("decodeTexture", py::overload_cast<const std::string&, uint32_t, uint32_t>(&DecodeTexture), "Decode one TEX1 texture level from filepath to an (h, w, 4) RGBA8 array",
+          py::kw_only(), py::arg("path"), py::arg("index"), py::arg("level") = 0);
+    m.def("decodeTexture", py::overload_cast<py::buffer, uint32_t, uint32_t>(&DecodeTexture), "Decode one TEX1 texture level from any bytes-like buffer to an (h, w, 4) RGBA8 array",
+          py::kw_only(), py::arg("data"), py::arg("index"), py::arg("level") = 0);
     
+    m.def("loadModelAsync", py::overload_cast<std::string, bool>(&LoadJ3DModelAsync), "Queue a BMD/BDL load from filepath, finished by pumpUploads", py::kw_only(), py::arg("path"), py::arg("cache") = true);
+    m.def("loadModelAsync", py::overload_cast<py::buffer, bool>(&LoadJ3DModelAsync), "Queue a BMD/BDL load from any bytes-like buffer, finished by pumpUploads", py::kw_only(), py::arg("data"), py::arg("cache") = true);
+    m.def("loadAnimationAsync", py::overload_cast<std::string>(&LoadAnimationAsync), "Parse any J3D animation from filepath on a worker thread", py::kw_only(), py::arg("path"));
+    m.def("loadAnimationAsync", py::overload_cast<py::buffer>(&LoadAnimationAsync), "Parse any J3D animation from any bytes-like buffer on a worker thread", py::kw_only(), py::arg("data"));
+    m.def("pumpUploads", &PumpUploads, "Finish queued model loads on the GL thread for up to budget_ms", py::arg("budget_ms") = 2.0f);
+    m.def("pendingUploads", &PyJ3D::AsyncLoader::GetPendingCount, "Number of model loads waiting for pumpUploads");
+
     m.def("loadBrk", py::overload_cast<std::string>(&LoadBrk), "Load BRK from filepath", py::kw_only(), py::arg("path"));
-    m.def("loadBrk", py::overload_cast<py::bytes>(&LoadBrk), "Load BRK from bytes object", py::kw_only(), py::arg("data"));
+    m.def("loadBrk", py::overload_cast<py::buffer>(&LoadBrk), "Load BRK from any bytes-like buffer", py::kw_only(), py::arg("data"));
     m.def("loadBtp", py::overload_cast<std::string>(&LoadBtp), "Load BTP from filepath", py::kw_only(), py::arg("path"));
-    m.def("loadBtp", py::overload_cast<py::bytes>(&LoadBtp), "Load BTP from bytes object", py::kw_only(), py::arg("data"));
+    m.def("loadBtp", py::overload_cast<py::buffer>(&LoadBtp), "Load BTP from any bytes-like buffer", py::kw_only(), py::arg("data"));
     m.def("loadBtk", py::overload_cast<std::string>(&LoadBtk), "Load BTK from filepath", py::kw_only(), py::arg("path"));
-    m.def("loadBtk", py::overload_cast<py::bytes>(&LoadBtk), "Load BTK from bytes object", py::kw_only(), py::arg("data"));
+    m.def("loadBtk", py::overload_cast<py::buffer>(&LoadBtk), "Load BTK from any bytes-like buffer", py::kw_only(), py::arg("data"));
     m.def("loadBck", py::overload_cast<std::string>(&LoadBck), "Load BCK from filepath", py::kw_only(), py::arg("path"));
-    m.def("loadBck", py::overload_cast<py::bytes>(&LoadBck), "Load BCK from bytes object", py::kw_only(), py::arg("data"));
+    m.def("loadBck", py::overload_cast<py::buffer>(&LoadBck), "Load BCK from any bytes-like buffer", py::kw_only(), py::arg("data"));
     m.def("loadBca", py::overload_cast<std::string>(&LoadBca), "Load BCA from filepath", py::kw_only(), py::arg("path"));
-    m.def("loadBca", py::overload_cast<py::bytes>(&LoadBca), "Load BCA from bytes object", py::kw_only(), py::arg("data"));
+    m.def("loadBca", py::overload_cast<py::buffer>(&LoadBca), "Load BCA from any bytes-like buffer", py::kw_only(), py::arg("data"));
     m.def("loadBva", py::overload_cast<std::string>(&LoadBva), "Load BVA from filepath", py::kw_only(), py::arg("path"));
-    m.def("loadBva", py::overload_cast<py::bytes>(&LoadBva), "Load BVA from bytes object", py::kw_only(), py::arg("data"));
+    m.def("loadBva", py::overload_cast<py::buffer>(&LoadBva), "Load BVA from any bytes-like buffer", py::kw_only(), py::arg("data"));
+    m.def("loadJointClip", py::overload_cast<std::string, bool, bool>(&LoadJointClip), "Load a BCK/BCA as a clip shared between instances, None if it isn't a joint animation. lossless=False packs scale/translation keys to 16 bits where that stays within a fixed tolerance", py::kw_only(), py::arg("path"), py::arg("lossless") = true, py::arg("cache") = true, RegistryGuard());
+    m.def("loadJointClip", py::overload_cast<py::buffer, bool, bool>(&LoadJointClip), "Load a BCK/BCA as a clip shared between instances from any bytes-like buffer", py::kw_only(), py::arg("data"), py::arg("lossless") = true, py::arg("cache") = true, RegistryGuard());
+    m.def("getJointClipCacheStats", &GetJointClipCacheStats, "Get joint clip cache hit/miss counters and the clips still alive", RegistryGuard());
+    m.def("clearJointClipCache", &PyJ3D::JointAnimation::ClearCache, "Forget cached clips, clips in use stay alive", RegistryGuard());
+    m.def("getJointAnimationStats", &GetJointAnimationStats, "Get joint clip evaluation counters from the last render", RegistryGuard());
     
-    m.def("init", &InitJ3DUltra, "Setup J3DUltra for Model Loading and Rendering");
-    m.def("cleanup", &CleanupJ3DUltra, "Cleanup J3DUltra Library");
-    m.def("setCamera", &SetCamera, "Set Projection and View Matrices to render with");
+    m.def("setTranslations", [](std::vector<std::shared_ptr<J3DModelInstance>> instances, FloatArray values){ SetInstanceVectors(instances, values, PyJ3D::Transforms::Component::Translation); }, "Set translations from an (N, 3) float32 array", py::arg("instances"), py::arg("values"), RegistryGuard());
+    m.def("setRotations", [](std::vector<std::shared_ptr<J3DModelInstance>> instances, FloatArray values){ SetInstanceVectors(instances, values, PyJ3D::Transforms::Component::Rotation); }, "Set rotations from an (N, 3) float32 array", py::arg("instances"), py::arg("values"), RegistryGuard());
+    m.def("setScales", [](std::vector<std::shared_ptr<J3DModelInstance>> instances, FloatArray values){ SetInstanceVectors(instances, values, PyJ3D::Transforms::Component::Scale); }, "Set scales from an (N, 3) float32 array", py::arg("instances"), py::arg("values"), RegistryGuard());
+    m.def("setTransforms", &SetInstanceTransforms, "Set transforms from an (N, 4, 4) float32 array", py::arg("instances"), py::arg("matrices"), RegistryGuard());
+
+    m.def("initHeadless", &InitJ3DUltraHeadless, "Initialize J3DUltra with its own surfaceless EGL context, no window needed", SetupGuard());
+    m.def("init", &InitJ3DUltra, "Setup J3DUltra for Model Loading and Rendering", SetupGuard());
+    m.def("cleanup", &CleanupJ3DUltra, "Cleanup J3DUltra Library", SetupGuard());
+    m.def("setCamera", py::overload_cast<py::buffer, py::buffer>(&SetCamera), "Set Projection and View Matrices to render with", GlGuard());
+    m.def("setCamera", py::overload_cast<std::vector<float>, std::vector<float>>(&SetCamera), "Set Projection and View Matrices to render with", GlGuard());
+    m.def("getViewMatrix", [](){ return GetMatrixView(defaultRenderer->GetView()); }, "Read-only numpy view of the current view matrix", RegistryGuard());
+    m.def("getProjMatrix", [](){ return GetMatrixView(defaultRenderer->GetProj()); }, "Read-only numpy view of the current projection matrix", RegistryGuard());
+    m.def("getDefaultRenderer", [](){ return defaultRenderer; }, "The renderer setCamera, renderModel and render use");
+    m.def("releaseContext", &PyJ3D::Headless::ReleaseCurrent, "Release the headless context from this thread so renderers on other threads can use it", SetupGuard());
+    m.def("acquireContext", &AcquireContext, "Make the headless context current on this thread again, for loading models after releaseContext", SetupGuard());
     
+    m.def("renderViews", &RenderInstanceViews, "Render the instances once per view matrix offscreen, returns (color (N, H, W, 4) uint8, depth (N, H, W) float32 or None)",
+          py::arg("instances"), py::arg("views"), py::arg("proj"), py::arg("width"), py::arg("height"), py::arg("clearColor") = std::array<float, 4>{ 0.0f, 0.0f, 0.0f, 0.0f }, py::arg("depth") = false);
     m.def("render", &RenderScene, "Execute all pending model renders");
-
-    m.def("resizePicking", &ResizePickingFB, "");
-    m.def("queryPicking", &QueryPicking, "");
-    m.def("initPicking", &InitPicking, "");
+    m.def("beginFrame", &PyJ3D::FrameClock::BeginFrame, "Start a new frame, after the first call renders in between share one frame for animation ticks and level of detail", RegistryGuard());
+    m.def("setCulling", &SetCulling, "Configure CPU culling before packet sorting (off by default), 0 disables the distance and screen size tests", py::arg("enabled") = true, py::arg("maxDistance") = 0.0f, py::arg("minScreenSize") = 0.0f, py::arg("boundsScale") = 1.0f, py::arg("animatedBoundsScale") = 2.0f, RegistryGuard());
+    m.def("getCullingStats", &GetCullingStats, "Get culling counters from the last render", RegistryGuard());
+    m.def("setAnimationLod", &SetAnimationLod, "Tick distant instances' animations every midInterval/farInterval frames, an animation shared with a near instance keeps running. With interpolate, joint clips blend between their samples instead of holding", py::arg("enabled") = true, py::arg("nearDistance") = 1000.0f, py::arg("farDistance") = 4000.0f, py::arg("midInterval") = 2, py::arg("farInterval") = 4, py::arg("interpolate") = true, RegistryGuard());
+    m.def("getAnimationLodStats", &GetAnimationLodStats, "Get animation level of detail counters from the last render", RegistryGuard());
+    m.def("setProfiling", &SetProfiling, "Record per-stage CPU/GPU timings and GL counters for the last history renders, needs init", py::arg("enabled") = true, py::arg("gpuTimers") = true, py::arg("history") = 120, GlGuard());
+    m.def("isProfiling", &PyJ3D::Profiler::IsEnabled, "Whether setProfiling is recording");
+    m.def("getFrameStats", &GetFrameStats, "Get timings in ms and counters of the last profiled render, None before the first one");
+    m.def("getFrameHistory", &GetFrameHistory, "Get every profiled render still in the history, oldest first");
+    m.def("writeChromeTrace", &WriteChromeTrace, "Write the profiled history as a Chrome trace event JSON file", py::arg("path"));
+    m.attr("profilingAvailable") = (bool)PYJ3D_PROFILING;
+    m.def("getCpuFeatures", &GetCpuFeatures, "Get the detected CPU features and the SIMD level the culling and animation kernels run at");
+    m.def("setSimdLevel", &PyJ3D::Simd::SetLevel, "Run the kernels at a lower SIMD level, or back up to the supported one, returns the level in use", py::arg("level"), RegistryGuard());
+    m.def("setSortMode", &SetSortMode, "Select the render packet sort, Keyed (default) or Name", py::arg("mode"), RegistryGuard());
+
+    m.def("resizePicking", &ResizePickingFB, "", GlGuard());
+    m.def("queryPicking", &QueryPicking, "", GlGuard());
+    m.def("raycast", &Raycast, "Nearest hit of a world space ray against the instances' geometry, posed by their joint clips, None on a miss", py::arg("instances"), py::arg("origin"), py::arg("direction"), py::arg("maxDistance") = INFINITY, RegistryGuard());
+    m.def("screenRay", &ScreenRay, "World space (origin, direction) through a framebuffer pixel using the current camera", py::arg("x"), py::arg("y"), py::arg("width"), py::arg("height"), RegistryGuard());
+    m.def("pick", [](int32_t x, int32_t y){ return PyJ3D::PickQueue::Request(x, y, 1, 1); }, "Queue a pick at a framebuffer pixel (origin bottom left), resolved a frame after the next render", py::arg("x"), py::arg("y"), RegistryGuard());
+    m.def("pickRegion", &PyJ3D::PickQueue::Request, "Queue a pick of every unique (model id, material id) pair in a region", py::arg("x"), py::arg("y"), py::arg("width"), py::arg("height"), RegistryGuard());
+    m.def("pollPicking", &PyJ3D::PickQueue::Poll, "Complete finished pick readbacks without blocking, returns the number completed", GlGuard());
+    m.def("initPicking", &InitPicking, "", GlGuard());
 }
\ No newline at end of file
@@ -0,0 +1,168 @@
+#include "TestUtil.hpp"
+#include "Fixtures.hpp"
+#include "Collision.hpp"
+#include "J3DFile.hpp"
+#include "JointAnimation.hpp"
+
+#include <algorithm>
+#include <random>
+
+using namespace PyJ3D;
+
+static J3DFile::ModelGeometry ReadQuad(){
+    std::vector<uint8_t> file = Tests::MakeSkinnedQuadModel();
+
+    J3DFile::ModelGeometry geometry;
+    CHECK(J3DFile::ReadModelGeometry(file.data(), file.size(), geometry));
+    return geometry;
+}
+
+// Rest pose of the fixture's two joints, laid out like JointAnimation::Sample's output.
+static std::vector<float> MakeRestPose(){
+    const uint32_t jointCount = 2;
+    std::vector<float> pose(JointAnimation::ComponentCount * jointCount, 0.0f);
+    for(uint32_t joint = 0; joint < jointCount; joint++){
+        pose[JointAnimation::ScaleX * jointCount + joint] = 1.0f;
+        pose[JointAnimation::ScaleY * jointCount + joint] = 1.0f;
+        pose[JointAnimation::ScaleZ * jointCount + joint] = 1.0f;
+    }
+    pose[JointAnimation::TranslationZ * jointCount + 1] = 5.0f;
+    return pose;
+}
+
+PYJ3D_TEST(GeometryPlacesRigidVerticesByTheirJoint){
+    J3DFile::ModelGeometry geometry = ReadQuad();
+
+    CHECK(geometry.Vertices.size() == 6);
+    CHECK(geometry.VertexDraws.size() == geometry.Vertices.size());
+    CHECK(geometry.JointParents.size() == 2 && geometry.JointParents[0] == -1 && geometry.JointParents[1] == 0);
+    for(const glm::vec3& vertex : geometry.Vertices){
+        CHECK_NEAR(vertex.z, 5.0f, 1e-6);
+    }
+}
+
+// Nearest hit over every triangle on its own, the reference the hierarchy has to agree with.
+static float NearestByLinearScan(const J3DFile::ModelGeometry& geometry, const glm::vec3& origin, const glm::vec3& dir){
+    float nearest = INFINITY;
+    for(size_t t = 0; t < geometry.Vertices.size() / 3; t++){
+        J3DFile::ModelGeometry single;
+        single.Vertices.assign(geometry.Vertices.begin() + t * 3, geometry.Vertices.begin() + t * 3 + 3);
+        single.Materials = { 0 };
+        single.Shapes = { 0 };
+
+        Collision::TriangleBvh one;
+        one.Build(single);
+        Collision::RayHit oneHit;
+        if(one.Intersect(origin, dir, INFINITY, oneHit)) nearest = std::min(nearest, oneHit.Distance);
+    }
+    return nearest;
+}
+
+PYJ3D_TEST(BvhMatchesBruteForceRaycasts){
+    J3DFile::ModelGeometry geometry = ReadQuad();
+    Collision::TriangleBvh bvh;
+    bvh.Build(geometry);
+
+    // a ray straight through the middle hits the z = 5 plane 15 units out
+    Collision::RayHit hit;
+    CHECK(bvh.Intersect(glm::vec3(0.0f, 0.0f, -10.0f), glm::vec3(0.0f, 0.0f, 1.0f), INFINITY, hit));
+    CHECK_NEAR(hit.Distance, 15.0f, 1e-4);
+    CHECK(!bvh.Intersect(glm::vec3(3.0f, 0.0f, -10.0f), glm::vec3(0.0f, 0.0f, 1.0f), INFINITY, hit));
+    CHECK(!bvh.Intersect(glm::vec3(0.0f, 0.0f, -10.0f), glm::vec3(0.0f, 0.0f, 1.0f), 14.0f, hit));
+
+    // every hit the hierarchy reports must be the nearest triangle a linear scan finds
+    std::mt19937 random(1234);
+    std::uniform_real_distribution<float> spread(-1.5f, 1.5f);
+    for(int i = 0; i < 200; i++){
+        glm::vec3 origin(spread(random), spread(random), -10.0f);
+        glm::vec3 dir = glm::vec3(spread(random) * 0.05f, spread(random) * 0.05f, 1.0f);
+
+        float nearest = NearestByLinearScan(geometry, origin, dir);
+        Collision::RayHit bvhHit;
+        bool found = bvh.Intersect(origin, dir, INFINITY, bvhHit);
+        CHECK(found == (nearest != INFINITY));
+        if(found) CHECK_NEAR(bvhHit.Distance, nearest, 1e-4);
+    }
+}
+
+PYJ3D_TEST(PosedBvhFollowsTheJoints){
+    J3DFile::ModelGeometry geometry = ReadQuad();
+    Collision::TriangleBvh bind;
+    bind.Build(geometry);
+    CHECK(bind.GetJointCount() == 2);
+
+    // the rest pose leaves the quad where it was bound
+    std::vector<float> pose = MakeRestPose();
+    Collision::TriangleBvh posed;
+    Collision::RayHit hit;
+    CHECK(posed.Pose(bind, pose.data(), 2));
+    CHECK(posed.Intersect(glm::vec3(0.0f, 0.0f, -10.0f), glm::vec3(0.0f, 0.0f, 1.0f), INFINITY, hit));
+    CHECK_NEAR(hit.Distance, 15.0f, 1e-4);
+
+    // moving the child joint moves the quad with it
+    pose[JointAnimation::TranslationZ * 2 + 1] = 8.0f;
+    CHECK(posed.Pose(bind, pose.data(), 2));
+    CHECK(posed.Intersect(glm::vec3(0.0f, 0.0f, -10.0f), glm::vec3(0.0f, 0.0f, 1.0f), INFINITY, hit));
+    CHECK_NEAR(hit.Distance, 18.0f, 1e-4);
+
+    // turning the root 90 degrees about y swings the quad onto the x = 5 plane
+    pose = MakeRestPose();
+    pose[JointAnimation::RotationY * 2 + 0] = 90.0f;
+    CHECK(posed.Pose(bind, pose.data(), 2));
+    CHECK(!posed.Intersect(glm::vec3(0.0f, 0.0f, -10.0f), glm::vec3(0.0f, 0.0f, 1.0f), INFINITY, hit));
+    CHECK(posed.Intersect(glm::vec3(-10.0f, 0.0f, 0.0f), glm::vec3(1.0f, 0.0f, 0.0f), INFINITY, hit));
+    CHECK_NEAR(hit.Distance, 15.0f, 1e-4);
+
+    // a pose for another skeleton is refused
+    CHECK(!posed.Pose(bind, pose.data(), 3));
+}
+
+PYJ3D_TEST(DeepBvhMatchesBruteForceRaycasts){
+    // a 24x24 grid of quads at staggered depths plus a stack of overlapping copies of one quad, enough triangles
+    // for several levels of interior nodes and a leaf that can't be split
+    J3DFile::ModelGeometry geometry;
+    auto addTriangle = [&](glm::vec3 a, glm::vec3 b, glm::vec3 c){
+        geometry.Vertices.insert(geometry.Vertices.end(), { a, b, c });
+        geometry.Materials.push_back((uint16_t)geometry.Materials.size());
+        geometry.Shapes.push_back(0);
+    };
+    for(int y = 0; y < 24; y++){
+        for(int x = 0; x < 24; x++){
+            float z = (float)((x * 7 + y * 13) % 5);
+            glm::vec3 corner((float)x, (float)y, z);
+            addTriangle(corner, corner + glm::vec3(1.0f, 0.0f, 0.0f), corner + glm::vec3(1.0f, 1.0f, 0.0f));
+            addTriangle(corner, corner + glm::vec3(1.0f, 1.0f, 0.0f), corner + glm::vec3(0.0f, 1.0f, 0.0f));
+        }
+    }
+    for(int i = 0; i < 12; i++){
+        addTriangle(glm::vec3(10.0f, 10.0f, -1.0f), glm::vec3(14.0f, 10.0f, -1.0f), glm::vec3(10.0f, 14.0f, -1.0f));
+    }
+
+    Collision::TriangleBvh bvh;
+    bvh.Build(geometry);
+
+    std::mt19937 random(99);
+    std::uniform_real_distribution<float> spread(-1.0f, 25.0f), tilt(-0.3f, 0.3f);
+    for(int i = 0; i < 300; i++){
+        glm::vec3 origin(spread(random), spread(random), -10.0f);
+        glm::vec3 dir(tilt(random), tilt(random), 1.0f);
+
+        float nearest = NearestByLinearScan(geometry, origin, dir);
+        Collision::RayHit hit;
+        bool found = bvh.Intersect(origin, dir, INFINITY, hit);
+        CHECK(found == (nearest != INFINITY));
+        if(found) CHECK_NEAR(hit.Distance, nearest, 1e-4);
+    }
+
+    // shallow rays from the side cross many leaves before the nearest hit
+    for(int i = 0; i < 50; i++){
+        glm::vec3 origin(-5.0f, spread(random), 8.0f);
+        glm::vec3 dir(1.0f, tilt(random) * 0.1f, -0.3f + tilt(random) * 0.2f);
+
+        float nearest = NearestByLinearScan(geometry, origin, dir);
+        Collision::RayHit hit;
+        bool found = bvh.Intersect(origin, dir, INFINITY, hit);
+        CHECK(found == (nearest != INFINITY));
+        if(found) CHECK_NEAR(hit.Distance, nearest, 1e-4);
+    }
+}
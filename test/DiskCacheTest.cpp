@@ -0,0 +1,147 @@
+#include "TestUtil.hpp"
+#include "DiskCache.hpp"
+
+#include <filesystem>
+#include <fstream>
+
+using namespace PyJ3D;
+
+// A fresh cache directory per test, removed again when the test ends.
+struct TempCache {
+    std::filesystem::path Path;
+
+    TempCache(const char* name){
+        Path = std::filesystem::temp_directory_path() / (std::string("pyj3d-test-") + name);
+        std::error_code err;
+        std::filesystem::remove_all(Path, err);
+        DiskCache::SetDirectory(Path.string());
+    }
+
+    ~TempCache(){
+        DiskCache::SetDirectory("");
+        std::error_code err;
+        std::filesystem::remove_all(Path, err);
+    }
+
+    std::filesystem::path GetBlobFile() const {
+        for(const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator(Path)){
+            if(entry.path().extension() == ".bin") return entry.path();
+        }
+        return {};
+    }
+};
+
+static std::vector<uint8_t> ReadAll(const std::filesystem::path& path){
+    std::ifstream file(path, std::ios::binary);
+    return std::vector<uint8_t>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+static void WriteAll(const std::filesystem::path& path, const std::vector<uint8_t>& bytes){
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write((const char*)bytes.data(), bytes.size());
+}
+
+static std::vector<uint8_t> MakePayload(){
+    DiskCache::BlobWriter writer;
+    writer.Write<uint32_t>(7);
+    writer.WriteArray(std::vector<float>{ 1.0f, -2.5f, 1000.0f });
+    return writer.GetBytes();
+}
+
+PYJ3D_TEST(DiskCacheBlobsRoundTrip){
+    TempCache cache("roundtrip");
+    std::vector<uint8_t> payload = MakePayload();
+    DiskCache::DiskCacheStats before = DiskCache::GetStats();
+
+    CHECK(DiskCache::Write(DiskCache::BlobKind::ModelData, 0x1234, payload.data(), payload.size()));
+
+    DiskCache::Blob blob;
+    CHECK(DiskCache::Read(DiskCache::BlobKind::ModelData, 0x1234, blob));
+    CHECK(blob.Size == payload.size());
+    CHECK(blob.Payload != nullptr && std::equal(payload.begin(), payload.end(), blob.Payload));
+
+    DiskCache::BlobReader reader(blob.Payload, blob.Size);
+    std::vector<float> values;
+    CHECK(reader.Read<uint32_t>() == 7);
+    reader.ReadArray(values);
+    CHECK(reader.IsComplete());
+    CHECK(values.size() == 3 && values[1] == -2.5f);
+
+    // same key under another kind or another key under the same kind is a miss
+    DiskCache::Blob other;
+    CHECK(!DiskCache::Read(DiskCache::BlobKind::TextureLevel, 0x1234, other));
+    CHECK(!DiskCache::Read(DiskCache::BlobKind::ModelData, 0x1235, other));
+
+    DiskCache::DiskCacheStats after = DiskCache::GetStats();
+    CHECK(after.Writes == before.Writes + 1);
+    CHECK(after.Hits == before.Hits + 1);
+    CHECK(after.Misses == before.Misses + 2);
+    CHECK(after.Rejected == before.Rejected);
+}
+
+PYJ3D_TEST(DiskCacheRejectsTruncatedBlobs){
+    TempCache cache("truncated");
+    std::vector<uint8_t> payload = MakePayload();
+    CHECK(DiskCache::Write(DiskCache::BlobKind::ModelData, 42, payload.data(), payload.size()));
+
+    std::filesystem::path path = cache.GetBlobFile();
+    std::vector<uint8_t> bytes = ReadAll(path);
+    DiskCache::DiskCacheStats before = DiskCache::GetStats();
+
+    // cut into the payload, then into the header
+    for(size_t size : { bytes.size() - 1, (size_t)8, (size_t)0 }){
+        WriteAll(path, std::vector<uint8_t>(bytes.begin(), bytes.begin() + size));
+        DiskCache::Blob blob;
+        CHECK(!DiskCache::Read(DiskCache::BlobKind::ModelData, 42, blob));
+        CHECK(blob.Payload == nullptr);
+    }
+
+    DiskCache::DiskCacheStats after = DiskCache::GetStats();
+    CHECK(after.Hits == before.Hits);
+    CHECK(after.Misses == before.Misses + 3);
+}
+
+PYJ3D_TEST(DiskCacheRejectsCorruptBlobs){
+    TempCache cache("corrupt");
+    std::vector<uint8_t> payload = MakePayload();
+    CHECK(DiskCache::Write(DiskCache::BlobKind::ModelData, 42, payload.data(), payload.size()));
+
+    std::filesystem::path path = cache.GetBlobFile();
+    std::vector<uint8_t> bytes = ReadAll(path);
+    DiskCache::DiskCacheStats before = DiskCache::GetStats();
+
+    // a flipped payload byte fails the hash, a flipped magic byte fails the header
+    for(size_t offset : { bytes.size() - 1, (size_t)0 }){
+        std::vector<uint8_t> corrupt = bytes;
+        corrupt[offset] ^= 0x5A;
+        WriteAll(path, corrupt);
+
+        DiskCache::Blob blob;
+        CHECK(!DiskCache::Read(DiskCache::BlobKind::ModelData, 42, blob));
+    }
+
+    // rewriting the blob makes it readable again
+    CHECK(DiskCache::Write(DiskCache::BlobKind::ModelData, 42, payload.data(), payload.size()));
+    DiskCache::Blob blob;
+    CHECK(DiskCache::Read(DiskCache::BlobKind::ModelData, 42, blob));
+
+    DiskCache::DiskCacheStats after = DiskCache::GetStats();
+    CHECK(after.Rejected == before.Rejected + 2);
+    CHECK(after.Hits == before.Hits + 1);
+}
+
+PYJ3D_TEST(DiskCacheClearOnlyRemovesBlobs){
+    TempCache cache("clear");
+    std::vector<uint8_t> payload = MakePayload();
+    CHECK(DiskCache::Write(DiskCache::BlobKind::ProgramBinary, 9, payload.data(), payload.size()));
+
+    // files a user might keep next to the cache, including ones that nearly look like blobs
+    const char* keep[] = { "notes.bin", "1-0000000000000009.bin.bak", "1-9.bin", "1-00000000000000AB.bin", "x1-0000000000000009.bin" };
+    for(const char* name : keep) WriteAll(cache.Path / name, { 1, 2, 3 });
+
+    DiskCache::Clear();
+
+    DiskCache::Blob blob;
+    CHECK(!DiskCache::Read(DiskCache::BlobKind::ProgramBinary, 9, blob));
+    for(const char* name : keep) CHECK(std::filesystem::exists(cache.Path / name));
+}
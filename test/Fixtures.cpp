@@ -0,0 +1,287 @@
+#include "Fixtures.hpp"
+
+#include <cstring>
+
+namespace PyJ3D::Tests {
+    void BigEndianWriter::U8(uint8_t value){
+        mBytes.push_back(value);
+    }
+
+    void BigEndianWriter::U16(uint16_t value){
+        mBytes.push_back((uint8_t)(value >> 8));
+        mBytes.push_back((uint8_t)value);
+    }
+
+    void BigEndianWriter::U32(uint32_t value){
+        U16((uint16_t)(value >> 16));
+        U16((uint16_t)value);
+    }
+
+    void BigEndianWriter::F32(float value){
+        uint32_t bits;
+        std::memcpy(&bits, &value, 4);
+        U32(bits);
+    }
+
+    void BigEndianWriter::Magic(const char* magic){
+        mBytes.insert(mBytes.end(), magic, magic + std::strlen(magic));
+    }
+
+    void BigEndianWriter::Align(size_t alignment){
+        PadTo((mBytes.size() + alignment - 1) / alignment * alignment);
+    }
+
+    void BigEndianWriter::PadTo(size_t offset){
+        if(mBytes.size() < offset) mBytes.resize(offset, 0);
+    }
+
+    void BigEndianWriter::PatchU32(size_t offset, uint32_t value){
+        mBytes[offset] = (uint8_t)(value >> 24);
+        mBytes[offset + 1] = (uint8_t)(value >> 16);
+        mBytes[offset + 2] = (uint8_t)(value >> 8);
+        mBytes[offset + 3] = (uint8_t)value;
+    }
+
+    // Pads to 0x20 and fills in the size after the magic.
+    static FixtureSection Finish(BigEndianWriter& writer){
+        writer.Align(0x20);
+        writer.PatchU32(4, (uint32_t)writer.Size());
+        return { writer.GetBytes() };
+    }
+
+    std::vector<uint8_t> MakeJ3DFile(const char* magic, const std::vector<FixtureSection>& sections){
+        BigEndianWriter file;
+        file.Magic(magic);
+        file.U32(0);
+        file.U32((uint32_t)sections.size());
+        file.Magic("SVR3");
+        file.PadTo(0x20);
+
+        for(const FixtureSection& section : sections){
+            file.GetBytes().insert(file.GetBytes().end(), section.Bytes.begin(), section.Bytes.end());
+        }
+
+        file.PatchU32(0x08, (uint32_t)file.Size());
+        return file.GetBytes();
+    }
+
+    static FixtureSection MakeInf1(){
+        BigEndianWriter inf1;
+        inf1.Magic("INF1");
+        inf1.U32(0);
+        inf1.U16(0);
+        inf1.U16(0xFFFF);
+        inf1.U32(1); // packets
+        inf1.U32(4); // vertices
+        inf1.U32(0x18);
+
+        // joint 0 { joint 1 { material 0 { shape 0 } } }
+        const uint16_t nodes[][2] = {
+            { 0x10, 0 }, { 0x01, 0 }, { 0x10, 1 }, { 0x01, 0 }, { 0x11, 0 }, { 0x01, 0 }, { 0x12, 0 },
+            { 0x02, 0 }, { 0x02, 0 }, { 0x02, 0 }, { 0x00, 0 }
+        };
+        for(const uint16_t* node : nodes){
+            inf1.U16(node[0]);
+            inf1.U16(node[1]);
+        }
+
+        return Finish(inf1);
+    }
+
+    static FixtureSection MakeJnt1(){
+        BigEndianWriter jnt1;
+        jnt1.Magic("JNT1");
+        jnt1.U32(0);
+        jnt1.U16(2);
+        jnt1.U16(0xFFFF);
+        jnt1.U32(0x18); // entries
+        jnt1.U32(0x98); // remap table
+        jnt1.U32(0);    // names
+
+        const float translations[2][3] = { { 0.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 5.0f } };
+        for(const float* translation : translations){
+            jnt1.U16(0);
+            jnt1.U8(0);
+            jnt1.U8(0xFF);
+            for(int i = 0; i < 3; i++) jnt1.F32(1.0f);
+            for(int i = 0; i < 3; i++) jnt1.U16(0);
+            jnt1.U16(0xFFFF);
+            for(int i = 0; i < 3; i++) jnt1.F32(translation[i]);
+            jnt1.F32(2.0f);
+            for(int i = 0; i < 3; i++) jnt1.F32(-1.0f);
+            for(int i = 0; i < 3; i++) jnt1.F32(1.0f);
+        }
+
+        jnt1.U16(0);
+        jnt1.U16(1);
+        return Finish(jnt1);
+    }
+
+    static FixtureSection MakeVtx1(){
+        BigEndianWriter vtx1;
+        vtx1.Magic("VTX1");
+        vtx1.U32(0);
+        vtx1.U32(0x40); // attribute formats
+        vtx1.U32(0x60); // positions, every other array is absent
+        vtx1.PadTo(0x40);
+
+        // position: xyz, float, no fraction bits, then the terminator
+        vtx1.U32(9);
+        vtx1.U32(1);
+        vtx1.U32(4);
+        vtx1.U8(0);
+        vtx1.PadTo(0x50);
+        vtx1.U32(0xFF);
+        vtx1.PadTo(0x60);
+
+        const float corners[4][2] = { { -1.0f, -1.0f }, { 1.0f, -1.0f }, { 1.0f, 1.0f }, { -1.0f, 1.0f } };
+        for(const float* corner : corners){
+            vtx1.F32(corner[0]);
+            vtx1.F32(corner[1]);
+            vtx1.F32(0.0f);
+        }
+
+        return Finish(vtx1);
+    }
+
+    static FixtureSection MakeDrw1(){
+        BigEndianWriter drw1;
+        drw1.Magic("DRW1");
+        drw1.U32(0);
+        drw1.U16(2);
+        drw1.U16(0xFFFF);
+        drw1.U32(0x14); // weighted flags
+        drw1.U32(0x16); // joint or envelope index
+
+        // both draw matrices are rigid, draw matrix n is joint n
+        drw1.U8(0);
+        drw1.U8(0);
+        drw1.U16(0);
+        drw1.U16(1);
+        return Finish(drw1);
+    }
+
+    static FixtureSection MakeShp1(){
+        BigEndianWriter shp1;
+        shp1.Magic("SHP1");
+        shp1.U32(0);
+        shp1.U16(1);
+        shp1.U16(0xFFFF);
+
+        const uint32_t offsets[] = { 0x40, 0x68, 0, 0x80, 0xA0, 0xC0, 0xE0, 0xF0 };
+        for(uint32_t offset : offsets) shp1.U32(offset);
+        shp1.PadTo(0x40);
+
+        // one packet, bounds of the quad in model space
+        shp1.U8(0);
+        shp1.U8(0xFF);
+        shp1.U16(1);
+        shp1.U16(0);
+        shp1.U16(0);
+        shp1.U16(0);
+        shp1.U16(0xFFFF);
+        shp1.F32(1.5f);
+        shp1.F32(-1.0f);
+        shp1.F32(-1.0f);
+        shp1.F32(5.0f);
+        shp1.F32(1.0f);
+        shp1.F32(1.0f);
+        shp1.F32(5.0f);
+
+        shp1.U16(0);
+        shp1.PadTo(0x80);
+
+        // matrix index sent direct, 16 bit position index
+        shp1.U32(0);
+        shp1.U32(1);
+        shp1.U32(9);
+        shp1.U32(3);
+        shp1.U32(0xFF);
+        shp1.U32(0);
+        shp1.PadTo(0xA0);
+
+        // matrix slot 0 is draw matrix 1
+        shp1.U16(1);
+        shp1.PadTo(0xC0);
+
+        shp1.U8(0x80);
+        shp1.U16(4);
+        for(uint16_t vertex = 0; vertex < 4; vertex++){
+            shp1.U8(0);
+            shp1.U16(vertex);
+        }
+        shp1.PadTo(0xE0);
+
+        shp1.U16(0);
+        shp1.U16(1);
+        shp1.U32(0);
+        shp1.PadTo(0xF0);
+
+        shp1.U32(0x20);
+        shp1.U32(0);
+        return Finish(shp1);
+    }
+
+    std::vector<uint8_t> MakeSkinnedQuadModel(){
+        return MakeJ3DFile("J3D2bmd3", { MakeInf1(), MakeVtx1(), MakeJnt1(), MakeDrw1(), MakeShp1() });
+    }
+
+    std::vector<uint8_t> MakeKeyedClip(){
+        // time, value, in slope and with a stride of 4 an out slope per key, a stride of 1 is a bare value
+        struct Track {
+            std::vector<float> Keys;
+            uint16_t Stride;
+        };
+
+        // scale, rotation, translation per axis, rotations in 16 bit angle units
+        const Track tracks[9] = {
+            { { 1.0f }, 1 },
+            { { 0.0f, 0.0f, 0.0f, 20.0f, 8192.0f, 100.0f, 60.0f, -4096.0f, 0.0f }, 3 },
+            { { 0.0f, 0.0f, 2.5f, 15.0f, 123.456f, 0.75f, 40.0f, -77.7f, -3.1f, 60.0f, 10.0f, 0.0f }, 3 },
+            { { 0.0f, 1.0f, 0.0f, 30.0f, 1.37f, 0.012f, 60.0f, 0.81f, 0.0f }, 3 },
+            { { 0.0f }, 1 },
+            { { 0.0f, -250.0f, 1.0f, 4.0f, 25.0f, 380.25f, -2.0f, 6.5f, 60.0f, -12.5f, 0.0f, 0.0f }, 4 },
+            { { 1.0f }, 1 },
+            { { 0.0f }, 1 },
+            { { 3.0f }, 1 }
+        };
+
+        std::vector<float> tables[3];
+        BigEndianWriter joints;
+        for(uint32_t component = 0; component < 9; component++){
+            const Track& track = tracks[component];
+            std::vector<float>& table = tables[component % 3];
+
+            joints.U16((uint16_t)(track.Keys.size() / track.Stride));
+            joints.U16((uint16_t)table.size());
+            joints.U16(track.Stride == 4 ? 1 : 0);
+            table.insert(table.end(), track.Keys.begin(), track.Keys.end());
+        }
+
+        BigEndianWriter ank1;
+        ank1.Magic("ANK1");
+        ank1.U32(0);
+        ank1.U8(0);  // play once
+        ank1.U8(0);  // angle shift
+        ank1.U16(60);
+        ank1.U16(1);
+        for(const std::vector<float>& table : tables) ank1.U16((uint16_t)table.size());
+        ank1.U32(0x40);
+        ank1.U32(0); // table offsets, patched below
+        ank1.U32(0);
+        ank1.U32(0);
+        ank1.PadTo(0x40);
+        ank1.GetBytes().insert(ank1.GetBytes().end(), joints.GetBytes().begin(), joints.GetBytes().end());
+
+        for(uint32_t kind = 0; kind < 3; kind++){
+            ank1.Align(0x20);
+            ank1.PatchU32(0x18 + kind * 4, (uint32_t)ank1.Size());
+            for(float value : tables[kind]){
+                if(kind == 1) ank1.U16((uint16_t)(int16_t)value);
+                else ank1.F32(value);
+            }
+        }
+
+        return MakeJ3DFile("J3D1bck1", { Finish(ank1) });
+    }
+}
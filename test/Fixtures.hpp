@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Small J3D files assembled in memory, so the parsers can be tested without shipping game assets.
+namespace PyJ3D::Tests {
+    // Big endian writer that sections are built with, offsets are from the start of the buffer.
+    class BigEndianWriter {
+        std::vector<uint8_t> mBytes;
+
+    public:
+        size_t Size() const { return mBytes.size(); }
+        std::vector<uint8_t>& GetBytes() { return mBytes; }
+
+        void U8(uint8_t value);
+        void U16(uint16_t value);
+        void U32(uint32_t value);
+        void F32(float value);
+        void Magic(const char* magic);
+        void Align(size_t alignment);
+        void PadTo(size_t offset);
+
+        // Overwrite a value written earlier, for offsets and sizes only known later.
+        void PatchU32(size_t offset, uint32_t value);
+    };
+
+    // A section's bytes, magic and size included.
+    struct FixtureSection {
+        std::vector<uint8_t> Bytes;
+    };
+
+    // Wraps sections in a J3D header with the given eight character magic, "J3D2bmd3" for models.
+    std::vector<uint8_t> MakeJ3DFile(const char* magic, const std::vector<FixtureSection>& sections);
+
+    // Two joints, the second a child of the first moved 5 units along +z. One quad spanning [-1, 1] on x and y
+    // in the second joint's space is bound rigidly to it, so the bind pose quad sits on the z = 5 plane.
+    std::vector<uint8_t> MakeSkinnedQuadModel();
+
+    // One joint BCK lasting 60 frames. Translation x/y, scale y and rotation x have hermite keys, translation y with
+    // separate out slopes, the rest are single values. Keys land on frames 0, 15, 20, 25, 30, 40 and 60.
+    std::vector<uint8_t> MakeKeyedClip();
+}
@@ -0,0 +1,60 @@
+#include "TestUtil.hpp"
+#include "Fixtures.hpp"
+#include "JointAnimation.hpp"
+
+#include <memory>
+
+using namespace PyJ3D;
+
+static std::shared_ptr<JointAnimation::JointClip> ReadKeyedClip(bool lossless){
+    std::vector<uint8_t> file = Tests::MakeKeyedClip();
+
+    std::shared_ptr<JointAnimation::JointClip> clip = JointAnimation::ReadClip(file.data(), file.size(), lossless);
+    CHECK(clip != nullptr && clip->JointCount == 1 && clip->Duration == 60);
+    return clip;
+}
+
+PYJ3D_TEST(ClipsKeepTheFileValuesByDefault){
+    std::vector<uint8_t> file = Tests::MakeKeyedClip();
+    std::shared_ptr<JointAnimation::JointClip> clip = JointAnimation::ReadClip(file.data(), file.size());
+    CHECK(clip != nullptr);
+
+    for(const JointAnimation::ClipTrack& track : clip->Tracks){
+        CHECK(!track.Packed || track.Target == JointAnimation::RotationX);
+    }
+
+    // at a key the hermite weights are exactly 1 and 0, so a lossless clip returns the file's floats
+    std::vector<float> pose(JointAnimation::ComponentCount);
+    JointAnimation::Sample(*clip, 15.0f, pose.data());
+    CHECK(pose[JointAnimation::TranslationX] == 123.456f);
+    JointAnimation::Sample(*clip, 25.0f, pose.data());
+    CHECK(pose[JointAnimation::TranslationY] == 380.25f);
+    JointAnimation::Sample(*clip, 30.0f, pose.data());
+    CHECK(pose[JointAnimation::ScaleY] == 1.37f);
+    CHECK(pose[JointAnimation::TranslationZ] == 3.0f);
+}
+
+PYJ3D_TEST(PackedClipStaysWithinTolerance){
+    std::shared_ptr<JointAnimation::JointClip> lossless = ReadKeyedClip(true);
+    std::shared_ptr<JointAnimation::JointClip> packed = ReadKeyedClip(false);
+
+    uint32_t packedTracks = 0;
+    for(const JointAnimation::ClipTrack& track : packed->Tracks){
+        if(track.Packed && track.Target != JointAnimation::RotationX) packedTracks++;
+    }
+    CHECK(packedTracks == 3);
+
+    // between keys too, where the slopes' error comes in
+    std::vector<float> exact(JointAnimation::ComponentCount), sampled(JointAnimation::ComponentCount);
+    for(float frame = 0.0f; frame <= 60.0f; frame += 0.125f){
+        JointAnimation::Sample(*lossless, frame, exact.data());
+        JointAnimation::Sample(*packed, frame, sampled.data());
+
+        for(uint32_t component = 0; component < JointAnimation::ComponentCount; component++){
+            float tolerance = component % 3 == 0 ? JointAnimation::ScaleTolerance : JointAnimation::TranslationTolerance;
+            if(component % 3 == 1) tolerance = 0.0f; // rotations are packed the same way either way
+
+            CHECK_NEAR(sampled[component], exact[component], tolerance + 1e-5);
+        }
+    }
+}
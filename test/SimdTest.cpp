@@ -0,0 +1,116 @@
+#include "TestUtil.hpp"
+#include "Simd.hpp"
+
+#include <random>
+
+using namespace PyJ3D;
+
+// Runs fn at every level the CPU supports, then goes back to the level that was active.
+template<typename Fn>
+static void ForEachLevel(Fn&& fn){
+    Simd::Level active = Simd::GetLevel();
+    for(Simd::Level level : { Simd::Level::Scalar, Simd::Level::Sse42, Simd::Level::Avx2 }){
+        if(level > Simd::GetSupportedLevel()) break;
+        Simd::SetLevel(level);
+        fn(level);
+    }
+    Simd::SetLevel(active);
+}
+
+PYJ3D_TEST(CullSpheresMatchesScalar){
+    // odd count so the vector loops have a tail
+    const size_t count = 1037;
+    std::mt19937 random(42);
+    std::uniform_real_distribution<float> position(-200.0f, 200.0f), size(0.0f, 20.0f);
+
+    std::vector<float> x(count), y(count), z(count), radius(count);
+    for(size_t i = 0; i < count; i++){
+        x[i] = position(random);
+        y[i] = position(random);
+        z[i] = position(random);
+        radius[i] = size(random);
+    }
+
+    // a 100 unit box around the origin, planes face inward
+    const glm::vec4 planes[6] = {
+        { 1, 0, 0, 100 }, { -1, 0, 0, 100 }, { 0, 1, 0, 100 }, { 0, -1, 0, 100 }, { 0, 0, 1, 100 }, { 0, 0, -1, 100 }
+    };
+
+    std::vector<uint8_t> expected(count), visible(count);
+    ForEachLevel([&](Simd::Level level){
+        std::vector<uint8_t>& out = level == Simd::Level::Scalar ? expected : visible;
+        Simd::GetKernels().CullSpheres(x.data(), y.data(), z.data(), radius.data(), count, planes, 1.5f, out.data());
+        if(level != Simd::Level::Scalar) CHECK(visible == expected);
+    });
+}
+
+PYJ3D_TEST(HermiteMatchesScalar){
+    const size_t count = 517;
+    std::mt19937 random(7);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f), value(-500.0f, 500.0f);
+
+    std::vector<float> u(count), value0(count), value1(count), slope0(count), slope1(count);
+    for(size_t i = 0; i < count; i++){
+        u[i] = unit(random);
+        value0[i] = value(random);
+        value1[i] = value(random);
+        slope0[i] = value(random);
+        slope1[i] = value(random);
+    }
+
+    // FMA rounds once where the scalar code rounds twice, so results agree to float precision, not bit for bit
+    std::vector<float> expected(count), out(count);
+    ForEachLevel([&](Simd::Level level){
+        std::vector<float>& result = level == Simd::Level::Scalar ? expected : out;
+        Simd::GetKernels().Hermite(u.data(), value0.data(), value1.data(), slope0.data(), slope1.data(), result.data(), count);
+        if(level == Simd::Level::Scalar) return;
+
+        for(size_t i = 0; i < count; i++){
+            CHECK_NEAR(out[i], expected[i], 1e-3);
+        }
+    });
+}
+
+// Every 16 bit value once, plus a few more so the vector loops have a tail.
+static std::vector<uint8_t> MakeAllTexels(size_t& count){
+    count = 65536 + 5;
+    std::vector<uint8_t> texels(count * 2);
+    for(size_t i = 0; i < count; i++){
+        texels[i * 2] = (uint8_t)(i >> 8);
+        texels[i * 2 + 1] = (uint8_t)i;
+    }
+    return texels;
+}
+
+PYJ3D_TEST(DecodeRgb565MatchesScalar){
+    size_t count;
+    std::vector<uint8_t> texels = MakeAllTexels(count);
+
+    std::vector<uint8_t> expected(count * 4), rgba(count * 4);
+    ForEachLevel([&](Simd::Level level){
+        std::vector<uint8_t>& out = level == Simd::Level::Scalar ? expected : rgba;
+        Simd::GetKernels().DecodeRgb565(texels.data(), out.data(), count);
+        if(level != Simd::Level::Scalar) CHECK(rgba == expected);
+    });
+
+    // pure red, and a green that only sets the low bit
+    CHECK(expected[0xF800 * 4] == 0xFF && expected[0xF800 * 4 + 1] == 0 && expected[0xF800 * 4 + 2] == 0 && expected[0xF800 * 4 + 3] == 0xFF);
+    CHECK(expected[0x0020 * 4 + 1] == 0x04);
+}
+
+PYJ3D_TEST(DecodeRgb5a3MatchesScalar){
+    size_t count;
+    std::vector<uint8_t> texels = MakeAllTexels(count);
+
+    std::vector<uint8_t> expected(count * 4), rgba(count * 4);
+    ForEachLevel([&](Simd::Level level){
+        std::vector<uint8_t>& out = level == Simd::Level::Scalar ? expected : rgba;
+        Simd::GetKernels().DecodeRgb5a3(texels.data(), out.data(), count);
+        if(level != Simd::Level::Scalar) CHECK(rgba == expected);
+    });
+
+    // opaque RGB555 white, then 3 bit alpha at its extremes
+    CHECK(expected[0xFFFF * 4] == 0xFF && expected[0xFFFF * 4 + 3] == 0xFF);
+    CHECK(expected[0x7FFF * 4] == 0xFF && expected[0x7FFF * 4 + 3] == 0xFF);
+    CHECK(expected[0x0F00 * 4] == 0xFF && expected[0x0F00 * 4 + 3] == 0);
+}
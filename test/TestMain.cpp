@@ -0,0 +1,30 @@
+#include "TestUtil.hpp"
+
+namespace PyJ3D::Tests {
+    static int failures = 0;
+
+    std::vector<TestCase>& GetTests(){
+        static std::vector<TestCase> tests;
+        return tests;
+    }
+
+    void Fail(const char* file, int line, const std::string& message){
+        std::printf("  %s:%d: %s\n", file, line, message.c_str());
+        failures++;
+    }
+}
+
+int main(){
+    int failedTests = 0;
+    for(const PyJ3D::Tests::TestCase& test : PyJ3D::Tests::GetTests()){
+        int before = PyJ3D::Tests::failures;
+        test.Run();
+
+        bool passed = PyJ3D::Tests::failures == before;
+        std::printf("%s %s\n", passed ? "PASS" : "FAIL", test.Name);
+        if(!passed) failedTests++;
+    }
+
+    std::printf("%d of %zu tests failed\n", failedTests, PyJ3D::Tests::GetTests().size());
+    return failedTests == 0 ? 0 : 1;
+}
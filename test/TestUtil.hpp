@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cmath>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Just enough of a test harness for the core library, each test registers itself and J3DUltraPyTests runs them all.
+namespace PyJ3D::Tests {
+    struct TestCase {
+        const char* Name;
+        std::function<void()> Run;
+    };
+
+    std::vector<TestCase>& GetTests();
+    void Fail(const char* file, int line, const std::string& message);
+
+    struct Registrar {
+        Registrar(const char* name, std::function<void()> run){ GetTests().push_back({ name, run }); }
+    };
+}
+
+#define PYJ3D_TEST(name) \
+    static void name(); \
+    static PyJ3D::Tests::Registrar name##Registrar(#name, name); \
+    static void name()
+
+#define CHECK(cond) \
+    do { if(!(cond)) PyJ3D::Tests::Fail(__FILE__, __LINE__, #cond); } while(0)
+
+#define CHECK_NEAR(a, b, tolerance) \
+    do { \
+        double checkA = (double)(a), checkB = (double)(b); \
+        if(!(std::abs(checkA - checkB) <= (double)(tolerance))){ \
+            PyJ3D::Tests::Fail(__FILE__, __LINE__, std::string(#a " == " #b ": ") + std::to_string(checkA) + " vs " + std::to_string(checkB)); \
+        } \
+    } while(0)
@@ -0,0 +1,236 @@
+#include "TestUtil.hpp"
+#include "Simd.hpp"
+#include "TextureDecode.hpp"
+
+#include <cstring>
+#include <random>
+
+using namespace PyJ3D;
+
+// A texture with two levels, sized so neither fills whole 4x4 tiles by default, filled with random texels.
+static std::vector<uint8_t> MakeTexture(TextureDecode::Format format, J3DFile::TextureHeader& texture, uint16_t width = 10, uint16_t height = 6){
+    texture.Format = (uint8_t)format;
+    texture.Width = width;
+    texture.Height = height;
+    texture.MipCount = 2;
+    texture.DataOffset = 0;
+
+    std::vector<uint8_t> data(TextureDecode::GetDataSize(texture));
+    std::mt19937 random(99);
+    for(uint8_t& byte : data) byte = (uint8_t)random();
+    return data;
+}
+
+// Decodes every texel on its own through the scalar kernel, straight from its spot in the tile layout.
+static std::vector<uint8_t> DecodeByTexel(const std::vector<uint8_t>& data, const J3DFile::TextureHeader& texture, uint32_t level){
+    size_t offset = 0;
+    for(uint32_t i = 0; i < level; i++){
+        offset += TextureDecode::GetLevelSize(texture.Format, TextureDecode::GetLevelWidth(texture, i), TextureDecode::GetLevelHeight(texture, i));
+    }
+
+    uint32_t width = TextureDecode::GetLevelWidth(texture, level), height = TextureDecode::GetLevelHeight(texture, level);
+    size_t tilesX = (width + 3) / 4;
+
+    Simd::Level active = Simd::GetLevel();
+    Simd::SetLevel(Simd::Level::Scalar);
+    std::vector<uint8_t> out((size_t)width * height * 4);
+    for(uint32_t y = 0; y < height; y++){
+        for(uint32_t x = 0; x < width; x++){
+            size_t texel = offset + ((y / 4) * tilesX + x / 4) * 32 + ((y % 4) * 4 + x % 4) * 2;
+            if(texture.Format == (uint8_t)TextureDecode::Format::RGB565) Simd::GetKernels().DecodeRgb565(data.data() + texel, out.data() + ((size_t)y * width + x) * 4, 1);
+            else Simd::GetKernels().DecodeRgb5a3(data.data() + texel, out.data() + ((size_t)y * width + x) * 4, 1);
+        }
+    }
+    Simd::SetLevel(active);
+    return out;
+}
+
+static void CheckEveryLevel(TextureDecode::Format format){
+    J3DFile::TextureHeader texture;
+    std::vector<uint8_t> data = MakeTexture(format, texture);
+
+    Simd::Level active = Simd::GetLevel();
+    for(uint32_t mip = 0; mip < texture.MipCount; mip++){
+        std::vector<uint8_t> expected = DecodeByTexel(data, texture, mip);
+
+        for(Simd::Level level : { Simd::Level::Scalar, Simd::Level::Sse42, Simd::Level::Avx2 }){
+            if(level > Simd::GetSupportedLevel()) break;
+            Simd::SetLevel(level);
+
+            std::vector<uint8_t> out;
+            CHECK(TextureDecode::DecodeLevel(data.data(), data.size(), texture, mip, out));
+            CHECK(out == expected);
+        }
+    }
+    Simd::SetLevel(active);
+}
+
+PYJ3D_TEST(DecodeLevelRgb565MatchesScalar){
+    CheckEveryLevel(TextureDecode::Format::RGB565);
+}
+
+PYJ3D_TEST(DecodeLevelRgb5a3MatchesScalar){
+    CheckEveryLevel(TextureDecode::Format::RGB5A3);
+}
+
+PYJ3D_TEST(DecodeLevelRejectsShortData){
+    J3DFile::TextureHeader texture;
+    std::vector<uint8_t> data = MakeTexture(TextureDecode::Format::RGB565, texture);
+
+    std::vector<uint8_t> out;
+    CHECK(!TextureDecode::DecodeLevel(data.data(), data.size() - 1, texture, 1, out));
+}
+
+static void CheckPixel(const std::vector<uint8_t>& pixels, uint32_t width, uint32_t x, uint32_t y, uint8_t r, uint8_t g, uint8_t b, uint8_t a){
+    const uint8_t* pixel = pixels.data() + ((size_t)y * width + x) * 4;
+    CHECK(pixel[0] == r && pixel[1] == g && pixel[2] == b && pixel[3] == a);
+}
+
+static void PutBlock(uint8_t* block, uint16_t color0, uint16_t color1, uint8_t indices){
+    block[0] = (uint8_t)(color0 >> 8);
+    block[1] = (uint8_t)color0;
+    block[2] = (uint8_t)(color1 >> 8);
+    block[3] = (uint8_t)color1;
+    std::memset(block + 4, indices, 4);
+}
+
+PYJ3D_TEST(DecodeLevelCmprBlocks){
+    J3DFile::TextureHeader texture;
+    texture.Format = (uint8_t)TextureDecode::Format::CMPR;
+    texture.Width = 8;
+    texture.Height = 8;
+
+    // one tile, its four blocks go top left, top right, bottom left, bottom right
+    std::vector<uint8_t> data(32, 0);
+    PutBlock(data.data(), 0xF800, 0x001F, 0x1B); // opaque, every row walks indices 0 to 3
+    PutBlock(data.data() + 8, 0x001F, 0xF800, 0xFF); // punch through, index 3 is transparent
+    PutBlock(data.data() + 16, 0x001F, 0xF800, 0xAA); // punch through, index 2 is the midpoint
+
+    std::vector<uint8_t> out;
+    CHECK(TextureDecode::DecodeLevel(data.data(), data.size(), texture, 0, out));
+    CHECK(out.size() == 8 * 8 * 4);
+
+    CheckPixel(out, 8, 0, 0, 255, 0, 0, 255);
+    CheckPixel(out, 8, 1, 0, 0, 0, 255, 255);
+    CheckPixel(out, 8, 2, 3, 170, 0, 85, 255);
+    CheckPixel(out, 8, 3, 3, 85, 0, 170, 255);
+    CheckPixel(out, 8, 5, 1, 0, 0, 0, 0);
+    CheckPixel(out, 8, 2, 6, 127, 0, 127, 255);
+    CheckPixel(out, 8, 6, 6, 0, 0, 0, 255);
+}
+
+// Reference BC1 decode: little endian colors and the first texel of a row in the low bits.
+static std::vector<uint8_t> DecodeBc1(const std::vector<uint8_t>& blocks, uint32_t width, uint32_t height){
+    size_t blocksX = (width + 3) / 4;
+    std::vector<uint8_t> out((size_t)width * height * 4);
+    for(uint32_t y = 0; y < height; y++){
+        for(uint32_t x = 0; x < width; x++){
+            const uint8_t* block = blocks.data() + ((y / 4) * blocksX + x / 4) * 8;
+            uint8_t swapped[4] = { block[1], block[0], block[3], block[2] };
+            uint8_t colors[16];
+            Simd::GetKernels().DecodeRgb565(swapped, colors, 2);
+
+            bool opaque = (block[0] | block[1] << 8) > (block[2] | block[3] << 8);
+            for(uint32_t c = 0; c < 3; c++){
+                colors[8 + c] = (uint8_t)(opaque ? (2 * colors[c] + colors[4 + c]) / 3 : (colors[c] + colors[4 + c]) / 2);
+                colors[12 + c] = (uint8_t)(opaque ? (colors[c] + 2 * colors[4 + c]) / 3 : 0);
+            }
+            colors[11] = 0xFF;
+            colors[15] = opaque ? 0xFF : 0x00;
+
+            uint32_t index = (block[4 + y % 4] >> ((x % 4) * 2)) & 3;
+            std::memcpy(out.data() + ((size_t)y * width + x) * 4, colors + index * 4, 4);
+        }
+    }
+    return out;
+}
+
+PYJ3D_TEST(ConvertCmprToBc1MatchesDecodeLevel){
+    J3DFile::TextureHeader texture;
+    std::vector<uint8_t> data = MakeTexture(TextureDecode::Format::CMPR, texture, 20, 12);
+
+    for(uint32_t mip = 0; mip < texture.MipCount; mip++){
+        uint32_t width = TextureDecode::GetLevelWidth(texture, mip), height = TextureDecode::GetLevelHeight(texture, mip);
+
+        std::vector<uint8_t> blocks, expected;
+        CHECK(TextureDecode::ConvertCmprToBc1(data.data(), data.size(), texture, mip, blocks));
+        CHECK(blocks.size() == (size_t)((width + 3) / 4) * ((height + 3) / 4) * 8);
+        CHECK(TextureDecode::DecodeLevel(data.data(), data.size(), texture, mip, expected));
+        CHECK(DecodeBc1(blocks, width, height) == expected);
+    }
+}
+
+PYJ3D_TEST(ConvertCmprToBc1RejectsOtherFormats){
+    J3DFile::TextureHeader texture;
+    std::vector<uint8_t> data = MakeTexture(TextureDecode::Format::RGB565, texture);
+
+    std::vector<uint8_t> out;
+    CHECK(!TextureDecode::ConvertCmprToBc1(data.data(), data.size(), texture, 0, out));
+}
+
+// One tile of indices 0 to 5 repeating, against a four entry palette stored after it.
+static void CheckPaletted(TextureDecode::Format format, uint16_t width, uint16_t height, TextureDecode::PaletteFormat paletteFormat,
+                          const uint8_t (&entries)[8], const uint8_t (&expected)[4][4]){
+    J3DFile::TextureHeader texture;
+    texture.Format = (uint8_t)format;
+    texture.Width = width;
+    texture.Height = height;
+    texture.PaletteFormat = (uint8_t)paletteFormat;
+    texture.PaletteCount = 4;
+
+    size_t texels = (size_t)width * height;
+    std::vector<uint8_t> data(32, 0);
+    for(size_t i = 0; i < texels; i++){
+        uint16_t index = (uint16_t)(i % 6);
+        if(format == TextureDecode::Format::C4) data[i / 2] |= (uint8_t)(index << ((~i & 1) * 4));
+        else if(format == TextureDecode::Format::C8) data[i] = (uint8_t)index;
+        else {
+            // the top two bits aren't part of the index
+            data[i * 2] = (uint8_t)((index | 0xC000) >> 8);
+            data[i * 2 + 1] = (uint8_t)index;
+        }
+    }
+    texture.PaletteOffset = data.size();
+    data.insert(data.end(), entries, entries + 8);
+
+    std::vector<uint8_t> out;
+    CHECK(TextureDecode::DecodeLevel(data.data(), data.size(), texture, 0, out));
+    CHECK(out.size() == texels * 4);
+
+    // indices past the palette read transparent black
+    static const uint8_t clear[4] = {};
+    for(size_t i = 0; i < texels && out.size() == texels * 4; i++){
+        const uint8_t* color = i % 6 < 4 ? expected[i % 6] : clear;
+        CHECK(std::memcmp(out.data() + i * 4, color, 4) == 0);
+    }
+}
+
+static const uint8_t Rgb565Entries[8] = { 0xF8, 0x00, 0x07, 0xE0, 0x00, 0x1F, 0xFF, 0xFF };
+static const uint8_t Rgb565Colors[4][4] = { { 255, 0, 0, 255 }, { 0, 255, 0, 255 }, { 0, 0, 255, 255 }, { 255, 255, 255, 255 } };
+
+PYJ3D_TEST(DecodeLevelC4){
+    CheckPaletted(TextureDecode::Format::C4, 8, 8, TextureDecode::PaletteFormat::RGB565, Rgb565Entries, Rgb565Colors);
+}
+
+PYJ3D_TEST(DecodeLevelC8){
+    static const uint8_t entries[8] = { 0xFF, 0x00, 0x80, 0x40, 0x00, 0xFF, 0x20, 0x10 };
+    static const uint8_t colors[4][4] = { { 0, 0, 0, 255 }, { 64, 64, 64, 128 }, { 255, 255, 255, 0 }, { 16, 16, 16, 32 } };
+    CheckPaletted(TextureDecode::Format::C8, 8, 4, TextureDecode::PaletteFormat::IA8, entries, colors);
+}
+
+PYJ3D_TEST(DecodeLevelC14X2){
+    CheckPaletted(TextureDecode::Format::C14X2, 4, 4, TextureDecode::PaletteFormat::RGB565, Rgb565Entries, Rgb565Colors);
+}
+
+PYJ3D_TEST(DecodeLevelRejectsShortPalette){
+    J3DFile::TextureHeader texture;
+    texture.Format = (uint8_t)TextureDecode::Format::C8;
+    texture.Width = 8;
+    texture.Height = 4;
+    texture.PaletteCount = 4;
+    texture.PaletteOffset = 32;
+
+    std::vector<uint8_t> data(32 + 7, 0);
+    std::vector<uint8_t> out;
+    CHECK(!TextureDecode::DecodeLevel(data.data(), data.size(), texture, 0, out));
+}
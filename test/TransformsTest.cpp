@@ -0,0 +1,51 @@
+#include "TestUtil.hpp"
+#include "Transforms.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+using namespace PyJ3D;
+
+// J3D composes rotations as Rz * Ry * Rx from euler degrees, the decomposition has to give the same angles back.
+static glm::mat4 ComposeZYX(const glm::vec3& degrees){
+    glm::mat4 m(1.0f);
+    m = glm::rotate(m, glm::radians(degrees.z), glm::vec3(0, 0, 1));
+    m = glm::rotate(m, glm::radians(degrees.y), glm::vec3(0, 1, 0));
+    m = glm::rotate(m, glm::radians(degrees.x), glm::vec3(1, 0, 0));
+    return m;
+}
+
+static void CheckSameRotation(const glm::mat4& a, const glm::mat4& b){
+    for(int col = 0; col < 3; col++){
+        for(int row = 0; row < 3; row++){
+            CHECK_NEAR(a[col][row], b[col][row], 1e-4);
+        }
+    }
+}
+
+PYJ3D_TEST(EulerRoundTripsThroughZYX){
+    const glm::vec3 angles[] = {
+        { 0, 0, 0 }, { 30, 0, 0 }, { 0, 45, 0 }, { 0, 0, 60 },
+        { 10, 20, 30 }, { -75, 40, 170 }, { 120, -30, -95 }, { 5, 89, -5 }
+    };
+
+    for(const glm::vec3& degrees : angles){
+        glm::mat4 expected = ComposeZYX(degrees);
+        glm::vec3 euler = Transforms::ToEulerDegrees(glm::quat_cast(expected));
+        CheckSameRotation(ComposeZYX(euler), expected);
+    }
+}
+
+PYJ3D_TEST(EulerKeepsAnglesInsideTheNormalRange){
+    glm::vec3 degrees(10, 20, 30);
+    glm::vec3 euler = Transforms::ToEulerDegrees(glm::quat_cast(ComposeZYX(degrees)));
+    CHECK_NEAR(euler.x, 10, 1e-3);
+    CHECK_NEAR(euler.y, 20, 1e-3);
+    CHECK_NEAR(euler.z, 30, 1e-3);
+}
+
+PYJ3D_TEST(EulerHandlesGimbalLock){
+    glm::mat4 expected = ComposeZYX(glm::vec3(25, 90, 0));
+    glm::vec3 euler = Transforms::ToEulerDegrees(glm::quat_cast(expected));
+    CHECK_NEAR(euler.y, 90, 1e-2);
+    CheckSameRotation(ComposeZYX(euler), expected);
+}
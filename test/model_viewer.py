@@ -115,10 +115,7 @@ if __name__ == "__main__":
 
         proj = matrix44.create_perspective_projection_matrix(45.0, width/height, 0.1, 100000.0)
 
-        ultra.setCamera(
-            proj.ravel().tolist(),
-            cam.view_matrix.ravel().tolist()
-        )
+        ultra.setCamera(proj, cam.view_matrix)
 
         if(model != None):
             model.render()